@@ -9,7 +9,9 @@
 #include "FFGL.h"
 #include "FFGLLib.h"
 #include "FFGLShader.h"
+#include "FFGLResources.h"
 #include "FFGLPluginSDK.h"
+#include "FFGLEffect.h"
 
 #if (!(defined(WIN32) || defined(_WIN32) || defined(__WIN32__)))
 // posix
@@ -37,8 +39,9 @@ struct Vertex
 	GLfloat color[4];
 };
 
-class EdgeTracer : public CFreeFrameGLPlugin
+class EdgeTracer : public FFGLEffect<EdgeTracer>
 {
+	friend class FFGLEffect<EdgeTracer>;
 
 public:
 
@@ -48,14 +51,9 @@ public:
 
 	FFResult SetFloatParameter( unsigned int index, float value );
 	float GetFloatParameter( unsigned int index );
-	FFResult ProcessOpenGL( ProcessOpenGLStruct* pGL );
-	FFResult InitGL( const FFGLViewportStruct *vp );
-	FFResult DeInitGL();
 	FFResult GetInputStatus( DWORD dwIndex );
 	char * GetParameterDisplay( DWORD dwIndex );
 
-	bool LoadShader( std::string shaderCode );
-
 
 	///////////////////////////////////////////////////
 	// Factory method
@@ -70,14 +68,6 @@ public:
 
 private:
 
-	bool bInitialized;
-
-	int m_initResources;
-	FFGLExtensions m_extensions;
-	FFGLShader m_shader;
-
-	GLuint m_fbo;
-
 	GLuint m_VertexLocation;
 	GLuint m_ColorLocation;
 
@@ -88,9 +78,11 @@ private:
 		{{1.0, -1.0}, {1.0, 0.0, 0.0, 0.0}}
 	};
 
-	GLuint m_rectLocation;
+	FFGLBuffer m_rectBuffer;
 
-	// Viewport
-	float m_vpWidth;
-	float m_vpHeight;
+	// FFGLEffect hooks
+	bool InitEffect();
+	void DeInitEffect();
+	bool ShaderLoaded();
+	FFResult Render( ProcessOpenGLStruct *pGL );
 };
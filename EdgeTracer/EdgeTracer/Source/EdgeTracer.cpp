@@ -57,6 +57,7 @@ void main( void ) {
 
 
 EdgeTracer::EdgeTracer()
+	: FFGLEffect<EdgeTracer>( vertexShaderCode, fragmentShaderCode )
 {
 #ifdef DEBUG
 	// Debug console window so printf works
@@ -81,8 +82,6 @@ EdgeTracer::EdgeTracer()
 		printf( (char*)glewGetErrorString( status ));
 		printf( "\n" );
 	}
-	
-	bInitialized = false;
 }
 
 EdgeTracer::~EdgeTracer()
@@ -90,53 +89,31 @@ EdgeTracer::~EdgeTracer()
 	//stub
 }
 
-FFResult EdgeTracer::InitGL( const FFGLViewportStruct * vp )
+bool EdgeTracer::InitEffect()
 {
-	m_extensions.Initialize();
-	if (m_extensions.multitexture == 0 || m_extensions.ARB_shader_objects == 0)
-	{
-		return FF_FAIL;
-	}
-
-	m_vpWidth = (float)vp->width;
-	m_vpHeight = (float)vp->height;
-
-	std::string shaderString = fragmentShaderCode;
-	bInitialized = LoadShader( shaderString );
-	if (bInitialized)
-	{
-		glGenBuffers( 1, &m_rectLocation );
-		glBindBuffer( GL_ARRAY_BUFFER, m_rectLocation );
-		glBufferData( GL_ARRAY_BUFFER, sizeof( m_rect ), m_rect, GL_STATIC_DRAW);
+	// nothing to draw with if the shader couldn't be compiled
+	if (!bInitialized)
+		return false;
 
+	if (!m_rectBuffer.Allocate( m_extensions, GL_ARRAY_BUFFER_ARB, sizeof( m_rect ), m_rect, GL_STATIC_DRAW_ARB, &m_glResources ))
+		return false;
+	m_extensions.glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
 
-		return FF_SUCCESS;
-	}
-	return FF_FAIL;
+	return true;
 }
 
-FFResult EdgeTracer::DeInitGL()
+void EdgeTracer::DeInitEffect()
 {
-	if (m_fbo) m_extensions.glDeleteFramebuffersEXT( 1, &m_fbo );
-
-	m_fbo = 0;
-
-	bInitialized = false;
-
-	return FF_SUCCESS;
+	m_rectBuffer.Release();
 }
 
-FFResult EdgeTracer::ProcessOpenGL( ProcessOpenGLStruct *pGl )
+FFResult EdgeTracer::Render( ProcessOpenGLStruct *pGl )
 {
-	FFGLTextureStruct Texture0;
-
-	FFGLTexCoords maxCoords;
-
 	m_shader.BindShader();
 
 	glEnableVertexAttribArray( m_VertexLocation );
 	glEnableVertexAttribArray( m_ColorLocation );
-	glBindBuffer( GL_ARRAY_BUFFER, m_rectLocation );
+	m_extensions.glBindBufferARB( GL_ARRAY_BUFFER_ARB, m_rectBuffer.GetHandle() );
 
 	glVertexAttribPointer( m_VertexLocation,
 		2,
@@ -156,6 +133,7 @@ FFResult EdgeTracer::ProcessOpenGL( ProcessOpenGLStruct *pGl )
 
 	glDisableVertexAttribArray( m_VertexLocation );
 	glDisableVertexAttribArray( m_ColorLocation );
+	m_extensions.glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
 
 	m_shader.UnbindShader();
 
@@ -193,71 +171,15 @@ FFResult EdgeTracer::GetInputStatus( DWORD dwIndex )
 
 char * EdgeTracer::GetParameterDisplay( DWORD dwIndex )
 {
-	return "fixme";
+	return CFreeFrameGLPlugin::GetParameterDisplay( dwIndex );
 }
 
-bool EdgeTracer::LoadShader( std::string shaderCode )
+bool EdgeTracer::ShaderLoaded()
 {
-	m_shader.SetExtensions( &m_extensions );
-	if (!m_shader.Compile( vertexShaderCode, shaderCode.c_str() ))
-	{
-		printf( "Shader failed to compile" );
-		GLint isCompiled = 0;
-		glGetShaderiv( m_shader.GetVertexShaderID(), GL_COMPILE_STATUS, &isCompiled );
-		if (isCompiled == GL_FALSE)
-		{
-			GLint length = 0;
-
-			glGetShaderiv( m_shader.GetVertexShaderID(), GL_INFO_LOG_LENGTH, &length );
-
-			std::vector<char> errorLog( length );
-			glGetShaderInfoLog( m_shader.GetVertexShaderID(), length, &length, &errorLog[0] );
-
-			printf( &errorLog[0] );
-		}
-		glGetShaderiv( m_shader.GetFragmentShaderID(), GL_COMPILE_STATUS, &isCompiled );
-		if (isCompiled == GL_FALSE)
-		{
-			GLint length = 0;
-
-			glGetShaderiv( m_shader.GetFragmentShaderID(), GL_INFO_LOG_LENGTH, &length );
+	//get uniform locations here using m_shader.FindUniform("string")
 
-			std::vector<char> errorLog( length );
-			glGetShaderInfoLog( m_shader.GetFragmentShaderID(), length, &length, &errorLog[0] );
+	m_VertexLocation = glGetAttribLocationARB( m_shader.GetShaderID(), "vtex" );
+	m_ColorLocation = glGetAttribLocationARB( m_shader.GetShaderID(), "color" );
 
-			printf( &errorLog[0] );
-		}
-
-		return false;
-	}
-
-	else
-	{
-		bool success = false;
-		if (m_shader.IsReady())
-		{
-			if (m_shader.BindShader())
-			{
-				success = true;
-			}
-		}
-		if (!success)
-		{
-			return success;
-		}
-
-		else
-		{
-			//get uniform locations here using m_shader.FindUniform("string")
-			
-			m_shader.BindShader();
-			m_VertexLocation = glGetAttribLocationARB( m_shader.GetShaderID(), "vtex" );
-
-			
-			m_ColorLocation = glGetAttribLocationARB( m_shader.GetShaderID(), "color" );
-
-			return true;
-		}
-	}
-	return false;
+	return true;
 }
\ No newline at end of file
@@ -66,6 +66,8 @@
 
 #include "FFGLPluginSDK.h"
 #include <memory.h>
+#include <atomic>
+#include <mutex>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Static and extern variables used in the FreeFrame SDK 
@@ -73,7 +75,45 @@
 
 extern CFFGLPluginInfo* g_CurrPluginInfo;
 
-static CFreeFrameGLPlugin* s_pPrototype = NULL;
+//hosts with several outputs instantiate and process on several threads at
+//once. the prototype is created by whichever thread needs it first and
+//only read after that, so lookups don't take the lock
+static std::atomic<CFreeFrameGLPlugin*> s_pPrototype(NULL);
+static std::mutex s_prototypeMutex;
+
+//returns the prototype, creating it if need be. NULL on failure
+static CFreeFrameGLPlugin *getPrototype()
+{
+  CFreeFrameGLPlugin *prototype = s_pPrototype.load(std::memory_order_acquire);
+  if (prototype!=NULL || g_CurrPluginInfo==NULL)
+    return prototype;
+
+  std::lock_guard<std::mutex> lock(s_prototypeMutex);
+
+  prototype = s_pPrototype.load(std::memory_order_relaxed);
+  if (prototype==NULL)
+  {
+    //get the instantiate function pointer
+    FPCREATEINSTANCEGL *pInstantiate = g_CurrPluginInfo->GetFactoryMethod();
+
+    //call the instantiate function, and make sure it worked
+    if (pInstantiate(&prototype)==FF_FAIL)
+    {
+      delete prototype;
+      prototype = NULL;
+    }
+    else
+    {
+      //the instances created from now on use the prototype's parameter
+      //information instead of building their own
+      prototype->ShareParamInfo();
+    }
+
+    s_pPrototype.store(prototype, std::memory_order_release);
+  }
+
+  return prototype;
+}
 
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -88,65 +128,51 @@ void *getInfo()
 
 FFResult initialise()
 {
-  if (g_CurrPluginInfo==NULL)
+  if (getPrototype()==NULL)
     return FF_FAIL;
 
-	if (s_pPrototype==NULL)
-  {
-    //get the instantiate function pointer
-    FPCREATEINSTANCEGL *pInstantiate = g_CurrPluginInfo->GetFactoryMethod();
-
-	  //call the instantiate function
-    FFResult ret = pInstantiate(&s_pPrototype);
-
-    //make sure the instantiate call worked
-    if ((ret == FF_FAIL) || (s_pPrototype == NULL))
-      return FF_FAIL;
-
-    return FF_SUCCESS;
-	}
-
 	return FF_SUCCESS; 
 }
 
 FFResult deInitialise()
 {
-	if (s_pPrototype != NULL) {
-		delete s_pPrototype;
-		s_pPrototype = NULL;
-	}
+  CFreeFrameGLPlugin *prototype;
+  {
+    std::lock_guard<std::mutex> lock(s_prototypeMutex);
+    prototype = s_pPrototype.exchange(NULL);
+  }
+  delete prototype;
+
+	//every instance has been deleted by now, anything still alive leaked
+	FFGLResourceTracker::CheckGlobalLeaks();
+
 	return FF_SUCCESS;
 }
 
 unsigned int getNumParameters() 
 {
-	if (s_pPrototype == NULL) {
-		FFResult dwRet = initialise();
-		if (dwRet == FF_FAIL) return FF_FAIL;
-	}
+	CFreeFrameGLPlugin *prototype = getPrototype();
+	if (prototype == NULL) return FF_FAIL;
 
-	return s_pPrototype->GetNumParams();
+	return prototype->GetNumParams();
 }
 							
 char* getParameterName(unsigned int index)
 {
-	if (s_pPrototype == NULL) {
-		FFResult dwRet = initialise();
-		if (dwRet == FF_FAIL) return NULL;
-	}
+	CFreeFrameGLPlugin *prototype = getPrototype();
+	if (prototype == NULL) return NULL;
 	
-	return s_pPrototype->GetParamName(index);
+	return prototype->GetParamName(index);
 }
 
 FFMixed getParameterDefault(unsigned int index)
 {
   FFMixed ret;
   ret.UIntValue = FF_FAIL;
-	if (s_pPrototype == NULL) {
-		FFResult dwRet = initialise();
-		if (dwRet == FF_FAIL) return ret;
-	}
-	return s_pPrototype->GetParamDefault(index);
+	CFreeFrameGLPlugin *prototype = getPrototype();
+	if (prototype == NULL) return ret;
+
+	return prototype->GetParamDefault(index);
 }
 
 FFResult getPluginCaps(unsigned int index)
@@ -154,10 +180,8 @@ FFResult getPluginCaps(unsigned int index)
 	int MinInputs = -1;
 	int MaxInputs = -1;
 
-	if (s_pPrototype == NULL) {
-		FFResult dwRet = initialise();
-		if (dwRet == FF_FAIL) return FF_FAIL;
-	}
+	CFreeFrameGLPlugin *prototype = getPrototype();
+	if (prototype == NULL) return FF_FAIL;
 
 	switch (index) {
 
@@ -176,19 +200,28 @@ FFResult getPluginCaps(unsigned int index)
   case FF_CAP_PROCESSOPENGL:
 		return FF_TRUE;
 
+  //FF_SETTIME moves the parameter ramps of every plugin (see
+  //FF_CAP_PARAMETERRAMPS), SetTime is only called on plugins that
+  //support it
   case FF_CAP_SETTIME:
-    if (s_pPrototype->GetTimeSupported())
-      return FF_TRUE;
-    else
-      return FF_FALSE;
+    return FF_TRUE;
+
+  case FF_CAP_PROCESSOPENGLBATCH:
+    return FF_TRUE;
+
+  case FF_CAP_SETPARAMETERS:
+    return FF_TRUE;
+
+  case FF_CAP_PARAMETERRAMPS:
+    return FF_TRUE;
 
 	case FF_CAP_MINIMUMINPUTFRAMES:
-		MinInputs = s_pPrototype->GetMinInputs();
+		MinInputs = prototype->GetMinInputs();
 		if (MinInputs < 0) return FF_FALSE;
 		return MinInputs;
 
 	case FF_CAP_MAXIMUMINPUTFRAMES:
-		MaxInputs = s_pPrototype->GetMaxInputs();
+		MaxInputs = prototype->GetMaxInputs();
 		if (MaxInputs < 0) return FF_FALSE;
 		return MaxInputs;
 
@@ -209,12 +242,10 @@ void *getExtendedInfo()
 
 unsigned int getParameterType(unsigned int index)
 {
-	if (s_pPrototype == NULL) {
-		FFResult dwRet = initialise();
-		if (dwRet == FF_FAIL) return FF_FAIL;
-	}
+	CFreeFrameGLPlugin *prototype = getPrototype();
+	if (prototype == NULL) return FF_FAIL;
 	
-	return s_pPrototype->GetParamType(index);
+	return prototype->GetParamType(index);
 }
 
 void *instantiateGL(const FFGLViewportStruct *pGLViewport)
@@ -223,13 +254,9 @@ void *instantiateGL(const FFGLViewportStruct *pGLViewport)
     return (void *)FF_FAIL;
 
   // If the plugin is not initialized, initialize it
-  if (s_pPrototype == NULL)
-  {
-		FFResult dwRet = initialise();
-
-	  if ((dwRet == FF_FAIL) || (s_pPrototype == NULL))
-      return (void *)FF_FAIL;
-	}
+  CFreeFrameGLPlugin *prototype = getPrototype();
+  if (prototype == NULL)
+    return (void *)FF_FAIL;
 		
 	//get the instantiate function pointer
   FPCREATEINSTANCEGL *pInstantiate = g_CurrPluginInfo->GetFactoryMethod();
@@ -246,10 +273,10 @@ void *instantiateGL(const FFGLViewportStruct *pGLViewport)
 	pInstance->m_pPlugin = pInstance;
 		
 	// Initializing instance with default values
-	for (unsigned int i = 0; i < s_pPrototype->GetNumParams(); ++i)
+	for (unsigned int i = 0; i < prototype->GetNumParams(); ++i)
   {
-		unsigned int pType = s_pPrototype->GetParamType(i);
-		FFMixed pDefault = s_pPrototype->GetParamDefault(i);
+		unsigned int pType = prototype->GetParamType(i);
+		FFMixed pDefault = prototype->GetParamDefault(i);
     if (pType == FF_TYPE_TEXT)
       dwRet = pInstance->SetTextParameter(i, (const char *)pDefault.PointerValue);
     else
@@ -283,6 +310,14 @@ FFResult deInstantiateGL(void *instanceID)
 	if (p != NULL)
   {
     p->DeInitGL();
+    p->DeInitBatchGL();
+
+    //PluginName is not null terminated
+    char name[17];
+    memcpy(name, g_CurrPluginInfo->GetPluginInfo()->PluginName, 16);
+    name[16] = 0;
+    p->GetGLResources().Report(name);
+
 		delete p;
 
 		return FF_SUCCESS;
@@ -292,6 +327,25 @@ FFResult deInstantiateGL(void *instanceID)
 }
 
 
+FFResult getGLMemoryUsage(CFreeFrameGLPlugin *p, FFGLMemoryUsageStruct *usage)
+{
+  if (usage == NULL)
+    return FF_FAIL;
+
+  if (p != NULL)
+  {
+    usage->NumObjects = p->GetGLResources().GetNumObjects();
+    usage->NumKiloBytes = (FFUInt32)(p->GetGLResources().GetNumBytes() / 1024);
+  }
+  else
+  {
+    usage->NumObjects = FFGLResourceTracker::GetGlobalNumObjects();
+    usage->NumKiloBytes = (FFUInt32)(FFGLResourceTracker::GetGlobalNumBytes() / 1024);
+  }
+
+  return FF_SUCCESS;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Implementation of plugMain, the one and only exposed function
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -366,6 +420,7 @@ FFResult deInstantiateGL(void *instanceID)
 		
 	case FF_SETPARAMETER:
 		if (pPlugObj != NULL) {
+      pPlugObj->CancelParameterRamp(((const SetParameterStruct*)inputValue.PointerValue)->ParameterNumber);
       if (getParameterType(((const SetParameterStruct*)inputValue.PointerValue)->ParameterNumber) == FF_TYPE_TEXT)
         retval.UIntValue = pPlugObj->SetTextParameter(((const SetParameterStruct*)inputValue.PointerValue)->ParameterNumber,
                                                       (const char *)((const SetParameterStruct*)inputValue.PointerValue)->NewParameterValue.PointerValue);
@@ -377,6 +432,25 @@ FFResult deInstantiateGL(void *instanceID)
 			retval.UIntValue = FF_FAIL;
 		break;
 	
+	case FF_SETPARAMETERS:
+		if (pPlugObj != NULL && inputValue.PointerValue != NULL) {
+      const SetParametersStruct *sps = (const SetParametersStruct *)inputValue.PointerValue;
+      pPlugObj->CancelParameterRamps(sps->parameters, sps->numParameters);
+      retval.UIntValue = pPlugObj->SetParameters(sps->parameters, sps->numParameters);
+    }
+		else
+			retval.UIntValue = FF_FAIL;
+		break;
+	
+	case FF_SETPARAMETERRAMPS:
+		if (pPlugObj != NULL && inputValue.PointerValue != NULL) {
+      const SetParameterRampsStruct *sprs = (const SetParameterRampsStruct *)inputValue.PointerValue;
+      retval.UIntValue = pPlugObj->SetParameterRamps(sprs->keyframes, sprs->numKeyframes);
+    }
+		else
+			retval.UIntValue = FF_FAIL;
+		break;
+	
 	case FF_GETPARAMETER:
 		if (pPlugObj != NULL) {
       if (getParameterType(inputValue.UIntValue) == FF_TYPE_TEXT)
@@ -403,6 +477,10 @@ FFResult deInstantiateGL(void *instanceID)
 			retval.UIntValue = FF_FAIL;
     break;
 	
+  case FF_GETGLMEMORYUSAGE:
+    retval.UIntValue = getGLMemoryUsage(pPlugObj, (FFGLMemoryUsageStruct *)inputValue.PointerValue);
+    break;
+
 	case FF_GETINPUTSTATUS:
 		if (pPlugObj != NULL)
 			retval.UIntValue = pPlugObj->GetInputStatus(inputValue.UIntValue);
@@ -423,12 +501,19 @@ FFResult deInstantiateGL(void *instanceID)
 			retval.UIntValue = FF_FAIL;
 		break;
 
+  case FF_PROCESSOPENGLBATCH:
+    if (pPlugObj != NULL && inputValue.PointerValue != NULL)
+      retval.UIntValue = pPlugObj->ProcessOpenGLBatch((ProcessOpenGLBatchStruct *)inputValue.PointerValue);
+    else
+      retval.UIntValue = FF_FAIL;
+    break;
+
   case FF_SETTIME:
     if (pPlugObj != NULL)
     {
       double *inputTime = (double *)inputValue.PointerValue;
       if (inputTime!=NULL)
-        retval.UIntValue = pPlugObj->SetTime(*inputTime);
+        retval.UIntValue = pPlugObj->SetHostTime(*inputTime);
       else
         retval.UIntValue = FF_FAIL;
     }
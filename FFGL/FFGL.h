@@ -91,10 +91,53 @@
 #define FF_DEINSTANTIATEGL     19
 #define FF_SETTIME             20
 
+// SDK extension, outside the range used by the FreeFrame specification.
+// inputValue.PointerValue points to a FFGLMemoryUsageStruct that is filled
+// with the GPU memory held by the instance, or by every instance of the
+// plugin when called with a NULL instanceID
+#define FF_GETGLMEMORYUSAGE    100
+
+// SDK extension. inputValue.PointerValue points to a
+// ProcessOpenGLBatchStruct: renders several frames, each with its own
+// inputs and parameter values, into the layers of a texture array in one
+// call. Hosts check FF_CAP_PROCESSOPENGLBATCH first and fall back to one
+// FF_PROCESSOPENGL per frame
+#define FF_PROCESSOPENGLBATCH  101
+
+// SDK extension. inputValue.PointerValue points to a SetParametersStruct:
+// sets several parameters of an instance in one call, as if each had been
+// set with FF_SETPARAMETER in order. Fails if any of them failed; the
+// others are set anyway. Hosts check FF_CAP_SETPARAMETERS first and fall
+// back to one FF_SETPARAMETER per value
+#define FF_SETPARAMETERS       102
+
+// SDK extension. inputValue.PointerValue points to a SetParameterRampsStruct:
+// gives parameters of an instance values to reach at a time on the clock
+// of FF_SETTIME. each FF_SETTIME then moves them in a straight line from
+// their current value towards their next keyframe (boolean and event
+// parameters jump when it is reached), so hosts can send a keyframe now
+// and then instead of a value every frame. a keyframe replaces the ones
+// already sent for the same parameter at its time or later, and
+// FF_SETPARAMETER or FF_SETPARAMETERS stop the ramp of the parameters they
+// set. hosts check FF_CAP_PARAMETERRAMPS first, and then send FF_SETTIME
+// before every frame. a plugin reporting FF_CAP_PARAMETERRAMPS reports
+// FF_CAP_SETTIME as well, so hosts that only send FF_SETTIME to plugins
+// asking for it move the ramps too
+#define FF_SETPARAMETERRAMPS   103
+
 // new plugin capabilities for FFGL
 #define FF_CAP_PROCESSOPENGL    4
 #define FF_CAP_SETTIME          5
 
+// SDK extension, see FF_PROCESSOPENGLBATCH
+#define FF_CAP_PROCESSOPENGLBATCH 100
+
+// SDK extension, see FF_SETPARAMETERS
+#define FF_CAP_SETPARAMETERS      101
+
+// SDK extension, see FF_SETPARAMETERRAMPS
+#define FF_CAP_PARAMETERRAMPS     102
+
 //FFGLViewportStruct (for InstantiateGL)
 typedef struct FFGLViewportStructTag
 {
@@ -109,6 +152,13 @@ typedef struct FFGLTextureStructTag
   GLuint Handle; //the actual texture handle, from glGenTextures()
 } FFGLTextureStruct;
 
+//FFGLMemoryUsageStruct (for GetGLMemoryUsage)
+typedef struct FFGLMemoryUsageStructTag
+{
+  FFUInt32 NumObjects; //live textures, framebuffers, renderbuffers, buffers and shaders
+  FFUInt32 NumKiloBytes; //approximate GPU memory held by those objects
+} FFGLMemoryUsageStruct;
+
 // ProcessOpenGLStruct
 typedef struct ProcessOpenGLStructTag {
   FFUInt32 numInputTextures;
@@ -122,5 +172,56 @@ typedef struct ProcessOpenGLStructTag {
   GLuint HostFBO; 
 } ProcessOpenGLStruct;
 
+// ProcessOpenGLBatchStruct (for FF_PROCESSOPENGLBATCH)
+typedef struct ProcessOpenGLBatchStructTag {
+  FFUInt32 numFrames;
+
+  //numInputTextures inputs per frame, the ones of frame i starting at
+  //inputTextures[i*numInputTextures]
+  FFUInt32 numInputTextures;
+  FFGLTextureStruct **inputTextures;
+
+  //optional, NULL keeps the current values. numParameters float values
+  //per frame, frame after frame, set before the frame renders. values of
+  //text parameters are ignored, the others stop their parameter's ramp
+  FFUInt32 numParameters;
+  const float *parameters;
+
+  //optional, NULL or the time of every frame (see FF_SETTIME)
+  const double *times;
+
+  //a GL_TEXTURE_2D_ARRAY_EXT, normally the size of the viewport the
+  //instance was created with. frame i is rendered into all of layer
+  //firstLayer+i, cleared to transparent black first
+  GLuint outputTexture;
+  FFUInt32 firstLayer;
+
+  //bound again when the call returns, as for ProcessOpenGLStruct
+  GLuint HostFBO;
+} ProcessOpenGLBatchStruct;
+
+// SetParametersStruct (for FF_SETPARAMETERS)
+typedef struct SetParametersStructTag {
+  FFUInt32 numParameters;
+
+  //as for FF_SETPARAMETER: float values in the bits of UIntValue, text in
+  //PointerValue
+  const SetParameterStruct *parameters;
+} SetParametersStruct;
+
+// ParameterKeyframeStruct (for SetParameterRampsStruct)
+typedef struct ParameterKeyframeStructTag {
+  FFUInt32 ParameterNumber; //text parameters can't be ramped
+  float Value;
+  double Time; //when Value is reached, in the time base of FF_SETTIME
+} ParameterKeyframeStruct;
+
+// SetParameterRampsStruct (for FF_SETPARAMETERRAMPS)
+typedef struct SetParameterRampsStructTag {
+  //the keyframes of one parameter in increasing time
+  FFUInt32 numKeyframes;
+  const ParameterKeyframeStruct *keyframes;
+} SetParameterRampsStruct;
+
 
 #endif
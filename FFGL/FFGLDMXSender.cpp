@@ -0,0 +1,292 @@
+//winsock2.h has to come before anything that pulls in windows.h
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#define FFGL_CLOSE_SOCKET closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define FFGL_CLOSE_SOCKET close
+#endif
+
+#include "FFGLDMXSender.h"
+#include <map>
+#include <random>
+#include <string.h>
+
+static const intptr_t NO_SOCKET = -1;
+
+static void PutShort(unsigned char *p, unsigned int value)
+{
+  p[0] = (unsigned char)(value>>8);
+  p[1] = (unsigned char)(value&0xff);
+}
+
+//the flags and length field of an E1.31 layer
+static void PutLayerLength(unsigned char *p, unsigned int length)
+{
+  PutShort(p, 0x7000 | length);
+}
+
+FFGLDMXSender::FFGLDMXSender()
+:m_protocol(FFGL_DMX_SACN),
+ m_socket(NO_SOCKET),
+ m_interval(0),
+ m_numPackets(0)
+{
+  //E1.31 wants a UUID per source
+  std::random_device random;
+  for (int i=0; i<16; i++)
+    m_cid[i] = (unsigned char)random();
+
+  m_cid[6] = (m_cid[6] & 0x0f) | 0x40; //version 4
+  m_cid[8] = (m_cid[8] & 0x3f) | 0x80; //variant
+}
+
+FFGLDMXSender::~FFGLDMXSender()
+{
+  Close();
+}
+
+int FFGLDMXSender::IsOpen() const
+{
+  return m_socket!=NO_SOCKET;
+}
+
+int FFGLDMXSender::Fail(const char *message)
+{
+  m_error = message;
+  Close();
+  return 0;
+}
+
+int FFGLDMXSender::Open(const FFGLPixelMap &map, const std::string &destination, const char *sourceName)
+{
+  Close();
+  m_error.clear();
+
+  m_protocol = map.GetProtocol();
+
+  uint32_t address = 0;
+  if (!destination.empty())
+  {
+    struct in_addr a;
+    if (inet_pton(AF_INET, destination.c_str(), &a)!=1)
+      return Fail("bad destination address");
+    address = a.s_addr;
+  }
+  else if (m_protocol==FFGL_DMX_ARTNET)
+  {
+    address = htonl(INADDR_BROADCAST);
+  }
+
+#ifdef _WIN32
+  WSADATA wsa;
+  if (WSAStartup(MAKEWORD(2, 2), &wsa)!=0)
+    return Fail("can't initialize winsock");
+#endif
+
+  m_socket = (intptr_t)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (m_socket==NO_SOCKET)
+    return Fail("can't create socket");
+
+  if (m_protocol==FFGL_DMX_ARTNET && destination.empty())
+  {
+    int broadcast = 1;
+    setsockopt(m_socket, SOL_SOCKET, SO_BROADCAST, (const char *)&broadcast, sizeof(broadcast));
+  }
+
+  //one packet per universe the map touches, in ascending order. pixels
+  //mostly come in runs on the same universe, so the last one is cached
+  //to keep large maps out of the std::map
+  std::map<unsigned int, unsigned int> index;
+  const uint32_t *destinations = map.GetDestinations();
+  size_t numPixels = map.GetNumPixels();
+  unsigned int lastUniverse = ~0u;
+  size_t i;
+
+  for (i=0; i<numPixels; i++)
+  {
+    unsigned int universe = destinations[i] / DMX_CHANNELS;
+    if (universe!=lastUniverse)
+    {
+      index[universe] = 0;
+      lastUniverse = universe;
+    }
+
+    //binary maps aren't checked channel by channel when they are loaded
+    if (destinations[i] % DMX_CHANNELS + 3 > DMX_CHANNELS)
+      return Fail("pixel channel out of range");
+  }
+
+  for (std::map<unsigned int, unsigned int>::iterator it=index.begin(); it!=index.end(); ++it)
+  {
+    if (m_protocol==FFGL_DMX_SACN && (it->first==0 || it->first>63999))
+      return Fail("sACN universes are 1..63999");
+    if (m_protocol==FFGL_DMX_ARTNET && it->first>32767)
+      return Fail("Art-Net universes end at 32767");
+
+    Universe u;
+    u.number = (unsigned short)it->first;
+    u.sequence = 0;
+
+    if (address!=0)
+      u.address = address;
+    else
+      u.address = htonl(0xefff0000 | u.number); //239.255.hi.lo
+
+    BuildHeader(u, sourceName);
+
+    it->second = (unsigned int)m_universes.size();
+    m_universes.push_back(u);
+  }
+
+  size_t header = m_protocol==FFGL_DMX_SACN ? SACN_HEADER_SIZE : ARTNET_HEADER_SIZE;
+  unsigned int lastIndex = 0;
+  lastUniverse = ~0u;
+
+  m_pixelUniverse.resize(numPixels);
+  m_pixelOffset.resize(numPixels);
+  for (i=0; i<numPixels; i++)
+  {
+    unsigned int universe = destinations[i] / DMX_CHANNELS;
+    if (universe!=lastUniverse)
+    {
+      lastIndex = index[universe];
+      lastUniverse = universe;
+    }
+
+    m_pixelUniverse[i] = lastIndex;
+    m_pixelOffset[i] = (unsigned int)(header + destinations[i] % DMX_CHANNELS);
+  }
+
+  m_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+    std::chrono::duration<double>(1.0 / map.GetRate()));
+  m_lastFrame = std::chrono::steady_clock::time_point();
+
+  return 1;
+}
+
+void FFGLDMXSender::Close()
+{
+  if (m_socket!=NO_SOCKET)
+  {
+    FFGL_CLOSE_SOCKET(m_socket);
+    m_socket = NO_SOCKET;
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+  }
+
+  m_universes.clear();
+  m_pixelUniverse.clear();
+  m_pixelOffset.clear();
+}
+
+void FFGLDMXSender::BuildHeader(Universe &u, const char *sourceName)
+{
+  if (m_protocol==FFGL_DMX_SACN)
+  {
+    u.packet.assign(SACN_HEADER_SIZE + DMX_CHANNELS, 0);
+    unsigned char *p = &u.packet[0];
+
+    //root layer
+    PutShort(p+0, 0x0010); //preamble size
+    PutShort(p+2, 0x0000); //postamble size
+    memcpy(p+4, "ASC-E1.17\0\0\0", 12);
+    PutLayerLength(p+16, (unsigned int)u.packet.size()-16);
+    p[21] = 0x04; //VECTOR_ROOT_E131_DATA
+    memcpy(p+22, m_cid, 16);
+
+    //framing layer
+    PutLayerLength(p+38, (unsigned int)u.packet.size()-38);
+    p[43] = 0x02; //VECTOR_E131_DATA_PACKET
+    size_t nameLength = strlen(sourceName);
+    memcpy(p+44, sourceName, nameLength<63 ? nameLength : 63); //64 bytes, null terminated
+    p[108] = 100; //priority
+    PutShort(p+113, u.number);
+
+    //DMP layer
+    PutLayerLength(p+115, (unsigned int)u.packet.size()-115);
+    p[117] = 0x02; //VECTOR_DMP_SET_PROPERTY
+    p[118] = 0xa1; //address and data type
+    PutShort(p+119, 0); //first property address
+    PutShort(p+121, 1); //address increment
+    PutShort(p+123, DMX_CHANNELS+1); //property count, the start code included
+    p[125] = 0; //start code
+  }
+  else
+  {
+    u.packet.assign(ARTNET_HEADER_SIZE + DMX_CHANNELS, 0);
+    unsigned char *p = &u.packet[0];
+
+    memcpy(p, "Art-Net\0", 8);
+    p[8] = 0x00; //OpDmx, little endian
+    p[9] = 0x50;
+    p[10] = 0; //protocol version 14
+    p[11] = 14;
+    p[13] = 0; //physical port
+    p[14] = (unsigned char)(u.number & 0xff); //sub-net and universe
+    p[15] = (unsigned char)((u.number>>8) & 0x7f); //net
+    PutShort(p+16, DMX_CHANNELS);
+  }
+}
+
+int FFGLDMXSender::ClaimFrame()
+{
+  if (m_socket==NO_SOCKET)
+    return 0;
+
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (now - m_lastFrame < m_interval)
+    return 0;
+
+  //the next interval starts when this frame was due rather than when it
+  //came, so a host frame rate that isn't a multiple of the map's rate
+  //still gets its full rate. after a pause it starts over from now
+  m_lastFrame += m_interval;
+  if (now - m_lastFrame >= m_interval)
+    m_lastFrame = now;
+
+  return 1;
+}
+
+int FFGLDMXSender::Send(const unsigned char *rgb, size_t numPixels)
+{
+  if (m_socket==NO_SOCKET)
+    return 0;
+
+  if (numPixels>m_pixelOffset.size())
+    numPixels = m_pixelOffset.size();
+
+  size_t i;
+  for (i=0; i<numPixels; i++)
+    memcpy(&m_universes[m_pixelUniverse[i]].packet[m_pixelOffset[i]], rgb + i*3, 3);
+
+  for (i=0; i<m_universes.size(); i++)
+  {
+    Universe &u = m_universes[i];
+
+    //Art-Net reserves sequence 0 for "not used"
+    u.sequence++;
+    if (m_protocol==FFGL_DMX_SACN)
+      u.packet[111] = u.sequence;
+    else
+      u.packet[12] = u.sequence!=0 ? u.sequence : ++u.sequence;
+
+    struct sockaddr_in to;
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_port = htons(m_protocol==FFGL_DMX_SACN ? SACN_PORT : ARTNET_PORT);
+    to.sin_addr.s_addr = u.address;
+
+    if (sendto(m_socket, (const char *)&u.packet[0], (int)u.packet.size(), 0, (const struct sockaddr *)&to, (socklen_t)sizeof(to))>0)
+      m_numPackets++;
+  }
+
+  return 1;
+}
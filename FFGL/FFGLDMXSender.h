@@ -0,0 +1,89 @@
+#ifndef FFGLDMXSENDER_H
+#define FFGLDMXSENDER_H
+
+#include <FFGLPixelMap.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+//FFGLDMXSender sends the pixels of a FFGLPixelMap as sACN (E1.31) or
+//Art-Net DMX universes over UDP. it does no GL and keeps no thread of its
+//own: it is meant to be driven from the consumer thread of a
+//FFGLReadback, so packetizing and sending stay off the render thread.
+//
+//to watch the output on the same machine, set the destination to
+//127.0.0.1 and run any sACN / Art-Net monitor
+class FFGLDMXSender
+{
+public:
+  FFGLDMXSender();
+  ~FFGLDMXSender();
+
+  //opens the socket and lays the universes out for map. destination is
+  //an IPv4 address; if empty sACN goes to the multicast group of each
+  //universe and Art-Net is broadcast on the local network. sourceName
+  //shows up in sACN monitors. returns 0 on failure, see GetError
+  int Open(const FFGLPixelMap &map, const std::string &destination, const char *sourceName);
+  void Close();
+
+  int IsOpen() const;
+  const std::string &GetError() const { return m_error; }
+
+  //1 if the map's interval has passed since the last frame it returned 1
+  //for, which then starts a new interval. DMX fixtures don't take more
+  //than ~44 updates a second, so the render thread asks before sampling
+  //and reading back a frame, and skips both for the frames in between
+  int ClaimFrame();
+
+  //writes the pixels into their universes and sends them. rgb holds
+  //three bytes per pixel of the map, in its order, pixels past the map's
+  //are ignored. every frame is sent, the rate is kept by ClaimFrame
+  int Send(const unsigned char *rgb, size_t numPixels);
+
+  size_t GetNumUniverses() const { return m_universes.size(); }
+  unsigned int GetNumPacketsSent() const { return m_numPackets; }
+
+private:
+  enum
+  {
+    SACN_PORT = 5568,
+    ARTNET_PORT = 6454,
+    SACN_HEADER_SIZE = 126,
+    ARTNET_HEADER_SIZE = 18,
+    DMX_CHANNELS = 512
+  };
+
+  struct Universe
+  {
+    unsigned short number;
+    unsigned char sequence;
+    uint32_t address; //network byte order
+    std::vector<unsigned char> packet; //header followed by 512 channels
+  };
+
+  int m_protocol;
+  intptr_t m_socket; //a SOCKET on windows, an fd elsewhere
+  std::string m_error;
+
+  std::vector<Universe> m_universes;
+
+  //for every pixel of the map, the universe and the packet offset its
+  //three channels go to
+  std::vector<unsigned int> m_pixelUniverse;
+  std::vector<unsigned int> m_pixelOffset;
+
+  unsigned char m_cid[16];
+  std::chrono::steady_clock::duration m_interval;
+  std::chrono::steady_clock::time_point m_lastFrame; //see ClaimFrame
+  unsigned int m_numPackets;
+
+  void BuildHeader(Universe &u, const char *sourceName);
+  int Fail(const char *message);
+
+  FFGLDMXSender(const FFGLDMXSender &);
+  FFGLDMXSender &operator=(const FFGLDMXSender &);
+};
+
+#endif
@@ -0,0 +1,257 @@
+#ifndef FFGLEFFECT_H
+#define FFGLEFFECT_H
+
+#include "FFGL.h"
+#include "FFGLLib.h"
+#include "FFGLExtensions.h"
+#include "FFGLResources.h"
+#include "FFGLShader.h"
+#include "FFGLPluginSDK.h"
+#include <chrono>
+
+//milliseconds since Start(). steady_clock is QueryPerformanceCounter on
+//windows, so this replaces the per plugin StartCounter/GetCounter pairs
+class FFGLStopwatch
+{
+public:
+  FFGLStopwatch() { Start(); }
+
+  void Start() { m_start = std::chrono::steady_clock::now(); }
+
+  double GetMilliseconds() const
+  {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+  }
+
+private:
+  std::chrono::steady_clock::time_point m_start;
+};
+
+//FFGLEffect is the base of the plugins that draw their input through one
+//shader. it holds what each of them used to carry a copy of: the
+//extensions, the shader and its background compile, the precision of the
+//intermediate copy, a stopwatch, and the copy/crop pass.
+//
+//a plugin derives from FFGLEffect<Plugin> and passes its shader sources to
+//the constructor. the base calls the hooks below on Plugin; they are
+//resolved at compile time, so a plugin declares only the ones it needs
+//(with the same signature, public or with FFGLEffect<Plugin> as a friend)
+//and the base's empty ones are used for the rest
+//
+//  bool InitEffect()          end of InitGL, false fails it
+//  void DeInitEffect()        start of DeInitGL
+//  bool ShaderLoaded()        the program has linked and is bound, look up
+//                             uniforms here. the default looks up tex0
+//  FFResult Render(ProcessOpenGLStruct *pGL)
+//                             a frame, once the shader has loaded
+//
+//until the shader has loaded ProcessOpenGL passes the input through, and
+//so it does for good if the shader failed
+template <class Plugin>
+class FFGLEffect : public CFreeFrameGLPlugin
+{
+public:
+  FFGLEffect(const char *vertexShader, const char *fragmentShader);
+
+  FFResult InitGL(const FFGLViewportStruct *vp);
+  FFResult DeInitGL();
+  FFResult ProcessOpenGL(ProcessOpenGLStruct *pGL);
+
+protected:
+  bool bInitialized; //the shader is compiling or has loaded
+  bool bShaderLoaded;
+
+  FFGLExtensions m_extensions;
+  FFGLTargetFormat m_targetFormat; //of the copies made by CopyInput
+  FFGLShader m_shader;
+  int m_inputTextureUniform;
+
+  //viewport, updated before every Render
+  float m_vpWidth;
+  float m_vpHeight;
+
+  //restarted by InitGL and once the shader has loaded
+  FFGLStopwatch m_stopwatch;
+
+  bool InitEffect() { return true; }
+  void DeInitEffect() {}
+  bool ShaderLoaded();
+  FFResult Render(ProcessOpenGLStruct *pGL) { return FF_SUCCESS; }
+
+  //copies left..right, bottom..top of the used area of input (0..1) into a
+  //texture of the input's size, stretching it. the copy keeps the precision
+  //of the input unless the plugin picked one in m_targetFormat, and is only
+  //reallocated when that or the input's size changes. must be called with
+  //no shader bound, or one that samples tex0 as it is; hostFbo and the
+  //viewport are restored afterwards.
+  //returns the copy, or input itself if no texture could be allocated
+  FFGLTextureStruct CopyInput(const FFGLTextureStruct &input, GLuint hostFbo,
+    float left = 0.0f, float bottom = 0.0f, float right = 1.0f, float top = 1.0f);
+
+private:
+  const char *m_vertexShader;
+  const char *m_fragmentShader;
+
+  FFGLTexture m_copy;
+  FFGLFramebuffer m_copyFbo;
+  GLuint m_copyAttached;
+
+  Plugin &GetPlugin() { return *static_cast<Plugin *>(this); }
+};
+
+template <class Plugin>
+FFGLEffect<Plugin>::FFGLEffect(const char *vertexShader, const char *fragmentShader)
+{
+  bInitialized = false;
+  bShaderLoaded = false;
+  m_inputTextureUniform = -1;
+  m_vpWidth = 0.0f;
+  m_vpHeight = 0.0f;
+
+  m_vertexShader = vertexShader;
+  m_fragmentShader = fragmentShader;
+  m_copyAttached = 0;
+}
+
+template <class Plugin>
+FFResult FFGLEffect<Plugin>::InitGL(const FFGLViewportStruct *vp)
+{
+  m_extensions.Initialize();
+  if (m_extensions.multitexture==0 || m_extensions.ARB_shader_objects==0)
+    return FF_FAIL;
+
+  m_vpWidth = (float)vp->width;
+  m_vpHeight = (float)vp->height;
+
+  m_stopwatch.Start();
+
+  //the program is compiled in the background so instantiating the plugin
+  //doesn't stall the host, see ProcessOpenGL
+  m_shader.SetExtensions(&m_extensions);
+  m_shader.SetResourceTracker(&m_glResources);
+  bInitialized = m_shader.BeginCompile(m_vertexShader, m_fragmentShader)!=0;
+  bShaderLoaded = false;
+  if (!bInitialized)
+    FFDebugMessage("FFGLEffect: the shader could not be compiled");
+
+  return GetPlugin().InitEffect() ? FF_SUCCESS : FF_FAIL;
+}
+
+template <class Plugin>
+FFResult FFGLEffect<Plugin>::DeInitGL()
+{
+  GetPlugin().DeInitEffect();
+
+  m_copyFbo.Release();
+  m_copy.Release();
+  m_copyAttached = 0;
+  m_shader.FreeGLResources();
+
+  bInitialized = false;
+  bShaderLoaded = false;
+
+  return FF_SUCCESS;
+}
+
+template <class Plugin>
+FFResult FFGLEffect<Plugin>::ProcessOpenGL(ProcessOpenGLStruct *pGL)
+{
+  if (!bShaderLoaded)
+  {
+    if (bInitialized && m_shader.IsCompileComplete())
+    {
+      if (m_shader.IsReady() && m_shader.BindShader())
+      {
+        bShaderLoaded = GetPlugin().ShaderLoaded();
+        m_shader.UnbindShader();
+      }
+
+      //FFGLShader has reported the errors, don't try again every frame
+      if (bShaderLoaded)
+        m_stopwatch.Start();
+      else
+        bInitialized = false;
+    }
+
+    if (!bShaderLoaded)
+    {
+      if (pGL->numInputTextures>0 && pGL->inputTextures[0]!=NULL)
+        FFGLDrawPassThrough(*(pGL->inputTextures[0]));
+      return FF_SUCCESS;
+    }
+  }
+
+  GetViewportSize(&m_vpWidth, &m_vpHeight);
+
+  return GetPlugin().Render(pGL);
+}
+
+template <class Plugin>
+bool FFGLEffect<Plugin>::ShaderLoaded()
+{
+  m_inputTextureUniform = m_shader.FindUniformIndex("tex0");
+  return true;
+}
+
+template <class Plugin>
+FFGLTextureStruct FFGLEffect<Plugin>::CopyInput(const FFGLTextureStruct &input, GLuint hostFbo,
+  float left, float bottom, float right, float top)
+{
+  GLint internalFormat = m_targetFormat.Select(m_extensions, input);
+  if (m_copy.GetHandle()==0 ||
+      m_copy.GetWidth()!=(GLsizei)input.Width ||
+      m_copy.GetHeight()!=(GLsizei)input.Height ||
+      m_copy.GetInternalFormat()!=internalFormat)
+  {
+    GLenum pixelFormat, pixelType;
+    FFGLGetPixelTransfer(internalFormat, &pixelFormat, &pixelType);
+
+    //a new texture may get the name of the old one, so it is attached
+    //again either way
+    m_copyAttached = 0;
+    if (!m_copy.Allocate(GL_TEXTURE_2D, internalFormat, input.Width, input.Height, pixelFormat, pixelType, &m_glResources))
+      return input;
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+
+  m_copyFbo.Create(m_extensions, &m_glResources);
+  m_extensions.glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_copyFbo.GetHandle());
+
+  //attaching makes the driver check the framebuffer again, so it is only
+  //done when the texture changed rather than for every copy
+  if (m_copyAttached!=m_copy.GetHandle())
+  {
+    m_extensions.glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, m_copy.GetHandle(), 0);
+    m_copyAttached = m_copy.GetHandle();
+  }
+
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glViewport(0, 0, input.Width, input.Height);
+
+  FFGLTexCoords maxCoords = GetMaxGLTexCoords(input);
+  float maxS = (float)maxCoords.s;
+  float maxT = (float)maxCoords.t;
+
+  glEnable(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, input.Handle);
+  FFGLDrawQuad(-1.0f, -1.0f, 1.0f, 1.0f, left * maxS, bottom * maxT, right * maxS, top * maxT);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glDisable(GL_TEXTURE_2D);
+
+  m_extensions.glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, hostFbo);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+  FFGLTextureStruct copy;
+  copy.Width = copy.HardwareWidth = input.Width;
+  copy.Height = copy.HardwareHeight = input.Height;
+  copy.Handle = m_copy.GetHandle();
+  return copy;
+}
+
+#endif
@@ -26,6 +26,34 @@ void FFGLExtensions::Initialize()
   InitMultitexture();
   InitARBShaderObjects();
   InitEXTFramebufferObject();
+  InitARBVertexBufferObject();
+  InitARBPixelBufferObject();
+  InitARBSync();
+  InitARBTimerQuery();
+  InitKHRParallelShaderCompile();
+  InitARBTextureFloat();
+  InitEXTTextureArray();
+}
+
+int FFGLExtensions::IsExtensionSupported(const char *name)
+{
+  const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+  if (extensions==NULL)
+    return 0;
+
+  //match whole names only, GL_foo must not match GL_foo_bar
+  size_t len = strlen(name);
+  const char *p = extensions;
+
+  while ((p = strstr(p, name))!=NULL)
+  {
+    if ((p==extensions || p[-1]==' ') && (p[len]==' ' || p[len]==0))
+      return 1;
+
+    p += len;
+  }
+
+  return 0;
 }
 
 void *FFGLExtensions::GetProcAddress(const char *name)
@@ -232,6 +260,158 @@ void FFGLExtensions::InitEXTFramebufferObject()
   EXT_framebuffer_object = 1;
 }
 
+void FFGLExtensions::InitARBVertexBufferObject()
+{
+  try
+  {
+
+  glBindBufferARB = (glBindBufferARBPROC)GetProcAddress("glBindBufferARB");
+  glDeleteBuffersARB = (glDeleteBuffersARBPROC)GetProcAddress("glDeleteBuffersARB");
+  glGenBuffersARB = (glGenBuffersARBPROC)GetProcAddress("glGenBuffersARB");
+  glBufferDataARB = (glBufferDataARBPROC)GetProcAddress("glBufferDataARB");
+  glBufferSubDataARB = (glBufferSubDataARBPROC)GetProcAddress("glBufferSubDataARB");
+  glGetBufferSubDataARB = (glGetBufferSubDataARBPROC)GetProcAddress("glGetBufferSubDataARB");
+  glMapBufferARB = (glMapBufferARBPROC)GetProcAddress("glMapBufferARB");
+  glUnmapBufferARB = (glUnmapBufferARBPROC)GetProcAddress("glUnmapBufferARB");
+
+  }
+  catch (...)
+  {
+    //not supported
+    ARB_vertex_buffer_object = 0;
+    return;
+  }
+
+  ARB_vertex_buffer_object = 1;
+}
+
+void FFGLExtensions::InitARBPixelBufferObject()
+{
+  //core since GL 2.1
+  const char *version = (const char *)glGetString(GL_VERSION);
+  double number = version!=NULL ? atof(version) : 0.0;
+
+  ARB_pixel_buffer_object =
+    ARB_vertex_buffer_object &&
+    (number>=2.1 ||
+     IsExtensionSupported("GL_ARB_pixel_buffer_object") ||
+     IsExtensionSupported("GL_EXT_pixel_buffer_object"));
+}
+
+void FFGLExtensions::InitARBSync()
+{
+  //optional, FFGLReadback falls back to counting frames without it
+  const char *version = (const char *)glGetString(GL_VERSION);
+  double number = version!=NULL ? atof(version) : 0.0;
+
+  if (number<3.2 && !IsExtensionSupported("GL_ARB_sync"))
+  {
+    ARB_sync = 0;
+    return;
+  }
+
+  try
+  {
+  glFenceSync = (glFenceSyncPROC)GetProcAddress("glFenceSync");
+  glClientWaitSync = (glClientWaitSyncPROC)GetProcAddress("glClientWaitSync");
+  glDeleteSync = (glDeleteSyncPROC)GetProcAddress("glDeleteSync");
+  }
+  catch (...)
+  {
+    //not supported
+    ARB_sync = 0;
+    return;
+  }
+
+  ARB_sync = 1;
+}
+
+void FFGLExtensions::InitARBTimerQuery()
+{
+  //optional, FFGLFrameGovernor keeps full resolution without it. core
+  //since GL 3.3, the EXT version only differs in the name of the 64 bit
+  //result call
+  const char *version = (const char *)glGetString(GL_VERSION);
+  double number = version!=NULL ? atof(version) : 0.0;
+
+  const char *getResult = NULL;
+  if (number>=3.3 || IsExtensionSupported("GL_ARB_timer_query"))
+    getResult = "glGetQueryObjectui64v";
+  else if (IsExtensionSupported("GL_EXT_timer_query"))
+    getResult = "glGetQueryObjectui64vEXT";
+
+  if (getResult==NULL || number<1.5)
+  {
+    ARB_timer_query = 0;
+    return;
+  }
+
+  try
+  {
+  glGenQueries = (glGenQueriesPROC)GetProcAddress("glGenQueries");
+  glDeleteQueries = (glDeleteQueriesPROC)GetProcAddress("glDeleteQueries");
+  glBeginQuery = (glBeginQueryPROC)GetProcAddress("glBeginQuery");
+  glEndQuery = (glEndQueryPROC)GetProcAddress("glEndQuery");
+  glGetQueryiv = (glGetQueryivPROC)GetProcAddress("glGetQueryiv");
+  glGetQueryObjectiv = (glGetQueryObjectivPROC)GetProcAddress("glGetQueryObjectiv");
+  glGetQueryObjectui64v = (glGetQueryObjectui64vPROC)GetProcAddress(getResult);
+  }
+  catch (...)
+  {
+    //not supported
+    ARB_timer_query = 0;
+    return;
+  }
+
+  ARB_timer_query = 1;
+}
+
+void FFGLExtensions::InitKHRParallelShaderCompile()
+{
+  //unlike the extensions above this one is optional (FFGLShader falls
+  //back to a worker thread without it), so check the extension string
+  //before asking for the entry point
+  const char *entryPoint = NULL;
+
+  if (IsExtensionSupported("GL_KHR_parallel_shader_compile"))
+    entryPoint = "glMaxShaderCompilerThreadsKHR";
+  else if (IsExtensionSupported("GL_ARB_parallel_shader_compile"))
+    entryPoint = "glMaxShaderCompilerThreadsARB";
+
+  if (entryPoint==NULL)
+  {
+    KHR_parallel_shader_compile = 0;
+    return;
+  }
+
+  try
+  {
+  glMaxShaderCompilerThreadsKHR = (glMaxShaderCompilerThreadsKHRPROC)GetProcAddress(entryPoint);
+  }
+  catch (...)
+  {
+    //not supported
+    KHR_parallel_shader_compile = 0;
+    return;
+  }
+
+  KHR_parallel_shader_compile = 1;
+}
+
+void FFGLExtensions::InitARBTextureFloat()
+{
+  //core since GL 3.0, where the extension string may not list it
+  GLint major = 0;
+  const char *version = (const char *)glGetString(GL_VERSION);
+  if (version!=NULL)
+    major = atoi(version);
+
+  ARB_texture_float =
+    major>=3 ||
+    IsExtensionSupported("GL_ARB_texture_float") ||
+    IsExtensionSupported("GL_ATI_texture_float");
+}
+
 #ifdef _WIN32
 void FFGLExtensions::InitWGLEXTSwapControl()
 {
@@ -250,3 +430,32 @@ void FFGLExtensions::InitWGLEXTSwapControl()
   WGL_EXT_swap_control = 1;
 }
 #endif
+
+void FFGLExtensions::InitEXTTextureArray()
+{
+  //core since GL 3.0, where the layer attachment lost its EXT suffix
+  GLint major = 0;
+  const char *version = (const char *)glGetString(GL_VERSION);
+  if (version!=NULL)
+    major = atoi(version);
+
+  if (major<3 && !IsExtensionSupported("GL_EXT_texture_array"))
+  {
+    EXT_texture_array = 0;
+    return;
+  }
+
+  try
+  {
+  glTexImage3D = (glTexImage3DPROC)GetProcAddress("glTexImage3D");
+  glFramebufferTextureLayerEXT = (glFramebufferTextureLayerEXTPROC)GetProcAddress(major>=3 ? "glFramebufferTextureLayer" : "glFramebufferTextureLayerEXT");
+  }
+  catch (...)
+  {
+    //not supported
+    EXT_texture_array = 0;
+    return;
+  }
+
+  EXT_texture_array = 1;
+}
@@ -341,6 +341,106 @@ typedef void (APIENTRY * glGetUniformfvARBPROC) (GLhandleARB_REPLACEMENT, GLint,
 typedef void (APIENTRY * glGetUniformivARBPROC) (GLhandleARB_REPLACEMENT, GLint, GLint *);
 typedef void (APIENTRY * glGetShaderSourceARBPROC) (GLhandleARB_REPLACEMENT, GLsizei, GLsizei *, GLcharARB *);
 
+///////////////////////
+// GL_ARB_vertex_buffer_object
+///////////////////////
+#define GL_ARRAY_BUFFER_ARB               0x8892
+#define GL_ELEMENT_ARRAY_BUFFER_ARB       0x8893
+#define GL_BUFFER_SIZE_ARB                0x8764
+#define GL_BUFFER_USAGE_ARB               0x8765
+#define GL_STREAM_DRAW_ARB                0x88E0
+#define GL_STREAM_READ_ARB                0x88E1
+#define GL_STREAM_COPY_ARB                0x88E2
+#define GL_STATIC_DRAW_ARB                0x88E4
+#define GL_STATIC_READ_ARB                0x88E5
+#define GL_STATIC_COPY_ARB                0x88E6
+#define GL_DYNAMIC_DRAW_ARB               0x88E8
+#define GL_DYNAMIC_READ_ARB               0x88E9
+#define GL_DYNAMIC_COPY_ARB               0x88EA
+#define GL_READ_ONLY_ARB                  0x88B8
+#define GL_WRITE_ONLY_ARB                 0x88B9
+#define GL_READ_WRITE_ARB                 0x88BA
+
+typedef void (APIENTRY * glBindBufferARBPROC) (GLenum target, GLuint buffer);
+typedef void (APIENTRY * glDeleteBuffersARBPROC) (GLsizei n, const GLuint *buffers);
+typedef void (APIENTRY * glGenBuffersARBPROC) (GLsizei n, GLuint *buffers);
+typedef void (APIENTRY * glBufferDataARBPROC) (GLenum target, ptrdiff_t size, const GLvoid *data, GLenum usage);
+typedef void (APIENTRY * glBufferSubDataARBPROC) (GLenum target, ptrdiff_t offset, ptrdiff_t size, const GLvoid *data);
+typedef void (APIENTRY * glGetBufferSubDataARBPROC) (GLenum target, ptrdiff_t offset, ptrdiff_t size, GLvoid *data);
+typedef GLvoid* (APIENTRY * glMapBufferARBPROC) (GLenum target, GLenum access);
+typedef GLboolean (APIENTRY * glUnmapBufferARBPROC) (GLenum target);
+
+///////////////////////
+// GL_ARB_pixel_buffer_object (uses the buffer object entry points above)
+///////////////////////
+#define GL_PIXEL_PACK_BUFFER_ARB          0x88EB
+#define GL_PIXEL_UNPACK_BUFFER_ARB        0x88EC
+
+///////////////////////
+// GL_ARB_sync
+///////////////////////
+#define GL_SYNC_GPU_COMMANDS_COMPLETE     0x9117
+#define GL_ALREADY_SIGNALED               0x911A
+#define GL_TIMEOUT_EXPIRED                0x911B
+#define GL_CONDITION_SATISFIED            0x911C
+#define GL_WAIT_FAILED                    0x911D
+#define GL_SYNC_FLUSH_COMMANDS_BIT        0x00000001
+
+typedef struct __GLsync *GLsync;
+typedef unsigned long long GLuint64_REPLACEMENT;	/* 64 bit timeout */
+
+typedef GLsync (APIENTRY * glFenceSyncPROC) (GLenum condition, GLbitfield flags);
+typedef GLenum (APIENTRY * glClientWaitSyncPROC) (GLsync sync, GLbitfield flags, GLuint64_REPLACEMENT timeout);
+typedef void (APIENTRY * glDeleteSyncPROC) (GLsync sync);
+
+///////////////////////
+// GL_ARB_timer_query (and the GL 1.5 query objects it uses)
+///////////////////////
+#define GL_CURRENT_QUERY                  0x8865
+#define GL_QUERY_RESULT                   0x8866
+#define GL_QUERY_RESULT_AVAILABLE         0x8867
+#define GL_TIME_ELAPSED                   0x88BF
+
+typedef void (APIENTRY * glGenQueriesPROC) (GLsizei n, GLuint *ids);
+typedef void (APIENTRY * glDeleteQueriesPROC) (GLsizei n, const GLuint *ids);
+typedef void (APIENTRY * glBeginQueryPROC) (GLenum target, GLuint id);
+typedef void (APIENTRY * glEndQueryPROC) (GLenum target);
+typedef void (APIENTRY * glGetQueryivPROC) (GLenum target, GLenum pname, GLint *params);
+typedef void (APIENTRY * glGetQueryObjectivPROC) (GLuint id, GLenum pname, GLint *params);
+typedef void (APIENTRY * glGetQueryObjectui64vPROC) (GLuint id, GLenum pname, GLuint64_REPLACEMENT *params);
+
+///////////////////////
+// GL_KHR_parallel_shader_compile
+///////////////////////
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR          0x91B1
+
+typedef void (APIENTRY * glMaxShaderCompilerThreadsKHRPROC) (GLuint count);
+
+///////////////////////
+// GL_ARB_texture_float / GL_ARB_half_float_pixel
+///////////////////////
+#define GL_RGBA32F_ARB                    0x8814
+#define GL_RGB32F_ARB                     0x8815
+#define GL_RGBA16F_ARB                    0x881A
+#define GL_RGB16F_ARB                     0x881B
+#define GL_HALF_FLOAT_ARB                 0x140B
+
+///////////////////////
+// GL_EXT_texture_array (and glTexImage3D, GL 1.2 but missing from the windows gl.h)
+///////////////////////
+#define GL_TEXTURE_2D_ARRAY_EXT           0x8C1A
+#define GL_TEXTURE_BINDING_2D_ARRAY_EXT   0x8C1D
+#define GL_MAX_ARRAY_TEXTURE_LAYERS_EXT   0x88FF
+
+typedef void (APIENTRY * glTexImage3DPROC) (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const GLvoid *pixels);
+typedef void (APIENTRY * glFramebufferTextureLayerEXTPROC) (GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer);
+
+//GL 1.2 packed pixels, missing from the windows gl.h
+#ifndef GL_UNSIGNED_INT_2_10_10_10_REV
+#define GL_UNSIGNED_INT_2_10_10_10_REV    0x8368
+#endif
+
 #ifdef _WIN32
 
 //////////////////
@@ -443,6 +543,17 @@ public:
   glGetUniformivARBPROC glGetUniformivARB;
   glGetShaderSourceARBPROC glGetShaderSourceARB;
 
+  //ARB_vertex_buffer_object
+  int ARB_vertex_buffer_object;
+  glBindBufferARBPROC glBindBufferARB;
+  glDeleteBuffersARBPROC glDeleteBuffersARB;
+  glGenBuffersARBPROC glGenBuffersARB;
+  glBufferDataARBPROC glBufferDataARB;
+  glBufferSubDataARBPROC glBufferSubDataARB;
+  glGetBufferSubDataARBPROC glGetBufferSubDataARB;
+  glMapBufferARBPROC glMapBufferARB;
+  glUnmapBufferARBPROC glUnmapBufferARB;
+
   //EXT_framebuffer_object
   int EXT_framebuffer_object;
   glBindFramebufferEXTPROC glBindFramebufferEXT;
@@ -463,6 +574,37 @@ public:
   glIsRenderbufferEXTPROC glIsRenderbufferEXT;
   glRenderbufferStorageEXTPROC glRenderbufferStorageEXT;
 
+  //ARB_pixel_buffer_object (no entry points of its own)
+  int ARB_pixel_buffer_object;
+
+  //ARB_sync
+  int ARB_sync;
+  glFenceSyncPROC glFenceSync;
+  glClientWaitSyncPROC glClientWaitSync;
+  glDeleteSyncPROC glDeleteSync;
+
+  //ARB_timer_query (or EXT_timer_query)
+  int ARB_timer_query;
+  glGenQueriesPROC glGenQueries;
+  glDeleteQueriesPROC glDeleteQueries;
+  glBeginQueryPROC glBeginQuery;
+  glEndQueryPROC glEndQuery;
+  glGetQueryivPROC glGetQueryiv;
+  glGetQueryObjectivPROC glGetQueryObjectiv;
+  glGetQueryObjectui64vPROC glGetQueryObjectui64v;
+
+  //KHR_parallel_shader_compile (or the ARB version of it)
+  int KHR_parallel_shader_compile;
+  glMaxShaderCompilerThreadsKHRPROC glMaxShaderCompilerThreadsKHR;
+
+  //ARB_texture_float (no entry points, float internal formats only)
+  int ARB_texture_float;
+
+  //EXT_texture_array, for FF_PROCESSOPENGLBATCH outputs
+  int EXT_texture_array;
+  glTexImage3DPROC glTexImage3D;
+  glFramebufferTextureLayerEXTPROC glFramebufferTextureLayerEXT;
+
 #ifdef _WIN32
   int WGL_EXT_swap_control;
   wglSwapIntervalEXTPROC wglSwapIntervalEXT;
@@ -471,10 +613,18 @@ public:
 
 private:
   void *GetProcAddress(const char *);
+  int IsExtensionSupported(const char *name);
   
   void InitMultitexture();
   void InitARBShaderObjects();
   void InitEXTFramebufferObject();
+  void InitARBVertexBufferObject();
+  void InitARBPixelBufferObject();
+  void InitARBSync();
+  void InitARBTimerQuery();
+  void InitKHRParallelShaderCompile();
+  void InitARBTextureFloat();
+  void InitEXTTextureArray();
 
 #ifdef _WIN32  
   void InitWGLEXTSwapControl();
@@ -2,7 +2,9 @@
 
 int FFGLFBO::Create(int _width,
                       int _height,
-                      FFGLExtensions &e)
+                      FFGLExtensions &e,
+                      FFGLResourceTracker *tracker,
+                      GLint internalFormat)
 {
   int glWidth = 1;
   while (glWidth<_width) glWidth*=2;
@@ -14,72 +16,54 @@ int FFGLFBO::Create(int _width,
   m_height = _height;
   m_glWidth = glWidth;
   m_glHeight = glHeight;
-  m_glPixelFormat = GL_RGBA8;
+  m_glPixelFormat = internalFormat;
   m_glTextureTarget = GL_TEXTURE_2D;
 
-  m_glTextureHandle = 0;
-  
-  e.glGenFramebuffersEXT(1, &m_fboHandle);
-
-  return 1;
-}
+  m_extensions = &e;
+  m_tracker = tracker;
 
-int IsTextureResident(GLuint handle)
-{
-  GLboolean b;
-
-  if (glAreTexturesResident(1, &handle, &b))  
-    return 1;
+  m_texture.Release();
+  m_depthBuffer.Release();
 
-  return 0;
+  return m_fbo.Create(e, m_tracker);
 }
 
 
 int FFGLFBO::BindAsRenderTarget(FFGLExtensions &e)
 {
   //make our fbo active
-  e.glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_fboHandle);
+  e.glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_fbo.GetHandle());
 
   //make sure there's a valid depth buffer attached to it
-  if (e.glIsRenderbufferEXT(m_depthBufferHandle)==0)
+  if (m_depthBuffer.GetHandle()==0)
   {
-    e.glGenRenderbuffersEXT(1, &m_depthBufferHandle);
-    e.glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, m_depthBufferHandle);
-    e.glRenderbufferStorageEXT( GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT24, m_glWidth, m_glHeight);
+    m_depthBuffer.Allocate(e, GL_DEPTH_COMPONENT24, m_glWidth, m_glHeight, m_tracker);
   
     //attach our depth buffer to the fbo
     e.glFramebufferRenderbufferEXT(
       GL_FRAMEBUFFER_EXT,
       GL_DEPTH_ATTACHMENT_EXT,
       GL_RENDERBUFFER_EXT,
-      m_depthBufferHandle);
+      m_depthBuffer.GetHandle());
   }
 
   //make sure we have a valid gl texture attached to it
-  if (!IsTextureResident(m_glTextureHandle))
+  if (m_texture.GetHandle()==0)
   {
-    //get a new one
-    glGenTextures(1,&m_glTextureHandle);
-
-    //bind it for some initialization
-    glBindTexture(m_glTextureTarget, m_glTextureHandle);
-
-    //this only works if the FBO pixel format
-    //is GL_RGBA8. other FBO pixel formats have to
-    //define their texture differently
-    GLuint pformat = GL_RGBA;
-    GLuint ptype = GL_UNSIGNED_BYTE;
+    //the storage is never uploaded to, but the pixel type still has
+    //to be one GL accepts for the internal format
+    GLenum pformat, ptype;
+    FFGLGetPixelTransfer(m_glPixelFormat, &pformat, &ptype);
 
-    glTexImage2D(
+    //get a new one, it is left bound for some initialization
+    m_texture.Allocate(
       m_glTextureTarget, //texture target
-      0, //mipmap level
       m_glPixelFormat, //gl internal pixel format
       m_glWidth, //gl width
       m_glHeight, //gl height
-      0, //no border
       pformat, //pixel format #2
       ptype, //pixel type
-      NULL); //null texture image data pointer
+      m_tracker);
 
     //for now, do not do mipmapping.
     //to do mipmapping, set this to 1, and after we've bound the texture,
@@ -108,7 +92,7 @@ int FFGLFBO::BindAsRenderTarget(FFGLExtensions &e)
       GL_FRAMEBUFFER_EXT,
       GL_COLOR_ATTACHMENT0_EXT,
       m_glTextureTarget,
-      m_glTextureHandle,
+      m_texture.GetHandle(),
       0);
   }  
 
@@ -172,7 +156,7 @@ FFGLTextureStruct FFGLFBO::GetTextureInfo()
   t.HardwareWidth = m_glWidth;
   t.HardwareHeight = m_glHeight;
   
-  t.Handle = m_glTextureHandle;
+  t.Handle = m_texture.GetHandle();
 
   return t;
 }
@@ -180,21 +164,7 @@ FFGLTextureStruct FFGLFBO::GetTextureInfo()
 
 void FFGLFBO::FreeResources(FFGLExtensions &e)
 {
-  if (m_fboHandle)
-  {
-    e.glDeleteFramebuffersEXT(1, &m_fboHandle);
-    m_fboHandle = 0;
-  }
-
-  if (m_depthBufferHandle)
-  {
-    e.glDeleteRenderBuffersEXT(1, &m_depthBufferHandle);
-    m_depthBufferHandle = 0;
-  }
-
-  if (m_glTextureHandle)
-  {
-    glDeleteTextures(1, &m_glTextureHandle);
-    m_glTextureHandle = 0;
-  }
+  m_fbo.Release();
+  m_depthBuffer.Release();
+  m_texture.Release();
 }
@@ -3,6 +3,7 @@
 
 #include <FFGL.h>
 #include <FFGLExtensions.h>
+#include <FFGLResources.h>
 
 class FFGLFBO
 {
@@ -14,12 +15,11 @@ public:
    m_glHeight(0),
    m_glPixelFormat(0),
    m_glTextureTarget(0),
-   m_glTextureHandle(0),
-   m_fboHandle(0),
-   m_depthBufferHandle(0)
+   m_extensions(NULL),
+   m_tracker(NULL)
   {}
 
-  int Create(int width, int height, FFGLExtensions &e);
+  int Create(int width, int height, FFGLExtensions &e, FFGLResourceTracker *tracker = NULL, GLint internalFormat = GL_RGBA8);
   int BindAsRenderTarget(FFGLExtensions &e);
   int UnbindAsRenderTarget(FFGLExtensions &e);
 
@@ -29,7 +29,7 @@ public:
   
   GLuint GetWidth() { return m_width; }
   GLuint GetHeight() { return m_height; }
-  GLuint GetFBOHandle() { return m_fboHandle; }
+  GLuint GetFBOHandle() { return m_fbo.GetHandle(); }
 
 protected:
   GLuint m_width;
@@ -38,9 +38,11 @@ protected:
   GLuint m_glHeight;
   GLuint m_glPixelFormat;
   GLuint m_glTextureTarget;
-  GLuint m_glTextureHandle;
-  GLuint m_fboHandle;
-  GLuint m_depthBufferHandle;
+  FFGLTexture m_texture;
+  FFGLFramebuffer m_fbo;
+  FFGLRenderbuffer m_depthBuffer;
+  FFGLExtensions *m_extensions;
+  FFGLResourceTracker *m_tracker;
 };
 
 #endif
@@ -0,0 +1,178 @@
+#include "FFGLFrameGovernor.h"
+
+const float FFGLFrameGovernor::SCALES[FFGLFrameGovernor::NUM_LEVELS] = { 1.0f, 0.75f, 0.5f };
+
+FFGLFrameGovernor::FFGLFrameGovernor()
+:m_extensions(NULL),
+ m_budget(0.0),
+ m_next(0),
+ m_numQueries(0),
+ m_active(-1),
+ m_level(0),
+ m_average(0.0),
+ m_numTimings(0),
+ m_overFrames(0),
+ m_underFrames(0)
+{
+  int i;
+  for (i=0; i<NUM_QUERIES; i++)
+  {
+    m_queries[i].id = 0;
+    m_queries[i].level = 0;
+  }
+}
+
+FFGLFrameGovernor::~FFGLFrameGovernor()
+{
+  FreeGLResources();
+}
+
+void FFGLFrameGovernor::SetExtensions(FFGLExtensions *e)
+{
+  m_extensions = e;
+}
+
+void FFGLFrameGovernor::SetBudget(double milliseconds)
+{
+  if (milliseconds<0.0)
+    milliseconds = 0.0;
+
+  if (milliseconds==m_budget)
+    return;
+
+  m_budget = milliseconds;
+
+  //a new budget is judged from fresh timings, at full resolution if off
+  SetLevel(m_budget>0.0 ? m_level : 0);
+}
+
+void FFGLFrameGovernor::BeginFrame()
+{
+  m_active = -1;
+
+  if (m_extensions==NULL || !m_extensions->ARB_timer_query)
+    return;
+
+  Collect();
+
+  if (m_budget<=0.0)
+    return;
+
+  //the queries are used round robin and finish in order. if all of them
+  //are pending the GPU is more than NUM_QUERIES frames behind and this
+  //frame goes untimed
+  if (m_numQueries==NUM_QUERIES)
+    return;
+
+  //time elapsed queries don't nest, and the host may be timing us
+  GLint current = 0;
+  m_extensions->glGetQueryiv(GL_TIME_ELAPSED, GL_CURRENT_QUERY, &current);
+  if (current!=0)
+    return;
+
+  int slot = (m_next + m_numQueries) % NUM_QUERIES;
+  Query &q = m_queries[slot];
+  if (q.id==0)
+  {
+    m_extensions->glGenQueries(1, &q.id);
+    if (q.id==0)
+      return;
+  }
+
+  m_extensions->glBeginQuery(GL_TIME_ELAPSED, q.id);
+  q.level = m_level;
+  m_numQueries++;
+  m_active = slot;
+}
+
+void FFGLFrameGovernor::EndFrame()
+{
+  if (m_active<0)
+    return;
+
+  m_extensions->glEndQuery(GL_TIME_ELAPSED);
+  m_active = -1;
+}
+
+void FFGLFrameGovernor::Collect()
+{
+  while (m_numQueries>0)
+  {
+    Query &q = m_queries[m_next];
+
+    GLint available = 0;
+    m_extensions->glGetQueryObjectiv(q.id, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+      return;
+
+    GLuint64_REPLACEMENT nanoseconds = 0;
+    m_extensions->glGetQueryObjectui64v(q.id, GL_QUERY_RESULT, &nanoseconds);
+
+    m_next = (m_next + 1) % NUM_QUERIES;
+    m_numQueries--;
+
+    //frames rendered at another scale say nothing about this one
+    if (m_budget>0.0 && q.level==m_level)
+      AddTiming((double)nanoseconds / 1000000.0);
+  }
+}
+
+void FFGLFrameGovernor::AddTiming(double milliseconds)
+{
+  //an exponential average, so one slow frame doesn't drop the scale
+  if (m_numTimings==0)
+    m_average = milliseconds;
+  else
+    m_average += (milliseconds - m_average) * 0.2;
+  m_numTimings++;
+
+  if (m_average>m_budget)
+  {
+    m_underFrames = 0;
+    if (++m_overFrames>=DROP_FRAMES && m_level<NUM_LEVELS-1)
+      SetLevel(m_level+1);
+    return;
+  }
+
+  m_overFrames = 0;
+  if (m_level==0)
+    return;
+
+  //the passes cost about their pixel count, and the next step up has to
+  //fit with room to spare or it would drop straight back
+  double up = SCALES[m_level-1] / SCALES[m_level];
+  if (m_average*up*up < m_budget*0.75)
+  {
+    if (++m_underFrames>=RAISE_FRAMES)
+      SetLevel(m_level-1);
+  }
+  else
+  {
+    m_underFrames = 0;
+  }
+}
+
+void FFGLFrameGovernor::SetLevel(int level)
+{
+  m_level = level;
+  m_numTimings = 0;
+  m_overFrames = 0;
+  m_underFrames = 0;
+}
+
+void FFGLFrameGovernor::FreeGLResources()
+{
+  int i;
+  for (i=0; i<NUM_QUERIES; i++)
+  {
+    if (m_queries[i].id!=0 && m_extensions!=NULL && m_extensions->ARB_timer_query)
+      m_extensions->glDeleteQueries(1, &m_queries[i].id);
+
+    m_queries[i].id = 0;
+  }
+
+  m_numQueries = 0;
+  m_next = 0;
+  m_active = -1;
+  SetLevel(0);
+}
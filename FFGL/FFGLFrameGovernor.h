@@ -0,0 +1,89 @@
+#ifndef FFGLFRAMEGOVERNOR_H
+#define FFGLFRAMEGOVERNOR_H
+
+#include <FFGL.h>
+#include <FFGLExtensions.h>
+
+//FFGLFrameGovernor keeps the GPU time of an instance's internal passes
+//within a budget by lowering the resolution they render at. a plugin
+//brackets the passes it governs with BeginFrame() and EndFrame(), renders
+//them at GetScale() of its output size, and scales the result up to the
+//host's framebuffer with a bilinear draw, so the host always gets the
+//size it asked for.
+//
+//the passes are timed with GL_TIME_ELAPSED queries that are collected
+//frames later, once the GPU has finished them, so measuring never stalls
+//the render thread. when the smoothed time is over budget for a few
+//frames the scale drops a step (1, 3/4, 1/2); it only comes back up once
+//the time the next step up is predicted to take (by its pixel count) has
+//stayed well under budget for a second or so, so the scale doesn't flip
+//back and forth around the budget.
+//
+//without timer queries, or with no budget set, the scale stays at 1 and
+//no queries are issued
+class FFGLFrameGovernor
+{
+public:
+  FFGLFrameGovernor();
+  ~FFGLFrameGovernor();
+
+  void SetExtensions(FFGLExtensions *e);
+
+  //GPU time the governed passes may take per frame, in milliseconds. 0
+  //switches the governor off and goes back to full resolution
+  void SetBudget(double milliseconds);
+  double GetBudget() const { return m_budget; }
+
+  //collects the timings the GPU has finished, steps the scale if needed
+  //and starts timing this frame. call before the first governed pass
+  void BeginFrame();
+
+  //stops timing this frame. call after the last governed pass
+  void EndFrame();
+
+  //the scale of the governed passes this frame: 1, 0.75 or 0.5
+  float GetScale() const { return SCALES[m_level]; }
+
+  //the smoothed GPU time of the governed passes at the current scale, in
+  //milliseconds. 0 until the first timing has come back
+  double GetMilliseconds() const { return m_average; }
+
+  void FreeGLResources();
+
+private:
+  enum
+  {
+    NUM_LEVELS = 3,
+    NUM_QUERIES = 4, //frames the GPU may be behind before timings are skipped
+    DROP_FRAMES = 4, //over budget this many timings in a row drops a step
+    RAISE_FRAMES = 60 //and well under it this many raises one
+  };
+
+  static const float SCALES[NUM_LEVELS];
+
+  struct Query
+  {
+    GLuint id;
+    int level; //the timing only counts if the level hasn't changed since
+  };
+
+  FFGLExtensions *m_extensions;
+  double m_budget;
+
+  Query m_queries[NUM_QUERIES];
+  int m_next; //oldest pending query, the one to collect first
+  int m_numQueries; //pending
+  int m_active; //query of this frame, -1 if it isn't timed
+
+  int m_level;
+  double m_average;
+  int m_numTimings; //at this level
+  int m_overFrames;
+  int m_underFrames;
+
+  void Collect();
+  void AddTiming(double milliseconds);
+  void SetLevel(int level);
+};
+
+#endif
@@ -47,6 +47,10 @@
 #ifndef __FFGLLIB_H__
 #define __FFGLLIB_H__
 
+#include <math.h>
+#include <stdio.h>
+#include <stdarg.h>
+
 //FFGLTexCoords
 typedef struct FFGLTexCoordsTag
 {
@@ -70,5 +74,113 @@ inline FFGLTexCoords GetMaxGLTexCoords(FFGLTextureStruct t)
   return texCoords;
 }
 
+//draws the used portion of a host texture over the whole viewport.
+//plugins use this to pass their input through while they're not
+//ready to render, e.g. while a shader is still compiling
+inline void FFGLDrawPassThrough(FFGLTextureStruct t)
+{
+  FFGLTexCoords maxCoords = GetMaxGLTexCoords(t);
+
+  glEnable(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, t.Handle);
+
+  glBegin(GL_QUADS);
+
+  //lower left
+  glTexCoord2d(0.0, 0.0);
+  glVertex2f(-1.0, -1.0);
+
+  //upper left
+  glTexCoord2d(0.0, maxCoords.t);
+  glVertex2f(-1.0, 1.0);
+
+  //upper right
+  glTexCoord2d(maxCoords.s, maxCoords.t);
+  glVertex2f(1.0, 1.0);
+
+  //lower right
+  glTexCoord2d(maxCoords.s, 0.0);
+  glVertex2f(1.0, -1.0);
+
+  glEnd();
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glDisable(GL_TEXTURE_2D);
+}
+
+//draws a quad from x0,y0 (lower left) to x1,y1 in clip space with the
+//texture coordinates s0,t0 to s1,t1. swapping s0 and s1 mirrors it. the
+//caller binds the texture or the shader
+inline void FFGLDrawQuad(GLfloat x0, GLfloat y0, GLfloat x1, GLfloat y1, GLfloat s0, GLfloat t0, GLfloat s1, GLfloat t1)
+{
+  glBegin(GL_QUADS);
+  glTexCoord2f(s0, t0);
+  glVertex2f(x0, y0);
+  glTexCoord2f(s0, t1);
+  glVertex2f(x0, y1);
+  glTexCoord2f(s1, t1);
+  glVertex2f(x1, y1);
+  glTexCoord2f(s1, t0);
+  glVertex2f(x1, y0);
+  glEnd();
+}
+
+//fills taps with the (offset in texels, weight) pairs of a gaussian for
+//FFGLSnippetGaussianBlur and returns how many it wrote. the first pair is
+//the centre texel; every further one stands for two neighbouring texels
+//on each side, sampled between them so the bilinear filter blends the
+//two in proportion to their weights. that halves the fetches of a plain
+//kernel. the kernel is cut at 3 sigma, or where maxTaps runs out, and
+//normalized. taps must have room for maxTaps pairs
+inline int FFGLGaussianTaps(float sigma, GLfloat *taps, int maxTaps)
+{
+  int radius = sigma>0.0f ? (int)ceil(sigma * 3.0f) : 0;
+  if (radius > (maxTaps-1) * 2)
+    radius = (maxTaps-1) * 2;
+
+  int numTaps = 1 + (radius+1) / 2;
+
+  taps[0] = 0.0f;
+  taps[1] = 1.0f;
+  double sum = 1.0;
+
+  int i;
+  for (i=1; i<numTaps; i++)
+  {
+    double k0 = (double)(i*2 - 1);
+    double k1 = (double)(i*2);
+    double w0 = exp(-k0*k0 / (2.0*sigma*sigma));
+    double w1 = i*2<=radius ? exp(-k1*k1 / (2.0*sigma*sigma)) : 0.0;
+
+    taps[i*2] = (GLfloat)((k0*w0 + k1*w1) / (w0 + w1));
+    taps[i*2+1] = (GLfloat)(w0 + w1);
+    sum += 2.0 * (w0 + w1);
+  }
+
+  for (i=0; i<numTaps; i++)
+    taps[i*2+1] = (GLfloat)(taps[i*2+1] / sum);
+
+  return numTaps;
+}
+
+//printf-style helper for SDK diagnostics. on windows the message goes
+//to the debugger output window, elsewhere it goes to stderr
+inline void FFDebugMessage(const char *format, ...)
+{
+  char message[512];
+
+  va_list args;
+  va_start(args, format);
+  vsnprintf(message, sizeof(message), format, args);
+  va_end(args);
+
+#ifdef _WIN32
+  OutputDebugStringA(message);
+  OutputDebugStringA("\n");
+#else
+  fprintf(stderr, "%s\n", message);
+#endif
+}
+
 #endif
 
@@ -0,0 +1,71 @@
+#ifndef FFGLLUMAKEYVARIANTS_H
+#define FFGLLUMAKEYVARIANTS_H
+
+#include <stdio.h>
+#include <FFGLShaderCache.h>
+#include <FFGLYUV.h>
+
+//the shader variants of plugins keying with FFGLSnippetLumaKey (Luma Key
+//and the fused Native Mapper). the options are compiled in, see
+//FFGLShaderCache, and a variant is found by its LK_VARIANT key:
+// - LK_MODE: how the key is applied, picked by FFGLLumaKeyMode.
+//   LK_MODE_LUMA is for the plugin's own main(), which writes the luma
+//   instead of keying (Luma Key's Auto Key histogram)
+// - LK_PREMULTIPLY: 0 or 1
+// - LK_FEATHER: also for the plugin's main(). LK_FEATHER_MASK writes only
+//   the key, LK_FEATHER_APPLY takes it from a blurred mask (Luma Key's
+//   Feather)
+// - the input format, see FFGLYUVInput::GetDefines
+#define LK_MODE_PASSTHROUGH (0)
+#define LK_MODE_HARD (1)
+#define LK_MODE_SOFT (2)
+#define LK_MODE_LUMA (3)
+
+#define LK_FEATHER_OFF (0)
+#define LK_FEATHER_MASK (1)
+#define LK_FEATHER_APPLY (2)
+
+#define LK_VARIANT( mode, premultiply, feather, format ) ((mode) | ((premultiply) << 2) | ((feather) << 3) | ((format) << 5))
+
+//the mode keying with the thresholds takes: nothing is keyed while the
+//end is (almost) 0, and a soft edge needs room between begin and end
+inline int FFGLLumaKeyMode(float thresholdBegin, float thresholdEnd)
+{
+  if (thresholdEnd<.01)
+    return LK_MODE_PASSTHROUGH;
+  if (thresholdBegin>=thresholdEnd)
+    return LK_MODE_HARD;
+  return LK_MODE_SOFT;
+}
+
+//the soft edge can't begin after it ends. returns the new begin if it
+//doesn't, and the one it replaces (previous) if it does
+inline float FFGLLumaKeyBegin(float begin, float end, float previous)
+{
+  return begin<=end ? begin : previous;
+}
+
+//queues the variant of the given options in cache, with its #defines
+inline void FFGLAddLumaKeyVariant(FFGLShaderCache &cache, int mode, int premultiply, int feather, int format)
+{
+  char defines[512];
+  snprintf(defines, sizeof(defines),
+    "%s"
+    "#define LK_MODE_PASSTHROUGH %d\n"
+    "#define LK_MODE_HARD %d\n"
+    "#define LK_MODE_SOFT %d\n"
+    "#define LK_MODE_LUMA %d\n"
+    "#define LK_MODE %d\n"
+    "#define LK_PREMULTIPLY %d\n"
+    "#define LK_FEATHER_OFF %d\n"
+    "#define LK_FEATHER_MASK %d\n"
+    "#define LK_FEATHER_APPLY %d\n"
+    "#define LK_FEATHER %d\n",
+    FFGLYUVInput::GetDefines(format),
+    LK_MODE_PASSTHROUGH, LK_MODE_HARD, LK_MODE_SOFT, LK_MODE_LUMA, mode, premultiply,
+    LK_FEATHER_OFF, LK_FEATHER_MASK, LK_FEATHER_APPLY, feather);
+
+  cache.Add(LK_VARIANT(mode, premultiply, feather, format), defines);
+}
+
+#endif
@@ -0,0 +1,130 @@
+#include "FFGLMappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FFGLMappedFile::FFGLMappedFile()
+:m_data(0),
+ m_size(0),
+#ifdef _WIN32
+ m_file(INVALID_HANDLE_VALUE),
+ m_mapping(0)
+#else
+ m_fd(-1)
+#endif
+{
+}
+
+FFGLMappedFile::~FFGLMappedFile()
+{
+  Close();
+}
+
+#ifdef _WIN32
+
+int FFGLMappedFile::Open(const char *path)
+{
+  Close();
+
+  m_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (m_file==INVALID_HANDLE_VALUE)
+    return 0;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(m_file, &size))
+  {
+    Close();
+    return 0;
+  }
+
+  //windows can't map an empty file
+  if (size.QuadPart==0)
+    return 1;
+
+  m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (m_mapping==NULL)
+  {
+    Close();
+    return 0;
+  }
+
+  m_data = (const unsigned char *)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+  if (m_data==NULL)
+  {
+    Close();
+    return 0;
+  }
+
+  m_size = (size_t)size.QuadPart;
+  return 1;
+}
+
+void FFGLMappedFile::Close()
+{
+  if (m_data!=NULL)
+    UnmapViewOfFile(m_data);
+
+  if (m_mapping!=NULL)
+    CloseHandle(m_mapping);
+
+  if (m_file!=INVALID_HANDLE_VALUE)
+    CloseHandle(m_file);
+
+  m_data = NULL;
+  m_size = 0;
+  m_mapping = NULL;
+  m_file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+int FFGLMappedFile::Open(const char *path)
+{
+  Close();
+
+  m_fd = open(path, O_RDONLY);
+  if (m_fd<0)
+    return 0;
+
+  struct stat st;
+  if (fstat(m_fd, &st)!=0)
+  {
+    Close();
+    return 0;
+  }
+
+  if (st.st_size==0)
+    return 1;
+
+  void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+  if (data==MAP_FAILED)
+  {
+    Close();
+    return 0;
+  }
+
+  m_data = (const unsigned char *)data;
+  m_size = (size_t)st.st_size;
+  return 1;
+}
+
+void FFGLMappedFile::Close()
+{
+  if (m_data!=NULL)
+    munmap((void *)m_data, m_size);
+
+  if (m_fd>=0)
+    close(m_fd);
+
+  m_data = NULL;
+  m_size = 0;
+  m_fd = -1;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef FFGLMAPPEDFILE_H
+#define FFGLMAPPEDFILE_H
+
+#include <stddef.h>
+
+//FFGLMappedFile maps a whole file read-only into memory. nothing is read
+//up front: the OS pages the file in as it is touched, so opening a large
+//file costs next to nothing and data that is only handed on (e.g. to
+//glTexSubImage2D) is never copied on the CPU side
+class FFGLMappedFile
+{
+public:
+  FFGLMappedFile();
+  ~FFGLMappedFile();
+
+  //returns 0 if the file can't be opened or mapped. an empty file opens
+  //fine, with no data
+  int Open(const char *path);
+  void Close();
+
+  const unsigned char *GetData() const { return m_data; }
+  size_t GetSize() const { return m_size; }
+
+private:
+  const unsigned char *m_data;
+  size_t m_size;
+
+#ifdef _WIN32
+  void *m_file; //HANDLE
+  void *m_mapping; //HANDLE
+#else
+  int m_fd;
+#endif
+
+  FFGLMappedFile(const FFGLMappedFile &);
+  FFGLMappedFile &operator=(const FFGLMappedFile &);
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef FFGLNATIVESCREENS_H
+#define FFGLNATIVESCREENS_H
+
+#include <vector>
+
+//a rectangle of a frame in 0..1, with bottom < top
+struct ROI
+{
+  float top;
+  float left;
+  float bottom;
+  float right;
+};
+
+//appends the screens of the EDGE Nightclub's 4096x1080 native frame to
+//screens, in 0..1 of that frame. Mirror Native, Native Mapper and
+//1080p to Native all map content onto this layout
+inline void FFGLGetNativeScreens(std::vector<ROI> &screens)
+{
+  ROI screen;
+
+  //back wall
+  screen.bottom = 1.0f - (512.0f / 1080.0f);
+  screen.top = 1.0f;
+  screen.left = 0.0f;
+  screen.right = .5f;
+  screens.push_back(screen);
+
+  //dj booth
+  screen.bottom = 1.0f - ((512.0f + 375.0f) / 1080.0f);
+  screen.top = 1.0f - (512.0f / 1080.0f);
+  screen.left = 649.0f / 4096.0f;
+  screen.right = screen.left + (750.0f / 4096.0f);
+  screens.push_back(screen);
+
+  //screen near bar
+  screen.bottom = 1.0f - (384.0f / 1080.0f);
+  screen.top = 1.0f;
+  screen.left = (2432.0f / 4096.0f);
+  screen.right = (3712.0f / 4096.0f);
+  screens.push_back(screen);
+
+  //outer wall L
+  screen.bottom = 0.0f;
+  screen.top = 384.0f / 1080.0f;
+  screen.left = 1792.0f / 4096.0f;
+  screen.right = screen.left + (640.0f / 4096.0f);
+  screens.push_back(screen);
+
+  //south wall l
+  screen.left = screen.right;
+  screen.right += 512.0f / 4096.0f;
+  screens.push_back(screen);
+
+  //south wall r
+  screen.left = screen.right;
+  screen.right += 512.0f / 4096.0f;
+  screens.push_back(screen);
+
+  //outer wall r
+  screen.left = screen.right;
+  screen.right += 640.0f / 4096.0f;
+  screens.push_back(screen);
+}
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef FFGLPARAMSCHEMA_H
+#define FFGLPARAMSCHEMA_H
+
+#include "FFGL.h"
+#include <stddef.h>
+#include <string>
+
+//parameters declared once, at compile time, instead of SetParamInfo calls
+//in the constructor and switch statements in SetFloatParameter and
+//GetFloatParameter:
+//
+//  struct MirrorNativeParams { float bottom; float left; ... };
+//
+//  static constexpr FFGLParam<MirrorNativeParams> s_params[] = {
+//    { "Bottom Bound", FF_TYPE_STANDARD, 0.0f, 0.0f, 1.0f, &MirrorNativeParams::bottom, NULL, NULL },
+//    ...
+//  };
+//  static_assert(FFGLParamsValid(s_params), "bad parameter schema");
+//  static const FFGLParamSchema<MirrorNativeParams> s_schema(s_params);
+//
+//every field is spelled out, even the NULL ones: FFGLParam has to stay an
+//aggregate for VS2015, so its members can't have default initializers.
+//the index of a parameter is its position in the array. the plugin hands
+//the schema to CFFGLPluginManager::SetParamSchema, which answers the
+//host's metadata calls through the virtual getters of FFGLParamTable (one
+//indirect call and an array index, rather than a list walk). the plugin
+//sets and gets values through the member pointers in place of a switch.
+//the array is checked at compile time, the lookups happen at run time.
+//the Values struct holds nothing but the current values, so a plugin can
+//take a snapshot of all of them with a copy
+
+//a parameter of a schema. the host sees every value as 0..1 (see the
+//FreeFrame specification), the plugin's member holds it mapped to
+//Min..Max
+template <class Values>
+struct FFGLParam
+{
+  char Name[17];              //at most 16 characters, zero padded
+  unsigned int Type;          //FF_TYPE_*
+  float Default;              //in Min..Max
+  float Min;                  //what the host's 0 maps to
+  float Max;                  //and its 1
+  float Values::*Value;       //the member holding the value, NULL for text
+  const char *Uniform;        //the uniform it is uploaded to, see SetParamUniform
+  std::string Values::*Text;  //the member of a FF_TYPE_TEXT parameter
+};
+
+template <class Values>
+constexpr bool FFGLParamValid(const FFGLParam<Values> &param)
+{
+  return param.Name[0]!=0 &&
+    (param.Type==FF_TYPE_TEXT ?
+      param.Text!=nullptr && param.Value==nullptr :
+      param.Value!=nullptr && param.Text==nullptr && param.Min<param.Max &&
+        param.Default>=param.Min && param.Default<=param.Max);
+}
+
+//every parameter has a name and a member of its type, and its default in
+//its range. for a static_assert next to the array
+template <class Values, size_t N>
+constexpr bool FFGLParamsValid(const FFGLParam<Values> (&params)[N], size_t first = 0)
+{
+  return first>=N || (FFGLParamValid(params[first]) && FFGLParamsValid(params, first + 1));
+}
+
+//what CFFGLPluginManager needs to know of a schema, whatever its Values
+class FFGLParamTable
+{
+public:
+  virtual unsigned int GetNumParams() const = 0;
+
+  //16 characters, not null terminated. NULL when index is out of range,
+  //like the FF_FAIL of GetType and GetDefault
+  virtual const char *GetName(unsigned int index) const = 0;
+  virtual unsigned int GetType(unsigned int index) const = 0;
+  virtual FFMixed GetDefault(unsigned int index) const = 0;
+  virtual const char *GetUniform(unsigned int index) const = 0;
+
+protected:
+  ~FFGLParamTable() {}
+};
+
+template <class Values>
+class FFGLParamSchema : public FFGLParamTable
+{
+public:
+  template <size_t N>
+  explicit FFGLParamSchema(const FFGLParam<Values> (&params)[N])
+  : m_params(params), m_numParams(N)
+  {
+  }
+
+  unsigned int GetNumParams() const { return m_numParams; }
+
+  const char *GetName(unsigned int index) const
+  {
+    return index<m_numParams ? m_params[index].Name : NULL;
+  }
+
+  unsigned int GetType(unsigned int index) const
+  {
+    return index<m_numParams ? m_params[index].Type : FF_FAIL;
+  }
+
+  FFMixed GetDefault(unsigned int index) const
+  {
+    FFMixed result;
+    result.PointerValue = NULL;
+
+    if (index>=m_numParams)
+    {
+      result.UIntValue = FF_FAIL;
+    }
+    else if (m_params[index].Type==FF_TYPE_TEXT)
+    {
+      //text parameters start out empty
+      result.PointerValue = (void *)"";
+    }
+    else
+    {
+      const FFGLParam<Values> &param = m_params[index];
+      float value = ToHost(param, param.Default);
+      result.UIntValue = *(FFUInt32 *)&value;
+    }
+
+    return result;
+  }
+
+  const char *GetUniform(unsigned int index) const
+  {
+    return index<m_numParams ? m_params[index].Uniform : NULL;
+  }
+
+  void SetDefaults(Values &values) const
+  {
+    for (unsigned int i = 0; i<m_numParams; i++)
+    {
+      if (m_params[i].Type==FF_TYPE_TEXT)
+        values.*m_params[i].Text = "";
+      else
+        values.*m_params[i].Value = m_params[i].Default;
+    }
+  }
+
+  //value is the host's, clamped to 0..1 and mapped to the range of the
+  //parameter
+  FFResult SetFloat(Values &values, unsigned int index, float value) const
+  {
+    if (index>=m_numParams || m_params[index].Type==FF_TYPE_TEXT)
+      return FF_FAIL;
+
+    const FFGLParam<Values> &param = m_params[index];
+    if (value<0.0f) value = 0.0f;
+    if (value>1.0f) value = 1.0f;
+    values.*param.Value = param.Min + value * (param.Max - param.Min);
+    return FF_SUCCESS;
+  }
+
+  //the value as the host sees it, 0..1
+  float GetFloat(const Values &values, unsigned int index) const
+  {
+    if (index>=m_numParams || m_params[index].Type==FF_TYPE_TEXT)
+      return 0.0f;
+
+    return ToHost(m_params[index], values.*m_params[index].Value);
+  }
+
+  FFResult SetText(Values &values, unsigned int index, const char *text) const
+  {
+    if (index>=m_numParams || m_params[index].Type!=FF_TYPE_TEXT)
+      return FF_FAIL;
+
+    values.*m_params[index].Text = text!=NULL ? text : "";
+    return FF_SUCCESS;
+  }
+
+  char *GetText(const Values &values, unsigned int index) const
+  {
+    if (index>=m_numParams || m_params[index].Type!=FF_TYPE_TEXT)
+      return (char *)FF_FAIL;
+
+    return (char *)(values.*m_params[index].Text).c_str();
+  }
+
+  //stores the values of a FF_SETPARAMETERS call, typed by the array in the
+  //same pass. the plugin applies side effects once, after all of them.
+  //fails if any of them failed
+  FFResult SetParameters(Values &values, const SetParameterStruct *params, unsigned int numParams) const
+  {
+    if (numParams>0 && params==NULL)
+      return FF_FAIL;
+
+    FFResult result = FF_SUCCESS;
+    for (unsigned int i = 0; i<numParams; i++)
+    {
+      unsigned int index = params[i].ParameterNumber;
+      FFResult set;
+      if (index<m_numParams && m_params[index].Type==FF_TYPE_TEXT)
+        set = SetText(values, index, (const char *)params[i].NewParameterValue.PointerValue);
+      else
+        set = SetFloat(values, index, *(float *)&params[i].NewParameterValue.UIntValue);
+      if (set!=FF_SUCCESS)
+        result = FF_FAIL;
+    }
+    return result;
+  }
+
+private:
+  const FFGLParam<Values> *m_params;
+  unsigned int m_numParams;
+
+  static float ToHost(const FFGLParam<Values> &param, float value)
+  {
+    return (value - param.Min) / (param.Max - param.Min);
+  }
+};
+
+#endif
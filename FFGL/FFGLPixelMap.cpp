@@ -0,0 +1,388 @@
+#include "FFGLPixelMap.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const unsigned int DMX_CHANNELS = 512;
+
+static const unsigned int BINARY_VERSION = 1;
+static const size_t BINARY_ALIGNMENT = 16;
+
+//the header of a binary pixel map, see FFGLPixelMap.h
+struct FFGLPixelMapHeader
+{
+  char magic[4]; //"FFPM"
+  uint32_t version;
+  uint32_t protocol;
+  float rate;
+  uint32_t numPixels;
+  uint32_t textureWidth;
+  uint32_t textureHeight;
+  uint32_t positionsOffset; //from the start of the file
+  uint32_t destinationsOffset;
+  uint32_t reserved[3];
+  char destination[64]; //null terminated, empty for none
+};
+
+static_assert(sizeof(FFGLPixelMapHeader)==112, "the binary pixel map header is 112 bytes");
+
+static size_t Align(size_t offset)
+{
+  return (offset + BINARY_ALIGNMENT - 1) & ~(BINARY_ALIGNMENT - 1);
+}
+
+//splits a line into whitespace separated words, dropping comments
+static void SplitWords(const std::string &line, std::vector<std::string> &words)
+{
+  words.clear();
+
+  size_t i = 0;
+  while (i<line.size())
+  {
+    while (i<line.size() && isspace((unsigned char)line[i]))
+      i++;
+
+    if (i>=line.size() || line[i]=='#')
+      break;
+
+    size_t start = i;
+    while (i<line.size() && !isspace((unsigned char)line[i]))
+      i++;
+
+    words.push_back(line.substr(start, i-start));
+  }
+}
+
+static int ToFloat(const std::string &word, float *value)
+{
+  char *end;
+  *value = (float)strtod(word.c_str(), &end);
+  return *end==0;
+}
+
+static int ToUInt(const std::string &word, unsigned int *value)
+{
+  char *end;
+  long l = strtol(word.c_str(), &end, 10);
+  *value = (unsigned int)l;
+  return *end==0 && l>=0;
+}
+
+const size_t FFGLPixelMap::TEXTURE_WIDTH;
+
+FFGLPixelMap::FFGLPixelMap()
+{
+  Clear();
+}
+
+void FFGLPixelMap::Clear()
+{
+  m_protocol = FFGL_DMX_SACN;
+  m_destination.clear();
+  m_rate = 44.0f;
+
+  m_numPixels = 0;
+  m_textureWidth = 0;
+  m_textureHeight = 0;
+  m_positionTexels = NULL;
+  m_destinations = NULL;
+
+  m_file.Close();
+  m_parsedTexels.clear();
+  m_parsedDestinations.clear();
+}
+
+int FFGLPixelMap::Load(const char *path)
+{
+  Clear();
+  m_error.clear();
+
+  if (!m_file.Open(path))
+  {
+    m_error = std::string("can't open ") + path;
+    return 0;
+  }
+
+  if (m_file.GetSize()>=4 && memcmp(m_file.GetData(), "FFPM", 4)==0)
+    return UseBinary();
+
+  //a text layout is parsed straight out of the mapping, which isn't
+  //needed afterwards
+  int result = ParseLines((const char *)m_file.GetData(), m_file.GetSize());
+  m_file.Close();
+
+  return result;
+}
+
+int FFGLPixelMap::UseBinary()
+{
+  const unsigned char *data = m_file.GetData();
+  size_t size = m_file.GetSize();
+
+  if (size<sizeof(FFGLPixelMapHeader))
+    return Fail(0, "truncated header");
+
+  FFGLPixelMapHeader header;
+  memcpy(&header, data, sizeof(header));
+
+  if (header.version!=BINARY_VERSION)
+    return Fail(0, "unsupported binary version");
+
+  if (header.protocol!=FFGL_DMX_SACN && header.protocol!=FFGL_DMX_ARTNET)
+    return Fail(0, "unknown protocol");
+
+  if (!(header.rate>0.0f))
+    return Fail(0, "bad rate");
+
+  if (memchr(header.destination, 0, sizeof(header.destination))==NULL)
+    return Fail(0, "bad destination");
+
+  size_t numPixels = header.numPixels;
+  size_t width = numPixels<TEXTURE_WIDTH ? numPixels : TEXTURE_WIDTH;
+  size_t height = width>0 ? (numPixels + width - 1) / width : 0;
+
+  if (header.textureWidth!=width || header.textureHeight!=height)
+    return Fail(0, "bad texture size");
+
+  //the arrays are used in place, so they have to be aligned and inside
+  //the file. the sizes are at most a few GB, no overflow in 64 bits
+  uint64_t positionsEnd = (uint64_t)header.positionsOffset + (uint64_t)width*height*4;
+  uint64_t destinationsEnd = (uint64_t)header.destinationsOffset + (uint64_t)numPixels*4;
+
+  if (header.positionsOffset<sizeof(header) || header.positionsOffset%BINARY_ALIGNMENT!=0 ||
+      header.destinationsOffset<sizeof(header) || header.destinationsOffset%BINARY_ALIGNMENT!=0 ||
+      positionsEnd>size || destinationsEnd>size)
+    return Fail(0, "truncated or corrupt arrays");
+
+  m_protocol = (int)header.protocol;
+  m_destination = header.destination;
+  m_rate = header.rate;
+
+  m_numPixels = numPixels;
+  m_textureWidth = (int)width;
+  m_textureHeight = (int)height;
+
+  if (numPixels>0)
+  {
+    m_positionTexels = data + header.positionsOffset;
+    m_destinations = (const uint32_t *)(data + header.destinationsOffset);
+  }
+
+  return 1;
+}
+
+int FFGLPixelMap::Save(const char *path)
+{
+  m_error.clear();
+
+  if (m_destination.size()>=sizeof(((FFGLPixelMapHeader *)0)->destination))
+  {
+    m_error = "destination too long";
+    return 0;
+  }
+
+  size_t positionsSize = (size_t)m_textureWidth * (size_t)m_textureHeight * 4;
+  size_t destinationsSize = m_numPixels * 4;
+
+  FFGLPixelMapHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, "FFPM", 4);
+  header.version = BINARY_VERSION;
+  header.protocol = (uint32_t)m_protocol;
+  header.rate = m_rate;
+  header.numPixels = (uint32_t)m_numPixels;
+  header.textureWidth = (uint32_t)m_textureWidth;
+  header.textureHeight = (uint32_t)m_textureHeight;
+  header.positionsOffset = (uint32_t)Align(sizeof(header));
+  header.destinationsOffset = (uint32_t)Align(header.positionsOffset + positionsSize);
+  memcpy(header.destination, m_destination.c_str(), m_destination.size());
+
+  FILE *f = NULL;
+#ifdef _WIN32
+  if (fopen_s(&f, path, "wb")!=0)
+    f = NULL;
+#else
+  f = fopen(path, "wb");
+#endif
+
+  if (f==NULL)
+  {
+    m_error = std::string("can't create ") + path;
+    return 0;
+  }
+
+  static const unsigned char padding[BINARY_ALIGNMENT] = { 0 };
+
+  int ok = fwrite(&header, sizeof(header), 1, f)==1;
+  ok = ok && fwrite(padding, 1, header.positionsOffset - sizeof(header), f)==header.positionsOffset - sizeof(header);
+
+  if (m_numPixels>0)
+  {
+    size_t gap = header.destinationsOffset - header.positionsOffset - positionsSize;
+    ok = ok && fwrite(m_positionTexels, 1, positionsSize, f)==positionsSize;
+    ok = ok && fwrite(padding, 1, gap, f)==gap;
+    ok = ok && fwrite(m_destinations, 1, destinationsSize, f)==destinationsSize;
+  }
+
+  if (fclose(f)!=0)
+    ok = 0;
+
+  if (!ok)
+    m_error = std::string("can't write ") + path;
+
+  return ok;
+}
+
+int FFGLPixelMap::Parse(const char *text, size_t length)
+{
+  Clear();
+  m_error.clear();
+
+  return ParseLines(text, length);
+}
+
+int FFGLPixelMap::ParseLines(const char *text, size_t length)
+{
+  const char *end = text + length;
+  std::vector<std::string> words;
+  int lineNumber = 0;
+
+  while (text<end)
+  {
+    const char *eol = (const char *)memchr(text, '\n', (size_t)(end-text));
+    if (eol==NULL)
+      eol = end;
+
+    std::string line(text, (size_t)(eol-text));
+    text = eol<end ? eol+1 : end;
+    lineNumber++;
+
+    SplitWords(line, words);
+    if (words.empty())
+      continue;
+
+    const std::string &keyword = words[0];
+
+    if (keyword=="protocol" && words.size()==2)
+    {
+      if (words[1]=="sacn")
+        m_protocol = FFGL_DMX_SACN;
+      else if (words[1]=="artnet")
+        m_protocol = FFGL_DMX_ARTNET;
+      else
+        return Fail(lineNumber, "unknown protocol");
+    }
+    else if (keyword=="destination" && words.size()==2)
+    {
+      m_destination = words[1];
+    }
+    else if (keyword=="rate" && words.size()==2)
+    {
+      if (!ToFloat(words[1], &m_rate) || m_rate<=0.0f)
+        return Fail(lineNumber, "bad rate");
+    }
+    else if (keyword=="pixel" && words.size()==5)
+    {
+      unsigned int universe, channel;
+      float x, y;
+
+      if (!ToUInt(words[1], &universe) || !ToUInt(words[2], &channel) ||
+          !ToFloat(words[3], &x) || !ToFloat(words[4], &y))
+        return Fail(lineNumber, "bad pixel");
+
+      if (!AddPixel(universe, channel, x, y))
+        return Fail(lineNumber, "pixel out of range");
+    }
+    else if (keyword=="strip" && words.size()==8)
+    {
+      unsigned int universe, channel, count;
+      float x0, y0, x1, y1;
+
+      if (!ToUInt(words[1], &universe) || !ToUInt(words[2], &channel) || !ToUInt(words[3], &count) ||
+          !ToFloat(words[4], &x0) || !ToFloat(words[5], &y0) ||
+          !ToFloat(words[6], &x1) || !ToFloat(words[7], &y1))
+        return Fail(lineNumber, "bad strip");
+
+      for (unsigned int i=0; i<count; i++)
+      {
+        float t = count>1 ? (float)i / (float)(count-1) : 0.0f;
+
+        if (channel+2>DMX_CHANNELS)
+        {
+          universe++;
+          channel = 1;
+        }
+
+        if (!AddPixel(universe, channel, x0 + (x1-x0)*t, y0 + (y1-y0)*t))
+          return Fail(lineNumber, "strip out of range");
+
+        channel += 3;
+      }
+    }
+    else
+    {
+      return Fail(lineNumber, "unknown statement");
+    }
+  }
+
+  UpdateParsed();
+  return 1;
+}
+
+int FFGLPixelMap::AddPixel(unsigned int universe, unsigned int channel, float x, float y)
+{
+  if (universe>63999 || channel<1 || channel+2>DMX_CHANNELS)
+    return 0;
+
+  if (x<0.0f) x = 0.0f;
+  if (x>1.0f) x = 1.0f;
+  if (y<0.0f) y = 0.0f;
+  if (y>1.0f) y = 1.0f;
+
+  unsigned int fx = (unsigned int)(x * 65535.0f + 0.5f);
+  unsigned int fy = (unsigned int)(y * 65535.0f + 0.5f);
+
+  m_parsedTexels.push_back((unsigned char)(fx>>8));
+  m_parsedTexels.push_back((unsigned char)(fx&0xff));
+  m_parsedTexels.push_back((unsigned char)(fy>>8));
+  m_parsedTexels.push_back((unsigned char)(fy&0xff));
+
+  m_parsedDestinations.push_back(universe*DMX_CHANNELS + channel-1);
+  return 1;
+}
+
+//points the accessors at the parsed arrays, the texels padded out to
+//whole rows of the texture
+void FFGLPixelMap::UpdateParsed()
+{
+  m_numPixels = m_parsedDestinations.size();
+  m_textureWidth = (int)(m_numPixels<TEXTURE_WIDTH ? m_numPixels : TEXTURE_WIDTH);
+  m_textureHeight = m_textureWidth>0 ? (int)((m_numPixels + m_textureWidth - 1) / m_textureWidth) : 0;
+
+  m_parsedTexels.resize((size_t)m_textureWidth * (size_t)m_textureHeight * 4, 0);
+
+  m_positionTexels = m_parsedTexels.empty() ? NULL : &m_parsedTexels[0];
+  m_destinations = m_parsedDestinations.empty() ? NULL : &m_parsedDestinations[0];
+}
+
+//line is 0 for errors in a binary map
+int FFGLPixelMap::Fail(int line, const char *message)
+{
+  if (line>0)
+  {
+    char location[32];
+    snprintf(location, sizeof(location), "line %d: ", line);
+    m_error = std::string(location) + message;
+  }
+  else
+  {
+    m_error = message;
+  }
+
+  std::string error = m_error;
+  Clear();
+  m_error = error;
+
+  return 0;
+}
@@ -0,0 +1,111 @@
+#ifndef FFGLPIXELMAP_H
+#define FFGLPIXELMAP_H
+
+#include <FFGLMappedFile.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//DMX protocols a pixel map can be sent with, see FFGLDMXSender
+enum
+{
+  FFGL_DMX_SACN,   //E1.31, universes 1..63999
+  FFGL_DMX_ARTNET  //Art-Net, universes (port addresses) 0..32767
+};
+
+//FFGLPixelMap is the layout of DMX addressed LED fixtures over a video
+//frame. it is read from a text file with one statement per line:
+//
+//  # comment
+//  protocol sacn|artnet
+//  destination 192.168.0.50     (optional, see FFGLDMXSender::Open)
+//  rate 44                      (optional, packets per second)
+//  pixel <universe> <channel> <x> <y>
+//  strip <universe> <channel> <count> <x0> <y0> <x1> <y1>
+//
+//a strip is count pixels spread evenly from x0,y0 to x1,y1. pixels take
+//three consecutive channels; one that doesn't fit in the rest of its
+//universe starts over at channel 1 of the next one, the way most pixel
+//controllers count.
+//
+//layouts with a lot of pixels take a while to parse, so a map can also be
+//saved in a binary form (Save) which Load maps into memory as is. there
+//is nothing to parse: the header is checked and the arrays are used in
+//place, so loading costs about as much as paging the file in. the format,
+//all little endian:
+//
+//  header          see FFGLPixelMapHeader in FFGLPixelMap.cpp, starts
+//                  with the magic "FFPM"
+//  positions       GetTextureWidth*GetTextureHeight RGBA8 texels, the
+//                  sample positions ready for glTexSubImage2D
+//  destinations    a uint32 per pixel, universe*512 + channel-1
+//
+//both arrays start on a 16 byte boundary. PixelMapConverter (next to the
+//Mirror Native plugins) turns a text layout into a binary one
+class FFGLPixelMap
+{
+public:
+  FFGLPixelMap();
+
+  //loads a text or binary layout. returns 0 and leaves the map empty if
+  //the file can't be read or has an error, see GetError
+  int Load(const char *path);
+  int Parse(const char *text, size_t length);
+  void Clear();
+
+  //writes the map in the binary form. returns 0 on failure
+  int Save(const char *path);
+
+  const std::string &GetError() const { return m_error; }
+
+  int GetProtocol() const { return m_protocol; }
+  const std::string &GetDestination() const { return m_destination; }
+  float GetRate() const { return m_rate; }
+
+  size_t GetNumPixels() const { return m_numPixels; }
+
+  //the pixels are sampled into a texture of this size, pixel i at
+  //column i%width of row i/width
+  int GetTextureWidth() const { return m_textureWidth; }
+  int GetTextureHeight() const { return m_textureHeight; }
+
+  //the sample positions as GL_RGBA8 texels, GetTextureWidth*
+  //GetTextureHeight of them: x and y as 16 bit fixed point split over rg
+  //and ba, so the map doesn't need float textures
+  const unsigned char *GetPositionTexels() const { return m_positionTexels; }
+
+  //where each pixel's three channels go, universe*512 + channel-1
+  const uint32_t *GetDestinations() const { return m_destinations; }
+
+private:
+  static const size_t TEXTURE_WIDTH = 256;
+
+  int m_protocol;
+  std::string m_destination;
+  float m_rate;
+  std::string m_error;
+
+  size_t m_numPixels;
+  int m_textureWidth;
+  int m_textureHeight;
+
+  //point into m_file for a binary map, into the vectors for a parsed one
+  const unsigned char *m_positionTexels;
+  const uint32_t *m_destinations;
+
+  FFGLMappedFile m_file;
+  std::vector<unsigned char> m_parsedTexels;
+  std::vector<uint32_t> m_parsedDestinations;
+
+  int UseBinary();
+  int ParseLines(const char *text, size_t length);
+  int AddPixel(unsigned int universe, unsigned int channel, float x, float y);
+  void UpdateParsed();
+  int Fail(int line, const char *message);
+
+  FFGLPixelMap(const FFGLPixelMap &);
+  FFGLPixelMap &operator=(const FFGLPixelMap &);
+};
+
+#endif
@@ -24,41 +24,67 @@
 // CFFGLPluginManager constructor and destructor
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+CFFGLPluginManager::ParamTable CFFGLPluginManager::s_moduleParams;
+std::atomic<bool> CFFGLPluginManager::s_moduleParamsShared(false);
+
 CFFGLPluginManager::CFFGLPluginManager()
 {
 	m_iMinInputs = 0;
 	m_iMaxInputs = 0;
   m_timeSupported = 0;
 
-	m_NParams = 0;
-	m_pFirst = NULL;
-	m_pLast = NULL;
+	m_pSchema = NULL;
+
+	// every object of the plugin class declares the same parameters, only the prototype builds them
+	if (s_moduleParamsShared.load(std::memory_order_acquire)) {
+		m_pOwnParams = NULL;
+		m_pParams = &s_moduleParams;
+	} else {
+		m_pOwnParams = new ParamTable;
+		m_pParams = m_pOwnParams;
+	}
 }
 
 CFFGLPluginManager::~CFFGLPluginManager()
 {
-	if (m_pFirst != NULL)
-  {
-		ParamInfo* pCurr = m_pFirst;
-		ParamInfo* pNext = m_pFirst;
+	delete m_pOwnParams;
 
-		while (pCurr != NULL)
-    {
-			pNext = pCurr->pNext;
+	m_pOwnParams = NULL;
+	m_pParams = NULL;
+}
+
+CFFGLPluginManager::ParamTable::~ParamTable()
+{
+	for (size_t i = 0; i < Params.size(); ++i) {
+		if (Params[i].StrDefaultValue != NULL) free(Params[i].StrDefaultValue);
+		if (Params[i].UniformName != NULL) free(Params[i].UniformName);
+	}
+}
 
-			if ( (pCurr->dwType == FF_TYPE_TEXT) &&
-				 (pCurr->StrDefaultValue != NULL) )
-			{
-				free(pCurr->StrDefaultValue);
-			}
+const CFFGLPluginManager::ParamInfo* CFFGLPluginManager::ParamTable::Find(unsigned int dwIndex) const
+{
+	// plugins declare their parameters in order, so the index is usually the position
+	if (dwIndex < Params.size() && Params[dwIndex].ID == dwIndex)
+		return &Params[dwIndex];
 
-			delete pCurr;
-			pCurr = pNext;
-		}
+	for (size_t i = 0; i < Params.size(); ++i) {
+		if (Params[i].ID == dwIndex) return &Params[i];
 	}
+	return NULL;
+}
+
+void CFFGLPluginManager::ShareParamInfo()
+{
+	if (m_pOwnParams == NULL || s_moduleParamsShared.load(std::memory_order_acquire))
+		return;
 
-	m_pFirst = NULL;
-	m_pLast = NULL;
+	// called under the prototype's lock, before any other object of the class exists
+	s_moduleParams.Params.swap(m_pOwnParams->Params);
+	delete m_pOwnParams;
+	m_pOwnParams = NULL;
+	m_pParams = &s_moduleParams;
+
+	s_moduleParamsShared.store(true, std::memory_order_release);
 }
 
 
@@ -75,69 +101,53 @@ void CFFGLPluginManager::SetMaxInputs(unsigned int iMaxInputs)
 	m_iMaxInputs = iMaxInputs;
 }
 
-void CFFGLPluginManager::SetParamInfo(unsigned int pIndex, const char* pchName, unsigned int pType, float fDefaultValue)
+CFFGLPluginManager::ParamInfo* CFFGLPluginManager::AddParamInfo(unsigned int dwIndex, const char* pchName, unsigned int dwType)
 {
-	ParamInfo* pInfo = new ParamInfo;
-	pInfo->ID = pIndex;
+	// the module's table is already complete
+	if (m_pOwnParams == NULL) return NULL;
+
+	ParamInfo info;
+	info.ID = dwIndex;
 	
 	bool bEndFound = false;
 	for (int i = 0; i < 16; ++i) {
 		if (pchName[i] == 0) bEndFound = true;
-		pInfo->Name[i] = (bEndFound) ?  0 : pchName[i];
+		info.Name[i] = (bEndFound) ?  0 : pchName[i];
 	}
 	
-	pInfo->dwType = pType;
+	info.dwType = dwType;
+	info.DefaultValue = 0;
+	info.StrDefaultValue = NULL;
+	info.UniformName = NULL;
+
+	m_pOwnParams->Params.push_back(info);
+	return &m_pOwnParams->Params.back();
+}
+
+void CFFGLPluginManager::SetParamInfo(unsigned int pIndex, const char* pchName, unsigned int pType, float fDefaultValue)
+{
+	ParamInfo* pInfo = AddParamInfo(pIndex, pchName, pType);
+	if (pInfo == NULL) return;
+
 	if (fDefaultValue > 1.0) fDefaultValue = 1.0;
 	if (fDefaultValue < 0.0) fDefaultValue = 0.0;
 	pInfo->DefaultValue = fDefaultValue;
-	pInfo->StrDefaultValue = NULL;
-	pInfo->pNext = NULL;
-	if (m_pFirst == NULL) m_pFirst = pInfo; 
-	if (m_pLast != NULL) m_pLast->pNext = pInfo;
-	m_pLast = pInfo;
-	m_NParams++;
 }
 
 void CFFGLPluginManager::SetParamInfo(unsigned int pIndex, const char* pchName, unsigned int pType, bool bDefaultValue)
 {
-	ParamInfo* pInfo = new ParamInfo;
-	pInfo->ID = pIndex;
-	
-	bool bEndFound = false;
-	for (int i = 0; i < 16; ++i) {
-		if (pchName[i] == 0) bEndFound = true;
-		pInfo->Name[i] = (bEndFound) ?  0 : pchName[i];
-	}
-	
-	pInfo->dwType = pType;
+	ParamInfo* pInfo = AddParamInfo(pIndex, pchName, pType);
+	if (pInfo == NULL) return;
+
 	pInfo->DefaultValue = bDefaultValue ? 1.0f : 0.0f;
-	pInfo->StrDefaultValue = NULL;
-	pInfo->pNext = NULL;
-	if (m_pFirst == NULL) m_pFirst = pInfo; 
-	if (m_pLast != NULL) m_pLast->pNext = pInfo;
-	m_pLast = pInfo;
-	m_NParams++;
 }
 
 void CFFGLPluginManager::SetParamInfo(unsigned int dwIndex, const char* pchName, unsigned int dwType, const char* pchDefaultValue)
 {
-	ParamInfo* pInfo = new ParamInfo;
-	pInfo->ID = dwIndex;
-	
-	bool bEndFound = false;
-	for (int i = 0; i < 16; ++i) {
-		if (pchName[i] == 0) bEndFound = true;
-		pInfo->Name[i] = (bEndFound) ?  0 : pchName[i];
-	}
+	ParamInfo* pInfo = AddParamInfo(dwIndex, pchName, dwType);
+	if (pInfo == NULL) return;
 
-	pInfo->dwType = dwType;
-	pInfo->DefaultValue = 0;
 	pInfo->StrDefaultValue = _strdup(pchDefaultValue);
-	pInfo->pNext = NULL;
-	if (m_pFirst == NULL) m_pFirst = pInfo; 
-	if (m_pLast != NULL) m_pLast->pNext = pInfo;
-	m_pLast = pInfo;
-	m_NParams++;
 }
 
 void CFFGLPluginManager::SetTimeSupported(bool supported)
@@ -145,53 +155,57 @@ void CFFGLPluginManager::SetTimeSupported(bool supported)
   m_timeSupported = supported;
 }
 
+void CFFGLPluginManager::SetParamSchema(const FFGLParamTable* pSchema)
+{
+	m_pSchema = pSchema;
+}
+
+void CFFGLPluginManager::SetParamUniform(unsigned int dwIndex, const char* pchUniformName)
+{
+	if (m_pOwnParams == NULL) return;
+
+	ParamInfo* pInfo = (ParamInfo*)m_pOwnParams->Find(dwIndex);
+	if (pInfo == NULL) return;
+
+	if (pInfo->UniformName != NULL) free(pInfo->UniformName);
+	pInfo->UniformName = (pchUniformName != NULL) ? _strdup(pchUniformName) : NULL;
+}
+
+const char* CFFGLPluginManager::GetParamUniform(unsigned int dwIndex) const
+{
+	if (m_pSchema != NULL) return m_pSchema->GetUniform(dwIndex);
+
+	const ParamInfo* pInfo = m_pParams->Find(dwIndex);
+	return (pInfo != NULL) ? pInfo->UniformName : NULL;
+}
+
 char* CFFGLPluginManager::GetParamName(unsigned int dwIndex) const
 {
-	ParamInfo* pCurr = m_pFirst;
-	bool bFound = false;
-	while (pCurr != NULL) {
-		if (pCurr->ID == dwIndex) {
-			bFound = true;
-			break;
-		}
-		pCurr = pCurr->pNext;
-	}
-	if (bFound) return pCurr->Name;
-	return NULL;
+	if (m_pSchema != NULL) return (char*)m_pSchema->GetName(dwIndex);
+
+	const ParamInfo* pInfo = m_pParams->Find(dwIndex);
+	return (pInfo != NULL) ? (char*)pInfo->Name : NULL;
 }
 	
 unsigned int CFFGLPluginManager::GetParamType(unsigned int dwIndex) const
 {
-	ParamInfo* pCurr = m_pFirst;
-	bool bFound = false;
-	while (pCurr != NULL) {
-		if (pCurr->ID == dwIndex) {
-			bFound = true;
-			break;
-		}
-		pCurr = pCurr->pNext;
-	}
-	if (bFound) return pCurr->dwType;
-	return FF_FAIL;
+	if (m_pSchema != NULL) return m_pSchema->GetType(dwIndex);
+
+	const ParamInfo* pInfo = m_pParams->Find(dwIndex);
+	return (pInfo != NULL) ? pInfo->dwType : FF_FAIL;
 }
 
 FFMixed CFFGLPluginManager::GetParamDefault(unsigned int dwIndex) const
 {
+	if (m_pSchema != NULL) return m_pSchema->GetDefault(dwIndex);
+
   FFMixed result;
-	ParamInfo* pCurr = m_pFirst;
-	bool bFound = false;
-	while (pCurr != NULL) {
-		if (pCurr->ID == dwIndex) {
-			bFound = true;
-			break;
-		}
-		pCurr = pCurr->pNext;
-	}
-	if (bFound) {
-		if (GetParamType(dwIndex) == FF_TYPE_TEXT)
-			result.PointerValue = (void*)pCurr->StrDefaultValue;
+	const ParamInfo* pInfo = m_pParams->Find(dwIndex);
+	if (pInfo != NULL) {
+		if (pInfo->dwType == FF_TYPE_TEXT)
+			result.PointerValue = (void*)pInfo->StrDefaultValue;
 		else
-			result.UIntValue = *(unsigned int*)&pCurr->DefaultValue;
+			result.UIntValue = *(unsigned int*)&pInfo->DefaultValue;
 	} else {
     result.UIntValue = FF_FAIL;
   }
@@ -22,6 +22,9 @@
 
 
 #include "FFGL.h"
+#include "FFGLParamSchema.h"
+#include <atomic>
+#include <vector>
 
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -97,9 +100,23 @@ public:
 	///						in any other case. In case of error, NULL is returned.
 	FFMixed GetParamDefault(unsigned int dwIndex) const;
 
-	/// This method is called by a the host to determine whether the plugin supports the SetTime function
+	/// This method is called by the SDK to determine whether the plugin supports the SetTime function. 
+	/// FF_CAP_SETTIME is reported either way, since FF_SETTIME also moves the parameter ramps.
 	bool GetTimeSupported() const;
 
+	/// This method returns the name of the shader uniform the plugin parameter is bound to (see SetParamUniform).
+	///
+	/// \param	dwIndex		The index of the plugin parameter whose uniform is queried. 
+	///						It should be in the range [0, Number of plugin parameters).
+	/// \return				The name of the uniform, or NULL if the parameter is not bound to a uniform.
+	const char* GetParamUniform(unsigned int dwIndex) const;
+
+	/// This method is called by the SDK once the prototype of the plugin has been constructed. It publishes the 
+	/// parameter information the prototype built with SetParamInfo and SetParamUniform for the whole plugin module: 
+	/// every object of the plugin class constructed afterwards refers to it instead of allocating its own, and its 
+	/// SetParamInfo and SetParamUniform calls do nothing. The information is freed when the module is unloaded.
+	void ShareParamInfo();
+
 protected:
 
 	///	The standard constructor of CFFGLPluginManager. 
@@ -175,6 +192,23 @@ protected:
 	/// \param	supported	The plugin indicates whether it supports the SetTime function by passing true or false (1 or 0)
 	void SetTimeSupported(bool supported);
 
+	/// This method is called by a plugin subclass, derived from this class, to bind the plugin parameter whose 
+	/// index is passed as parameter to a uniform of its shaders. Bound parameters are uploaded by 
+	/// CFreeFrameGLPlugin::UpdateParamUniforms, only when their value changed since the previous upload. 
+	/// It should be called after the SetParamInfo call for the same parameter.
+	///
+	/// \param	dwIndex			Index of the plugin parameter to bind.
+	/// \param	pchUniformName	The name of the uniform, as declared in the shader.
+	void SetParamUniform(unsigned int dwIndex, const char* pchUniformName);
+
+	/// This method is called by a plugin subclass, derived from this class, instead of SetParamInfo and 
+	/// SetParamUniform, when it declares its parameters at compile time with a FFGLParamSchema (see 
+	/// FFGLParamSchema.h). The names, types, defaults and uniforms of the parameters are then read from the 
+	/// schema, by index, and nothing is allocated per parameter.
+	///
+	/// \param	pSchema			The schema of the plugin. It must outlive the plugin object, i.e. be a static.
+	void SetParamSchema(const FFGLParamTable* pSchema);
+
 private:
 		
 	// Structure for keeping information about each plugin parameter
@@ -184,13 +218,29 @@ private:
 		unsigned int dwType;					
 		float DefaultValue;				
 		char* StrDefaultValue;			
-		ParamInfoStruct* pNext;	
+		char* UniformName;
 	} ParamInfo;
 
-	// Information on paramters and pointers to ParamInfo list
-	int m_NParams;
-	ParamInfo* m_pFirst;
-	ParamInfo* m_pLast;
+	// The parameters of the plugin class, in the order they were declared
+	struct ParamTable {
+		std::vector<ParamInfo> Params;
+		~ParamTable();
+		const ParamInfo* Find(unsigned int dwIndex) const;
+	};
+
+	// Compile-time parameters, when the plugin has a schema; the table below is empty then
+	const FFGLParamTable* m_pSchema;
+
+	// The table the Get methods read: the module's once ShareParamInfo has been called, 
+	// otherwise m_pOwnParams, which SetParamInfo adds to
+	const ParamTable* m_pParams;
+	ParamTable* m_pOwnParams;
+
+	// Published by ShareParamInfo
+	static ParamTable s_moduleParams;
+	static std::atomic<bool> s_moduleParamsShared;
+
+	ParamInfo* AddParamInfo(unsigned int dwIndex, const char* pchName, unsigned int dwType);
 	
 	// Inputs
 	int m_iMinInputs;
@@ -34,6 +34,7 @@ inline unsigned int CFFGLPluginManager::GetMaxInputs() const
 
 inline unsigned int CFFGLPluginManager::GetNumParams() const
 {
-	return m_NParams;
+	if (m_pSchema != NULL) return m_pSchema->GetNumParams();
+	return (unsigned int)m_pParams->Params.size();
 }
 
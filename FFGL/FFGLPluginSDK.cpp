@@ -21,9 +21,6 @@
 #include <stdio.h>
 #include <memory.h>
 
-// Buffer used by the default implementation of getParameterDisplay
-static char s_DisplayValue[5];
-
 
 ////////////////////////////////////////////////////////
 // CFreeFrameGLPlugin constructor and destructor
@@ -32,10 +29,20 @@ static char s_DisplayValue[5];
 CFreeFrameGLPlugin::CFreeFrameGLPlugin()
 : CFFGLPluginManager()
 {
+	m_paramUniformShader = NULL;
+	m_paramUniformVersion = 0;
+	memset(m_displayValue, 0, sizeof(m_displayValue));
+	m_batchExtensions = NULL;
+	m_inBatch = 0;
+	m_batchWidth = 0.0f;
+	m_batchHeight = 0.0f;
+	m_hostTime = 0.0;
+	m_hasHostTime = false;
 }
 
 CFreeFrameGLPlugin::~CFreeFrameGLPlugin() 
 {
+	delete m_batchExtensions;
 }
 
 
@@ -56,9 +63,9 @@ char* CFreeFrameGLPlugin::GetParameterDisplay(unsigned int index)
 		else
     {
 			float fValue = m_pPlugin->GetFloatParameter(index);
-			memset(s_DisplayValue, 0, 5);
-			_snprintf_s(s_DisplayValue, _TRUNCATE, "%f", fValue);
-			return s_DisplayValue;
+			memset(m_displayValue, 0, sizeof(m_displayValue));
+			_snprintf_s(m_displayValue, _TRUNCATE, "%f", fValue);
+			return m_displayValue;
 		}
 	}
 	return NULL;
@@ -84,8 +91,297 @@ char* CFreeFrameGLPlugin::GetTextParameter(unsigned int index)
   return (char *)FF_FAIL;
 }					
 
+FFResult CFreeFrameGLPlugin::SetParameters(const SetParameterStruct *params, unsigned int numParams)
+{
+	if (numParams > 0 && params == NULL) return FF_FAIL;
+
+	FFResult result = FF_SUCCESS;
+	for (unsigned int i = 0; i < numParams; ++i) {
+		unsigned int index = params[i].ParameterNumber;
+		FFResult set;
+		if (GetParamType(index) == FF_TYPE_TEXT)
+			set = SetTextParameter(index, (const char *)params[i].NewParameterValue.PointerValue);
+		else
+			set = SetFloatParameter(index, *(float *)&params[i].NewParameterValue.UIntValue);
+		if (set != FF_SUCCESS) result = FF_FAIL;
+	}
+	return result;
+}
+
+FFResult CFreeFrameGLPlugin::SetParameterRamps(const ParameterKeyframeStruct *keyframes, unsigned int numKeyframes)
+{
+	if (numKeyframes > 0 && keyframes == NULL) return FF_FAIL;
+
+	FFResult result = FF_SUCCESS;
+	for (unsigned int i = 0; i < numKeyframes; ++i) {
+		const ParameterKeyframeStruct &keyframe = keyframes[i];
+		unsigned int type = GetParamType(keyframe.ParameterNumber);
+		if (type == FF_FAIL || type == FF_TYPE_TEXT) {
+			result = FF_FAIL;
+			continue;
+		}
+
+		ParamRamp *ramp = NULL;
+		for (size_t r = 0; r < m_paramRamps.size() && ramp == NULL; ++r) {
+			if (m_paramRamps[r].ParameterNumber == keyframe.ParameterNumber) ramp = &m_paramRamps[r];
+		}
+		if (ramp == NULL) {
+			m_paramRamps.push_back(ParamRamp());
+			ramp = &m_paramRamps.back();
+			ramp->ParameterNumber = keyframe.ParameterNumber;
+			ramp->Step = type == FF_TYPE_BOOLEAN || type == FF_TYPE_EVENT;
+			ramp->FromValue = GetFloatParameter(keyframe.ParameterNumber);
+			ramp->FromTime = m_hasHostTime ? m_hostTime : keyframe.Time;
+		}
+
+		// the host has changed its mind about everything from this keyframe on
+		std::vector<ParameterKeyframeStruct> &queued = ramp->Keyframes;
+		size_t keep = 0;
+		while (keep < queued.size() && queued[keep].Time < keyframe.Time) ++keep;
+		queued.resize(keep);
+		queued.push_back(keyframe);
+	}
+	return result;
+}
+
+void CFreeFrameGLPlugin::CancelParameterRamps(const SetParameterStruct *params, unsigned int numParams)
+{
+	if (m_paramRamps.empty() || params == NULL) return;
+
+	for (unsigned int i = 0; i < numParams; ++i)
+		EraseParamRamp(params[i].ParameterNumber);
+}
+
+void CFreeFrameGLPlugin::EraseParamRamp(unsigned int index)
+{
+	for (size_t r = 0; r < m_paramRamps.size(); ++r) {
+		if (m_paramRamps[r].ParameterNumber == index) {
+			m_paramRamps[r] = m_paramRamps.back();
+			m_paramRamps.pop_back();
+			return;
+		}
+	}
+}
+
+FFResult CFreeFrameGLPlugin::SetHostTime(double time)
+{
+	m_hostTime = time;
+	m_hasHostTime = true;
+
+	if (!m_paramRamps.empty()) {
+		m_rampParams.clear();
+		for (size_t r = 0; r < m_paramRamps.size(); ) {
+			ParamRamp &ramp = m_paramRamps[r];
+
+			// the last keyframe reached is where the next segment starts
+			size_t reached = 0;
+			while (reached < ramp.Keyframes.size() && ramp.Keyframes[reached].Time <= time) ++reached;
+			if (reached > 0) {
+				ramp.FromValue = ramp.Keyframes[reached - 1].Value;
+				ramp.FromTime = ramp.Keyframes[reached - 1].Time;
+				ramp.Keyframes.erase(ramp.Keyframes.begin(), ramp.Keyframes.begin() + reached);
+			}
+
+			// a time before the start of the segment (the host looped or seeked) holds its first value
+			float value = ramp.FromValue;
+			if (!ramp.Keyframes.empty() && !ramp.Step && time > ramp.FromTime) {
+				const ParameterKeyframeStruct &next = ramp.Keyframes[0];
+				double f = (time - ramp.FromTime) / (next.Time - ramp.FromTime);
+				value = ramp.FromValue + (float)f * (next.Value - ramp.FromValue);
+			}
+
+			SetParameterStruct param;
+			param.ParameterNumber = ramp.ParameterNumber;
+			param.NewParameterValue.PointerValue = NULL;
+			memcpy(&param.NewParameterValue.UIntValue, &value, sizeof(float));
+			m_rampParams.push_back(param);
+
+			// done once the last keyframe has been reached
+			if (ramp.Keyframes.empty()) {
+				m_paramRamps[r] = m_paramRamps.back();
+				m_paramRamps.pop_back();
+			} else {
+				++r;
+			}
+		}
+
+		SetParameters(&m_rampParams[0], (unsigned int)m_rampParams.size());
+	}
+
+	if (GetTimeSupported()) return SetTime(time);
+	return FF_SUCCESS;
+}
+
+char* CFreeFrameGLPlugin::CopyParameterDisplay(const char *text)
+{
+	memset(m_displayValue, 0, sizeof(m_displayValue));
+	if (text != NULL)
+		_snprintf_s(m_displayValue, _TRUNCATE, "%s", text);
+	return m_displayValue;
+}
+
+void CFreeFrameGLPlugin::UpdateParamUniforms(FFGLShader *shader)
+{
+	if (shader == NULL) return;
+
+	if (shader != m_paramUniformShader || shader->GetUniformsVersion() != m_paramUniformVersion)
+	{
+		// resolve the bound parameters against this shader's uniforms
+		m_paramUniforms.clear();
+		for (unsigned int i = 0; i < GetNumParams(); ++i) {
+			const char* pchUniform = GetParamUniform(i);
+			if (pchUniform == NULL) continue;
+
+			ParamUniform binding;
+			binding.ParamIndex = i;
+			binding.UniformIndex = shader->FindUniformIndex(pchUniform);
+
+			// not active in this shader (or optimized away)
+			if (binding.UniformIndex >= 0)
+				m_paramUniforms.push_back(binding);
+		}
+
+		m_paramUniformShader = shader;
+		m_paramUniformVersion = shader->GetUniformsVersion();
+	}
+
+	for (size_t i = 0; i < m_paramUniforms.size(); ++i)
+		shader->SetUniform1f(m_paramUniforms[i].UniformIndex, GetFloatParameter(m_paramUniforms[i].ParamIndex));
+}
+
 FFResult CFreeFrameGLPlugin::GetInputStatus(unsigned int index)
 {
 	if (index >= GetMaxInputs()) return FF_FAIL;
 	return FF_INPUT_INUSE;
 }
+
+FFResult CFreeFrameGLPlugin::ProcessOpenGLBatch(ProcessOpenGLBatchStruct *pBatch)
+{
+	if (BeginBatch(pBatch)!=FF_SUCCESS)
+		return FF_FAIL;
+
+	FFResult result = FF_SUCCESS;
+
+	for (FFUInt32 i = 0; i < pBatch->numFrames && result==FF_SUCCESS; i++)
+	{
+		ProcessOpenGLStruct pGL;
+		BeginBatchFrame(pBatch, i, &pGL);
+		result = ProcessOpenGL(&pGL);
+	}
+
+	EndBatch(pBatch);
+	return result;
+}
+
+FFResult CFreeFrameGLPlugin::BeginBatch(ProcessOpenGLBatchStruct *pBatch)
+{
+	if (pBatch==NULL || pBatch->outputTexture==0 ||
+		(pBatch->numInputTextures>0 && pBatch->inputTextures==NULL))
+		return FF_FAIL;
+
+	if (m_batchExtensions==NULL)
+	{
+		m_batchExtensions = new FFGLExtensions();
+		m_batchExtensions->Initialize();
+	}
+
+	FFGLExtensions &e = *m_batchExtensions;
+	if (!e.EXT_texture_array || !e.EXT_framebuffer_object || !m_batchFbo.Create(e, &m_glResources))
+		return FF_FAIL;
+
+	//the size of the layers, asked once for the whole batch
+	GLint width = 0, height = 0;
+	glBindTexture(GL_TEXTURE_2D_ARRAY_EXT, pBatch->outputTexture);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY_EXT, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY_EXT, 0, GL_TEXTURE_HEIGHT, &height);
+	glBindTexture(GL_TEXTURE_2D_ARRAY_EXT, 0);
+
+	if (width<=0 || height<=0)
+		return FF_FAIL;
+
+	glPushAttrib(GL_VIEWPORT_BIT | GL_COLOR_BUFFER_BIT);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	e.glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_batchFbo.GetHandle());
+
+	m_inBatch = 1;
+	m_batchWidth = (float)width;
+	m_batchHeight = (float)height;
+
+	//the values of every frame are set with one SetParameters call. the
+	//parameters are picked once per batch, text ones are left out
+	m_batchParams.clear();
+	if (pBatch->parameters!=NULL)
+	{
+		for (FFUInt32 p = 0; p < pBatch->numParameters; p++)
+		{
+			if (GetParamType(p)!=FF_TYPE_TEXT)
+			{
+				SetParameterStruct param;
+				param.ParameterNumber = p;
+				param.NewParameterValue.PointerValue = NULL;
+				m_batchParams.push_back(param);
+			}
+		}
+		if (!m_batchParams.empty())
+			CancelParameterRamps(&m_batchParams[0], (unsigned int)m_batchParams.size());
+	}
+
+	return FF_SUCCESS;
+}
+
+void CFreeFrameGLPlugin::BeginBatchFrame(ProcessOpenGLBatchStruct *pBatch, FFUInt32 frame, ProcessOpenGLStruct *pGL)
+{
+	FFGLExtensions &e = *m_batchExtensions;
+
+	if (!m_batchParams.empty())
+	{
+		const float *values = pBatch->parameters + (size_t)frame * pBatch->numParameters;
+		for (size_t p = 0; p < m_batchParams.size(); p++)
+			memcpy(&m_batchParams[p].NewParameterValue.UIntValue, &values[m_batchParams[p].ParameterNumber], sizeof(float));
+		SetParameters(&m_batchParams[0], (unsigned int)m_batchParams.size());
+	}
+
+	if (pBatch->times!=NULL)
+		SetHostTime(pBatch->times[frame]);
+
+	e.glFramebufferTextureLayerEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, pBatch->outputTexture, 0, pBatch->firstLayer + frame);
+
+	//the plugin may have left another viewport behind
+	glViewport(0, 0, (GLsizei)m_batchWidth, (GLsizei)m_batchHeight);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	pGL->numInputTextures = pBatch->numInputTextures;
+	pGL->inputTextures = pBatch->numInputTextures>0 ? pBatch->inputTextures + (size_t)frame * pBatch->numInputTextures : NULL;
+	pGL->HostFBO = m_batchFbo.GetHandle();
+}
+
+void CFreeFrameGLPlugin::EndBatch(ProcessOpenGLBatchStruct *pBatch)
+{
+	FFGLExtensions &e = *m_batchExtensions;
+
+	m_inBatch = 0;
+
+	e.glFramebufferTextureLayerEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, 0, 0, 0);
+	e.glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, pBatch->HostFBO);
+	glPopAttrib();
+}
+
+void CFreeFrameGLPlugin::DeInitBatchGL()
+{
+	m_batchFbo.Release();
+}
+
+void CFreeFrameGLPlugin::GetViewportSize(float *width, float *height)
+{
+	if (m_inBatch)
+	{
+		*width = m_batchWidth;
+		*height = m_batchHeight;
+		return;
+	}
+
+	float vpdim[4];
+	glGetFloatv(GL_VIEWPORT, vpdim);
+	*width = vpdim[2];
+	*height = vpdim[3];
+}
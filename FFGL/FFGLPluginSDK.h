@@ -22,6 +22,9 @@
 
 #include "FFGLPluginManager.h"
 #include "FFGLPluginInfo.h"
+#include "FFGLResources.h"
+#include "FFGLShader.h"
+#include <vector>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// \class		CFreeFrameGLPlugin
@@ -68,7 +71,8 @@ public:
 
 	/// Default implementation of the FreeFrame getParameterDisplay instance specific function. It provides a string 
 	/// to display as the value of the plugin parameter whose index is passed as parameter to the method. This default 
-	/// implementation just returns the string representation of the float value of the plugin parameter. A custom 
+	/// implementation just returns the string representation of the float value of the plugin parameter, written to 
+	/// a buffer of the instance so instances on different threads don't overwrite each other's text. A custom 
 	/// implementation may be provided by every specific plugin.
 	///
 	/// \param		dwIndex		The index of the parameter whose display value is queried. 
@@ -82,6 +86,35 @@ public:
 	virtual FFResult SetTextParameter(unsigned int index, const char *value);
 	virtual float GetFloatParameter(unsigned int index);
 	virtual char* GetTextParameter(unsigned int index);
+
+	/// Default implementation of the FF_SETPARAMETERS SDK extension. It sets every parameter with SetTextParameter 
+	/// or SetFloatParameter, looking its type up in the plugin's own table. Plugins whose parameters have side effects 
+	/// (a shader variant, a format) may provide their own implementation that stores all the values first and 
+	/// applies the side effects once.
+	///
+	/// \param		params		numParams parameter numbers and values, as for FF_SETPARAMETER.
+	/// \param		numParams	The number of parameters to set.
+	/// \return					FF_SUCCESS, or FF_FAIL if setting any of the parameters failed.
+	virtual FFResult SetParameters(const SetParameterStruct *params, unsigned int numParams);
+
+	/// Implementation of the FF_SETPARAMETERRAMPS SDK extension. It queues the keyframes; SetHostTime moves the 
+	/// parameters towards them. A parameter's ramp starts from its value when its first keyframe arrives, at the 
+	/// last time the host set (or at the keyframe's own time if the host hasn't set one yet).
+	///
+	/// \param		keyframes		numKeyframes parameter numbers, values and times.
+	/// \param		numKeyframes	The number of keyframes.
+	/// \return					FF_SUCCESS, or FF_FAIL if any of the keyframes is for a text parameter or 
+	///							a parameter the plugin doesn't have (the others are queued anyway).
+	FFResult SetParameterRamps(const ParameterKeyframeStruct *keyframes, unsigned int numKeyframes);
+
+	/// Stops the ramp of a parameter, at the value it has reached. Called by the SDK before the host sets 
+	/// the parameter, so the host's value isn't overwritten by the next SetHostTime.
+	///
+	/// \param		index	The index of the parameter.
+	void CancelParameterRamp(unsigned int index) { if (!m_paramRamps.empty()) EraseParamRamp(index); }
+
+	/// Calls CancelParameterRamp for every parameter in params.
+	void CancelParameterRamps(const SetParameterStruct *params, unsigned int numParams);
 	
 	/// Default implementation of the FFGL ProcessOpenGL instance specific function. This function processes 
 	/// the input texture(s) by 
@@ -92,6 +125,20 @@ public:
 	///						A custom implementation must be provided by every specific plugin.
   virtual FFResult ProcessOpenGL(ProcessOpenGLStruct* pOpenGLData) { return FF_FAIL; }
 
+	/// Default implementation of the FF_PROCESSOPENGLBATCH SDK extension. It renders every frame of the batch with 
+	/// ProcessOpenGL into its layer of the output texture array. The framebuffer and the size of the layers are set up 
+	/// once per batch rather than once per frame, and GetViewportSize answers from the batch instead of asking GL. 
+	/// Plugins that can render several frames at once may provide their own implementation, built on 
+	/// BeginBatch, BeginBatchFrame and EndBatch like this one.
+	///
+	/// \param		pBatch	Pointer to a ProcessOpenGLBatchStruct structure (see the definition in FFGL.h).
+	/// \return		FF_SUCCESS, or FF_FAIL if texture arrays aren't supported, the batch is malformed or 
+	///						ProcessOpenGL fails for a frame (the frames before it have been rendered).
+	virtual FFResult ProcessOpenGLBatch(ProcessOpenGLBatchStruct *pBatch);
+
+	/// Frees the OpenGL objects ProcessOpenGLBatch created. Called by the SDK after DeInitGL.
+	void DeInitBatchGL();
+
  	/// Default implementation of the FFGL SetTime instance specific function
 	///
 	/// \param		pOpenGLData to a ProcessOpenGLStruct structure (see the definition in FFGL.h and 
@@ -100,6 +147,14 @@ public:
 	///						A custom implementation must be provided by every specific plugin.
   virtual FFResult SetTime(double time) { return FF_FAIL; }
 
+	/// Handles FF_SETTIME for the SDK. It sets every ramped parameter to its value at time with one SetParameters 
+	/// call, dropping the keyframes that have been reached, then passes the time on to SetTime if the plugin 
+	/// supports it. Called on the render thread, before the frame the time belongs to.
+	///
+	/// \param		time	The host's time, in seconds.
+	/// \return		The result of SetTime, or FF_SUCCESS if the plugin doesn't support it.
+	FFResult SetHostTime(double time);
+
 	/// Default implementation of the FreeFrame getInputStatus instance specific function. This function is called 
 	/// to know whether a given input is currently in use. For the default implementation every input is always in use. 
 	/// A custom implementation may be provided by every specific plugin.
@@ -115,13 +170,104 @@ public:
 	/// so that they can use it for calling the plugin methods).
 	CFreeFrameGLPlugin *m_pPlugin;
 
+	/// Returns the tracker that accounts for the OpenGL objects allocated by this instance.
+	///
+	/// \return		A reference to the resource tracker of the instance.
+	FFGLResourceTracker &GetGLResources() { return m_glResources; }
+
 protected:
 
+	/// Resource tracker of the instance. Plugins pass it to the FFGLTexture, FFGLFramebuffer, 
+	/// FFGLBuffer, FFGLFBO and FFGLShader objects they allocate, so that the memory held by the 
+	/// instance can be queried by the host and leaks are reported when the instance is deleted.
+	FFGLResourceTracker m_glResources;
+
+	/// Uploads the current value of every plugin parameter bound to a uniform with SetParamUniform. 
+	/// Uniform indexes are resolved once per shader (and again only when it is relinked), and a value 
+	/// is only uploaded when it differs from the last one uploaded to that shader. 
+	/// Plugins call it from ProcessOpenGL, with the shader bound.
+	///
+	/// \param		shader	The bound shader the parameters are uploaded to.
+	void UpdateParamUniforms(FFGLShader *shader);
+
+	/// Copies text into the buffer of the default GetParameterDisplay, truncated to the 15 characters it holds, 
+	/// and returns it. Plugins showing a name or a fixed word for a parameter return this rather than a string 
+	/// literal, which the host must not be handed as a char*.
+	///
+	/// \param		text	The text to display.
+	/// \return		The instance's display buffer.
+	char* CopyParameterDisplay(const char *text);
+
+	/// Returns the size of the viewport the plugin renders to. Inside a batch it comes from the batch, otherwise 
+	/// from glGetFloatv(GL_VIEWPORT). Plugins call it from ProcessOpenGL.
+	///
+	/// \param		width	Receives the width of the viewport.
+	/// \param		height	Receives the height of the viewport.
+	void GetViewportSize(float *width, float *height);
+
+	/// Starts a batch for an implementation of ProcessOpenGLBatch: checks it, binds the framebuffer the layers are
+	/// attached to and picks the parameters it sets. Every successful BeginBatch is followed by an EndBatch.
+	///
+	/// \param		pBatch	The batch passed to ProcessOpenGLBatch.
+	/// \return		FF_SUCCESS, or FF_FAIL if texture arrays aren't supported or the batch is malformed.
+	FFResult BeginBatch(ProcessOpenGLBatchStruct *pBatch);
+
+	/// Sets the parameter values and time of a frame of the batch, attaches its layer, sets the viewport to it
+	/// and clears it. Leaves the bound shader and textures alone, so a plugin may keep them over the frames.
+	///
+	/// \param		pBatch	The batch passed to BeginBatch.
+	/// \param		frame	The frame, 0..numFrames-1.
+	/// \param		pGL		Receives the inputs of the frame, as ProcessOpenGL would get them.
+	void BeginBatchFrame(ProcessOpenGLBatchStruct *pBatch, FFUInt32 frame, ProcessOpenGLStruct *pGL);
+
+	/// Binds the host's framebuffer again and restores the viewport.
+	///
+	/// \param		pBatch	The batch passed to BeginBatch.
+	void EndBatch(ProcessOpenGLBatchStruct *pBatch);
+
 	/// The only protected function of CFreeFrameGLPlugin is its constructor. In fact, nor CFFGLPluginManager objects nor 
 	/// CFreeFrameGLPlugin objects should be created directly, but only objects of the subclasses implementing specific 
 	/// plugins should be instantiated. Moreover, subclasses should define and provide a factory method to be used by 
 	/// the FreeFrame SDK for instantiating plugin objects.
 	CFreeFrameGLPlugin();
+
+private:
+
+	// Parameter to uniform index table of the shader last passed to UpdateParamUniforms
+	struct ParamUniform {
+		unsigned int ParamIndex;
+		int UniformIndex;
+	};
+	std::vector<ParamUniform> m_paramUniforms;
+	FFGLShader *m_paramUniformShader;
+	unsigned int m_paramUniformVersion;
+
+	// Buffer used by the default implementation of GetParameterDisplay,
+	// big enough for a float formatted with %f (FreeFrame shows 16 chars)
+	char m_displayValue[16];
+
+	// ProcessOpenGLBatch state, created by the first batch
+	FFGLExtensions *m_batchExtensions;
+	FFGLFramebuffer m_batchFbo;
+	int m_inBatch;
+	float m_batchWidth;
+	float m_batchHeight;
+	std::vector<SetParameterStruct> m_batchParams;
+
+	// A parameter moving towards the keyframes the host has sent for it
+	struct ParamRamp {
+		unsigned int ParameterNumber;
+		bool Step; // boolean and event parameters jump to each keyframe when it is reached
+		float FromValue; // where the current segment starts
+		double FromTime;
+		std::vector<ParameterKeyframeStruct> Keyframes; // not reached yet, in increasing time
+	};
+	std::vector<ParamRamp> m_paramRamps;
+	std::vector<SetParameterStruct> m_rampParams;
+	double m_hostTime;
+	bool m_hasHostTime;
+
+	void EraseParamRamp(unsigned int index);
 };
 
 
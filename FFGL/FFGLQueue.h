@@ -0,0 +1,83 @@
+#ifndef FFGLQUEUE_H
+#define FFGLQUEUE_H
+
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+
+//FFGLSPSCQueue is a bounded, lock-free queue for exactly one producer
+//thread and one consumer thread, e.g. the render thread handing frames
+//to a worker. Push and Pop never block and never allocate, so the render
+//thread can't be held up by a slow consumer; a full queue simply refuses
+//the item.
+//
+//Reset() sizes the queue and must be called while neither thread uses it
+template <class T>
+class FFGLSPSCQueue
+{
+public:
+  FFGLSPSCQueue()
+  :m_head(0),
+   m_tail(0)
+  {}
+
+  void Reset(size_t capacity)
+  {
+    //one slot stays empty to tell a full queue from an empty one
+    m_items.assign(capacity+1, T());
+    m_head.store(0);
+    m_tail.store(0);
+  }
+
+  size_t GetCapacity() const
+  {
+    return m_items.empty() ? 0 : m_items.size()-1;
+  }
+
+  //producer only. returns 0 if the queue is full
+  int Push(const T &item)
+  {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    size_t next = Next(tail);
+
+    if (m_items.empty() || next==m_head.load(std::memory_order_acquire))
+      return 0;
+
+    m_items[tail] = item;
+    m_tail.store(next, std::memory_order_release);
+    return 1;
+  }
+
+  //consumer only. returns 0 if the queue is empty
+  int Pop(T &item)
+  {
+    size_t head = m_head.load(std::memory_order_relaxed);
+
+    if (head==m_tail.load(std::memory_order_acquire))
+      return 0;
+
+    item = m_items[head];
+    m_head.store(Next(head), std::memory_order_release);
+    return 1;
+  }
+
+private:
+  std::vector<T> m_items;
+
+  //head is written by the consumer and tail by the producer. keep them
+  //on separate cache lines so the two threads don't keep stealing the
+  //line from each other
+  std::atomic<size_t> m_head;
+  char m_pad[64];
+  std::atomic<size_t> m_tail;
+
+  size_t Next(size_t i) const
+  {
+    return i+1<m_items.size() ? i+1 : 0;
+  }
+
+  FFGLSPSCQueue(const FFGLSPSCQueue &);
+  FFGLSPSCQueue &operator=(const FFGLSPSCQueue &);
+};
+
+#endif
@@ -0,0 +1,459 @@
+#include "FFGLReadback.h"
+#include "FFGLLib.h"
+#include <chrono>
+
+//how long a non-dropping Capture waits on a fence before checking again
+static const GLuint64_REPLACEMENT FENCE_WAIT_NS = 100000000;
+
+//frames shared with the consumer: one it is working on, one waiting in
+//m_ready and one the render thread can fill meanwhile, plus a spare
+static const size_t FRAME_POOL_SIZE = 4;
+
+FFGLReadback::FFGLReadback()
+:m_extensions(NULL),
+ m_tracker(NULL),
+ m_latency(DEFAULT_LATENCY),
+ m_requestedLatency(DEFAULT_LATENCY),
+ m_outputWidth(0),
+ m_outputHeight(0),
+ m_pixelFormat(GL_RGBA),
+ m_dropFrames(1),
+ m_write(0),
+ m_read(0),
+ m_frameNumber(0),
+ m_running(0),
+ m_numDropped(0),
+ m_numDelivered(0),
+ m_numConsumed(0)
+{
+  m_ready.Reset(FRAME_POOL_SIZE);
+  m_free.Reset(FRAME_POOL_SIZE);
+
+  for (size_t i=0; i<FRAME_POOL_SIZE; i++)
+  {
+    FFGLReadbackFrame *frame = new FFGLReadbackFrame();
+    frame->frameNumber = 0;
+    frame->width = 0;
+    frame->height = 0;
+    frame->bytesPerPixel = 4;
+
+    m_frames.push_back(frame);
+    m_free.Push(frame);
+  }
+}
+
+FFGLReadback::~FFGLReadback()
+{
+  Stop();
+  FreeGLResources();
+
+  for (size_t i=0; i<m_frames.size(); i++)
+    delete m_frames[i];
+}
+
+void FFGLReadback::SetExtensions(FFGLExtensions *e)
+{
+  m_extensions = e;
+}
+
+void FFGLReadback::SetResourceTracker(FFGLResourceTracker *tracker)
+{
+  m_tracker = tracker;
+}
+
+void FFGLReadback::SetLatency(int frames)
+{
+  if (frames<2) frames = 2;
+  if (frames>MAX_LATENCY) frames = MAX_LATENCY;
+
+  m_requestedLatency = frames;
+}
+
+void FFGLReadback::SetOutputSize(GLsizei width, GLsizei height)
+{
+  m_outputWidth = width;
+  m_outputHeight = height;
+}
+
+void FFGLReadback::SetPixelFormat(GLenum format)
+{
+  m_pixelFormat = format==GL_RGB ? GL_RGB : GL_RGBA;
+}
+
+void FFGLReadback::SetDropFrames(int drop)
+{
+  m_dropFrames = drop;
+}
+
+int FFGLReadback::Start(ConsumerFunc func)
+{
+  if (m_running)
+    return 0;
+
+  m_consumer = func;
+  m_running = 1;
+  m_consumerThread = std::thread(&FFGLReadback::ConsumerLoop, this);
+
+  return 1;
+}
+
+void FFGLReadback::Stop()
+{
+  if (!m_consumerThread.joinable())
+    return;
+
+  m_running = 0;
+  m_wake.notify_one();
+  m_consumerThread.join();
+
+  //the consumer is gone, so this thread may play both ends of m_ready
+  FFGLReadbackFrame *frame;
+  while (m_ready.Pop(frame))
+    m_free.Push(frame);
+}
+
+void FFGLReadback::ConsumerLoop()
+{
+  while (m_running)
+  {
+    FFGLReadbackFrame *frame;
+    if (m_ready.Pop(frame))
+    {
+      m_consumer(*frame);
+      m_free.Push(frame);
+      m_numConsumed++;
+      continue;
+    }
+
+    //the render thread doesn't take the mutex when it notifies, so a
+    //wakeup can be missed. the timeout bounds what that costs
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    m_wake.wait_for(lock, std::chrono::milliseconds(2));
+  }
+}
+
+void FFGLReadback::CreateRing()
+{
+  m_latency = m_requestedLatency;
+
+  for (int i=0; i<m_latency; i++)
+  {
+    Slot *slot = new Slot();
+    slot->fence = NULL;
+    slot->frameNumber = 0;
+    slot->width = 0;
+    slot->height = 0;
+    slot->format = GL_RGBA;
+    slot->pending = 0;
+
+    m_slots.push_back(slot);
+  }
+
+  m_write = 0;
+  m_read = 0;
+}
+
+void FFGLReadback::DeleteRing()
+{
+  for (size_t i=0; i<m_slots.size(); i++)
+  {
+    if (m_slots[i]->fence!=NULL)
+      m_extensions->glDeleteSync(m_slots[i]->fence);
+
+    delete m_slots[i];
+  }
+
+  m_slots.clear();
+}
+
+//hands the slots whose copy has completed to the consumer, oldest first.
+//with wait set it blocks until at least the oldest pending one is done
+void FFGLReadback::Deliver(int wait)
+{
+  while (!m_slots.empty())
+  {
+    Slot &slot = *m_slots[m_read];
+    if (!slot.pending)
+      break;
+
+    if (slot.fence!=NULL)
+    {
+      //a zero timeout only polls the fence
+      GLenum status = m_extensions->glClientWaitSync(
+        slot.fence,
+        wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+        wait ? FENCE_WAIT_NS : 0);
+
+      if (status==GL_TIMEOUT_EXPIRED)
+      {
+        if (wait)
+          continue;
+        break;
+      }
+
+      m_extensions->glDeleteSync(slot.fence);
+      slot.fence = NULL;
+    }
+    else if (!wait && m_frameNumber - slot.frameNumber < (unsigned int)m_slots.size())
+    {
+      //without fences the copy is assumed done once the ring has come
+      //round, mapping it may stall if it isn't
+      break;
+    }
+
+    if (m_running)
+    {
+      m_extensions->glBindBufferARB(GL_PIXEL_PACK_BUFFER_ARB, slot.buffer.GetHandle());
+      const unsigned char *data =
+        (const unsigned char *)m_extensions->glMapBufferARB(GL_PIXEL_PACK_BUFFER_ARB, GL_READ_ONLY_ARB);
+
+      FFGLReadbackFrame *frame = NULL;
+      int haveFrame = data!=NULL && m_free.Pop(frame);
+
+      //not dropping: wait for the consumer to give a frame back
+      while (data!=NULL && !haveFrame && !m_dropFrames && m_running)
+      {
+        m_wake.notify_one();
+        std::this_thread::yield();
+        haveFrame = m_free.Pop(frame);
+      }
+
+      if (haveFrame)
+      {
+        frame->frameNumber = slot.frameNumber;
+        frame->width = slot.width;
+        frame->height = slot.height;
+        frame->bytesPerPixel = slot.format==GL_RGB ? 3 : 4;
+        frame->pixels.assign(data, data + (size_t)slot.width * (size_t)slot.height * frame->bytesPerPixel);
+
+        //m_ready holds every frame there is, so this can't fail
+        m_ready.Push(frame);
+        m_numDelivered++;
+        m_wake.notify_one();
+      }
+      else
+      {
+        //the consumer is still busy with older frames
+        m_numDropped++;
+      }
+
+      if (data!=NULL)
+        m_extensions->glUnmapBufferARB(GL_PIXEL_PACK_BUFFER_ARB);
+
+      m_extensions->glBindBufferARB(GL_PIXEL_PACK_BUFFER_ARB, 0);
+    }
+
+    slot.pending = 0;
+    m_read = (m_read+1) % (int)m_slots.size();
+    wait = 0;
+  }
+}
+
+void FFGLReadback::Flush()
+{
+  while (!m_slots.empty() && m_slots[m_read]->pending)
+    Deliver(1);
+
+  while (m_running && m_numConsumed!=m_numDelivered)
+  {
+    m_wake.notify_one();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+const FFGLTexture *FFGLReadback::ScaleDown(const FFGLTextureStruct &source, GLsizei width, GLsizei height)
+{
+  //sizes of the steps, the last one is the output
+  std::vector<GLsizei> widths, heights;
+
+  GLsizei w = (GLsizei)source.Width;
+  GLsizei h = (GLsizei)source.Height;
+
+  while (w>2*width || h>2*height)
+  {
+    w = (w+1)/2 > width ? (w+1)/2 : width;
+    h = (h+1)/2 > height ? (h+1)/2 : height;
+    widths.push_back(w);
+    heights.push_back(h);
+  }
+  widths.push_back(width);
+  heights.push_back(height);
+
+  while (m_scaleChain.size()<widths.size())
+    m_scaleChain.push_back(new FFGLTexture());
+
+  FFGLTextureStruct previous = source;
+
+  for (size_t i=0; i<widths.size(); i++)
+  {
+    FFGLTexture &target = *m_scaleChain[i];
+    if (!target.Allocate(GL_TEXTURE_2D, GL_RGBA8, widths[i], heights[i], GL_RGBA, GL_UNSIGNED_BYTE, m_tracker))
+      return NULL;
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    m_extensions->glFramebufferTexture2DEXT(
+      GL_FRAMEBUFFER_EXT,
+      GL_COLOR_ATTACHMENT0_EXT,
+      GL_TEXTURE_2D,
+      target.GetHandle(),
+      0);
+    glViewport(0, 0, widths[i], heights[i]);
+
+    FFGLDrawPassThrough(previous);
+
+    previous.Width = previous.HardwareWidth = widths[i];
+    previous.Height = previous.HardwareHeight = heights[i];
+    previous.Handle = target.GetHandle();
+  }
+
+  return m_scaleChain[widths.size()-1];
+}
+
+int FFGLReadback::Capture(const FFGLTextureStruct &source)
+{
+  return Capture(source, -1);
+}
+
+int FFGLReadback::CaptureLayer(GLuint arrayTexture, GLint layer, GLsizei width, GLsizei height)
+{
+  if (m_extensions==NULL || !m_extensions->EXT_texture_array || layer<0 ||
+      (m_outputWidth>0 && (m_outputWidth!=width || m_outputHeight!=height)))
+    return 0;
+
+  FFGLTextureStruct source;
+  source.Width = source.HardwareWidth = (FFUInt32)width;
+  source.Height = source.HardwareHeight = (FFUInt32)height;
+  source.Handle = arrayTexture;
+  return Capture(source, layer);
+}
+
+int FFGLReadback::Capture(const FFGLTextureStruct &source, GLint layer)
+{
+  if (m_extensions==NULL || !m_extensions->ARB_pixel_buffer_object || source.Handle==0)
+    return 0;
+
+  m_frameNumber++;
+
+  //delivering first may free the slot this frame goes to
+  Deliver(0);
+
+  //the ring is only resized once everything in it has been delivered
+  if (m_slots.empty() ||
+      (m_requestedLatency!=m_latency && m_read==m_write && !m_slots[m_read]->pending))
+  {
+    DeleteRing();
+    CreateRing();
+  }
+
+  Slot &slot = *m_slots[m_write];
+  if (slot.pending && !m_dropFrames)
+  {
+    //the ring is full, so the oldest slot is this one
+    Deliver(1);
+  }
+
+  if (slot.pending)
+  {
+    //the GPU hasn't finished the copy from a ring ago, skip this frame
+    //rather than wait for it
+    m_numDropped++;
+    return 0;
+  }
+
+  GLsizei width = m_outputWidth>0 ? m_outputWidth : (GLsizei)source.Width;
+  GLsizei height = m_outputHeight>0 ? m_outputHeight : (GLsizei)source.Height;
+
+  if (!m_fbo.Create(*m_extensions, m_tracker))
+    return 0;
+
+  GLint previousFBO = 0;
+  GLint previousViewport[4];
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING_EXT, &previousFBO);
+  glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+  m_extensions->glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_fbo.GetHandle());
+
+  //the used part of a host texture starts at its origin, so it can be
+  //read straight from the source when no scaling is needed
+  GLuint readTexture = source.Handle;
+  int result = 1;
+
+  if (width!=(GLsizei)source.Width || height!=(GLsizei)source.Height)
+  {
+    const FFGLTexture *scaled = ScaleDown(source, width, height);
+    if (scaled!=NULL)
+      readTexture = scaled->GetHandle();
+    else
+      result = 0;
+  }
+
+  if (result)
+  {
+    Attach(readTexture, layer);
+
+    size_t bytes = (size_t)width * (size_t)height * (m_pixelFormat==GL_RGB ? 3 : 4);
+    if (slot.buffer.GetSize()!=bytes)
+      result = slot.buffer.Allocate(*m_extensions, GL_PIXEL_PACK_BUFFER_ARB, bytes, NULL, GL_STREAM_READ_ARB, m_tracker);
+    else
+      m_extensions->glBindBufferARB(GL_PIXEL_PACK_BUFFER_ARB, slot.buffer.GetHandle());
+  }
+
+  if (result)
+  {
+    //with a pack buffer bound this only queues the copy. RGB rows
+    //aren't 4 byte aligned, so pack them tightly
+    GLint alignment;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    glReadBuffer(GL_COLOR_ATTACHMENT0_EXT);
+    glReadPixels(0, 0, width, height, m_pixelFormat, GL_UNSIGNED_BYTE, NULL);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+    m_extensions->glBindBufferARB(GL_PIXEL_PACK_BUFFER_ARB, 0);
+
+    if (m_extensions->ARB_sync)
+      slot.fence = m_extensions->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    slot.frameNumber = m_frameNumber;
+    slot.width = width;
+    slot.height = height;
+    slot.format = m_pixelFormat;
+    slot.pending = 1;
+
+    m_write = (m_write+1) % (int)m_slots.size();
+  }
+
+  //don't keep the host's texture attached
+  Attach(0, layer);
+
+  m_extensions->glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, (GLuint)previousFBO);
+  glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+
+  return result;
+}
+
+void FFGLReadback::Attach(GLuint texture, GLint layer)
+{
+  //a layer, or a 2D texture for a layer < 0
+  if (layer>=0)
+    m_extensions->glFramebufferTextureLayerEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, texture, 0, texture!=0 ? layer : 0);
+  else
+    m_extensions->glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, texture, 0);
+}
+
+void FFGLReadback::FreeGLResources()
+{
+  DeleteRing();
+
+  for (size_t i=0; i<m_scaleChain.size(); i++)
+    delete m_scaleChain[i];
+  m_scaleChain.clear();
+
+  m_fbo.Release();
+}
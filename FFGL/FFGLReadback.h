@@ -0,0 +1,170 @@
+#ifndef FFGLREADBACK_H
+#define FFGLREADBACK_H
+
+#include <FFGL.h>
+#include <FFGLExtensions.h>
+#include <FFGLResources.h>
+#include <FFGLQueue.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//a frame read back by FFGLReadback. pixels are RGBA8 or RGB8 (see
+//SetPixelFormat), tightly packed, bottom row first (the order glReadPixels
+//returns them in)
+struct FFGLReadbackFrame
+{
+  unsigned int frameNumber; //counts calls to FFGLReadback::Capture
+  GLsizei width;
+  GLsizei height;
+  int bytesPerPixel;
+  std::vector<unsigned char> pixels;
+};
+
+//FFGLReadback gets the output of a plugin to CPU side consumers (LED
+//controllers, thumbnails, ...) without stalling the render thread the
+//way a plain glReadPixels does.
+//
+//every Capture() reads a texture into the next pixel pack buffer of a
+//ring and fences it. the copy runs on the GPU while the host renders on;
+//a later Capture() maps the buffer once its fence has signaled and hands
+//the pixels to a consumer thread through a lock-free queue. frames thus
+//arrive GetLatency() frames late. if the ring or the consumer falls
+//behind, frames are dropped rather than waited for - unless dropping is
+//switched off (SetDropFrames), as an offline renderer that has to get
+//every frame does.
+//
+//the source can be scaled down on the GPU first (SetOutputSize), which
+//cuts the bandwidth of the copy when the consumer only needs a few
+//hundred pixels.
+//
+//Capture may be called from inside a FFGLRenderGraph pass, so any pass
+//output can be read back: call it from a pass that reads the resource.
+//it restores the framebuffer and viewport it found
+class FFGLReadback
+{
+public:
+  typedef std::function<void (const FFGLReadbackFrame &frame)> ConsumerFunc;
+
+  FFGLReadback();
+  ~FFGLReadback();
+
+  void SetExtensions(FFGLExtensions *e);
+  void SetResourceTracker(FFGLResourceTracker *tracker);
+
+  //number of pack buffers in the ring, i.e. how many frames late the
+  //pixels arrive. 2..8, the default is 3. takes effect once the frames in
+  //flight have been delivered
+  void SetLatency(int frames);
+  int GetLatency() const { return m_latency; }
+
+  //size the source is scaled to before it is read back. 0 keeps the
+  //size of the source
+  void SetOutputSize(GLsizei width, GLsizei height);
+
+  //GL_RGBA (the default) or GL_RGB. with GL_RGB the GPU drops alpha
+  //while it packs the pixels, a quarter less to copy and hand over
+  void SetPixelFormat(GLenum format);
+
+  //with 0 Capture waits for the GPU and the consumer instead of dropping
+  //a frame when either is behind. the default is 1, live output would
+  //rather skip a frame than stall the host
+  void SetDropFrames(int drop);
+
+  //starts the consumer thread, which calls func for every frame read
+  //back. returns 0 if it is already running
+  int Start(ConsumerFunc func);
+
+  //stops the consumer thread. frames not consumed yet are dropped
+  void Stop();
+
+  //render thread. queues a read of the used part of source and delivers
+  //the reads that have completed. never waits for the GPU. returns 0 if
+  //the frame was dropped or pixel buffer objects aren't supported
+  int Capture(const FFGLTextureStruct &source);
+
+  //render thread. as Capture, for a layer of a GL_TEXTURE_2D_ARRAY_EXT
+  //(the output of FF_PROCESSOPENGLBATCH) of width x height. layers are
+  //read at their size, so it fails with an output size set to another one
+  int CaptureLayer(GLuint arrayTexture, GLint layer, GLsizei width, GLsizei height);
+
+  //render thread. waits until every frame captured so far has been read
+  //back and consumed. the consumer thread must be running
+  void Flush();
+
+  //frames dropped because the ring or the consumer was busy
+  unsigned int GetNumDropped() const { return m_numDropped; }
+
+  //render thread, with the context current
+  void FreeGLResources();
+
+private:
+  enum { DEFAULT_LATENCY = 3, MAX_LATENCY = 8 };
+
+  struct Slot
+  {
+    FFGLBuffer buffer;
+    GLsync fence;
+    unsigned int frameNumber;
+    GLsizei width;
+    GLsizei height;
+    GLenum format;
+    int pending;
+  };
+
+  FFGLExtensions *m_extensions;
+  FFGLResourceTracker *m_tracker;
+
+  int m_latency;
+  int m_requestedLatency;
+  GLsizei m_outputWidth;
+  GLsizei m_outputHeight;
+  GLenum m_pixelFormat;
+  int m_dropFrames;
+
+  std::vector<Slot *> m_slots;
+  int m_write;
+  int m_read;
+  unsigned int m_frameNumber;
+
+  //downscale chain, each step at most halves the size so the bilinear
+  //filter averages every source texel
+  std::vector<FFGLTexture *> m_scaleChain;
+  FFGLFramebuffer m_fbo;
+
+  //frames go render thread -> m_ready -> consumer -> m_free -> render
+  //thread. they are only touched by the thread that popped them
+  std::vector<FFGLReadbackFrame *> m_frames;
+  FFGLSPSCQueue<FFGLReadbackFrame *> m_ready;
+  FFGLSPSCQueue<FFGLReadbackFrame *> m_free;
+
+  std::thread m_consumerThread;
+  std::atomic<int> m_running;
+  ConsumerFunc m_consumer;
+
+  //only used to put the consumer to sleep while m_ready is empty
+  std::mutex m_wakeMutex;
+  std::condition_variable m_wake;
+
+  std::atomic<unsigned int> m_numDropped;
+
+  //for Flush: frames handed to the consumer, and the ones it is done with
+  unsigned int m_numDelivered;
+  std::atomic<unsigned int> m_numConsumed;
+
+  void CreateRing();
+  void DeleteRing();
+  void Deliver(int wait);
+  const FFGLTexture *ScaleDown(const FFGLTextureStruct &source, GLsizei width, GLsizei height);
+  int Capture(const FFGLTextureStruct &source, GLint layer);
+  void Attach(GLuint texture, GLint layer);
+  void ConsumerLoop();
+
+  FFGLReadback(const FFGLReadback &);
+  FFGLReadback &operator=(const FFGLReadback &);
+};
+
+#endif
@@ -0,0 +1,412 @@
+#include "FFGLRenderGraph.h"
+#include "FFGLLib.h"
+
+FFGLRenderGraph::FFGLRenderGraph()
+:m_extensions(NULL),
+ m_tracker(NULL),
+ m_hostFBO(0),
+ m_numExecuted(0),
+ m_numCulled(0)
+{
+  Begin(0);
+}
+
+FFGLRenderGraph::~FFGLRenderGraph()
+{
+  FreeGLResources();
+}
+
+void FFGLRenderGraph::SetExtensions(FFGLExtensions *e)
+{
+  m_extensions = e;
+}
+
+void FFGLRenderGraph::SetResourceTracker(FFGLResourceTracker *tracker)
+{
+  m_tracker = tracker;
+}
+
+void FFGLRenderGraph::Begin(GLuint hostFBO)
+{
+  m_hostFBO = hostFBO;
+  m_passes.clear();
+  m_order.clear();
+  m_resources.clear();
+
+  //resource 0 is always the host's framebuffer
+  Resource host;
+  host.kind = RESOURCE_HOST;
+  host.width = 0;
+  host.height = 0;
+  host.internalFormat = 0;
+  host.mipmapped = 0;
+  host.imported.Width = host.imported.Height = 0;
+  host.imported.HardwareWidth = host.imported.HardwareHeight = 0;
+  host.imported.Handle = 0;
+  host.writer = -1;
+  host.lastRead = -1;
+  host.physical = -1;
+  m_resources.push_back(host);
+}
+
+int FFGLRenderGraph::Import(const FFGLTextureStruct &texture)
+{
+  Resource r = m_resources[HOST_OUTPUT];
+  r.kind = RESOURCE_IMPORTED;
+  r.width = texture.Width;
+  r.height = texture.Height;
+  r.imported = texture;
+
+  m_resources.push_back(r);
+  return (int)m_resources.size()-1;
+}
+
+int FFGLRenderGraph::CreateTarget(GLsizei width, GLsizei height, GLint internalFormat)
+{
+  Resource r = m_resources[HOST_OUTPUT];
+  r.kind = RESOURCE_TARGET;
+  r.width = width;
+  r.height = height;
+  r.internalFormat = internalFormat;
+
+  m_resources.push_back(r);
+  return (int)m_resources.size()-1;
+}
+
+int FFGLRenderGraph::CreateMipmappedTarget(GLsizei width, GLsizei height, GLint internalFormat)
+{
+  int target = CreateTarget(width, height, internalFormat);
+  m_resources[target].mipmapped = 1;
+  return target;
+}
+
+int FFGLRenderGraph::AddPass(const char *name, int output, PassFunc func)
+{
+  if (output<0 || output>=(int)m_resources.size())
+    return -1;
+
+  Resource &r = m_resources[output];
+
+  //imported textures are read only, and every target has a single writer
+  //(the host framebuffer may be drawn by several passes, in order)
+  if (r.kind==RESOURCE_IMPORTED || (r.kind==RESOURCE_TARGET && r.writer>=0))
+    return -1;
+
+  Pass p;
+  p.name = name;
+  p.output = output;
+  p.func = func;
+  p.keep = 0;
+  p.live = 0;
+
+  m_passes.push_back(p);
+
+  int pass = (int)m_passes.size()-1;
+  if (r.kind==RESOURCE_TARGET)
+    r.writer = pass;
+
+  return pass;
+}
+
+void FFGLRenderGraph::Read(int pass, int resource)
+{
+  if (pass<0 || pass>=(int)m_passes.size())
+    return;
+
+  if (resource<=HOST_OUTPUT || resource>=(int)m_resources.size())
+    return;
+
+  m_passes[pass].inputs.push_back(resource);
+}
+
+void FFGLRenderGraph::Keep(int pass)
+{
+  if (pass<0 || pass>=(int)m_passes.size())
+    return;
+
+  m_passes[pass].keep = 1;
+}
+
+void FFGLRenderGraph::CullPasses()
+{
+  //a pass is live if it draws to the host or is kept, or if a live pass
+  //reads its output
+  std::vector<int> stack;
+
+  size_t i;
+  for (i=0; i<m_passes.size(); i++)
+  {
+    m_passes[i].live = (m_passes[i].output==HOST_OUTPUT || m_passes[i].keep);
+    if (m_passes[i].live)
+      stack.push_back((int)i);
+  }
+
+  while (!stack.empty())
+  {
+    Pass &p = m_passes[stack.back()];
+    stack.pop_back();
+
+    for (i=0; i<p.inputs.size(); i++)
+    {
+      int writer = m_resources[p.inputs[i]].writer;
+      if (writer>=0 && !m_passes[writer].live)
+      {
+        m_passes[writer].live = 1;
+        stack.push_back(writer);
+      }
+    }
+  }
+}
+
+int FFGLRenderGraph::SortPasses()
+{
+  //passes are few, so a repeated scan is enough. picking the first ready
+  //pass each time keeps the order the plugin declared them in wherever
+  //the dependencies allow it
+  std::vector<int> placed(m_passes.size(), 0);
+
+  int numLive = 0;
+  size_t i, j;
+  for (i=0; i<m_passes.size(); i++)
+    numLive += m_passes[i].live;
+
+  m_order.clear();
+
+  while ((int)m_order.size()<numLive)
+  {
+    int next = -1;
+
+    for (i=0; i<m_passes.size() && next<0; i++)
+    {
+      if (!m_passes[i].live || placed[i])
+        continue;
+
+      int ready = 1;
+      for (j=0; j<m_passes[i].inputs.size(); j++)
+      {
+        int writer = m_resources[m_passes[i].inputs[j]].writer;
+        if (writer>=0 && !placed[writer])
+          ready = 0;
+      }
+
+      if (ready)
+        next = (int)i;
+    }
+
+    if (next<0)
+    {
+      FFDebugMessage("FFGLRenderGraph: passes depend on each other in a cycle\n");
+      return 0;
+    }
+
+    placed[next] = 1;
+    m_order.push_back(next);
+  }
+
+  return 1;
+}
+
+int FFGLRenderGraph::AcquireTarget(Resource &r)
+{
+  //reuse a free pooled texture of the same size and format
+  size_t i;
+  for (i=0; i<m_pool.size(); i++)
+  {
+    PooledTarget &t = m_pool[i];
+    if (!t.inUse &&
+        t.texture->GetWidth()==r.width &&
+        t.texture->GetHeight()==r.height &&
+        t.texture->GetInternalFormat()==r.internalFormat &&
+        t.mipmapped==r.mipmapped)
+    {
+      t.inUse = 1;
+      t.idleFrames = 0;
+      r.physical = (int)i;
+      return 1;
+    }
+  }
+
+  PooledTarget t;
+  t.texture = new FFGLTexture();
+  t.mipmapped = r.mipmapped;
+  t.inUse = 1;
+  t.idleFrames = 0;
+
+  GLenum format, type;
+  FFGLGetPixelTransfer(r.internalFormat, &format, &type);
+
+  if (!t.texture->Allocate(GL_TEXTURE_2D, r.internalFormat, r.width, r.height, format, type, m_tracker))
+  {
+    delete t.texture;
+    return 0;
+  }
+
+  //the nearest level, so a reader at exactly a power of two of the size
+  //gets the texels of that level unblended with the next
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, r.mipmapped ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  m_pool.push_back(t);
+  r.physical = (int)m_pool.size()-1;
+  return 1;
+}
+
+void FFGLRenderGraph::TrimPool()
+{
+  size_t i = 0;
+  while (i<m_pool.size())
+  {
+    if (m_pool[i].idleFrames>MAX_IDLE_FRAMES)
+    {
+      delete m_pool[i].texture;
+      m_pool.erase(m_pool.begin()+i);
+    }
+    else
+    {
+      i++;
+    }
+  }
+}
+
+int FFGLRenderGraph::Execute()
+{
+  m_numExecuted = 0;
+  m_numCulled = 0;
+
+  if (m_extensions==NULL)
+    return 0;
+
+  CullPasses();
+  if (!SortPasses())
+    return 0;
+
+  m_numCulled = (int)(m_passes.size()-m_order.size());
+
+  size_t pos, i;
+
+  //a target can go back to the pool after the last pass reading it
+  for (pos=0; pos<m_order.size(); pos++)
+  {
+    Pass &p = m_passes[m_order[pos]];
+    for (i=0; i<p.inputs.size(); i++)
+      m_resources[p.inputs[i]].lastRead = (int)pos;
+  }
+
+  for (i=0; i<m_pool.size(); i++)
+  {
+    m_pool[i].inUse = 0;
+    m_pool[i].idleFrames++;
+  }
+
+  //every target gets its texture before the first pass runs, so a failed
+  //allocation leaves the frame undrawn rather than half drawn. the
+  //textures are handed out and returned in execution order, which is
+  //what lets targets share them
+  for (pos=0; pos<m_order.size(); pos++)
+  {
+    Pass &p = m_passes[m_order[pos]];
+    Resource &out = m_resources[p.output];
+
+    if (out.kind==RESOURCE_TARGET && !AcquireTarget(out))
+    {
+      TrimPool();
+      return 0;
+    }
+
+    for (i=0; i<p.inputs.size(); i++)
+    {
+      Resource &in = m_resources[p.inputs[i]];
+      if (in.kind==RESOURCE_TARGET && in.lastRead==(int)pos && in.physical>=0)
+        m_pool[in.physical].inUse = 0;
+    }
+  }
+
+  GLint hostViewport[4];
+  glGetIntegerv(GL_VIEWPORT, hostViewport);
+
+  if (!m_fbo.Create(*m_extensions, m_tracker))
+    return 0;
+
+  int onHost = 1;
+
+  for (pos=0; pos<m_order.size(); pos++)
+  {
+    Pass &p = m_passes[m_order[pos]];
+    Resource &out = m_resources[p.output];
+
+    if (out.kind==RESOURCE_HOST)
+    {
+      if (!onHost)
+      {
+        m_extensions->glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_hostFBO);
+        glViewport(hostViewport[0], hostViewport[1], hostViewport[2], hostViewport[3]);
+        onHost = 1;
+      }
+    }
+    else
+    {
+      m_extensions->glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_fbo.GetHandle());
+      m_extensions->glFramebufferTexture2DEXT(
+        GL_FRAMEBUFFER_EXT,
+        GL_COLOR_ATTACHMENT0_EXT,
+        GL_TEXTURE_2D,
+        m_pool[out.physical].texture->GetHandle(),
+        0);
+      glViewport(0, 0, out.width, out.height);
+      onHost = 0;
+    }
+
+    if (p.func)
+      p.func(*this);
+
+    if (out.kind==RESOURCE_TARGET && out.mipmapped)
+      m_pool[out.physical].texture->GenerateMipmaps(*m_extensions);
+
+    m_numExecuted++;
+  }
+
+  if (!onHost)
+  {
+    m_extensions->glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_hostFBO);
+    glViewport(hostViewport[0], hostViewport[1], hostViewport[2], hostViewport[3]);
+  }
+
+  TrimPool();
+
+  return 1;
+}
+
+FFGLTextureStruct FFGLRenderGraph::GetTexture(int resource) const
+{
+  FFGLTextureStruct t = m_resources[HOST_OUTPUT].imported;
+
+  if (resource<=HOST_OUTPUT || resource>=(int)m_resources.size())
+    return t;
+
+  const Resource &r = m_resources[resource];
+
+  if (r.kind==RESOURCE_IMPORTED)
+    return r.imported;
+
+  if (r.physical>=0)
+  {
+    t.Width = t.HardwareWidth = r.width;
+    t.Height = t.HardwareHeight = r.height;
+    t.Handle = m_pool[r.physical].texture->GetHandle();
+  }
+
+  return t;
+}
+
+void FFGLRenderGraph::FreeGLResources()
+{
+  size_t i;
+  for (i=0; i<m_pool.size(); i++)
+    delete m_pool[i].texture;
+
+  m_pool.clear();
+  m_fbo.Release();
+}
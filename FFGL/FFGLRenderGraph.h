@@ -0,0 +1,158 @@
+#ifndef FFGLRENDERGRAPH_H
+#define FFGLRENDERGRAPH_H
+
+#include <FFGL.h>
+#include <FFGLExtensions.h>
+#include <FFGLResources.h>
+#include <functional>
+#include <vector>
+
+//FFGLRenderGraph runs the passes of a multi-pass effect. every frame the
+//plugin declares its passes, which textures each one reads and which
+//target it writes, then calls Execute(). the graph
+// - orders the passes so every target is written before it is read
+// - skips passes whose output nobody reads, unless they are kept
+// - backs the intermediate targets with textures from a pool that lives
+//   across frames, and lets targets whose lifetimes don't overlap share
+//   the same texture
+// - renders every pass through one framebuffer object, and restores the
+//   host's framebuffer and viewport once, at the end
+//
+//a frame looks like
+//
+//  m_graph.Begin( pGL->HostFBO );
+//  int input = m_graph.Import( *pGL->inputTextures[0] );
+//  int blur = m_graph.CreateTarget( w, h );
+//  int pass = m_graph.AddPass( "blur", blur, [=](FFGLRenderGraph &g) { ... } );
+//  m_graph.Read( pass, input );
+//  ...
+//  m_graph.Execute();
+//
+//inside a pass callback the target is bound and the viewport set to its
+//size; GetTexture() gives the textures of the resources it reads
+class FFGLRenderGraph
+{
+public:
+  //resource id of the host's framebuffer. a pass writing it is the final
+  //pass and is never culled
+  enum { HOST_OUTPUT = 0 };
+
+  typedef std::function<void (FFGLRenderGraph &graph)> PassFunc;
+
+  FFGLRenderGraph();
+  ~FFGLRenderGraph();
+
+  void SetExtensions(FFGLExtensions *e);
+  void SetResourceTracker(FFGLResourceTracker *tracker);
+
+  //forgets the passes and resources of the previous frame. pooled
+  //textures are kept
+  void Begin(GLuint hostFBO);
+
+  //makes a texture owned by someone else (usually a host input) readable
+  //by passes. returns its resource id
+  int Import(const FFGLTextureStruct &texture);
+
+  //declares an intermediate render target. it has no GL storage until a
+  //pass that is not culled writes it. returns its resource id
+  int CreateTarget(GLsizei width, GLsizei height, GLint internalFormat = GL_RGBA8);
+
+  //a target whose mip chain is filled after the pass writing it. a pass
+  //drawing it into a target a power of two smaller reads the level of
+  //that size, i.e. the average of every block of texels
+  int CreateMipmappedTarget(GLsizei width, GLsizei height, GLint internalFormat = GL_RGBA8);
+
+  //declares a pass writing output (a target or HOST_OUTPUT). returns the
+  //pass id, or -1 if output is not a writable resource
+  int AddPass(const char *name, int output, PassFunc func);
+
+  //declares that pass samples resource
+  void Read(int pass, int resource);
+
+  //declares that pass has an effect outside the graph (it queues a
+  //readback of its target, say), so it runs even if no pass reads its
+  //output
+  void Keep(int pass);
+
+  //culls, orders, allocates and runs the passes declared since Begin().
+  //returns 0 if the passes depend on each other in a cycle or a target
+  //could not be allocated, in which case nothing is drawn
+  int Execute();
+
+  //the texture backing resource, valid inside pass callbacks
+  FFGLTextureStruct GetTexture(int resource) const;
+
+  //number of passes run / culled by the last Execute()
+  int GetNumExecutedPasses() const { return m_numExecuted; }
+  int GetNumCulledPasses() const { return m_numCulled; }
+
+  //number of pooled textures, i.e. the intermediate targets after aliasing
+  int GetNumPooledTargets() const { return (int)m_pool.size(); }
+
+  void FreeGLResources();
+
+private:
+  enum
+  {
+    RESOURCE_HOST,
+    RESOURCE_IMPORTED,
+    RESOURCE_TARGET
+  };
+
+  //pooled textures nobody used for this many frames are released
+  enum { MAX_IDLE_FRAMES = 60 };
+
+  struct Resource
+  {
+    int kind;
+    GLsizei width;
+    GLsizei height;
+    GLint internalFormat;
+    int mipmapped;
+    FFGLTextureStruct imported;
+    int writer; //pass writing it, -1 if none
+    int lastRead; //position of the last pass reading it, in execution order
+    int physical; //index into m_pool, -1 until allocated
+  };
+
+  struct Pass
+  {
+    const char *name;
+    int output;
+    std::vector<int> inputs;
+    PassFunc func;
+    int keep;
+    int live;
+  };
+
+  struct PooledTarget
+  {
+    FFGLTexture *texture;
+    int mipmapped;
+    int inUse;
+    int idleFrames;
+  };
+
+  FFGLExtensions *m_extensions;
+  FFGLResourceTracker *m_tracker;
+  GLuint m_hostFBO;
+  FFGLFramebuffer m_fbo;
+
+  std::vector<Resource> m_resources;
+  std::vector<Pass> m_passes;
+  std::vector<int> m_order;
+  std::vector<PooledTarget> m_pool;
+
+  int m_numExecuted;
+  int m_numCulled;
+
+  void CullPasses();
+  int SortPasses();
+  int AcquireTarget(Resource &r);
+  void TrimPool();
+
+  FFGLRenderGraph(const FFGLRenderGraph &);
+  FFGLRenderGraph &operator=(const FFGLRenderGraph &);
+};
+
+#endif
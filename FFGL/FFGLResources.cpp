@@ -0,0 +1,614 @@
+#include "FFGLResources.h"
+#include "FFGLLib.h"
+
+//module wide counters, shared by every tracker in this plugin
+static std::atomic<unsigned int> s_globalNumObjects(0);
+static std::atomic<size_t> s_globalNumBytes(0);
+
+size_t FFGLBytesPerPixel(GLint internalFormat)
+{
+  switch (internalFormat)
+  {
+  case 1:
+  case GL_ALPHA:
+  case GL_ALPHA8:
+  case GL_LUMINANCE:
+  case GL_LUMINANCE8:
+  case GL_INTENSITY8:
+    return 1;
+
+  case 2:
+  case GL_LUMINANCE_ALPHA:
+  case GL_LUMINANCE8_ALPHA8:
+  case GL_DEPTH_COMPONENT16:
+    return 2;
+
+  case 3:
+  case GL_RGB:
+  case GL_RGB8:
+  case GL_DEPTH_COMPONENT24:
+    //24 bit formats are padded to 32 bits by every driver we care about
+    return 4;
+
+  case 4:
+  case GL_RGBA:
+  case GL_RGBA8:
+  case GL_RGB10_A2:
+  case GL_DEPTH_COMPONENT32:
+    return 4;
+
+  case GL_RGBA12:
+  case GL_RGBA16:
+  case GL_RGB16F_ARB:
+  case GL_RGBA16F_ARB:
+    return 8;
+
+  case GL_RGB32F_ARB:
+  case GL_RGBA32F_ARB:
+    return 16;
+
+  default:
+    //unknown format, assume the common case
+    return 4;
+  }
+}
+
+void FFGLGetPixelTransfer(GLint internalFormat, GLenum *format, GLenum *type)
+{
+  *format = GL_RGBA;
+
+  switch (internalFormat)
+  {
+  case GL_RGB10_A2:
+    *type = GL_UNSIGNED_INT_2_10_10_10_REV;
+    break;
+
+  case GL_RGBA12:
+  case GL_RGBA16:
+    *type = GL_UNSIGNED_SHORT;
+    break;
+
+  case GL_RGB16F_ARB:
+  case GL_RGBA16F_ARB:
+    *type = GL_HALF_FLOAT_ARB;
+    break;
+
+  case GL_RGB32F_ARB:
+  case GL_RGBA32F_ARB:
+    *type = GL_FLOAT;
+    break;
+
+  default:
+    *type = GL_UNSIGNED_BYTE;
+    break;
+  }
+}
+
+////////////////////////////////////////////////////////
+// FFGLTargetFormat
+////////////////////////////////////////////////////////
+
+static const char *s_precisionNames[FFGL_PRECISION_NUM] =
+{
+  "Auto",
+  "8 bit",
+  "10 bit",
+  "Half float"
+};
+
+FFGLTargetFormat::FFGLTargetFormat()
+:m_precision(FFGL_PRECISION_AUTO),
+ m_inputFormat(GL_RGBA8)
+{
+  m_input.Width = m_input.Height = 0;
+  m_input.HardwareWidth = m_input.HardwareHeight = 0;
+  m_input.Handle = 0;
+}
+
+void FFGLTargetFormat::SetPrecision(int precision)
+{
+  if (precision<0 || precision>=FFGL_PRECISION_NUM)
+    precision = FFGL_PRECISION_AUTO;
+
+  m_precision = precision;
+}
+
+int FFGLTargetFormat::PrecisionFromParam(float value)
+{
+  int precision = (int)(value * (FFGL_PRECISION_NUM-1) + 0.5f);
+  if (precision<0) precision = 0;
+  if (precision>=FFGL_PRECISION_NUM) precision = FFGL_PRECISION_NUM-1;
+  return precision;
+}
+
+const char *FFGLTargetFormat::GetPrecisionName(int precision)
+{
+  if (precision<0 || precision>=FFGL_PRECISION_NUM)
+    precision = FFGL_PRECISION_AUTO;
+
+  return s_precisionNames[precision];
+}
+
+GLint FFGLTargetFormat::Select(FFGLExtensions &e, const FFGLTextureStruct &input)
+{
+  GLint format = GL_RGBA8;
+
+  switch (m_precision)
+  {
+  case FFGL_PRECISION_8BIT:
+    format = GL_RGBA8;
+    break;
+
+  case FFGL_PRECISION_10BIT:
+    format = GL_RGB10_A2;
+    break;
+
+  case FFGL_PRECISION_HALF_FLOAT:
+    format = GL_RGBA16F_ARB;
+    break;
+
+  default:
+    //asking GL is a round trip through the driver, so it is only done
+    //when the host hands over a different texture, or reallocates the
+    //same handle at another size
+    if (input.Handle!=0 &&
+        (input.Handle!=m_input.Handle ||
+         input.Width!=m_input.Width || input.Height!=m_input.Height ||
+         input.HardwareWidth!=m_input.HardwareWidth || input.HardwareHeight!=m_input.HardwareHeight))
+    {
+      GLint bound = 0;
+      glGetIntegerv(GL_TEXTURE_BINDING_2D, &bound);
+      glBindTexture(GL_TEXTURE_2D, input.Handle);
+      glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &m_inputFormat);
+      glBindTexture(GL_TEXTURE_2D, bound);
+
+      m_input = input;
+    }
+
+    switch (m_inputFormat)
+    {
+    case GL_RGB16F_ARB:
+    case GL_RGBA16F_ARB:
+    case GL_RGB32F_ARB:
+    case GL_RGBA32F_ARB:
+      format = GL_RGBA16F_ARB;
+      break;
+
+    case GL_RGB10_A2:
+      format = GL_RGB10_A2;
+      break;
+
+    case GL_RGBA12:
+    case GL_RGBA16:
+      format = GL_RGBA16;
+      break;
+
+    default:
+      format = GL_RGBA8;
+      break;
+    }
+    break;
+  }
+
+  if (format==GL_RGBA16F_ARB && !e.ARB_texture_float)
+    format = GL_RGBA8;
+
+  return format;
+}
+
+////////////////////////////////////////////////////////
+// FFGLResourceTracker
+////////////////////////////////////////////////////////
+
+FFGLResourceTracker::FFGLResourceTracker()
+:m_numObjects(0),
+ m_numBytes(0),
+ m_peakBytes(0)
+{
+}
+
+FFGLResourceTracker::~FFGLResourceTracker()
+{
+}
+
+void FFGLResourceTracker::Add(FFGLResourceTracker *tracker, size_t bytes)
+{
+  s_globalNumObjects++;
+  s_globalNumBytes += bytes;
+
+  if (tracker==NULL)
+    return;
+
+  tracker->m_numObjects++;
+  size_t total = (tracker->m_numBytes += bytes);
+
+  size_t peak = tracker->m_peakBytes;
+  while (total>peak && !tracker->m_peakBytes.compare_exchange_weak(peak, total))
+  {
+  }
+}
+
+void FFGLResourceTracker::Remove(FFGLResourceTracker *tracker, size_t bytes)
+{
+  s_globalNumObjects--;
+  s_globalNumBytes -= bytes;
+
+  if (tracker==NULL)
+    return;
+
+  tracker->m_numObjects--;
+  tracker->m_numBytes -= bytes;
+}
+
+void FFGLResourceTracker::Resize(FFGLResourceTracker *tracker, size_t oldBytes, size_t newBytes)
+{
+  s_globalNumBytes -= oldBytes;
+  s_globalNumBytes += newBytes;
+
+  if (tracker==NULL)
+    return;
+
+  tracker->m_numBytes -= oldBytes;
+  size_t total = (tracker->m_numBytes += newBytes);
+
+  size_t peak = tracker->m_peakBytes;
+  while (total>peak && !tracker->m_peakBytes.compare_exchange_weak(peak, total))
+  {
+  }
+}
+
+void FFGLResourceTracker::Report(const char *label) const
+{
+  unsigned int numObjects = m_numObjects;
+  size_t numBytes = m_numBytes;
+
+  if (numObjects==0)
+  {
+    FFDebugMessage("%s: peak GPU memory %u KB",
+      label,
+      (unsigned int)(m_peakBytes / 1024));
+  }
+  else
+  {
+    FFDebugMessage("%s: peak GPU memory %u KB, %u GL objects (%u KB) not freed by DeInitGL",
+      label,
+      (unsigned int)(m_peakBytes / 1024),
+      numObjects,
+      (unsigned int)(numBytes / 1024));
+  }
+}
+
+unsigned int FFGLResourceTracker::GetGlobalNumObjects()
+{
+  return s_globalNumObjects;
+}
+
+size_t FFGLResourceTracker::GetGlobalNumBytes()
+{
+  return s_globalNumBytes;
+}
+
+int FFGLResourceTracker::CheckGlobalLeaks()
+{
+  unsigned int numObjects = s_globalNumObjects;
+
+  if (numObjects==0)
+    return 1;
+
+  FFDebugMessage("FFGL: %u GL objects (%u KB) leaked at deinitialise",
+    numObjects,
+    (unsigned int)(s_globalNumBytes / 1024));
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////
+// FFGLTexture
+////////////////////////////////////////////////////////
+
+FFGLTexture::FFGLTexture()
+:m_handle(0),
+ m_target(GL_TEXTURE_2D),
+ m_internalFormat(0),
+ m_width(0),
+ m_height(0),
+ m_numLayers(1),
+ m_mipmapped(0),
+ m_bytes(0),
+ m_tracker(NULL)
+{
+}
+
+FFGLTexture::~FFGLTexture()
+{
+  Release();
+}
+
+int FFGLTexture::Allocate(
+  GLenum target,
+  GLint internalFormat,
+  GLsizei width,
+  GLsizei height,
+  GLenum format,
+  GLenum type,
+  FFGLResourceTracker *tracker)
+{
+  if (m_handle!=0 &&
+      m_target==target &&
+      m_internalFormat==internalFormat &&
+      m_width==width &&
+      m_height==height &&
+      m_numLayers==1)
+  {
+    glBindTexture(m_target, m_handle);
+    return 1;
+  }
+
+  Release();
+
+  glGenTextures(1, &m_handle);
+  if (m_handle==0)
+    return 0;
+
+  m_target = target;
+  m_internalFormat = internalFormat;
+  m_width = width;
+  m_height = height;
+  m_numLayers = 1;
+  m_bytes = (size_t)width * (size_t)height * FFGLBytesPerPixel(internalFormat);
+  m_tracker = tracker;
+
+  glBindTexture(m_target, m_handle);
+  glTexImage2D(m_target, 0, m_internalFormat, m_width, m_height, 0, format, type, NULL);
+
+  FFGLResourceTracker::Add(m_tracker, m_bytes);
+
+  //the texture is left bound so the caller can set its parameters
+  return 1;
+}
+
+int FFGLTexture::AllocateArray(
+  FFGLExtensions &e,
+  GLint internalFormat,
+  GLsizei width,
+  GLsizei height,
+  GLsizei numLayers,
+  GLenum format,
+  GLenum type,
+  FFGLResourceTracker *tracker)
+{
+  if (!e.EXT_texture_array || numLayers<1)
+    return 0;
+
+  if (m_handle!=0 &&
+      m_target==GL_TEXTURE_2D_ARRAY_EXT &&
+      m_internalFormat==internalFormat &&
+      m_width==width &&
+      m_height==height &&
+      m_numLayers==numLayers)
+  {
+    glBindTexture(m_target, m_handle);
+    return 1;
+  }
+
+  Release();
+
+  glGenTextures(1, &m_handle);
+  if (m_handle==0)
+    return 0;
+
+  m_target = GL_TEXTURE_2D_ARRAY_EXT;
+  m_internalFormat = internalFormat;
+  m_width = width;
+  m_height = height;
+  m_numLayers = numLayers;
+  m_bytes = (size_t)width * (size_t)height * (size_t)numLayers * FFGLBytesPerPixel(internalFormat);
+  m_tracker = tracker;
+
+  glBindTexture(m_target, m_handle);
+  e.glTexImage3D(m_target, 0, m_internalFormat, m_width, m_height, m_numLayers, 0, format, type, NULL);
+
+  FFGLResourceTracker::Add(m_tracker, m_bytes);
+
+  //the texture is left bound so the caller can set its parameters
+  return 1;
+}
+
+int FFGLTexture::GenerateMipmaps(FFGLExtensions &e)
+{
+  if (m_handle==0 || m_target!=GL_TEXTURE_2D || e.glGenerateMipmapEXT==NULL)
+    return 0;
+
+  glBindTexture(m_target, m_handle);
+  e.glGenerateMipmapEXT(m_target);
+  glBindTexture(m_target, 0);
+
+  if (!m_mipmapped)
+  {
+    //the levels below level 0 add up to a third of it
+    size_t bytes = m_bytes + m_bytes/3;
+    FFGLResourceTracker::Resize(m_tracker, m_bytes, bytes);
+    m_bytes = bytes;
+    m_mipmapped = 1;
+  }
+
+  return 1;
+}
+
+void FFGLTexture::Release()
+{
+  if (m_handle==0)
+    return;
+
+  glDeleteTextures(1, &m_handle);
+  FFGLResourceTracker::Remove(m_tracker, m_bytes);
+
+  m_handle = 0;
+  m_width = 0;
+  m_height = 0;
+  m_numLayers = 1;
+  m_mipmapped = 0;
+  m_bytes = 0;
+  m_tracker = NULL;
+}
+
+////////////////////////////////////////////////////////
+// FFGLFramebuffer
+////////////////////////////////////////////////////////
+
+FFGLFramebuffer::FFGLFramebuffer()
+:m_handle(0),
+ m_extensions(NULL),
+ m_tracker(NULL)
+{
+}
+
+FFGLFramebuffer::~FFGLFramebuffer()
+{
+  Release();
+}
+
+int FFGLFramebuffer::Create(FFGLExtensions &e, FFGLResourceTracker *tracker)
+{
+  if (m_handle!=0)
+    return 1;
+
+  e.glGenFramebuffersEXT(1, &m_handle);
+  if (m_handle==0)
+    return 0;
+
+  m_extensions = &e;
+  m_tracker = tracker;
+
+  FFGLResourceTracker::Add(m_tracker, 0);
+
+  return 1;
+}
+
+void FFGLFramebuffer::Release()
+{
+  if (m_handle==0)
+    return;
+
+  m_extensions->glDeleteFramebuffersEXT(1, &m_handle);
+  FFGLResourceTracker::Remove(m_tracker, 0);
+
+  m_handle = 0;
+  m_tracker = NULL;
+}
+
+////////////////////////////////////////////////////////
+// FFGLRenderbuffer
+////////////////////////////////////////////////////////
+
+FFGLRenderbuffer::FFGLRenderbuffer()
+:m_handle(0),
+ m_bytes(0),
+ m_extensions(NULL),
+ m_tracker(NULL)
+{
+}
+
+FFGLRenderbuffer::~FFGLRenderbuffer()
+{
+  Release();
+}
+
+int FFGLRenderbuffer::Allocate(
+  FFGLExtensions &e,
+  GLenum internalFormat,
+  GLsizei width,
+  GLsizei height,
+  FFGLResourceTracker *tracker)
+{
+  Release();
+
+  e.glGenRenderbuffersEXT(1, &m_handle);
+  if (m_handle==0)
+    return 0;
+
+  m_extensions = &e;
+  m_tracker = tracker;
+  m_bytes = (size_t)width * (size_t)height * FFGLBytesPerPixel(internalFormat);
+
+  e.glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, m_handle);
+  e.glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, internalFormat, width, height);
+
+  FFGLResourceTracker::Add(m_tracker, m_bytes);
+
+  return 1;
+}
+
+void FFGLRenderbuffer::Release()
+{
+  if (m_handle==0)
+    return;
+
+  m_extensions->glDeleteRenderBuffersEXT(1, &m_handle);
+  FFGLResourceTracker::Remove(m_tracker, m_bytes);
+
+  m_handle = 0;
+  m_bytes = 0;
+  m_tracker = NULL;
+}
+
+////////////////////////////////////////////////////////
+// FFGLBuffer
+////////////////////////////////////////////////////////
+
+FFGLBuffer::FFGLBuffer()
+:m_handle(0),
+ m_size(0),
+ m_extensions(NULL),
+ m_tracker(NULL)
+{
+}
+
+FFGLBuffer::~FFGLBuffer()
+{
+  Release();
+}
+
+int FFGLBuffer::Allocate(
+  FFGLExtensions &e,
+  GLenum target,
+  size_t size,
+  const GLvoid *data,
+  GLenum usage,
+  FFGLResourceTracker *tracker)
+{
+  if (e.ARB_vertex_buffer_object==0)
+    return 0;
+
+  if (m_handle==0)
+  {
+    e.glGenBuffersARB(1, &m_handle);
+    if (m_handle==0)
+      return 0;
+
+    m_extensions = &e;
+    m_tracker = tracker;
+    FFGLResourceTracker::Add(m_tracker, 0);
+  }
+
+  e.glBindBufferARB(target, m_handle);
+  e.glBufferDataARB(target, (ptrdiff_t)size, data, usage);
+
+  FFGLResourceTracker::Resize(m_tracker, m_size, size);
+  m_size = size;
+
+  return 1;
+}
+
+void FFGLBuffer::Release()
+{
+  if (m_handle==0)
+    return;
+
+  m_extensions->glDeleteBuffersARB(1, &m_handle);
+  FFGLResourceTracker::Remove(m_tracker, m_size);
+
+  m_handle = 0;
+  m_size = 0;
+  m_tracker = NULL;
+}
@@ -0,0 +1,247 @@
+#ifndef FFGLRESOURCES_H
+#define FFGLRESOURCES_H
+
+#include <FFGL.h>
+#include <FFGLExtensions.h>
+#include <stddef.h>
+#include <atomic>
+
+//returns the approximate size in bytes of one texel of the given
+//internal format, used for GPU memory accounting
+size_t FFGLBytesPerPixel(GLint internalFormat);
+
+//the pixel format and type to pass to glTexImage2D along with
+//internalFormat when allocating storage for it
+void FFGLGetPixelTransfer(GLint internalFormat, GLenum *format, GLenum *type);
+
+//precision of the intermediate textures a plugin renders to
+enum
+{
+  FFGL_PRECISION_AUTO, //follow the input
+  FFGL_PRECISION_8BIT, //GL_RGBA8
+  FFGL_PRECISION_10BIT, //GL_RGB10_A2, note the 2 bit alpha
+  FFGL_PRECISION_HALF_FLOAT, //GL_RGBA16F
+  FFGL_PRECISION_NUM
+};
+
+//FFGLTargetFormat picks the internal format of the intermediate
+//targets that hold (processed) copies of a host input. with
+//FFGL_PRECISION_AUTO they keep the precision of the input, so 10 bit
+//and HDR sources aren't quantized to 8 bits by the first copy; the other
+//settings trade quality for bandwidth explicitly
+class FFGLTargetFormat
+{
+public:
+  FFGLTargetFormat();
+
+  void SetPrecision(int precision);
+  int GetPrecision() const { return m_precision; }
+
+  //maps a 0..1 plugin parameter to a precision and back, and names it
+  static int PrecisionFromParam(float value);
+  static constexpr float PrecisionToParam(int precision) { return (float)precision / (float)(FFGL_PRECISION_NUM-1); }
+  static const char *GetPrecisionName(int precision);
+
+  //the internal format for a target holding a copy of input. the format
+  //of the input is only queried from GL when its handle or any of its
+  //sizes change, i.e. when the host hands over another texture or
+  //respecifies this one at another size. FFGLTextureStruct doesn't carry
+  //the format itself, so a texture respecified at the same size with
+  //another format keeps the format queried before. falls back to
+  //GL_RGBA8 when the driver can't render to float textures
+  GLint Select(FFGLExtensions &e, const FFGLTextureStruct &input);
+
+private:
+  int m_precision;
+  FFGLTextureStruct m_input; //the input m_inputFormat was queried for
+  GLint m_inputFormat;
+};
+
+//FFGLResourceTracker keeps count of the GL objects and the approximate
+//number of bytes of GPU memory held by one plugin instance. every tracker
+//also feeds a set of module wide counters, so the total held by all
+//instances of the plugin can be queried at any time.
+//all counters are atomic so a host thread may query them while the
+//render thread allocates
+class FFGLResourceTracker
+{
+public:
+  FFGLResourceTracker();
+  ~FFGLResourceTracker();
+
+  //record an object (and its storage) being created or destroyed.
+  //tracker may be NULL, in which case only the global counters change
+  static void Add(FFGLResourceTracker *tracker, size_t bytes);
+  static void Remove(FFGLResourceTracker *tracker, size_t bytes);
+
+  //record the storage of an already counted object changing size
+  static void Resize(FFGLResourceTracker *tracker, size_t oldBytes, size_t newBytes);
+
+  unsigned int GetNumObjects() const { return m_numObjects; }
+  size_t GetNumBytes() const { return m_numBytes; }
+  size_t GetPeakBytes() const { return m_peakBytes; }
+
+  //prints a one line summary of this tracker. objects still alive
+  //are reported as leaks
+  void Report(const char *label) const;
+
+  static unsigned int GetGlobalNumObjects();
+  static size_t GetGlobalNumBytes();
+
+  //reports and returns 0 if any tracked GL object is still alive
+  static int CheckGlobalLeaks();
+
+private:
+  std::atomic<unsigned int> m_numObjects;
+  std::atomic<size_t> m_numBytes;
+  std::atomic<size_t> m_peakBytes;
+
+  //not copyable
+  FFGLResourceTracker(const FFGLResourceTracker &);
+  FFGLResourceTracker &operator=(const FFGLResourceTracker &);
+};
+
+//the classes below own a single GL object each. the object is deleted by
+//Release() or, at the latest, by the destructor - so a plugin that forgets
+//to free something in DeInitGL no longer leaks it for the life of the host.
+//deleting GL objects needs a current context, which the SDK guarantees
+//during DeInitGL and when deInstantiateGL deletes the instance
+
+class FFGLTexture
+{
+public:
+  FFGLTexture();
+  ~FFGLTexture();
+
+  //allocates storage for a 2D texture. if the texture already exists with
+  //the same size and format this is a no-op, otherwise it is reallocated
+  int Allocate(
+    GLenum target,
+    GLint internalFormat,
+    GLsizei width,
+    GLsizei height,
+    GLenum format,
+    GLenum type,
+    FFGLResourceTracker *tracker);
+
+  //allocates storage for a GL_TEXTURE_2D_ARRAY_EXT of numLayers layers,
+  //e.g. the output of FF_PROCESSOPENGLBATCH. needs EXT_texture_array
+  int AllocateArray(
+    FFGLExtensions &e,
+    GLint internalFormat,
+    GLsizei width,
+    GLsizei height,
+    GLsizei numLayers,
+    GLenum format,
+    GLenum type,
+    FFGLResourceTracker *tracker);
+
+  //fills the mip chain of a GL_TEXTURE_2D from level 0, allocating the
+  //chain the first time. needs EXT_framebuffer_object
+  int GenerateMipmaps(FFGLExtensions &e);
+
+  void Release();
+
+  GLuint GetHandle() const { return m_handle; }
+  GLenum GetTarget() const { return m_target; }
+  GLint GetInternalFormat() const { return m_internalFormat; }
+  GLsizei GetWidth() const { return m_width; }
+  GLsizei GetHeight() const { return m_height; }
+  GLsizei GetNumLayers() const { return m_numLayers; }
+  size_t GetNumBytes() const { return m_bytes; }
+
+private:
+  GLuint m_handle;
+  GLenum m_target;
+  GLint m_internalFormat;
+  GLsizei m_width;
+  GLsizei m_height;
+  GLsizei m_numLayers;
+  int m_mipmapped;
+  size_t m_bytes;
+  FFGLResourceTracker *m_tracker;
+
+  FFGLTexture(const FFGLTexture &);
+  FFGLTexture &operator=(const FFGLTexture &);
+};
+
+class FFGLFramebuffer
+{
+public:
+  FFGLFramebuffer();
+  ~FFGLFramebuffer();
+
+  //creates the framebuffer object if it doesn't exist yet
+  int Create(FFGLExtensions &e, FFGLResourceTracker *tracker);
+  void Release();
+
+  GLuint GetHandle() const { return m_handle; }
+
+private:
+  GLuint m_handle;
+  FFGLExtensions *m_extensions;
+  FFGLResourceTracker *m_tracker;
+
+  FFGLFramebuffer(const FFGLFramebuffer &);
+  FFGLFramebuffer &operator=(const FFGLFramebuffer &);
+};
+
+class FFGLRenderbuffer
+{
+public:
+  FFGLRenderbuffer();
+  ~FFGLRenderbuffer();
+
+  int Allocate(
+    FFGLExtensions &e,
+    GLenum internalFormat,
+    GLsizei width,
+    GLsizei height,
+    FFGLResourceTracker *tracker);
+
+  void Release();
+
+  GLuint GetHandle() const { return m_handle; }
+
+private:
+  GLuint m_handle;
+  size_t m_bytes;
+  FFGLExtensions *m_extensions;
+  FFGLResourceTracker *m_tracker;
+
+  FFGLRenderbuffer(const FFGLRenderbuffer &);
+  FFGLRenderbuffer &operator=(const FFGLRenderbuffer &);
+};
+
+class FFGLBuffer
+{
+public:
+  FFGLBuffer();
+  ~FFGLBuffer();
+
+  //creates the buffer object if needed and (re)specifies its storage.
+  //the buffer is left bound to target
+  int Allocate(
+    FFGLExtensions &e,
+    GLenum target,
+    size_t size,
+    const GLvoid *data,
+    GLenum usage,
+    FFGLResourceTracker *tracker);
+
+  void Release();
+
+  GLuint GetHandle() const { return m_handle; }
+  size_t GetSize() const { return m_size; }
+
+private:
+  GLuint m_handle;
+  size_t m_size;
+  FFGLExtensions *m_extensions;
+  FFGLResourceTracker *m_tracker;
+
+  FFGLBuffer(const FFGLBuffer &);
+  FFGLBuffer &operator=(const FFGLBuffer &);
+};
+
+#endif
@@ -1,12 +1,18 @@
 #include "FFGLShader.h"
+#include "FFGLLib.h"
+
+static std::atomic<unsigned int> s_uniformsVersion(0);
 
 FFGLShader::FFGLShader()
+:m_compileState(COMPILE_IDLE),
+ m_uniformsVersion(0)
 {
   m_linkStatus = 0;
   m_glProgram = 0;
   m_glVertexShader = 0;
   m_glFragmentShader = 0;
   m_extensions = NULL;
+  m_tracker = NULL;
 }
 
 void FFGLShader::CreateGLResources()
@@ -15,37 +21,58 @@ void FFGLShader::CreateGLResources()
     return;
 
   if (m_glProgram==0)
+  {
     m_glProgram = m_extensions->glCreateProgramObjectARB();
+    if (m_glProgram)
+      FFGLResourceTracker::Add(m_tracker, 0);
+  }
 
   if (m_glVertexShader==0)
+  {
     m_glVertexShader = m_extensions->glCreateShaderObjectARB(GL_VERTEX_SHADER_ARB);
+    if (m_glVertexShader)
+      FFGLResourceTracker::Add(m_tracker, 0);
+  }
 
   if (m_glFragmentShader==0)
+  {
     m_glFragmentShader = m_extensions->glCreateShaderObjectARB(GL_FRAGMENT_SHADER_ARB);
+    if (m_glFragmentShader)
+      FFGLResourceTracker::Add(m_tracker, 0);
+  }
 }
 
 void FFGLShader::FreeGLResources()
 {
+  //the worker may still be using the objects
+  WaitForCompile();
+
   if (m_extensions==NULL)
     return;
 
   if (m_glFragmentShader)
   {
     m_extensions->glDeleteObjectARB(m_glFragmentShader);
+    FFGLResourceTracker::Remove(m_tracker, 0);
     m_glFragmentShader = 0;
   }
 
   if (m_glVertexShader)
   {
     m_extensions->glDeleteObjectARB(m_glVertexShader);
+    FFGLResourceTracker::Remove(m_tracker, 0);
     m_glVertexShader = 0;
   }
 
   if (m_glProgram)
   {
     m_extensions->glDeleteObjectARB(m_glProgram);
+    FFGLResourceTracker::Remove(m_tracker, 0);
     m_glProgram = 0;
   }
+
+  m_linkStatus = 0;
+  m_uniforms.clear();
 }
 
 int FFGLShader::BindShader()
@@ -77,6 +104,8 @@ int FFGLShader::UnbindShader()
 
 FFGLShader::~FFGLShader()
 {
+  //in case the plugin didn't free its shader in DeInitGL
+  FreeGLResources();
 }
 
 void FFGLShader::SetExtensions(FFGLExtensions *e)
@@ -84,129 +113,260 @@ void FFGLShader::SetExtensions(FFGLExtensions *e)
   m_extensions = e;
 }
 
-int FFGLShader::Compile(const char *vtxProgram, const char *fragProgram)
+void FFGLShader::SetResourceTracker(FFGLResourceTracker *tracker)
+{
+  m_tracker = tracker;
+}
+
+void FFGLShader::WaitForCompile()
+{
+  if (m_compileThread.joinable())
+    m_compileThread.join();
+
+  m_compileState = COMPILE_IDLE;
+}
+
+int FFGLShader::SourceAndCompile(GLenum shader, const char *defines, const char *program)
+{
+  if (shader==0 || m_glProgram==0 ||
+      program==NULL || program[0]==0)
+    return 0;
+
+  //the defines go in as a separate string so the program text
+  //never has to be copied
+  const char *strings[] =
+  {
+    (defines!=NULL) ? defines : "",
+    program,
+    NULL
+  };
+
+  // Load Shader Sources
+  m_extensions->glShaderSourceARB(shader, 2, strings, NULL);
+
+  // Compile The Shaders
+  m_extensions->glCompileShaderARB(shader);
+
+  return 1;
+}
+
+int FFGLShader::CheckCompileStatus(GLenum shader)
+{
+  GLint compileSuccess = 0;
+
+  m_extensions->glGetObjectParameterivARB(
+    shader,
+    GL_OBJECT_COMPILE_STATUS_ARB,
+    &compileSuccess);
+
+  if (compileSuccess == GL_TRUE)
+    return 1;
+
+  //get the log so we can peek at the error string
+  char log[1024];
+  GLsizei returnedLength = 0;
+
+  m_extensions->glGetInfoLogARB(
+    shader,
+    sizeof(log)-1,
+    &returnedLength,
+    log);
+
+  log[returnedLength] = 0;
+  FFDebugMessage("FFGLShader: compile failed\n%s", log);
+
+  return 0;
+}
+
+int FFGLShader::LinkProgram(int attachVertex, int attachFragment)
+{
+  if (attachFragment)
+    m_extensions->glAttachObjectARB(m_glProgram, m_glFragmentShader);
+
+  if (attachVertex)
+    m_extensions->glAttachObjectARB(m_glProgram, m_glVertexShader);
+
+  //check if linking worked
+  GLint linkSuccess = 0;
+
+  if (attachVertex || attachFragment)
+  {
+    // Link The Program Object
+    m_extensions->glLinkProgramARB(m_glProgram);
+
+    //with KHR_parallel_shader_compile this returns right away, the
+    //status is only queried once the driver reports completion
+    if (m_compileState!=COMPILE_PARALLEL)
+    {
+      m_extensions->glGetObjectParameterivARB(
+        m_glProgram,
+        GL_OBJECT_LINK_STATUS_ARB,
+        &linkSuccess);
+    }
+  }
+
+  return linkSuccess;
+}
+
+int FFGLShader::Compile(const char *vtxProgram, const char *fragProgram, const char *defines)
 {
   if (m_extensions==NULL)
     return 0;
-  
+
+  WaitForCompile();
+
   if (m_glProgram==0)
     CreateGLResources();
-  
-  int doLink = 0;
 
   //if we can compile a fragment shader, do it.
-  if (m_glFragmentShader!=0 &&
-      m_glProgram!=0 &&
-      fragProgram!=NULL && fragProgram[0]!=0)
+  int fragOk = 0;
+  if (SourceAndCompile(m_glFragmentShader, defines, fragProgram))
+    fragOk = CheckCompileStatus(m_glFragmentShader);
+
+  //if we can compile a vertex shader, do it
+  int vtxOk = 0;
+  if (SourceAndCompile(m_glVertexShader, defines, vtxProgram))
+    vtxOk = CheckCompileStatus(m_glVertexShader);
+
+  m_linkStatus = LinkProgram(vtxOk, fragOk);
+  ReadActiveUniforms();
+
+  return m_linkStatus;
+}
+
+int FFGLShader::BeginCompile(const char *vtxProgram, const char *fragProgram, const char *defines)
+{
+  if (m_extensions==NULL)
+    return 0;
+
+  WaitForCompile();
+
+  if (m_glProgram==0)
+    CreateGLResources();
+
+  m_linkStatus = 0;
+
+  if (m_extensions->KHR_parallel_shader_compile)
   {
-    const char *strings[] =
-    {
-      fragProgram,
-      NULL
-    };
-
-    // Load Shader Sources
-    m_extensions->glShaderSourceARB(m_glFragmentShader, 1, strings, NULL);
-
-    // Compile The Shaders
-    m_extensions->glCompileShaderARB(m_glFragmentShader);
-    
-    GLint compileSuccess;
-    
-    m_extensions->glGetObjectParameterivARB(
-      m_glFragmentShader,
-      GL_OBJECT_COMPILE_STATUS_ARB,
-      &compileSuccess);
-
-    if (compileSuccess == GL_TRUE)
-    {
-      //attach it to the program
-      m_extensions->glAttachObjectARB(m_glProgram, m_glFragmentShader);
-      doLink = 1;
-    }
-    else
-    {
-      //get the log so we can peek at the error string
-      char log[1024];
-      GLsizei returnedLength;
-      
-      m_extensions->glGetInfoLogARB(
-        m_glFragmentShader,
-        sizeof(log)-1,
-        &returnedLength,
-        log);
-
-      log[returnedLength] = 0;
-      int a;
-      a=0;
-    }
+    //compile errors are picked up by the link status, so both
+    //shaders are attached without waiting for them
+    int fragStarted = SourceAndCompile(m_glFragmentShader, defines, fragProgram);
+    int vtxStarted = SourceAndCompile(m_glVertexShader, defines, vtxProgram);
+
+    if (!fragStarted && !vtxStarted)
+      return 0;
+
+    m_compileState = COMPILE_PARALLEL;
+    LinkProgram(vtxStarted, fragStarted);
+
+    return 1;
   }
 
-  //if we can compile a vertex shader, do it
-  if (m_glVertexShader!=0 &&
-      m_glProgram!=0 &&
-      vtxProgram!=0 && vtxProgram[0]!=0)
+#ifdef _WIN32
+  HDC dc = wglGetCurrentDC();
+  HGLRC hostContext = wglGetCurrentContext();
+  HGLRC workerContext = NULL;
+
+  if (dc!=NULL && hostContext!=NULL)
+    workerContext = wglCreateContext(dc);
+
+  //the new context has no objects yet, so it can join the host's share group
+  if (workerContext!=NULL && wglShareLists(hostContext, workerContext))
   {
-    const char *strings[] =
-    {
-      vtxProgram,
-      NULL
-    };
+    m_vtxSource = (vtxProgram!=NULL) ? vtxProgram : "";
+    m_fragSource = (fragProgram!=NULL) ? fragProgram : "";
+    m_defines = (defines!=NULL) ? defines : "";
 
-    // Load Shader Sources
-    m_extensions->glShaderSourceARB(m_glVertexShader, 1, strings, NULL);
+    m_compileState = COMPILE_THREAD;
+    m_compileThread = std::thread(&FFGLShader::CompileOnWorker, this, dc, workerContext);
 
-    // Compile The Shaders
-    m_extensions->glCompileShaderARB(m_glVertexShader);
+    return 1;
+  }
 
-    GLint compileSuccess;
-      
-    m_extensions->glGetObjectParameterivARB(
-      m_glVertexShader,
-      GL_OBJECT_COMPILE_STATUS_ARB,
-      &compileSuccess);
+  if (workerContext!=NULL)
+    wglDeleteContext(workerContext);
+#endif
 
-    if (compileSuccess == GL_TRUE)
-    {
-      //attach it to the program
-      m_extensions->glAttachObjectARB(m_glProgram, m_glVertexShader);
-      doLink = 1;
-    } 
-    else
-    {
-      //get the log so we can peek at the error string
-      char log[1024];
-      GLsizei returnedLength;
-      
-      m_extensions->glGetInfoLogARB(
-        m_glVertexShader,
-        sizeof(log)-1,
-        &returnedLength,
-        log);
-
-      log[returnedLength] = 0;
-      int a;
-      a=0;
-    }     
+  //no way to compile in the background
+  Compile(vtxProgram, fragProgram, defines);
+  return 1;
+}
+
+#ifdef _WIN32
+void FFGLShader::CompileOnWorker(HDC dc, HGLRC workerContext)
+{
+  if (wglMakeCurrent(dc, workerContext))
+  {
+    int fragOk = 0;
+    if (SourceAndCompile(m_glFragmentShader, m_defines.c_str(), m_fragSource.c_str()))
+      fragOk = CheckCompileStatus(m_glFragmentShader);
+
+    int vtxOk = 0;
+    if (SourceAndCompile(m_glVertexShader, m_defines.c_str(), m_vtxSource.c_str()))
+      vtxOk = CheckCompileStatus(m_glVertexShader);
+
+    m_linkStatus = LinkProgram(vtxOk, fragOk);
+
+    //make sure the program is complete before the host context uses it
+    glFinish();
+
+    wglMakeCurrent(NULL, NULL);
   }
-  
-  //check if linking worked
-  GLint linkSuccess = 0;
 
-  if (doLink)
+  wglDeleteContext(workerContext);
+
+  m_compileState = COMPILE_THREAD_DONE;
+}
+#endif
+
+int FFGLShader::IsCompileComplete()
+{
+  switch (m_compileState)
   {
-    // Link The Program Object
-    m_extensions->glLinkProgramARB(m_glProgram);
-      
-	  m_extensions->glGetObjectParameterivARB(
-	    m_glProgram,
-	    GL_OBJECT_LINK_STATUS_ARB,
-	    &linkSuccess);  
+  case COMPILE_PARALLEL:
+    {
+      GLint complete = 0;
+
+      m_extensions->glGetObjectParameterivARB(
+        m_glProgram,
+        GL_COMPLETION_STATUS_KHR,
+        &complete);
+
+      if (!complete)
+        return 0;
+
+      m_compileState = COMPILE_IDLE;
+
+      GLint linkSuccess = 0;
+
+      m_extensions->glGetObjectParameterivARB(
+        m_glProgram,
+        GL_OBJECT_LINK_STATUS_ARB,
+        &linkSuccess);
+
+      if (!linkSuccess)
+      {
+        //report whichever shader failed
+        CheckCompileStatus(m_glFragmentShader);
+        CheckCompileStatus(m_glVertexShader);
+      }
+
+      m_linkStatus = linkSuccess;
+      ReadActiveUniforms();
+      return 1;
+    }
+
+  case COMPILE_THREAD:
+    return 0;
+
+  case COMPILE_THREAD_DONE:
+    WaitForCompile();
+    ReadActiveUniforms();
+    return 1;
+
+  default:
+    return 1;
   }
-  
-  m_linkStatus = linkSuccess;
-  
-  return linkSuccess;
 }
 
 GLint FFGLShader::GetVertexShaderID()
@@ -228,3 +388,138 @@ GLuint FFGLShader::FindUniform(const char *name)
 {
   return m_extensions->glGetUniformLocationARB(m_glProgram,name);
 }
+
+void FFGLShader::ReadActiveUniforms()
+{
+  m_uniforms.clear();
+
+  //unique across all shaders, so a new shader allocated where a deleted
+  //one used to be can't be mistaken for it
+  m_uniformsVersion = ++s_uniformsVersion;
+
+  if (m_linkStatus!=1)
+    return;
+
+  GLint numUniforms = 0;
+  GLint maxLength = 0;
+
+  m_extensions->glGetObjectParameterivARB(m_glProgram, GL_OBJECT_ACTIVE_UNIFORMS_ARB, &numUniforms);
+  m_extensions->glGetObjectParameterivARB(m_glProgram, GL_OBJECT_ACTIVE_UNIFORM_MAX_LENGTH_ARB, &maxLength);
+
+  if (numUniforms<=0 || maxLength<=0)
+    return;
+
+  std::vector<GLcharARB> name(maxLength+1);
+
+  for (GLint i=0; i<numUniforms; i++)
+  {
+    Uniform u;
+    GLsizei length = 0;
+
+    m_extensions->glGetActiveUniformARB(
+      m_glProgram,
+      i,
+      maxLength,
+      &length,
+      &u.size,
+      &u.type,
+      &name[0]);
+
+    name[length] = 0;
+
+    //arrays are reported as "name[0]", they're looked up by their plain name
+    u.name = &name[0];
+    size_t bracket = u.name.find('[');
+    if (bracket!=std::string::npos)
+      u.name.erase(bracket);
+
+    //built in uniforms (gl_*) have no location
+    u.location = m_extensions->glGetUniformLocationARB(m_glProgram, &name[0]);
+    if (u.location<0)
+      continue;
+
+    u.valid = 0;
+    u.value[0] = u.value[1] = u.value[2] = u.value[3] = 0.0f;
+
+    m_uniforms.push_back(u);
+  }
+}
+
+int FFGLShader::FindUniformIndex(const char *name) const
+{
+  for (size_t i=0; i<m_uniforms.size(); i++)
+  {
+    if (m_uniforms[i].name==name)
+      return (int)i;
+  }
+
+  return -1;
+}
+
+FFGLShader::Uniform *FFGLShader::GetUniformIfChanged(int index, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+  if (index<0 || index>=(int)m_uniforms.size())
+    return NULL;
+
+  Uniform &u = m_uniforms[index];
+
+  if (u.valid &&
+      u.value[0]==x && u.value[1]==y &&
+      u.value[2]==z && u.value[3]==w)
+    return NULL;
+
+  u.valid = 1;
+  u.value[0] = x;
+  u.value[1] = y;
+  u.value[2] = z;
+  u.value[3] = w;
+
+  return &u;
+}
+
+void FFGLShader::SetUniform1i(int index, GLint value)
+{
+  Uniform *u = GetUniformIfChanged(index, (GLfloat)value, 0.0f, 0.0f, 0.0f);
+  if (u!=NULL)
+    m_extensions->glUniform1iARB(u->location, value);
+}
+
+void FFGLShader::SetUniform1f(int index, GLfloat value)
+{
+  Uniform *u = GetUniformIfChanged(index, value, 0.0f, 0.0f, 0.0f);
+  if (u==NULL)
+    return;
+
+  //boolean plugin parameters are floats, but may be declared
+  //as bool or int in the shader
+  if (u->type==GL_BOOL_ARB || u->type==GL_INT)
+    m_extensions->glUniform1iARB(u->location, (GLint)(value+0.5f));
+  else
+    m_extensions->glUniform1fARB(u->location, value);
+}
+
+void FFGLShader::SetUniform2f(int index, GLfloat x, GLfloat y)
+{
+  Uniform *u = GetUniformIfChanged(index, x, y, 0.0f, 0.0f);
+  if (u!=NULL)
+    m_extensions->glUniform2fARB(u->location, x, y);
+}
+
+void FFGLShader::SetUniform4f(int index, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+  Uniform *u = GetUniformIfChanged(index, x, y, z, w);
+  if (u!=NULL)
+    m_extensions->glUniform4fARB(u->location, x, y, z, w);
+}
+
+void FFGLShader::SetUniform2fv(int index, GLsizei count, const GLfloat *values)
+{
+  if (index<0 || index>=(int)m_uniforms.size())
+    return;
+
+  Uniform &u = m_uniforms[index];
+  if (count>u.size)
+    count = u.size;
+
+  m_extensions->glUniform2fvARB(u.location, count, values);
+}
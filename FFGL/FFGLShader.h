@@ -3,6 +3,11 @@
 
 #include <FFGL.h>
 #include <FFGLExtensions.h>
+#include <FFGLResources.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
 
 class FFGLShader
 {
@@ -11,30 +16,108 @@ public:
   virtual ~FFGLShader();
 
   void SetExtensions(FFGLExtensions *e);
-  
+
+  //GL objects created after this call are counted against tracker
+  void SetResourceTracker(FFGLResourceTracker *tracker);
+
   int IsReady() { return (m_glProgram!=0 && m_glVertexShader!=0 && m_glFragmentShader!=0 && m_linkStatus==1); }
-  
-  int Compile(const char *vtxProgram, const char *fragProgram);
+
+  //compiles and links right away, blocking the calling thread.
+  //defines (e.g. "#define FOO 1\n") is prepended to both programs, so one
+  //source can be specialized into several variants
+  int Compile(const char *vtxProgram, const char *fragProgram, const char *defines = NULL);
+
+  //starts compiling and linking without waiting for the driver.
+  //with KHR_parallel_shader_compile the driver does the work in the
+  //background, otherwise (on windows) it is done by a worker thread
+  //on a context that shares objects with the current one. elsewhere
+  //this falls back to Compile(). returns 0 if nothing could be started
+  int BeginCompile(const char *vtxProgram, const char *fragProgram, const char *defines = NULL);
+
+  //polls a compile started by BeginCompile, never blocks.
+  //returns 1 once the program has finished (check IsReady() to see if
+  //it linked), 0 while the driver or worker is still busy
+  int IsCompileComplete();
 
   int GetVertexShaderID();
   int GetFragmentShaderID();
   int GetShaderID();
 
   GLuint FindUniform(const char *name);
-  
+
+  //the active uniforms of the program are read once, when it links.
+  //FindUniformIndex looks a name up in that table without calling GL
+  //and returns -1 if the uniform isn't active. the SetUniform functions
+  //take that index, remember the last value uploaded to the program and
+  //skip the upload when it hasn't changed. the program must be bound
+  int GetNumUniforms() const { return (int)m_uniforms.size(); }
+
+  //changes whenever the table is rebuilt, i.e. indexes from
+  //FindUniformIndex are only valid while this stays the same
+  unsigned int GetUniformsVersion() const { return m_uniformsVersion; }
+  int FindUniformIndex(const char *name) const;
+  void SetUniform1i(int index, GLint value);
+  void SetUniform1f(int index, GLfloat value);
+  void SetUniform2f(int index, GLfloat x, GLfloat y);
+  void SetUniform4f(int index, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+
+  //uploads count vec2s to an array uniform. arrays aren't cached, every
+  //call uploads, and count is cut to the size of the array
+  void SetUniform2fv(int index, GLsizei count, const GLfloat *values);
+
   int BindShader();
   int UnbindShader();
 
   void FreeGLResources();
 
 private:
+  enum
+  {
+    COMPILE_IDLE,
+    COMPILE_PARALLEL, //driver compiles, we poll GL_COMPLETION_STATUS_KHR
+    COMPILE_THREAD, //worker thread compiles on a shared context
+    COMPILE_THREAD_DONE
+  };
+
+  struct Uniform
+  {
+    std::string name;
+    GLint location;
+    GLenum type;
+    GLint size;
+    int valid; //value holds what was last uploaded
+    GLfloat value[4];
+  };
+
   FFGLExtensions *m_extensions;
+  FFGLResourceTracker *m_tracker;
   GLenum m_glProgram;
   GLenum m_glVertexShader;
   GLenum m_glFragmentShader;
   GLuint m_linkStatus;
-  
+
+  std::atomic<int> m_compileState;
+  std::thread m_compileThread;
+
+  //the worker thread reads the sources after BeginCompile returns
+  std::string m_vtxSource;
+  std::string m_fragSource;
+  std::string m_defines;
+
+  std::vector<Uniform> m_uniforms;
+  unsigned int m_uniformsVersion;
+
   void CreateGLResources();
+  void WaitForCompile();
+  int SourceAndCompile(GLenum shader, const char *defines, const char *program);
+  int CheckCompileStatus(GLenum shader);
+  int LinkProgram(int attachVertex, int attachFragment);
+  void ReadActiveUniforms();
+  Uniform *GetUniformIfChanged(int index, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+
+#ifdef _WIN32
+  void CompileOnWorker(HDC dc, HGLRC workerContext);
+#endif
 };
 
 #endif
@@ -0,0 +1,122 @@
+#include "FFGLShaderCache.h"
+
+FFGLShaderCache::FFGLShaderCache()
+:m_extensions(NULL),
+ m_tracker(NULL),
+ m_vtxProgram(NULL),
+ m_fragProgram(NULL)
+{
+}
+
+FFGLShaderCache::~FFGLShaderCache()
+{
+  FreeGLResources();
+}
+
+void FFGLShaderCache::SetExtensions(FFGLExtensions *e)
+{
+  m_extensions = e;
+}
+
+void FFGLShaderCache::SetResourceTracker(FFGLResourceTracker *tracker)
+{
+  m_tracker = tracker;
+}
+
+void FFGLShaderCache::SetSource(const char *vtxProgram, const char *fragProgram)
+{
+  m_vtxProgram = vtxProgram;
+  m_fragProgram = fragProgram;
+}
+
+void FFGLShaderCache::Add(unsigned int key, const char *defines)
+{
+  if (m_variants.find(key)!=m_variants.end())
+    return;
+
+  Variant v;
+  v.shader = new FFGLShader();
+  v.shader->SetExtensions(m_extensions);
+  v.shader->SetResourceTracker(m_tracker);
+  v.defines = (defines!=NULL) ? defines : "";
+  v.started = 0;
+
+  m_variants[key] = v;
+
+  Update();
+}
+
+int FFGLShaderCache::Update()
+{
+  if (m_extensions==NULL)
+    return 0;
+
+  //the worker thread fallback creates a context per compile, so without
+  //driver side parallel compilation only one variant is in flight at a time
+  int maxInFlight = m_extensions->KHR_parallel_shader_compile ? (int)m_variants.size() : 1;
+  int inFlight = 0;
+
+  VariantMap::iterator it;
+  for (it = m_variants.begin(); it!=m_variants.end(); ++it)
+  {
+    if (it->second.started && !it->second.shader->IsCompileComplete())
+      inFlight++;
+  }
+
+  for (it = m_variants.begin(); it!=m_variants.end() && inFlight<maxInFlight; ++it)
+  {
+    Variant &v = it->second;
+
+    if (v.started)
+      continue;
+
+    v.started = 1;
+    if (v.shader->BeginCompile(m_vtxProgram, m_fragProgram, v.defines.c_str()) &&
+        !v.shader->IsCompileComplete())
+      inFlight++;
+  }
+
+  return inFlight;
+}
+
+FFGLShader *FFGLShaderCache::Get(unsigned int key)
+{
+  VariantMap::iterator it = m_variants.find(key);
+  if (it==m_variants.end())
+    return NULL;
+
+  Update();
+
+  Variant &v = it->second;
+  if (!v.started || !v.shader->IsCompileComplete() || !v.shader->IsReady())
+    return NULL;
+
+  return v.shader;
+}
+
+int FFGLShaderCache::IsComplete()
+{
+  if (Update()!=0)
+    return 0;
+
+  VariantMap::iterator it;
+  for (it = m_variants.begin(); it!=m_variants.end(); ++it)
+  {
+    if (!it->second.started)
+      return 0;
+  }
+
+  return 1;
+}
+
+void FFGLShaderCache::FreeGLResources()
+{
+  VariantMap::iterator it;
+  for (it = m_variants.begin(); it!=m_variants.end(); ++it)
+  {
+    it->second.shader->FreeGLResources();
+    delete it->second.shader;
+  }
+
+  m_variants.clear();
+}
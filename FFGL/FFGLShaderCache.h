@@ -0,0 +1,69 @@
+#ifndef FFGLSHADERCACHE_H
+#define FFGLSHADERCACHE_H
+
+#include <FFGL.h>
+#include <FFGLExtensions.h>
+#include <FFGLResources.h>
+#include <FFGLShader.h>
+#include <map>
+#include <string>
+
+//FFGLShaderCache specializes one vertex/fragment program pair into
+//variants by prepending a block of #defines, so the choices a plugin
+//would otherwise make per pixel from uniforms are made by the GLSL
+//compiler instead. the plugin picks a key for every combination of
+//options it cares about (usually a small bitmask), adds the variants
+//it needs and asks for the one matching its current parameters.
+//
+//variants are compiled with FFGLShader::BeginCompile so adding them
+//never stalls the host. when the driver can't compile in the
+//background the cache starts one variant at a time
+class FFGLShaderCache
+{
+public:
+  FFGLShaderCache();
+  ~FFGLShaderCache();
+
+  void SetExtensions(FFGLExtensions *e);
+  void SetResourceTracker(FFGLResourceTracker *tracker);
+
+  //the program text shared by every variant. both strings must stay
+  //valid for the life of the cache (the usual STRINGIFY globals do)
+  void SetSource(const char *vtxProgram, const char *fragProgram);
+
+  //queues a variant for compilation. does nothing if key is already known
+  void Add(unsigned int key, const char *defines);
+
+  //returns the variant for key if it has finished compiling and linked,
+  //NULL if it is unknown, still compiling or failed
+  FFGLShader *Get(unsigned int key);
+
+  //returns 1 once every variant added so far has finished compiling
+  int IsComplete();
+
+  void FreeGLResources();
+
+private:
+  struct Variant
+  {
+    FFGLShader *shader;
+    std::string defines;
+    int started;
+  };
+
+  typedef std::map<unsigned int, Variant> VariantMap;
+
+  FFGLExtensions *m_extensions;
+  FFGLResourceTracker *m_tracker;
+  const char *m_vtxProgram;
+  const char *m_fragProgram;
+  VariantMap m_variants;
+
+  //starts queued variants and returns the number still compiling
+  int Update();
+
+  FFGLShaderCache(const FFGLShaderCache &);
+  FFGLShaderCache &operator=(const FFGLShaderCache &);
+};
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef FFGLSHADERSNIPPETS_H
+#define FFGLSHADERSNIPPETS_H
+
+//GLSL building blocks shared by several plugins. a fragment program is
+//composed by concatenating the snippets it needs in front of its own
+//main(), e.g.
+//
+//  std::string frag = FFGLSnippetSampleInput;
+//  frag += FFGLSnippetLumaKey;
+//  frag += fragmentMain;
+//
+//so effects that are usually chained in the host can be fused into a
+//single pass without copying their code around.
+//
+//snippets are stringized like the plugin shaders, so they can't contain
+//'#'. options are passed in as macros, defined in the preamble handed to
+//FFGLShader::Compile / FFGLShaderCache::Add
+
+#define FFGL_GLSL(A) #A
+
+//the fixed function style vertex program used by every plugin
+static const char FFGLSnippetVertexPassThrough[] = FFGL_GLSL(
+void main()
+{
+	gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+	gl_TexCoord[0] = gl_MultiTexCoord0;
+	gl_FrontColor = gl_Color;
+}
+);
+
+//vec4 ffglSampleInputLuma( vec2 uv, out float luma ) reads the input at
+//uv (in the coordinates of input 0) as RGBA, and its luma.
+//vec4 ffglSampleInput( vec2 uv ) is the same without the luma.
+//needs FFGL_INPUT_FORMAT, see FFGLYUVInput::GetDefines. planar YUV
+//inputs are converted here, and their luma is the Y sample itself. the
+//uniforms are fed by FFGLYUVInput::Bind
+static const char FFGLSnippetSampleInput[] = FFGL_GLSL(
+uniform sampler2D tex0;
+uniform sampler2D tex1;
+uniform sampler2D tex2;
+uniform vec4 yuvRow0;
+uniform vec4 yuvRow1;
+uniform vec4 yuvRow2;
+uniform vec4 yuvOffset;
+uniform vec2 chromaScale;
+
+vec4 ffglSampleInputLuma( vec2 uv, out float luma )
+{
+	if (FFGL_INPUT_FORMAT == FFGL_INPUT_RGBA)
+	{
+		vec4 color = texture2D( tex0, uv );
+		luma = dot( color.xyz, vec3( .2126, .7152, .0722 ) );
+		return color;
+	}
+
+	vec3 yuv;
+	yuv.x = texture2D( tex0, uv ).r;
+	if (FFGL_INPUT_FORMAT == FFGL_INPUT_NV12)
+	{
+		yuv.yz = texture2D( tex1, uv * chromaScale ).rg;
+	}
+	else
+	{
+		yuv.y = texture2D( tex1, uv * chromaScale ).r;
+		yuv.z = texture2D( tex2, uv * chromaScale ).r;
+	}
+	yuv -= yuvOffset.xyz;
+
+	luma = clamp( yuv.x * yuvRow0.x, 0.0, 1.0 );
+	vec3 rgb = vec3( dot( yuvRow0.xyz, yuv ), dot( yuvRow1.xyz, yuv ), dot( yuvRow2.xyz, yuv ) );
+	return vec4( clamp( rgb, 0.0, 1.0 ), 1.0 );
+}
+
+vec4 ffglSampleInput( vec2 uv )
+{
+	float luma;
+	return ffglSampleInputLuma( uv, luma );
+}
+);
+
+//vec4 ffglLumaKey( vec4 color, float luma ) scales the alpha of color by
+//luma, usually the one returned by ffglSampleInputLuma.
+//needs LK_MODE (one of LK_MODE_PASSTHROUGH, LK_MODE_HARD, LK_MODE_SOFT)
+//and LK_PREMULTIPLY (0 or 1), see FFGLLumaKeyVariants.h. both are
+//constant in a variant, so the compiler removes the branches. the
+//thresholds are uniforms
+static const char FFGLSnippetLumaKey[] = FFGL_GLSL(
+uniform float thresholdBegin;
+uniform float thresholdEnd;
+
+vec4 ffglLumaKey( vec4 color, float luma )
+{
+	float alpha = color.w;
+	if (LK_MODE != LK_MODE_PASSTHROUGH)
+	{
+		if (LK_MODE == LK_MODE_HARD)
+			alpha *= step( thresholdEnd, luma );
+		else
+			alpha *= smoothstep( thresholdBegin, thresholdEnd, luma );
+	}
+	if (LK_PREMULTIPLY == 1)
+		return vec4( color.xyz * alpha, alpha );
+	return vec4( color.xyz, alpha );
+}
+);
+
+//vec4 ffglGaussianBlur( sampler2D tex, vec2 uv, vec2 texel ) is one pass
+//of a separable gaussian blur of tex around uv. texel is the size of a
+//texel of tex along the axis of the pass, e.g. vec2( 1.0/width, 0.0 ), so
+//a blur is this twice, once per axis. the blurTaps uniform takes the
+//pairs from FFGLGaussianTaps; they fold two texels into one fetch, so tex
+//needs GL_LINEAR filtering. needs FFGL_BLUR_TAPS, the number of pairs.
+//the loop is unrolled by the compiler, so it is a variant per count
+static const char FFGLSnippetGaussianBlur[] = FFGL_GLSL(
+uniform vec2 blurTaps[FFGL_BLUR_TAPS];
+
+vec4 ffglGaussianBlur( sampler2D tex, vec2 uv, vec2 texel )
+{
+	vec4 sum = texture2D( tex, uv ) * blurTaps[0].y;
+	for (int i = 1; i < FFGL_BLUR_TAPS; i++)
+	{
+		vec2 offset = texel * blurTaps[i].x;
+		sum += (texture2D( tex, uv - offset ) + texture2D( tex, uv + offset )) * blurTaps[i].y;
+	}
+	return sum;
+}
+);
+
+#endif
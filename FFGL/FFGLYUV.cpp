@@ -0,0 +1,176 @@
+#include "FFGLYUV.h"
+#include "FFGLLib.h"
+
+#define FFGL_YUV_FORMAT_DEFINES \
+  "#define FFGL_INPUT_RGBA 0\n" \
+  "#define FFGL_INPUT_NV12 1\n" \
+  "#define FFGL_INPUT_I420 2\n"
+
+static const char *s_formatDefines[FFGL_INPUT_NUM_FORMATS] =
+{
+  FFGL_YUV_FORMAT_DEFINES "#define FFGL_INPUT_FORMAT 0\n",
+  FFGL_YUV_FORMAT_DEFINES "#define FFGL_INPUT_FORMAT 1\n",
+  FFGL_YUV_FORMAT_DEFINES "#define FFGL_INPUT_FORMAT 2\n"
+};
+
+static const char *s_formatNames[FFGL_INPUT_NUM_FORMATS] =
+{
+  "RGBA",
+  "NV12",
+  "I420"
+};
+
+FFGLYUVInput::FFGLYUVInput()
+:m_format(FFGL_INPUT_RGBA),
+ m_bt709(1),
+ m_fullRange(0),
+ m_shader(NULL),
+ m_offsetUniform(-1),
+ m_chromaScaleUniform(-1),
+ m_numBound(0)
+{
+  for (int i=0; i<3; i++)
+  {
+    m_planeUniforms[i] = -1;
+    m_rowUniforms[i] = -1;
+  }
+}
+
+void FFGLYUVInput::SetFormat(int format)
+{
+  if (format<0 || format>=FFGL_INPUT_NUM_FORMATS)
+    format = FFGL_INPUT_RGBA;
+
+  m_format = format;
+}
+
+void FFGLYUVInput::SetBT709(int bt709)
+{
+  m_bt709 = bt709;
+}
+
+void FFGLYUVInput::SetFullRange(int fullRange)
+{
+  m_fullRange = fullRange;
+}
+
+int FFGLYUVInput::GetNumPlanes(int format)
+{
+  switch (format)
+  {
+  case FFGL_INPUT_NV12: return 2;
+  case FFGL_INPUT_I420: return 3;
+  default: return 1;
+  }
+}
+
+const char *FFGLYUVInput::GetDefines(int format)
+{
+  if (format<0 || format>=FFGL_INPUT_NUM_FORMATS)
+    format = FFGL_INPUT_RGBA;
+
+  return s_formatDefines[format];
+}
+
+int FFGLYUVInput::FormatFromParam(float value)
+{
+  int format = (int)(value * (FFGL_INPUT_NUM_FORMATS-1) + 0.5f);
+  if (format<0) format = 0;
+  if (format>=FFGL_INPUT_NUM_FORMATS) format = FFGL_INPUT_NUM_FORMATS-1;
+  return format;
+}
+
+const char *FFGLYUVInput::GetFormatName(int format)
+{
+  if (format<0 || format>=FFGL_INPUT_NUM_FORMATS)
+    format = FFGL_INPUT_RGBA;
+
+  return s_formatNames[format];
+}
+
+void FFGLYUVInput::UseShader(FFGLShader *shader)
+{
+  m_shader = shader;
+
+  m_planeUniforms[0] = shader->FindUniformIndex("tex0");
+  m_planeUniforms[1] = shader->FindUniformIndex("tex1");
+  m_planeUniforms[2] = shader->FindUniformIndex("tex2");
+  m_rowUniforms[0] = shader->FindUniformIndex("yuvRow0");
+  m_rowUniforms[1] = shader->FindUniformIndex("yuvRow1");
+  m_rowUniforms[2] = shader->FindUniformIndex("yuvRow2");
+  m_offsetUniform = shader->FindUniformIndex("yuvOffset");
+  m_chromaScaleUniform = shader->FindUniformIndex("chromaScale");
+}
+
+int FFGLYUVInput::Bind(FFGLExtensions &e, const ProcessOpenGLStruct *pGL)
+{
+  m_numBound = 0;
+
+  if (m_shader==NULL)
+    return 0;
+
+  int numPlanes = GetNumPlanes(m_format);
+  if ((int)pGL->numInputTextures<numPlanes)
+    return 0;
+
+  int i;
+  for (i=0; i<numPlanes; i++)
+  {
+    if (pGL->inputTextures[i]==NULL || pGL->inputTextures[i]->Handle==0)
+      return 0;
+  }
+
+  for (i=0; i<numPlanes; i++)
+  {
+    e.glActiveTexture(GL_TEXTURE0 + i);
+    glBindTexture(GL_TEXTURE_2D, pGL->inputTextures[i]->Handle);
+    m_shader->SetUniform1i(m_planeUniforms[i], i);
+  }
+  e.glActiveTexture(GL_TEXTURE0);
+  m_numBound = numPlanes;
+
+  if (m_format==FFGL_INPUT_RGBA)
+    return 1;
+
+  //the shader samples the chroma planes with the texture coordinates of
+  //the luma plane, which may be padded differently
+  FFGLTexCoords lumaMax = GetMaxGLTexCoords(*pGL->inputTextures[0]);
+  FFGLTexCoords chromaMax = GetMaxGLTexCoords(*pGL->inputTextures[1]);
+  m_shader->SetUniform2f(
+    m_chromaScaleUniform,
+    (GLfloat)(chromaMax.s / lumaMax.s),
+    (GLfloat)(chromaMax.t / lumaMax.t));
+
+  //Y'CbCr to R'G'B', with the range expansion folded into the matrix
+  float kr = m_bt709 ? 0.2126f : 0.299f;
+  float kb = m_bt709 ? 0.0722f : 0.114f;
+  float kg = 1.0f - kr - kb;
+
+  float yScale = m_fullRange ? 1.0f : 255.0f / 219.0f;
+  float cScale = m_fullRange ? 1.0f : 255.0f / 224.0f;
+  float yOffset = m_fullRange ? 0.0f : 16.0f / 255.0f;
+  float cOffset = 128.0f / 255.0f;
+
+  m_shader->SetUniform4f(m_rowUniforms[0], yScale, 0.0f, cScale * 2.0f * (1.0f - kr), 0.0f);
+  m_shader->SetUniform4f(
+    m_rowUniforms[1],
+    yScale,
+    -cScale * 2.0f * (1.0f - kb) * kb / kg,
+    -cScale * 2.0f * (1.0f - kr) * kr / kg,
+    0.0f);
+  m_shader->SetUniform4f(m_rowUniforms[2], yScale, cScale * 2.0f * (1.0f - kb), 0.0f, 0.0f);
+  m_shader->SetUniform4f(m_offsetUniform, yOffset, cOffset, cOffset, 0.0f);
+
+  return 1;
+}
+
+void FFGLYUVInput::Unbind(FFGLExtensions &e)
+{
+  for (int i=m_numBound-1; i>=0; i--)
+  {
+    e.glActiveTexture(GL_TEXTURE0 + i);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+
+  m_numBound = 0;
+}
@@ -0,0 +1,78 @@
+#ifndef FFGLYUV_H
+#define FFGLYUV_H
+
+#include <FFGL.h>
+#include <FFGLExtensions.h>
+#include <FFGLShader.h>
+
+//layouts of the frame a host passes to a plugin. with the planar YUV
+//layouts every plane is a separate host input, so decoded video can be
+//handed over without converting it to RGBA on the CPU first:
+// - NV12: input 0 is Y (one channel), input 1 is UV at half size
+//   (two channels, e.g. GL_RG8, U in red and V in green)
+// - I420: input 0 is Y, inputs 1 and 2 are U and V at half size
+//   (one channel each)
+//the conversion to RGB is done by FFGLSnippetSampleInput
+enum
+{
+  FFGL_INPUT_RGBA,
+  FFGL_INPUT_NV12,
+  FFGL_INPUT_I420,
+  FFGL_INPUT_NUM_FORMATS
+};
+
+//FFGLYUVInput binds the planes of the input and feeds the conversion
+//uniforms of FFGLSnippetSampleInput. the layout is a compile time option
+//of the shader (see GetDefines), the matrix and range are uniforms so
+//they can change without switching variants
+class FFGLYUVInput
+{
+public:
+  FFGLYUVInput();
+
+  void SetFormat(int format);
+  int GetFormat() const { return m_format; }
+
+  //BT.709 when set, BT.601 otherwise
+  void SetBT709(int bt709);
+  int GetBT709() const { return m_bt709; }
+
+  //full (0..255) or limited (16..235 / 16..240) range
+  void SetFullRange(int fullRange);
+  int GetFullRange() const { return m_fullRange; }
+
+  //number of host inputs read by format
+  static int GetNumPlanes(int format);
+
+  //the #define block selecting format in FFGLSnippetSampleInput
+  static const char *GetDefines(int format);
+
+  //maps a 0..1 plugin parameter to a format and back, and names it
+  static int FormatFromParam(float value);
+  static constexpr float FormatToParam(int format) { return (float)format / (float)(FFGL_INPUT_NUM_FORMATS-1); }
+  static const char *GetFormatName(int format);
+
+  //looks the conversion uniforms up in shader. call it whenever the
+  //plugin switches to another shader
+  void UseShader(FFGLShader *shader);
+
+  //binds the planes of pGL's inputs to texture units 0.. and uploads the
+  //conversion. the shader must be bound. returns 0 if the host didn't
+  //pass enough inputs for the format
+  int Bind(FFGLExtensions &e, const ProcessOpenGLStruct *pGL);
+  void Unbind(FFGLExtensions &e);
+
+private:
+  int m_format;
+  int m_bt709;
+  int m_fullRange;
+
+  FFGLShader *m_shader;
+  int m_planeUniforms[3];
+  int m_rowUniforms[3];
+  int m_offsetUniform;
+  int m_chromaScaleUniform;
+  int m_numBound;
+};
+
+#endif
@@ -9,9 +9,65 @@ int( *cross_secure_sprintf )(char *, size_t, const char *, ...) = snprintf;
 
 #define FFPARAM_THRESHOLD_BEGIN (0)
 #define FFPARAM_THRESHOLD_END (1)
+#define FFPARAM_PREMULTIPLY (2)
+#define FFPARAM_INPUT_FORMAT (3)
+#define FFPARAM_BT709 (4)
+#define FFPARAM_FULL_RANGE (5)
+#define FFPARAM_PRECISION (6)
+#define FFPARAM_GPU_BUDGET (7)
+#define FFPARAM_AUTO_KEY (8)
+#define FFPARAM_FEATHER (9)
+
+// GPU time the key may take per frame at a GPU Budget of 1. 0 is off
+#define LK_MAX_BUDGET_MS (10.0)
+
+// Auto Key draws the luma of the input into a square of LK_LUMA_SIZE,
+// bilinear filtered, and counts every texel of it on the GPU. The
+// cumulative histogram is an atlas of LK_HISTOGRAM_TILES squared tiles,
+// one per 4 of the 256 levels, whose mip chain averages every tile down
+// to a texel: a read back of 256 bytes. Every texel of a tile counts a
+// block of LK_LUMA_SIZE / LK_HISTOGRAM_TILE_SIZE squared luma texels
+#define LK_LUMA_SIZE (128)
+#define LK_HISTOGRAM_TILES (8)
+#define LK_HISTOGRAM_TILE_SIZE (32)
+
+// Feather radius at Feather = 1, in pixels of the output. The blur has
+// at most LK_MAX_BLUR_TAPS taps per side, which reach (taps - 1) * 2 mask
+// texels, so a radius the half size mask can't cover goes to quarter size
+#define LK_MAX_FEATHER (48.0f)
+#define LK_MAX_BLUR_TAPS (8)
+
+// Texture unit of the blurred mask, after the planes of the input
+#define LK_FEATHER_UNIT (3)
 
 #define STRINGIFY(A) #A
 
+// In the order of the FFPARAM_ indexes. The thresholds are uploaded to the
+// shader by UpdateParamUniforms, unless Auto Key replaces them (see DrawKey)
+static constexpr FFGLParam<LumaKeyParams> s_params[] =
+{
+	{ "Threshold Begin", FF_TYPE_STANDARD, 0.0f, 0.0f, 1.0f, &LumaKeyParams::thresholdBegin, "thresholdBegin", NULL },
+	{ "Threshold End", FF_TYPE_STANDARD, 0.0f, 0.0f, 1.0f, &LumaKeyParams::thresholdEnd, "thresholdEnd", NULL },
+	{ "Premultiply", FF_TYPE_BOOLEAN, 0.0f, 0.0f, 1.0f, &LumaKeyParams::premultiply, NULL, NULL },
+	{ "Input Format", FF_TYPE_STANDARD, FFGLYUVInput::FormatToParam( FFGL_INPUT_RGBA ), 0.0f, 1.0f, &LumaKeyParams::inputFormat, NULL, NULL },
+	{ "YUV BT.709", FF_TYPE_BOOLEAN, 1.0f, 0.0f, 1.0f, &LumaKeyParams::bt709, NULL, NULL },
+	{ "YUV Full Range", FF_TYPE_BOOLEAN, 0.0f, 0.0f, 1.0f, &LumaKeyParams::fullRange, NULL, NULL },
+	{ "Precision", FF_TYPE_STANDARD, FFGLTargetFormat::PrecisionToParam( FFGL_PRECISION_AUTO ), 0.0f, 1.0f, &LumaKeyParams::precision, NULL, NULL },
+	{ "GPU Budget", FF_TYPE_STANDARD, 0.0f, 0.0f, 1.0f, &LumaKeyParams::gpuBudget, NULL, NULL },
+	{ "Auto Key", FF_TYPE_BOOLEAN, 0.0f, 0.0f, 1.0f, &LumaKeyParams::autoKey, NULL, NULL },
+	{ "Feather", FF_TYPE_STANDARD, 0.0f, 0.0f, 1.0f, &LumaKeyParams::feather, NULL, NULL },
+};
+static_assert( FFGLParamsValid( s_params ), "bad parameter schema" );
+
+static const FFGLParamSchema<LumaKeyParams> s_schema( s_params );
+
+// The size of the Feather mask, as a fraction of the output, for a radius
+// in pixels of the output
+static int GetFeatherDivisor( float radius )
+{
+	return radius / 2.0f <= (LK_MAX_BLUR_TAPS - 1) * 2 ? 2 : 4;
+}
+
 ///Plugin Info
 static CFFGLPluginInfo PluginInfo(
 	LumaKey::CreateInstance,		// Create method
@@ -67,27 +123,75 @@ char *vertexShaderCode = STRINGIFY(
 // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // ++++++ COPY/PASTE YOUR GLSL SANDBOX OR SHADERTOY SHADER CODE HERE +++++
 // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// The key itself lives in FFGLShaderSnippets.h so the fused Native Mapper
+// plugin can share it. LoadShaders puts the snippets in front of this main.
+// The LK_MODE_LUMA variant writes the luma the key would use instead, for
+// the Auto Key histogram. For Feather the LK_FEATHER_MASK variants write
+// only the key, and the LK_FEATHER_APPLY ones take it from the blurred
+// mask instead of keying
 char *fragmentShaderCode = STRINGIFY(
 	// ==================== PASTE WITHIN THESE LINES =======================
 
-	uniform sampler2D tex0;
-	uniform float thresholdBegin;
-	uniform float thresholdEnd;
+uniform sampler2D featherMask;
+uniform vec2 featherScale;
 
-// Red screen test shader
 void main( void ) {
-	vec4 color = texture2D( tex0, gl_TexCoord[0].st );
-	if (thresholdEnd < .01)
-		gl_FragColor = color;
+	float luma;
+	vec4 color = ffglSampleInputLuma( gl_TexCoord[0].st, luma );
+	if (LK_MODE == LK_MODE_LUMA)
+	{
+		gl_FragColor = vec4( luma );
+	}
+	else if (LK_FEATHER == LK_FEATHER_MASK)
+	{
+		gl_FragColor = vec4( ffglLumaKey( vec4( 1.0 ), luma ).w );
+	}
 	else
 	{
-		float luma = .2126 * color.x + .7152 * color.y + .0722 * color.z;
-		float alpha = smoothstep( thresholdBegin + .0001, thresholdEnd + .0001, luma );
-		gl_FragColor = vec4( color.xyz, alpha * color.w );
+		if (LK_FEATHER == LK_FEATHER_APPLY)
+			color.w *= texture2D( featherMask, gl_TexCoord[0].st * featherScale ).r;
+		gl_FragColor = ffglLumaKey( color, luma );
 	}
 }
 );
 
+// A texel of the Auto Key histogram atlas: for the 4 levels of its tile,
+// the fraction of a block of the luma that is below each of them
+char *histogramShaderCode = STRINGIFY(
+uniform sampler2D luma;
+
+void main( void ) {
+	vec2 texel = floor( gl_FragCoord.xy );
+	vec2 tile = floor( texel / LK_HISTOGRAM_TILE_SIZE );
+	float first = (tile.y * LK_HISTOGRAM_TILES + tile.x) * 4.0;
+
+	// the luma is stored as a byte b, which is below the level l when b < l
+	vec4 levels = (vec4( first, first + 1.0, first + 2.0, first + 3.0 ) - 0.5) / 255.0;
+
+	vec2 corner = (texel - tile * LK_HISTOGRAM_TILE_SIZE) * float( LK_LUMA_BLOCK );
+	vec4 below = vec4( 0.0 );
+	for (int y = 0; y < LK_LUMA_BLOCK; y++)
+	{
+		for (int x = 0; x < LK_LUMA_BLOCK; x++)
+		{
+			float l = texture2D( luma, (corner + vec2( float( x ), float( y ) ) + 0.5) / LK_LUMA_SIZE ).r;
+			below += vec4( lessThan( vec4( l ), levels ) );
+		}
+	}
+	gl_FragColor = below / float( LK_LUMA_BLOCK * LK_LUMA_BLOCK );
+}
+);
+
+// One axis of the Feather blur, see FFGLSnippetGaussianBlur
+char *blurShaderCode = STRINGIFY(
+uniform sampler2D mask;
+uniform vec2 texel;
+
+void main( void ) {
+	gl_FragColor = ffglGaussianBlur( mask, gl_TexCoord[0].st, texel );
+}
+);
+
 LumaKey::LumaKey()
 {
 #ifdef DEBUG
@@ -100,26 +204,48 @@ LumaKey::LumaKey()
 #endif
 
 	SetMinInputs( 0 );
-	SetMaxInputs( 1 );
+	SetMaxInputs( 3 );
 
 	//Setup Parameters
-	SetParamInfo( FFPARAM_THRESHOLD_BEGIN, "Threshold Begin", FF_TYPE_STANDARD, 0.0f );
-	SetParamInfo( FFPARAM_THRESHOLD_END, "Threshold End", FF_TYPE_STANDARD, 0.0f );
+	SetParamSchema( &s_schema );
+	s_schema.SetDefaults( m_params );
+
+	m_resolution[0] = m_resolution[1] = m_resolution[2] = 0.0f;
+	m_inputTextureUniform = -1;
+	m_thresholdUniforms[0] = m_thresholdUniforms[1] = -1;
+	m_thresholds[0] = m_thresholds[1] = 0.0f;
+	m_display[0] = 0;
+
+	m_lumaShader = NULL;
+	m_histogramShader = NULL;
+	m_autoKeyRunning = false;
+	for (int i = 0; i < 2; i++)
+	{
+		m_autoFractions[i] = 0.0f;
+		m_autoThresholds[i] = -1.0f;
+	}
+
+	m_blurShader = NULL;
+	m_blurTaps.resize( LK_MAX_BLUR_TAPS * 2 );
+	m_numBlurTaps = 1;
+	m_featherDivisor = 2;
+	m_maskShader = NULL;
+	m_maskThresholdUniforms[0] = m_maskThresholdUniforms[1] = -1;
+	m_featherShader = NULL;
+	m_featherMaskUniform = -1;
+	m_featherScaleUniform = -1;
 
-	SetDefaults();
+	m_shader = NULL;
+	m_shaderFormat = FFGL_INPUT_RGBA;
+	m_queuedFormats = 0;
 
 	bInitialized = false;
 }
 
 LumaKey::~LumaKey()
 {
-	//stub
-}
-
-void LumaKey::SetDefaults()
-{
-	m_thresholdEnd = 0.0;
-	m_thresholdBegin = 0.0;
+	// the consumer thread calls back into this object
+	StopAutoKey();
 }
 
 FFResult LumaKey::InitGL( const FFGLViewportStruct *vp )
@@ -130,19 +256,34 @@ FFResult LumaKey::InitGL( const FFGLViewportStruct *vp )
 
 	m_vpWidth = (float)vp->width;
 	m_vpHeight = (float)vp->height;
+
+	m_graph.SetExtensions( &m_extensions );
+	m_graph.SetResourceTracker( &m_glResources );
+	m_governor.SetExtensions( &m_extensions );
+	m_lumaReadback.SetExtensions( &m_extensions );
+	m_lumaReadback.SetResourceTracker( &m_glResources );
 	
-	std::string shaderString = fragmentShaderCode;
-	bInitialized = LoadShader( shaderString );
+	bInitialized = LoadShaders();
 	return FF_SUCCESS;
 }
 
 FFResult LumaKey::DeInitGL()
 {
-	if (m_fbo)			m_extensions.glDeleteFramebuffersEXT( 1, &m_fbo );
-	if (m_glTexture0)	glDeleteTextures( 1, &m_glTexture0 );
+	m_graph.FreeGLResources();
+	m_governor.FreeGLResources();
+	StopAutoKey();
+	m_lumaReadback.FreeGLResources();
+	m_shaders.FreeGLResources();
+	m_blurShaders.FreeGLResources();
+	m_histogramShaders.FreeGLResources();
+	m_shader = NULL;
+	m_lumaShader = NULL;
+	m_histogramShader = NULL;
+	m_blurShader = NULL;
+	m_maskShader = NULL;
+	m_featherShader = NULL;
+	m_queuedFormats = 0;
 
-	m_glTexture0 = 0;
-	m_fbo = 0;
 	bInitialized = false;
 
 	return FF_SUCCESS;
@@ -157,221 +298,742 @@ FFResult LumaKey::ProcessOpenGL( ProcessOpenGLStruct * pGL )
 {
 	FFGLTextureStruct Texture0;
 
-	FFGLTexCoords maxCoords;
-
 	if (bInitialized)
 	{
-		float vpdim[4];
-		glGetFloatv( GL_VIEWPORT, vpdim );
-		m_vpWidth = vpdim[2];
-		m_vpHeight = vpdim[3];
+		// the variants of other input formats are only compiled once
+		// the format is first selected
+		QueueVariants( m_yuv.GetFormat() );
+
+		// pick the variant for the current parameters. while it is still
+		// compiling keep the previous one, or pass the input through
+		GetThresholds( m_thresholds[0], m_thresholds[1] );
+		FFGLShader *shader = m_shaders.Get( SelectVariant() );
+		if (shader != NULL && shader != m_shader)
+			UseVariant( shader, m_yuv.GetFormat() );
 
-		if (m_inputTextureLocation >= 0)
+		if (m_params.autoKey > 0.5f)
 		{
-			if (m_inputTextureLocation >= 0 && pGL->numInputTextures > 0 && pGL->inputTextures[0] != NULL)
+			FFGLShader *lumaShader = m_shaders.Get( LK_VARIANT( LK_MODE_LUMA, 0, LK_FEATHER_OFF, m_yuv.GetFormat() ) );
+			if (lumaShader != m_lumaShader)
 			{
-				Texture0 = *(pGL->inputTextures[0]);
-				maxCoords = GetMaxGLTexCoords( Texture0 );
-				if ((int)m_resolution[0] != Texture0.Width || (int)m_resolution[1] != Texture0.Height)
-				{
-					if (m_glTexture0 > 0)
-					{
-						glDeleteTextures( 1, &m_glTexture0 );
-						m_glTexture0 = 0;
-					}
-				}
-
-				m_resolution[0] = (float)Texture0.Width;
-				m_resolution[1] = (float)Texture0.Height;
-
-				CreateRectangleTexture( Texture0, maxCoords, m_glTexture0, GL_TEXTURE0, m_fbo, pGL->HostFBO );
-
+				m_lumaShader = lumaShader;
+				if (m_lumaShader != NULL)
+					m_lumaYuv.UseShader( m_lumaShader );
 			}
+			m_histogramShader = m_histogramShaders.Get( 0 );
+			if (!m_autoKeyRunning)
+				StartAutoKey();
+		}
+		else if (m_autoKeyRunning)
+		{
+			StopAutoKey();
 		}
 
-		m_shader.BindShader();
+		// a variant of another format can't read this input
+		if (m_shader == NULL || m_shaderFormat != m_yuv.GetFormat())
+		{
+			if (pGL->numInputTextures > 0 && pGL->inputTextures[0] != NULL)
+				FFGLDrawPassThrough( *(pGL->inputTextures[0]) );
+			return FF_SUCCESS;
+		}
+	}
+
+	if (bInitialized)
+	{
+		GetViewportSize( &m_vpWidth, &m_vpHeight );
+
+		if (pGL->numInputTextures < 1 || pGL->inputTextures[0] == NULL)
+			return FF_SUCCESS;
+
+		Texture0 = *(pGL->inputTextures[0]);
 
-		if (m_inputTextureLocation >= 0 && Texture0.Handle > 0)
+		m_resolution[0] = (float)Texture0.Width;
+		m_resolution[1] = (float)Texture0.Height;
+
+		// the governor times the passes and picks the resolution they run
+		// at, the host's framebuffer keeps its size either way
+		m_governor.BeginFrame();
+		float scale = m_governor.GetScale();
+
+		// until its shaders have compiled the key stays sharp
+		bool feather = m_params.feather > 0.0f && SelectFeather( scale );
+
+		m_graph.Begin( pGL->HostFBO );
+
+		// below full scale the key goes into a smaller target, which is
+		// stretched over the host's framebuffer with a bilinear draw
+		int key = FFGLRenderGraph::HOST_OUTPUT;
+		if (scale < 1.0f)
 		{
-			m_extensions.glUniform1iARB( m_inputTextureLocation, 0 );
+			GLsizei width = (GLsizei)(m_vpWidth * scale + 0.5f);
+			GLsizei height = (GLsizei)(m_vpHeight * scale + 0.5f);
+			key = m_graph.CreateTarget( width > 0 ? width : 1, height > 0 ? height : 1, m_targetFormat.Select( m_extensions, Texture0 ) );
 		}
 
-		if (m_inputTextureLocation >= 0 && Texture0.Handle > 0)
+		if (feather)
 		{
-			m_extensions.glActiveTexture( GL_TEXTURE0 );
+			// the input is sampled by the mask and key passes themselves
+			int mask = AddFeatherPasses( pGL, scale );
+			int keyPass = m_graph.AddPass( "key", key, [this, pGL, mask]( FFGLRenderGraph &graph )
+			{
+				DrawFeathered( pGL, graph.GetTexture( mask ) );
+			} );
+			m_graph.Read( keyPass, mask );
+		}
+		else if (scale < 1.0f)
+		{
+			// straight from the input, a copy would only add a pass
+			bool rgba = m_yuv.GetFormat() == FFGL_INPUT_RGBA;
+			int keyPass = m_graph.AddPass( "key", key, [this, pGL, Texture0, rgba]( FFGLRenderGraph & )
+			{
+				FFGLTextureStruct input = Texture0;
+				DrawKey( pGL, rgba ? &input : NULL );
+			} );
+			if (rgba)
+				m_graph.Read( keyPass, m_graph.Import( Texture0 ) );
+		}
+		else if (m_yuv.GetFormat() != FFGL_INPUT_RGBA)
+		{
+			// the planes are sampled and converted by the key pass itself
+			m_graph.AddPass( "key", FFGLRenderGraph::HOST_OUTPUT, [this, pGL]( FFGLRenderGraph & )
+			{
+				DrawKey( pGL, NULL );
+			} );
+		}
+		else
+		{
+			// copy the used part of the input into a texture of its own, so the
+			// key pass can sample it with 0..1 coordinates, then key that copy
+			// into the host's framebuffer. the copy keeps the precision of the
+			// input unless the user picked one
+			int input = m_graph.Import( Texture0 );
+			int copy = m_graph.CreateTarget( Texture0.Width, Texture0.Height, m_targetFormat.Select( m_extensions, Texture0 ) );
+
+			int copyPass = m_graph.AddPass( "copy", copy, [input]( FFGLRenderGraph &graph )
+			{
+				FFGLDrawPassThrough( graph.GetTexture( input ) );
+			} );
+			m_graph.Read( copyPass, input );
 
-			if (m_glTexture0 > 0)
-				glBindTexture( GL_TEXTURE_2D, m_glTexture0 );
-			else
-				glBindTexture( GL_TEXTURE_2D, Texture0.Handle );
+			int keyPass = m_graph.AddPass( "key", FFGLRenderGraph::HOST_OUTPUT, [this, pGL, copy]( FFGLRenderGraph &graph )
+			{
+				FFGLTextureStruct copyTexture = graph.GetTexture( copy );
+				DrawKey( pGL, &copyTexture );
+			} );
+			m_graph.Read( keyPass, copy );
 		}
 
-		if (m_thresholdEndLocation >= 0)
+		if (scale < 1.0f)
 		{
-			m_extensions.glUniform1fARB( m_thresholdEndLocation, m_thresholdEnd );
+			int upscalePass = m_graph.AddPass( "upscale", FFGLRenderGraph::HOST_OUTPUT, [key]( FFGLRenderGraph &graph )
+			{
+				FFGLDrawPassThrough( graph.GetTexture( key ) );
+			} );
+			m_graph.Read( upscalePass, key );
 		}
 
-		if (m_thresholdBeginLocation >= 0)
+		if (m_autoKeyRunning && m_lumaShader != NULL && m_histogramShader != NULL)
 		{
-			m_extensions.glUniform1fARB( m_thresholdBeginLocation, m_thresholdBegin );
+			// the percentiles the consumer thread picks, see UpdateAutoThresholds
+			m_autoFractions[0] = m_params.thresholdBegin;
+			m_autoFractions[1] = m_params.thresholdEnd;
+
+			int luma = m_graph.CreateTarget( LK_LUMA_SIZE, LK_LUMA_SIZE );
+			int atlas = m_graph.CreateMipmappedTarget( LK_HISTOGRAM_TILES * LK_HISTOGRAM_TILE_SIZE, LK_HISTOGRAM_TILES * LK_HISTOGRAM_TILE_SIZE );
+			int bins = m_graph.CreateTarget( LK_HISTOGRAM_TILES, LK_HISTOGRAM_TILES );
+
+			m_graph.AddPass( "luma", luma, [this, pGL]( FFGLRenderGraph & )
+			{
+				DrawLuma( pGL );
+			} );
+
+			int atlasPass = m_graph.AddPass( "histogram", atlas, [this, luma]( FFGLRenderGraph &graph )
+			{
+				DrawHistogram( graph.GetTexture( luma ) );
+			} );
+			m_graph.Read( atlasPass, luma );
+
+			// a texel per tile reads the level of the mip chain holding
+			// the averages of the tiles, which are then queued for the
+			// readback. No pass reads the bins, so the pass is kept
+			int binsPass = m_graph.AddPass( "bins", bins, [this, atlas, bins]( FFGLRenderGraph &graph )
+			{
+				FFGLDrawPassThrough( graph.GetTexture( atlas ) );
+				m_lumaReadback.Capture( graph.GetTexture( bins ) );
+			} );
+			m_graph.Read( binsPass, atlas );
+			m_graph.Keep( binsPass );
 		}
 
-		glEnable( GL_TEXTURE_2D );
-		glBegin( GL_QUADS );
-		glTexCoord2f( 0.0, 0.0 );
-		glVertex2f( -1.0, -1.0 );
-		glTexCoord2f( 0.0, 1.0 );
-		glVertex2f( -1.0, 1.0 );
-		glTexCoord2f( 1.0, 1.0 );
-		glVertex2f( 1.0, 1.0 );
-		glTexCoord2f( 1.0, 0.0 );
-		glVertex2f( 1.0, -1.0 );
-		glEnd();
-		glDisable( GL_TEXTURE_2D );
-
-		if (m_inputTextureLocation >= 0 && Texture0.Handle > 0) {
-			m_extensions.glActiveTexture( GL_TEXTURE0 );
-			glBindTexture( GL_TEXTURE_2D, 0 );
+		m_graph.Execute();
+		m_governor.EndFrame();
+	}
+
+	return FF_SUCCESS;
+}
+
+FFResult LumaKey::ProcessOpenGLBatch( ProcessOpenGLBatchStruct *pBatch )
+{
+	if (BeginBatch( pBatch ) != FF_SUCCESS)
+		return FF_FAIL;
+
+	// the frames a plain key can draw keep the shader and its sampler
+	// bound from one to the next, straight into their layers. The others
+	// go through ProcessOpenGL
+	FFGLShader *bound = NULL;
+	FFResult result = FF_SUCCESS;
+
+	for (FFUInt32 i = 0; i < pBatch->numFrames && result == FF_SUCCESS; i++)
+	{
+		ProcessOpenGLStruct pGL;
+		BeginBatchFrame( pBatch, i, &pGL );
+
+		FFGLTextureStruct *input = pGL.numInputTextures > 0 ? pGL.inputTextures[0] : NULL;
+		if (input != NULL && CanKeyDirectly( *input ))
+		{
+			if (bound != m_shader)
+			{
+				if (bound != NULL)
+					bound->UnbindShader();
+
+				bound = m_shader;
+				bound->BindShader();
+				if (m_inputTextureUniform >= 0)
+					bound->SetUniform1i( m_inputTextureUniform, 0 );
+				m_extensions.glActiveTexture( GL_TEXTURE0 );
+			}
+
+			// the thresholds may change from frame to frame
+			UpdateParamUniforms( bound );
+
+			glBindTexture( GL_TEXTURE_2D, input->Handle );
+			glEnable( GL_TEXTURE_2D );
+			FFGLDrawQuad( -1.0f, -1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f );
+			glDisable( GL_TEXTURE_2D );
 		}
+		else
+		{
+			if (bound != NULL)
+			{
+				glBindTexture( GL_TEXTURE_2D, 0 );
+				bound->UnbindShader();
+				bound = NULL;
+			}
 
-		m_shader.UnbindShader();
+			result = ProcessOpenGL( &pGL );
+		}
+	}
 
+	if (bound != NULL)
+	{
+		glBindTexture( GL_TEXTURE_2D, 0 );
+		bound->UnbindShader();
 	}
 
-	return FF_SUCCESS;
+	EndBatch( pBatch );
+	return result;
+}
+
+bool LumaKey::CanKeyDirectly( const FFGLTextureStruct &input )
+{
+	// the sharp key of an RGBA input at full scale, with the variant for
+	// the current parameters loaded: one pass, with nothing to update on
+	// the way. The input is sampled where the copy of ProcessOpenGL would
+	// be, so it has to fill its texture and keep its precision
+	if (!bInitialized || m_shader == NULL || m_shaderFormat != FFGL_INPUT_RGBA || m_yuv.GetFormat() != FFGL_INPUT_RGBA)
+		return false;
+	if (m_params.autoKey > 0.5f || m_autoKeyRunning || m_params.feather > 0.0f || m_governor.GetScale() < 1.0f)
+		return false;
+	if (input.Width != input.HardwareWidth || input.Height != input.HardwareHeight || m_targetFormat.GetPrecision() != FFGL_PRECISION_AUTO)
+		return false;
+
+	GetThresholds( m_thresholds[0], m_thresholds[1] );
+	return m_shaders.Get( SelectVariant() ) == m_shader;
 }
 
 FFResult LumaKey::SetFloatParameter( unsigned int index, float value )
 {
+	float thresholdBegin = m_params.thresholdBegin;
+	if (s_schema.SetFloat( m_params, index, value ) != FF_SUCCESS)
+		return FF_FAIL;
+
 	switch (index)
 	{
-	case FFPARAM_THRESHOLD_END:
-		m_thresholdEnd = value;
+	case FFPARAM_THRESHOLD_BEGIN:
+		m_params.thresholdBegin = FFGLLumaKeyBegin( m_params.thresholdBegin, m_params.thresholdEnd, thresholdBegin );
 		break;
 
-	case FFPARAM_THRESHOLD_BEGIN:
-		if(value <= m_thresholdEnd)
-			m_thresholdBegin = value;
+	case FFPARAM_INPUT_FORMAT:
+	case FFPARAM_BT709:
+	case FFPARAM_FULL_RANGE:
+	case FFPARAM_PRECISION:
+		ApplyFormats();
 		break;
 
-	default:
-		return FF_FAIL;
+	case FFPARAM_GPU_BUDGET:
+		m_governor.SetBudget( m_params.gpuBudget * LK_MAX_BUDGET_MS );
 		break;
 	}
+
 	return FF_SUCCESS;
 }
 
+FFResult LumaKey::SetParameters( const SetParameterStruct *params, unsigned int numParams )
+{
+	// all the values are stored first, the formats follow them once
+	float thresholdBegin = m_params.thresholdBegin;
+	FFResult result = s_schema.SetParameters( m_params, params, numParams );
+
+	m_params.thresholdBegin = FFGLLumaKeyBegin( m_params.thresholdBegin, m_params.thresholdEnd, thresholdBegin );
+
+	ApplyFormats();
+	m_governor.SetBudget( m_params.gpuBudget * LK_MAX_BUDGET_MS );
+	return result;
+}
+
+void LumaKey::ApplyFormats()
+{
+	// the luma and feather variants read the input the same way as the key
+	FFGLYUVInput *yuv[4] = { &m_yuv, &m_lumaYuv, &m_maskYuv, &m_featherYuv };
+	for (int i = 0; i < 4; i++)
+	{
+		yuv[i]->SetFormat( FFGLYUVInput::FormatFromParam( m_params.inputFormat ) );
+		yuv[i]->SetBT709( m_params.bt709 > 0.5f ? 1 : 0 );
+		yuv[i]->SetFullRange( m_params.fullRange > 0.5f ? 1 : 0 );
+	}
+	m_targetFormat.SetPrecision( FFGLTargetFormat::PrecisionFromParam( m_params.precision ) );
+}
+
 float LumaKey::GetFloatParameter( unsigned int index )
 {
-	switch (index)
+	return s_schema.GetFloat( m_params, index );
+}
+
+char * LumaKey::GetParameterDisplay( DWORD dwIndex )
+{
+	if (dwIndex == FFPARAM_INPUT_FORMAT)
+		return CopyParameterDisplay( FFGLYUVInput::GetFormatName( m_yuv.GetFormat() ) );
+	if (dwIndex == FFPARAM_PRECISION)
+		return CopyParameterDisplay( FFGLTargetFormat::GetPrecisionName( m_targetFormat.GetPrecision() ) );
+	if (dwIndex == FFPARAM_GPU_BUDGET)
 	{
-	case FFPARAM_THRESHOLD_END:
-		return m_thresholdEnd;
-		break;
+		// with the resolution the key currently runs at
+		if (m_governor.GetBudget() <= 0.0)
+			return CopyParameterDisplay( "Off" );
+		cross_secure_sprintf( m_display, sizeof( m_display ), "%.1f ms, %d%%",
+			m_governor.GetBudget(), (int)(m_governor.GetScale() * 100.0f + 0.5f) );
+		return m_display;
+	}
+	if ((dwIndex == FFPARAM_THRESHOLD_BEGIN || dwIndex == FFPARAM_THRESHOLD_END) && m_params.autoKey > 0.5f)
+	{
+		// with Auto Key on the thresholds are percentiles, shown with the
+		// luma they currently pick
+		float thresholds[2];
+		GetThresholds( thresholds[0], thresholds[1] );
+		float fraction = dwIndex == FFPARAM_THRESHOLD_BEGIN ? m_params.thresholdBegin : m_params.thresholdEnd;
+		cross_secure_sprintf( m_display, sizeof( m_display ), "%d%% = %.3f",
+			(int)(fraction * 100.0f + 0.5f), thresholds[dwIndex == FFPARAM_THRESHOLD_BEGIN ? 0 : 1] );
+		return m_display;
+	}
+	if (dwIndex == FFPARAM_FEATHER)
+	{
+		// with the size of the mask it is blurred at
+		if (m_params.feather <= 0.0f)
+			return CopyParameterDisplay( "Off" );
+		float radius = m_params.feather * LK_MAX_FEATHER;
+		cross_secure_sprintf( m_display, sizeof( m_display ), "%.1f px, 1/%d",
+			radius, GetFeatherDivisor( radius * m_governor.GetScale() ) );
+		return m_display;
+	}
 
-	case FFPARAM_THRESHOLD_BEGIN:
-		return m_thresholdBegin;
-		break;
+	return CFreeFrameGLPlugin::GetParameterDisplay( dwIndex );
+}
+
+bool LumaKey::LoadShaders()
+{
+	m_shaders.SetExtensions( &m_extensions );
+	m_shaders.SetResourceTracker( &m_glResources );
+
+	m_fragmentSource = FFGLSnippetSampleInput;
+	m_fragmentSource += FFGLSnippetLumaKey;
+	m_fragmentSource += fragmentShaderCode;
+	m_shaders.SetSource( vertexShaderCode, m_fragmentSource.c_str() );
+
+	// a blur variant per number of taps, they are small enough to queue
+	// them all
+	m_blurShaders.SetExtensions( &m_extensions );
+	m_blurShaders.SetResourceTracker( &m_glResources );
+
+	m_blurSource = FFGLSnippetGaussianBlur;
+	m_blurSource += blurShaderCode;
+	m_blurShaders.SetSource( vertexShaderCode, m_blurSource.c_str() );
 
-	default:
-		return 0.0f;
+	for (int taps = 1; taps <= LK_MAX_BLUR_TAPS; taps++)
+	{
+		char defines[64];
+		cross_secure_sprintf( defines, sizeof( defines ), "#define FFGL_BLUR_TAPS %d\n", taps );
+		m_blurShaders.Add( taps, defines );
 	}
+
+	// a single Auto Key histogram shader, its sizes are defines so the
+	// loops have constant bounds
+	m_histogramShaders.SetExtensions( &m_extensions );
+	m_histogramShaders.SetResourceTracker( &m_glResources );
+	m_histogramShaders.SetSource( vertexShaderCode, histogramShaderCode );
+
+	char defines[256];
+	cross_secure_sprintf( defines, sizeof( defines ),
+		"#define LK_LUMA_SIZE %d.0\n#define LK_LUMA_BLOCK %d\n#define LK_HISTOGRAM_TILES %d.0\n#define LK_HISTOGRAM_TILE_SIZE %d.0\n",
+		LK_LUMA_SIZE, LK_LUMA_SIZE / LK_HISTOGRAM_TILE_SIZE, LK_HISTOGRAM_TILES, LK_HISTOGRAM_TILE_SIZE );
+	m_histogramShaders.Add( 0, defines );
+
+	m_queuedFormats = 0;
+	QueueVariants( m_yuv.GetFormat() );
+	return true;
 }
 
-char * LumaKey::GetParameterDisplay( DWORD dwIndex )
+void LumaKey::QueueVariants( int format )
 {
-	return "1";
+	if (m_queuedFormats & (1 << format))
+		return;
+
+	m_queuedFormats |= 1 << format;
+
+	// every variant of the format is queued up front so switching between
+	// them never waits on the compiler. they are compiled in the
+	// background so instantiating the plugin doesn't stall the host either
+	for (int premultiply = 0; premultiply <= 1; premultiply++)
+	{
+		for (int mode = LK_MODE_PASSTHROUGH; mode <= LK_MODE_SOFT; mode++)
+			FFGLAddLumaKeyVariant( m_shaders, mode, premultiply, LK_FEATHER_OFF, format );
+
+		// the feathered key composites the blurred mask, it doesn't key
+		FFGLAddLumaKeyVariant( m_shaders, LK_MODE_PASSTHROUGH, premultiply, LK_FEATHER_APPLY, format );
+	}
+
+	// neither the luma nor the masks premultiply
+	FFGLAddLumaKeyVariant( m_shaders, LK_MODE_LUMA, 0, LK_FEATHER_OFF, format );
+	FFGLAddLumaKeyVariant( m_shaders, LK_MODE_HARD, 0, LK_FEATHER_MASK, format );
+	FFGLAddLumaKeyVariant( m_shaders, LK_MODE_SOFT, 0, LK_FEATHER_MASK, format );
+}
+
+int LumaKey::SelectMode()
+{
+	return FFGLLumaKeyMode( m_thresholds[0], m_thresholds[1] );
 }
 
-bool LumaKey::LoadShader( std::string shaderString )
+unsigned int LumaKey::SelectVariant()
 {
-	m_shader.SetExtensions( &m_extensions );
-	if (!m_shader.Compile( vertexShaderCode, shaderString.c_str() ))
+	return LK_VARIANT( SelectMode(), m_params.premultiply > 0.5f ? 1 : 0, LK_FEATHER_OFF, m_yuv.GetFormat() );
+}
+
+void LumaKey::UseVariant( FFGLShader *shader, int format )
+{
+	m_shader = shader;
+	m_shaderFormat = format;
+	m_yuv.UseShader( shader );
+
+	//the thresholds are bound with SetParamUniform, only the sampler is looked up here.
+	//Auto Key uploads its own thresholds over them
+	m_inputTextureUniform = m_shader->FindUniformIndex( "tex0" );
+	m_thresholdUniforms[0] = m_shader->FindUniformIndex( "thresholdBegin" );
+	m_thresholdUniforms[1] = m_shader->FindUniformIndex( "thresholdEnd" );
+}
+
+void LumaKey::DrawKey( ProcessOpenGLStruct *pGL, FFGLTextureStruct *source )
+{
+	FFGLTexCoords maxCoords;
+	maxCoords.s = maxCoords.t = 1.0;
+
+	m_shader->BindShader();
+
+	if (source != NULL)
 	{
-		printf( "Shader failed to compile." );
-		return false;
+		if (m_inputTextureUniform >= 0)
+		{
+			m_shader->SetUniform1i( m_inputTextureUniform, 0 );
+
+			m_extensions.glActiveTexture( GL_TEXTURE0 );
+			glBindTexture( GL_TEXTURE_2D, source->Handle );
+		}
+
+		maxCoords = GetMaxGLTexCoords( *source );
 	}
 	else
 	{
-		bool success = false;
-		if (m_shader.IsReady())
+		if (!m_yuv.Bind( m_extensions, pGL ))
 		{
-			if (m_shader.BindShader())
-				success = true;
+			m_shader->UnbindShader();
+			return;
 		}
-		if (!success)
-			return false;
-		else
+
+		maxCoords = GetMaxGLTexCoords( *(pGL->inputTextures[0]) );
+	}
+
+	// The thresholds are the only parameters bound to uniforms. With Auto
+	// Key they come from the histogram instead, and uploading the
+	// parameters first would only have them overwritten
+	if (m_params.autoKey > 0.5f)
+	{
+		m_shader->SetUniform1f( m_thresholdUniforms[0], m_thresholds[0] );
+		m_shader->SetUniform1f( m_thresholdUniforms[1], m_thresholds[1] );
+	}
+	else
+	{
+		UpdateParamUniforms( m_shader );
+	}
+
+	glEnable( GL_TEXTURE_2D );
+	FFGLDrawQuad( -1.0f, -1.0f, 1.0f, 1.0f, 0.0f, 0.0f, (float)maxCoords.s, (float)maxCoords.t );
+	glDisable( GL_TEXTURE_2D );
+
+	if (source != NULL)
+	{
+		if (m_inputTextureUniform >= 0)
 		{
-			//get uniform locations here using m_shader.FindUniform("string")
-			m_inputTextureLocation = -1;
+			m_extensions.glActiveTexture( GL_TEXTURE0 );
+			glBindTexture( GL_TEXTURE_2D, 0 );
+		}
+	}
+	else
+	{
+		m_yuv.Unbind( m_extensions );
+	}
+
+	m_shader->UnbindShader();
+}
+
+void LumaKey::DrawLuma( ProcessOpenGLStruct *pGL )
+{
+	m_lumaShader->BindShader();
+
+	// the whole input, every texel counted by DrawHistogram
+	if (m_lumaYuv.Bind( m_extensions, pGL ))
+	{
+		FFGLTexCoords maxCoords = GetMaxGLTexCoords( *(pGL->inputTextures[0]) );
+		FFGLDrawQuad( -1.0f, -1.0f, 1.0f, 1.0f, 0.0f, 0.0f, (float)maxCoords.s, (float)maxCoords.t );
+		m_lumaYuv.Unbind( m_extensions );
+	}
+
+	m_lumaShader->UnbindShader();
+}
+
+void LumaKey::DrawHistogram( const FFGLTextureStruct &luma )
+{
+	m_histogramShader->BindShader();
+	m_histogramShader->SetUniform1i( m_histogramShader->FindUniformIndex( "luma" ), 0 );
 
-			if (m_inputTextureLocation < 0)
-				m_inputTextureLocation = m_shader.FindUniform( "tex0" );
+	m_extensions.glActiveTexture( GL_TEXTURE0 );
+	glBindTexture( GL_TEXTURE_2D, luma.Handle );
 
-			m_thresholdEndLocation = -1;
-			m_thresholdEndLocation = m_shader.FindUniform( "thresholdEnd" );
+	FFGLDrawQuad( -1.0f, -1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f );
 
-			m_thresholdBeginLocation = -1;
-			m_thresholdBeginLocation = m_shader.FindUniform( "thresholdBegin" );
+	glBindTexture( GL_TEXTURE_2D, 0 );
 
-			m_shader.UnbindShader();
-			if (m_glTexture0 > 0) glDeleteTextures( 1, &m_glTexture0 );
-			m_glTexture0 = 0;
+	m_histogramShader->UnbindShader();
+}
+
+bool LumaKey::SelectFeather( float scale )
+{
+	// nothing is keyed out, so there is no edge to feather
+	int mode = SelectMode();
+	if (mode == LK_MODE_PASSTHROUGH)
+		return false;
+
+	int format = m_yuv.GetFormat();
+
+	FFGLShader *maskShader = m_shaders.Get( LK_VARIANT( mode, 0, LK_FEATHER_MASK, format ) );
+	if (maskShader != m_maskShader)
+	{
+		m_maskShader = maskShader;
+		if (m_maskShader != NULL)
+		{
+			m_maskYuv.UseShader( m_maskShader );
+			m_maskThresholdUniforms[0] = m_maskShader->FindUniformIndex( "thresholdBegin" );
+			m_maskThresholdUniforms[1] = m_maskShader->FindUniformIndex( "thresholdEnd" );
+		}
+	}
 
-			return true;
+	FFGLShader *featherShader = m_shaders.Get( LK_VARIANT( LK_MODE_PASSTHROUGH, m_params.premultiply > 0.5f ? 1 : 0, LK_FEATHER_APPLY, format ) );
+	if (featherShader != m_featherShader)
+	{
+		m_featherShader = featherShader;
+		if (m_featherShader != NULL)
+		{
+			m_featherYuv.UseShader( m_featherShader );
+			m_featherMaskUniform = m_featherShader->FindUniformIndex( "featherMask" );
+			m_featherScaleUniform = m_featherShader->FindUniformIndex( "featherScale" );
 		}
 	}
-	return false;
+
+	// the radius is three sigma, in texels of the mask. the governor's
+	// scale shrinks it with the key, so it stays the same on the output
+	float radius = m_params.feather * LK_MAX_FEATHER * scale;
+	m_featherDivisor = GetFeatherDivisor( radius );
+	m_numBlurTaps = FFGLGaussianTaps( radius / 3.0f / (float)m_featherDivisor, &m_blurTaps[0], LK_MAX_BLUR_TAPS );
+	m_blurShader = m_blurShaders.Get( m_numBlurTaps );
+
+	return m_maskShader != NULL && m_featherShader != NULL && m_blurShader != NULL;
 }
 
-void LumaKey::CreateRectangleTexture( FFGLTextureStruct texture, FFGLTexCoords maxCoords, GLuint & glTexture, GLenum texunit, GLuint & fbo, GLuint hostFbo )
+int LumaKey::AddFeatherPasses( ProcessOpenGLStruct *pGL, float scale )
 {
-	if (fbo == 0)
+	GLsizei width = (GLsizei)ceil( m_vpWidth * scale / (float)m_featherDivisor );
+	GLsizei height = (GLsizei)ceil( m_vpHeight * scale / (float)m_featherDivisor );
+	if (width < 1)
+		width = 1;
+	if (height < 1)
+		height = 1;
+
+	// the mask only holds the key, 8 bits are plenty whatever the input
+	int mask = m_graph.CreateTarget( width, height );
+	int blurX = m_graph.CreateTarget( width, height );
+	int blurY = m_graph.CreateTarget( width, height );
+
+	m_graph.AddPass( "mask", mask, [this, pGL]( FFGLRenderGraph & )
 	{
-		m_extensions.glGenFramebuffersEXT( 1, &fbo );
+		DrawMask( pGL );
+	} );
+
+	int blurXPass = m_graph.AddPass( "feather x", blurX, [this, mask]( FFGLRenderGraph &graph )
+	{
+		DrawBlur( graph.GetTexture( mask ), 1.0f, 0.0f );
+	} );
+	m_graph.Read( blurXPass, mask );
+
+	int blurYPass = m_graph.AddPass( "feather y", blurY, [this, blurX]( FFGLRenderGraph &graph )
+	{
+		DrawBlur( graph.GetTexture( blurX ), 0.0f, 1.0f );
+	} );
+	m_graph.Read( blurYPass, blurX );
+
+	return blurY;
+}
+
+void LumaKey::DrawMask( ProcessOpenGLStruct *pGL )
+{
+	m_maskShader->BindShader();
+
+	// the thresholds are the only uniforms of the key, Auto Key's included
+	m_maskShader->SetUniform1f( m_maskThresholdUniforms[0], m_thresholds[0] );
+	m_maskShader->SetUniform1f( m_maskThresholdUniforms[1], m_thresholds[1] );
+
+	if (m_maskYuv.Bind( m_extensions, pGL ))
+	{
+		FFGLTexCoords maxCoords = GetMaxGLTexCoords( *(pGL->inputTextures[0]) );
+		FFGLDrawQuad( -1.0f, -1.0f, 1.0f, 1.0f, 0.0f, 0.0f, (float)maxCoords.s, (float)maxCoords.t );
+		m_maskYuv.Unbind( m_extensions );
 	}
 
-	if (glTexture == 0)
-	{
-		glGenTextures( 1, &glTexture );
-		m_extensions.glActiveTexture( texunit );
-		glBindTexture( GL_TEXTURE_2D, glTexture );
-		glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-		glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-		glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_R, GL_REPEAT );
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-		glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, texture.Width, texture.Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
+	m_maskShader->UnbindShader();
+}
+
+void LumaKey::DrawBlur( const FFGLTextureStruct &source, float x, float y )
+{
+	m_blurShader->BindShader();
+
+	m_blurShader->SetUniform1i( m_blurShader->FindUniformIndex( "mask" ), 0 );
+	m_blurShader->SetUniform2f( m_blurShader->FindUniformIndex( "texel" ),
+		x / (float)source.HardwareWidth, y / (float)source.HardwareHeight );
+	m_blurShader->SetUniform2fv( m_blurShader->FindUniformIndex( "blurTaps" ), m_numBlurTaps, &m_blurTaps[0] );
+
+	m_extensions.glActiveTexture( GL_TEXTURE0 );
+	glBindTexture( GL_TEXTURE_2D, source.Handle );
+
+	FFGLTexCoords maxCoords = GetMaxGLTexCoords( source );
+	FFGLDrawQuad( -1.0f, -1.0f, 1.0f, 1.0f, 0.0f, 0.0f, (float)maxCoords.s, (float)maxCoords.t );
+
+	glBindTexture( GL_TEXTURE_2D, 0 );
+
+	m_blurShader->UnbindShader();
+}
+
+void LumaKey::DrawFeathered( ProcessOpenGLStruct *pGL, const FFGLTextureStruct &mask )
+{
+	m_featherShader->BindShader();
+
+	if (m_featherYuv.Bind( m_extensions, pGL ))
+	{
+		// the mask covers the used part of the input, featherScale maps
+		// the input's coordinates to the mask's
+		FFGLTexCoords maxCoords = GetMaxGLTexCoords( *(pGL->inputTextures[0]) );
+		FFGLTexCoords maskCoords = GetMaxGLTexCoords( mask );
+		m_featherShader->SetUniform1i( m_featherMaskUniform, LK_FEATHER_UNIT );
+		m_featherShader->SetUniform2f( m_featherScaleUniform,
+			(float)(maskCoords.s / maxCoords.s), (float)(maskCoords.t / maxCoords.t) );
+
+		m_extensions.glActiveTexture( GL_TEXTURE0 + LK_FEATHER_UNIT );
+		glBindTexture( GL_TEXTURE_2D, mask.Handle );
+		m_extensions.glActiveTexture( GL_TEXTURE0 );
+
+		FFGLDrawQuad( -1.0f, -1.0f, 1.0f, 1.0f, 0.0f, 0.0f, (float)maxCoords.s, (float)maxCoords.t );
+
+		m_extensions.glActiveTexture( GL_TEXTURE0 + LK_FEATHER_UNIT );
 		glBindTexture( GL_TEXTURE_2D, 0 );
 		m_extensions.glActiveTexture( GL_TEXTURE0 );
+
+		m_featherYuv.Unbind( m_extensions );
 	}
-	m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, fbo );
-	m_extensions.glFramebufferTexture2DEXT( GL_READ_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, glTexture, 0 );
 
-	glEnable( GL_TEXTURE_2D );
-	glBindTexture( GL_TEXTURE_2D, texture.Handle );
-	glBegin( GL_QUADS );
-
-	//lower left
-	glTexCoord2f( 0.0, 0.0 );
-	glVertex2f( -1.0, -1.0 );
-	//upper left
-	glTexCoord2f( 0.0, (float)maxCoords.t );
-	glVertex2f( -1.0, 1.0 );
-	// upper right
-	glTexCoord2f( (float)maxCoords.s, (float)maxCoords.t );
-	glVertex2f( 1.0, 1.0 );
-	//lower right
-	glTexCoord2f( (float)maxCoords.s, 0.0 );
-	glVertex2f( 1.0, -1.0 );
-	glEnd();
-	glDisable( GL_TEXTURE_2D );
+	m_featherShader->UnbindShader();
+}
 
-	glBindTexture( GL_TEXTURE_2D, 0 );
+void LumaKey::GetThresholds( float &begin, float &end )
+{
+	// until the first histogram has come back the percentiles stand in
+	// for the luma they will pick
+	begin = m_params.thresholdBegin;
+	end = m_params.thresholdEnd;
+	if (m_params.autoKey > 0.5f && m_autoThresholds[1] >= 0.0f)
+	{
+		begin = m_autoThresholds[0];
+		end = m_autoThresholds[1];
+	}
+}
 
-	if (hostFbo > 0)
-		m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, hostFbo );
-	else
-		m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, 0 );
+void LumaKey::StartAutoKey()
+{
+	m_autoThresholds[0] = -1.0f;
+	m_autoThresholds[1] = -1.0f;
+	m_autoKeyRunning = m_lumaReadback.Start( [this]( const FFGLReadbackFrame &frame )
+	{
+		UpdateAutoThresholds( frame );
+	} ) != 0;
+}
+
+void LumaKey::StopAutoKey()
+{
+	if (!m_autoKeyRunning)
+		return;
+
+	m_lumaReadback.Stop();
+	m_autoKeyRunning = false;
+	m_autoThresholds[0] = -1.0f;
+	m_autoThresholds[1] = -1.0f;
+}
+
+void LumaKey::UpdateAutoThresholds( const FFGLReadbackFrame &frame )
+{
+	// consumer thread of m_lumaReadback. the tiles of the histogram are in
+	// the order of their levels, 4 to a texel, so byte l is the fraction
+	// of the luma below level l
+	if (frame.pixels.size() < 256)
+		return;
+	const unsigned char *below = &frame.pixels[0];
+
+	for (int t = 0; t < 2; t++)
+	{
+		// the lowest luma that the given fraction of the samples is below,
+		// so Threshold End = 0.3 keys out the darkest 30% of the picture
+		float wanted = m_autoFractions[t] * 255.0f;
+		int level = 0;
+		while (level < 255 && (float)below[level] < wanted)
+			level++;
+		float threshold = (float)level / 255.0f;
+
+		// eased in over a few frames, or the key would flicker with the
+		// noise of the picture
+		float previous = m_autoThresholds[t];
+		m_autoThresholds[t] = previous < 0.0f ? threshold : previous + (threshold - previous) * 0.25f;
+	}
 }
@@ -1,12 +1,21 @@
 #pragma once
 
+#include <atomic>
 #include <stdio.h>
 #include <string>
 #include <time.h>
 #include <vector>
 #include "FFGL.h"
 #include "FFGLLib.h"
+#include "FFGLLumaKeyVariants.h"
+#include "FFGLFrameGovernor.h"
+#include "FFGLReadback.h"
+#include "FFGLRenderGraph.h"
 #include "FFGLShader.h"
+#include "FFGLShaderCache.h"
+#include "FFGLShaderSnippets.h"
+#include "FFGLYUV.h"
+#include "FFGLResources.h"
 #include "FFGLPluginSDK.h"
 
 #if (!(defined(WIN32) || defined(_WIN32) || defined(__WIN32__)))
@@ -26,8 +35,21 @@ typedef int64_t LARGE_INTEGER;
 #endif
 
 #define GL_SHADING_LANGUAGE_VERSION	0x8B8C
-#define GL_READ_FRAMEBUFFER_EXT		0x8CA8
-#define GL_TEXTURE_WRAP_R			0x8072
+
+// The parameters, see s_schema in LumaKey.cpp
+struct LumaKeyParams
+{
+	float thresholdBegin;
+	float thresholdEnd;
+	float premultiply;
+	float inputFormat;
+	float bt709;
+	float fullRange;
+	float precision;
+	float gpuBudget;
+	float autoKey;
+	float feather;
+};
 
 class LumaKey : public CFreeFrameGLPlugin
 {
@@ -50,7 +72,9 @@ public:
 	///////////////////////////////////////////////////
 	FFResult SetFloatParameter( unsigned int index, float value );
 	float GetFloatParameter( unsigned int index );
+	FFResult SetParameters( const SetParameterStruct *params, unsigned int numParams );
 	FFResult ProcessOpenGL( ProcessOpenGLStruct* pGL );
+	FFResult ProcessOpenGLBatch( ProcessOpenGLBatchStruct *pBatch );
 	FFResult InitGL( const FFGLViewportStruct *vp );
 	FFResult DeInitGL();
 	FFResult GetInputStatus( DWORD dwIndex );
@@ -71,27 +95,79 @@ protected:
 
 	bool bInitialized;
 
-	GLuint m_glTexture0;
-	GLuint m_fbo;
+	FFGLRenderGraph m_graph;
+	FFGLFrameGovernor m_governor;
+	FFGLTargetFormat m_targetFormat;
 
 	///	Viewport
 	float m_vpWidth;
 	float m_vpHeight;
 
-	float m_thresholdEnd;
-	GLint m_thresholdEndLocation;
-
-	float m_thresholdBegin;
-	GLint m_thresholdBeginLocation;
+	LumaKeyParams m_params;
 
 	int m_initResources;
 	FFGLExtensions m_extensions;
-	FFGLShader m_shader;
+	FFGLShaderCache m_shaders;
+	std::string m_fragmentSource;
+	FFGLShader *m_shader;
+	int m_shaderFormat;
+	int m_queuedFormats;
+	FFGLYUVInput m_yuv;
 	float m_resolution[3];
 
-	GLint m_inputTextureLocation;
+	int m_inputTextureUniform;
+	int m_thresholdUniforms[2];
+	float m_thresholds[2]; // of this frame, see GetThresholds
+	char m_display[32];
+
+	// Auto Key: a luma variant draws the luma of the input, the histogram
+	// shader counts it into a cumulative histogram on the GPU, and its 256
+	// bins are read back a few frames later. The consumer thread of the
+	// readback turns them into the thresholds, -1 until the first ones
+	// have arrived
+	FFGLShader *m_lumaShader;
+	FFGLYUVInput m_lumaYuv;
+	FFGLShaderCache m_histogramShaders;
+	FFGLShader *m_histogramShader;
+	FFGLReadback m_lumaReadback;
+	bool m_autoKeyRunning;
+	std::atomic<float> m_autoFractions[2];
+	std::atomic<float> m_autoThresholds[2];
+
+	// Feather: the key is drawn into a mask at half or quarter size, which
+	// is blurred there in two passes and replaces the alpha of the key in
+	// the last pass. The shaders are NULL while they are compiling
+	FFGLShaderCache m_blurShaders;
+	std::string m_blurSource;
+	FFGLShader *m_blurShader;
+	std::vector<GLfloat> m_blurTaps; // see FFGLGaussianTaps
+	int m_numBlurTaps;
+	int m_featherDivisor;
+	FFGLShader *m_maskShader;
+	FFGLYUVInput m_maskYuv;
+	int m_maskThresholdUniforms[2];
+	FFGLShader *m_featherShader;
+	FFGLYUVInput m_featherYuv;
+	int m_featherMaskUniform;
+	int m_featherScaleUniform;
 	
-	void SetDefaults();
-	bool LoadShader( std::string shaderString );
-	void CreateRectangleTexture( FFGLTextureStruct texture, FFGLTexCoords maxCoords, GLuint &glTexture, GLenum texunit, GLuint &fbo, GLuint hostFbo );
+	void ApplyFormats();
+	void GetThresholds( float &begin, float &end );
+	void StartAutoKey();
+	void StopAutoKey();
+	void UpdateAutoThresholds( const FFGLReadbackFrame &frame );
+	void DrawLuma( ProcessOpenGLStruct *pGL );
+	void DrawHistogram( const FFGLTextureStruct &luma );
+	bool SelectFeather( float scale );
+	int AddFeatherPasses( ProcessOpenGLStruct *pGL, float scale );
+	void DrawMask( ProcessOpenGLStruct *pGL );
+	void DrawBlur( const FFGLTextureStruct &source, float x, float y );
+	void DrawFeathered( ProcessOpenGLStruct *pGL, const FFGLTextureStruct &mask );
+	bool LoadShaders();
+	int SelectMode();
+	unsigned int SelectVariant();
+	void QueueVariants( int format );
+	void UseVariant( FFGLShader *shader, int format );
+	void DrawKey( ProcessOpenGLStruct *pGL, FFGLTextureStruct *source );
+	bool CanKeyDirectly( const FFGLTextureStruct &input );
 };
\ No newline at end of file
@@ -11,9 +11,27 @@ int( *cross_secure_sprintf )(char *, size_t, const char *, ...) = snprintf;
 #define FFPARAM_LEFT	(1)
 #define FFPARAM_TOP		(2)
 #define FFPARAM_RIGHT	(3)
+#define FFPARAM_PRECISION	(4)
+#define FFPARAM_DMX_OUTPUT	(5)
+#define FFPARAM_PIXEL_MAP	(6)
 
 #define STRINGIFY(A) #A
 
+// In the order of the FFPARAM_ indexes
+static constexpr FFGLParam<C1080pToNativeParams> s_params[] =
+{
+	{ "Bottom Bound",	FF_TYPE_STANDARD, 0.0f, 0.0f, 1.0f, &C1080pToNativeParams::bottom, NULL, NULL },
+	{ "Left Bound",		FF_TYPE_STANDARD, 0.0f, 0.0f, 1.0f, &C1080pToNativeParams::left, NULL, NULL },
+	{ "Top Bound",		FF_TYPE_STANDARD, 1.0f, 0.0f, 1.0f, &C1080pToNativeParams::top, NULL, NULL },
+	{ "Right Bound",	FF_TYPE_STANDARD, 1.0f, 0.0f, 1.0f, &C1080pToNativeParams::right, NULL, NULL },
+	{ "Precision",		FF_TYPE_STANDARD, FFGLTargetFormat::PrecisionToParam( FFGL_PRECISION_AUTO ), 0.0f, 1.0f, &C1080pToNativeParams::precision, NULL, NULL },
+	{ "DMX Output",		FF_TYPE_BOOLEAN, 0.0f, 0.0f, 1.0f, &C1080pToNativeParams::dmxOutput, NULL, NULL },
+	{ "Pixel Map",		FF_TYPE_TEXT, 0.0f, 0.0f, 0.0f, NULL, NULL, &C1080pToNativeParams::pixelMap },
+};
+static_assert( FFGLParamsValid( s_params ), "bad parameter schema" );
+
+static const FFGLParamSchema<C1080pToNativeParams> s_schema( s_params );
+
 ///Plugin Info
 static CFFGLPluginInfo PluginInfo(
 	C1080pToNative::CreateInstance,		// Create method
@@ -79,7 +97,23 @@ char *fragmentShaderCode = STRINGIFY(
 	}
 );
 
+// Samples the input for the DMX output. Every fragment is one pixel of the
+// pixel map; its position in the input is packed into the texel of
+// fixturePositions under it, see FFGLPixelMap::GetPositionTexels
+char *fixtureShaderCode = STRINGIFY(
+	uniform sampler2D tex0;
+	uniform sampler2D fixturePositions;
+	uniform vec2 maxCoords;
+
+	void main(void) {
+		vec4 p = texture2D( fixturePositions, gl_TexCoord[0].st );
+		vec2 uv = vec2( p.r * 65280.0 + p.g * 255.0, p.b * 65280.0 + p.a * 255.0 ) / 65535.0;
+		gl_FragColor = vec4( texture2D( tex0, uv * maxCoords ).rgb, 1.0 );
+	}
+);
+
 C1080pToNative::C1080pToNative()
+	: FFGLEffect<C1080pToNative>( vertexShaderCode, fragmentShaderCode )
 {
 #ifdef DEBUG
 	// Debug console window so printf works
@@ -94,16 +128,13 @@ C1080pToNative::C1080pToNative()
 	SetMaxInputs( 2 );
 
 	//Setup Parameters
-	SetParamInfo( FFPARAM_BOTTOM,	"Bottom Bound"	, FF_TYPE_STANDARD, 0.0f );
-	SetParamInfo( FFPARAM_LEFT,		"Left Bound"	, FF_TYPE_STANDARD, 0.0f );
-	SetParamInfo( FFPARAM_TOP,		"Top Bound"		, FF_TYPE_STANDARD, 1.0f );
-	SetParamInfo( FFPARAM_RIGHT,	"Right Bound"	, FF_TYPE_STANDARD, 1.0f );
-
-	m_Roi = { 0.0f, 0.0f, 1.0f, 1.0f };
+	SetParamSchema( &s_schema );
+	s_schema.SetDefaults( m_params );
 
 	SetDefaults();
 
-	bInitialized = false;
+	m_pixelMapChanged = false;
+	m_fixtureShaderLoaded = false;
 }
 
 C1080pToNative::~C1080pToNative()
@@ -111,176 +142,127 @@ C1080pToNative::~C1080pToNative()
 	//stub
 }
 
-FFResult C1080pToNative::InitGL( const FFGLViewportStruct * vp )
+bool C1080pToNative::InitEffect()
 {
-	m_extensions.Initialize();
-	if (m_extensions.multitexture == 0 || m_extensions.ARB_shader_objects == 0)
-		return FF_FAIL;
-
-	m_vpWidth = (float)vp->width;
-	m_vpHeight = (float)vp->height;
+	m_readback.SetExtensions( &m_extensions );
+	m_readback.SetResourceTracker( &m_glResources );
+	m_fixtureShader.SetExtensions( &m_extensions );
+	m_fixtureShader.SetResourceTracker( &m_glResources );
+	m_fixtureShader.BeginCompile( vertexShaderCode, fixtureShaderCode );
+	m_fixtureShaderLoaded = false;
 
+	// the positions texture has to be uploaded with this context
+	m_pixelMapChanged = true;
 
-	StartCounter();
-
-	std::string shaderString = fragmentShaderCode;
-	bInitialized = LoadShader( shaderString );
-	return FF_SUCCESS;
+	return true;
 }
 
-FFResult C1080pToNative::DeInitGL()
+void C1080pToNative::DeInitEffect()
 {
-	if (m_fbo)	m_extensions.glDeleteFramebuffersEXT( 1, &m_fbo );
-	if (m_glTexture0)	glDeleteTextures( 1, &m_glTexture0 );
-	if (m_glTexture1)	glDeleteTextures( 1, &m_glTexture1 );
-
-	m_glTexture0 = 0;
-	m_glTexture1 = 0;
-	m_fbo = 0;
-	bInitialized = false;
-
-	return FF_SUCCESS;
+	m_readback.Stop();
+	m_readback.FreeGLResources();
+	m_dmxSender.Close();
+	m_fixtureShader.FreeGLResources();
+	m_fixturePositions.Release();
+	m_fixtureColors.Release();
+	m_fixtureFbo.Release();
 }
 
-FFResult C1080pToNative::ProcessOpenGL( ProcessOpenGLStruct * pGL )
+FFResult C1080pToNative::Render( ProcessOpenGLStruct * pGL )
 {
-	FFGLTextureStruct Texture0;
+	if (pGL->numInputTextures < 1 || pGL->inputTextures[0] == NULL)
+		return FF_SUCCESS;
 
-	FFGLTexCoords maxCoords;
+	FFGLTextureStruct Texture0 = *(pGL->inputTextures[0]);
 
-	if (bInitialized) 
+	for (const ROI &screen : this->screens)
 	{
-		float vpdim[4];
-		glGetFloatv( GL_VIEWPORT, vpdim );
-		m_vpWidth = vpdim[2];
-		m_vpHeight = vpdim[3];
+		// the copy is drawn without a shader, so it is made before binding ours
+		FFGLTextureStruct copy = CopyInput( Texture0, pGL->HostFBO, screen.left, screen.bottom, screen.right, screen.top );
 
-		for (ROI screen : this->screens)
-		{
-			if (m_inputTextureLocation >= 0)
-			{
-				if (m_inputTextureLocation >= 0 && pGL->numInputTextures > 0 && pGL->inputTextures[0] != NULL)
-				{
-					Texture0 = *(pGL->inputTextures[0]);
-					maxCoords = GetMaxGLTexCoords( Texture0 );
-
-					//CreateRectangleTexture( Texture0, maxCoords, m_glTexture0, GL_TEXTURE0, m_fbo, pGL->HostFBO );
-
-					CreateRectangleTexture( Texture0, maxCoords, screen, m_glTexture0, GL_TEXTURE0, m_fbo, pGL->HostFBO );
-				}
-			}
-
-			m_shader.BindShader();
-
-			//Bind all the variables!
-			if (m_inputTextureLocation >= 0 && Texture0.Handle > 0)
-			{
-				m_extensions.glUniform1iARB( m_inputTextureLocation, 0 );
-			}
-
-			if (m_inputTextureLocation >= 0 && Texture0.Handle > 0)
-			{
-				m_extensions.glActiveTexture( GL_TEXTURE0 );
-
-				if (m_glTexture0 > 0)
-					glBindTexture( GL_TEXTURE_2D, m_glTexture0 );
-				else
-					glBindTexture( GL_TEXTURE_2D, Texture0.Handle );
-			}
-
-			ROI normalizedRoi = screen;
-			normalizedRoi.bottom = normalizedRoi.bottom * 2 - 1;
-			normalizedRoi.left = normalizedRoi.left * 2 - 1;
-			normalizedRoi.top = normalizedRoi.top * 2 - 1;
-			normalizedRoi.right = normalizedRoi.right * 2 - 1;
-
-			glEnable( GL_TEXTURE_2D );
-			glBegin( GL_QUADS );
-			glTexCoord2f( 0.0, 0.0 );
-			glVertex2f( normalizedRoi.left, normalizedRoi.bottom );
-			glTexCoord2f( 0.0, 1.0 );
-			glVertex2f( normalizedRoi.left, normalizedRoi.top );
-			glTexCoord2f( 1.0, 1.0 );
-			glVertex2f( (normalizedRoi.right - normalizedRoi.left) / 2 + normalizedRoi.left, normalizedRoi.top );
-			glTexCoord2f( 1.0, 0.0 );
-			glVertex2f( (normalizedRoi.right - normalizedRoi.left) / 2 + normalizedRoi.left, normalizedRoi.bottom );
-
-			//mirror
-			glTexCoord2f( 1.0, 0.0 );
-			glVertex2f( (normalizedRoi.right - normalizedRoi.left) / 2 + normalizedRoi.left, normalizedRoi.bottom );
-			glTexCoord2f( 1.0, 1.0 );
-			glVertex2f( (normalizedRoi.right - normalizedRoi.left) / 2 + normalizedRoi.left, normalizedRoi.top );
-			glTexCoord2f( 0.0, 1.0 );
-			glVertex2f( normalizedRoi.right, normalizedRoi.top );
-			glTexCoord2f( 0.0, 0.0 );
-			glVertex2f( normalizedRoi.right, normalizedRoi.bottom );
-			glEnd();
-			glDisable( GL_TEXTURE_2D );
-
-			// unbind input texture 0
-			if (m_inputTextureLocation >= 0 && Texture0.Handle > 0) {
-				m_extensions.glActiveTexture( GL_TEXTURE0 );
-				glBindTexture( GL_TEXTURE_2D, 0 );
-			}
-
-			m_shader.UnbindShader();
+		m_shader.BindShader();
 
-		}
+		//Bind all the variables!
+		if (m_inputTextureUniform >= 0)
+			m_shader.SetUniform1i( m_inputTextureUniform, 0 );
+
+		m_extensions.glActiveTexture( GL_TEXTURE0 );
+		glBindTexture( GL_TEXTURE_2D, copy.Handle );
+
+		ROI normalizedRoi = screen;
+		normalizedRoi.bottom = normalizedRoi.bottom * 2 - 1;
+		normalizedRoi.left = normalizedRoi.left * 2 - 1;
+		normalizedRoi.top = normalizedRoi.top * 2 - 1;
+		normalizedRoi.right = normalizedRoi.right * 2 - 1;
 
+		float middle = (normalizedRoi.right - normalizedRoi.left) / 2 + normalizedRoi.left;
+
+		glEnable( GL_TEXTURE_2D );
+		FFGLDrawQuad( normalizedRoi.left, normalizedRoi.bottom, middle, normalizedRoi.top, 0.0f, 0.0f, 1.0f, 1.0f );
+		//mirror
+		FFGLDrawQuad( middle, normalizedRoi.bottom, normalizedRoi.right, normalizedRoi.top, 1.0f, 0.0f, 0.0f, 1.0f );
+		glDisable( GL_TEXTURE_2D );
+
+		// unbind input texture 0
+		glBindTexture( GL_TEXTURE_2D, 0 );
+
+		m_shader.UnbindShader();
 	}
 
+	if (m_params.dmxOutput > 0.5f)
+		SampleFixtures( Texture0, pGL->HostFBO );
+
 	return FF_SUCCESS;
 }
 
 FFResult C1080pToNative::SetFloatParameter( unsigned int index, float value )
 {
-	switch (index)
-	{
-	case FFPARAM_BOTTOM:
-		m_Roi.bottom = value;
-		break;
-
-	case FFPARAM_LEFT:
-		m_Roi.left = value;
-		break;
-
-	case FFPARAM_TOP:
-		m_Roi.top = value;
-		break;
+	if (s_schema.SetFloat( m_params, index, value ) != FF_SUCCESS)
+		return FF_FAIL;
 
-	case FFPARAM_RIGHT:
-		m_Roi.right = value;
-		break;
+	if (index == FFPARAM_PRECISION)
+		m_targetFormat.SetPrecision( FFGLTargetFormat::PrecisionFromParam( m_params.precision ) );
 
-	default:
-		return FF_FAIL;
-	}
 	return FF_SUCCESS;
 }
 
 float C1080pToNative::GetFloatParameter( unsigned int index )
 {
-	switch (index)
-	{
-	case FFPARAM_BOTTOM:
-		return m_Roi.bottom;
-		break;
+	return s_schema.GetFloat( m_params, index );
+}
 
-	case FFPARAM_LEFT:
-		return m_Roi.left;
-		break;
+FFResult C1080pToNative::SetTextParameter( unsigned int index, const char *value )
+{
+	if (s_schema.SetText( m_params, index, value ) != FF_SUCCESS)
+		return FF_FAIL;
 
-	case FFPARAM_TOP:
-		return m_Roi.top;
-		break;
+	LoadPixelMap();
+	return FF_SUCCESS;
+}
 
-	case FFPARAM_RIGHT:
-		return m_Roi.right;
-		break;
+char * C1080pToNative::GetTextParameter( unsigned int index )
+{
+	return s_schema.GetText( m_params, index );
+}
 
-	default:
-		return FF_FAIL;
+FFResult C1080pToNative::SetParameters( const SetParameterStruct *params, unsigned int numParams )
+{
+	// the values are stored first, the precision and the pixel map are
+	// applied once for all of them. Like SetTextParameter, a pixel map
+	// sent again is loaded again, the file may have changed
+	FFResult result = s_schema.SetParameters( m_params, params, numParams );
+
+	m_targetFormat.SetPrecision( FFGLTargetFormat::PrecisionFromParam( m_params.precision ) );
+	for (unsigned int i = 0; params != NULL && i < numParams; i++)
+	{
+		if (params[i].ParameterNumber == FFPARAM_PIXEL_MAP)
+		{
+			LoadPixelMap();
+			break;
+		}
 	}
+
+	return result;
 }
 
 FFResult C1080pToNative::GetInputStatus( DWORD dwIndex )
@@ -290,219 +272,137 @@ FFResult C1080pToNative::GetInputStatus( DWORD dwIndex )
 
 char * C1080pToNative::GetParameterDisplay( DWORD dwIndex )
 {
-	return "1";
+	if (dwIndex == FFPARAM_PRECISION)
+		return CopyParameterDisplay( FFGLTargetFormat::GetPrecisionName( m_targetFormat.GetPrecision() ) );
+
+	// the values, and the pixel map's path
+	return CFreeFrameGLPlugin::GetParameterDisplay( dwIndex );
 }
 
 void C1080pToNative::SetDefaults()
 {
-	m_glTexture0 = 0;
-	m_glTexture1 = 0;
-	m_fbo = 0;
-
 	//set screen ROI's
-
-	ROI screen;
-	
-	//back wall
-	screen.bottom = 1.0f - (512.0f / 1080.0f);
-	screen.top = 1.0f;
-	screen.left = 0.0f;
-	screen.right = .5f;
-	this->screens.push_back( screen );
-
-	//dj booth
-	screen.bottom = 1.0f - ((512.0f + 375.0f) / 1080.0f);
-	screen.top = 1.0f - (512.0f / 1080.0f);
-	screen.left = 649.0 / 4096.0;
-	screen.right = screen.left + (750.0f / 4096.0f);
-	this->screens.push_back( screen );
-
-	//screen near bar
-	screen.bottom = 1.0f - (384.0f / 1080.0f);
-	screen.top = 1.0f;
-	screen.left = (2432.0f / 4096.0f);
-	screen.right = (3712.0f / 4096.0f);
-	this->screens.push_back( screen );
-
-	//outer wall L
-	screen.bottom = 0.0f;
-	screen.top = 384.0f / 1080.0f;
-	screen.left = 1792.0f / 4096.0f;
-	screen.right = screen.left + (640.0f / 4096.0f);
-	this->screens.push_back( screen );
-
-	//south wall l
-	screen.left = screen.right;
-	screen.right += 512.0f / 4096.0f;
-	this->screens.push_back( screen );
-
-	//south wall r
-	screen.left = screen.right;
-	screen.right += 512.0f / 4096.0f;
-	this->screens.push_back( screen );
-
-	//outer wall r
-	screen.left = screen.right;
-	screen.right += 640.0f / 4096.0f;
-	this->screens.push_back( screen );
+	FFGLGetNativeScreens( this->screens );
 }
 
-void C1080pToNative::StartCounter()
+void C1080pToNative::LoadPixelMap()
 {
-}
-FFGLTextureStruct Texture1;
+	if (m_params.pixelMap.empty())
+		m_pixelMap.Clear();
+	else if (!m_pixelMap.Load( m_params.pixelMap.c_str() ))
+		FFDebugMessage( "Pixel map %s: %s", m_params.pixelMap.c_str(), m_pixelMap.GetError().c_str() );
 
-double C1080pToNative::GetCounter()
-{
-	return 0;
+	// the GL side and the sender are updated by the next frame
+	m_pixelMapChanged = true;
 }
 
-bool C1080pToNative::LoadShader( std::string shaderString )
+void C1080pToNative::ApplyPixelMap()
 {
-	m_shader.SetExtensions( &m_extensions );
-	if (!m_shader.Compile( vertexShaderCode, shaderString.c_str() ))
-	{
-		printf( "Shader failed to compile." );
-		return false;
-	}
-	else
-	{
-		bool success = false;
-		if (m_shader.IsReady())
-		{
-			if (m_shader.BindShader())
-				success = true;
-		}
-		if (!success)
-			return false;
-		else
-		{
-			//get uniform locations here using m_shader.FindUniform("string")
-			m_inputTextureLocation = -1;
+	m_pixelMapChanged = false;
 
-			if (m_inputTextureLocation < 0)
-				m_inputTextureLocation = m_shader.FindUniform( "tex0" );
+	// the sender is used by the readback's consumer thread while it runs
+	m_readback.Stop();
+	m_dmxSender.Close();
 
-			m_shader.UnbindShader();
-			if (m_glTexture0 > 0) glDeleteTextures( 1, &m_glTexture0 );
-			if (m_glTexture1 > 0) glDeleteTextures( 1, &m_glTexture1 );
-			m_glTexture0 = 0;
-			m_glTexture1 = 0;
+	if (m_pixelMap.GetNumPixels() == 0)
+		return;
 
-			StartCounter();
+	int width = m_pixelMap.GetTextureWidth();
+	int height = m_pixelMap.GetTextureHeight();
 
-			return true;
-		}
-	}
-	return false;
-}
+	// the positions are already texels; for a binary map they come straight
+	// out of the mapped file, paged in as the driver copies them
+	m_fixturePositions.Allocate( GL_TEXTURE_2D, GL_RGBA8, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &m_glResources );
+	glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, m_pixelMap.GetPositionTexels() );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+	glBindTexture( GL_TEXTURE_2D, 0 );
 
-void C1080pToNative::CreateRectangleTexture( FFGLTextureStruct texture, FFGLTexCoords maxCoords, GLuint & glTexture, GLenum texunit, GLuint & fbo, GLuint hostFbo )
-{
-	if (fbo == 0)
+	if (!m_dmxSender.Open( m_pixelMap, m_pixelMap.GetDestination(), "FFGL 1080p to Native" ))
 	{
-		m_extensions.glGenFramebuffersEXT( 1, &fbo );
+		FFDebugMessage( "DMX output: %s", m_dmxSender.GetError().c_str() );
+		return;
 	}
 
-	if (glTexture == 0)
+	// the sampled colors come back as tightly packed RGB, three bytes per
+	// pixel of the map in its order, which is what the sender takes. The
+	// last row may be padded past the map's pixels, the sender ignores those
+	m_readback.SetPixelFormat( GL_RGB );
+	m_readback.Start( [this]( const FFGLReadbackFrame &frame )
 	{
-		glGenTextures( 1, &glTexture );
-		m_extensions.glActiveTexture( texunit );
-		glBindTexture( GL_TEXTURE_2D, glTexture );
-		glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-		glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-		glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_R, GL_REPEAT );
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-		glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, texture.Width, texture.Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
-		glBindTexture( GL_TEXTURE_2D, 0 );
-		m_extensions.glActiveTexture( GL_TEXTURE0 );
-	}
-	m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, fbo );
-	m_extensions.glFramebufferTexture2DEXT( GL_READ_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, glTexture, 0 );
-
-	glEnable( GL_TEXTURE_2D );
-	glBindTexture( GL_TEXTURE_2D, texture.Handle );
-	glBegin( GL_QUADS );
-
-	//lower left
-	glTexCoord2f( 0.0, 0.0 );
-	glVertex2f( -1.0, -1.0 );
-	//upper left
-	glTexCoord2f( 0.0, (float)maxCoords.t );
-	glVertex2f( -1.0, 1.0 );
-	// upper right
-	glTexCoord2f( (float)maxCoords.s, (float)maxCoords.t );
-	glVertex2f( 1.0, 1.0 );
-	//lower right
-	glTexCoord2f( (float)maxCoords.s, 0.0 );
-	glVertex2f( 1.0, -1.0 );
-	glEnd();
-	glDisable( GL_TEXTURE_2D );
-
-	glBindTexture( GL_TEXTURE_2D , 0);
-
-	if (hostFbo > 0)
-		m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, hostFbo );
-	else
-		m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, 0 );
+		m_dmxSender.Send( &frame.pixels[0], (size_t)frame.width * (size_t)frame.height );
+	} );
 }
 
-void C1080pToNative::CreateRectangleTexture( FFGLTextureStruct texture, FFGLTexCoords maxCoords, ROI roi, GLuint & glTexture, GLenum texunit, GLuint & fbo, GLuint hostFbo )
+void C1080pToNative::SampleFixtures( FFGLTextureStruct input, GLuint hostFbo )
 {
-	if (fbo == 0)
+	if (m_pixelMapChanged)
+		ApplyPixelMap();
+
+	if (m_pixelMap.GetNumPixels() == 0 || !m_dmxSender.IsOpen())
+		return;
+
+	if (!m_fixtureShaderLoaded)
 	{
-		m_extensions.glGenFramebuffersEXT( 1, &fbo );
+		if (!m_fixtureShader.IsCompileComplete() || !m_fixtureShader.IsReady())
+			return;
+
+		m_fixtureInputUniform = m_fixtureShader.FindUniformIndex( "tex0" );
+		m_fixturePositionsUniform = m_fixtureShader.FindUniformIndex( "fixturePositions" );
+		m_fixtureMaxCoordsUniform = m_fixtureShader.FindUniformIndex( "maxCoords" );
+		m_fixtureShaderLoaded = true;
 	}
 
-	float texWidth = (float)maxCoords.s;
-	float texHeight = (float)maxCoords.t;
+	// only the frames the sender's rate lets through are sampled and read back
+	if (!m_dmxSender.ClaimFrame())
+		return;
 
-	roi.left *= texWidth;
-	roi.right *= texWidth;
-	roi.bottom *= texHeight;
-	roi.top *= texHeight;
+	int width = m_pixelMap.GetTextureWidth();
+	int height = m_pixelMap.GetTextureHeight();
 
-	if (glTexture == 0)
-	{
-		glGenTextures( 1, &glTexture );
-		m_extensions.glActiveTexture( texunit );
-		glBindTexture( GL_TEXTURE_2D, glTexture );
-		glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-		glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-		glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_R, GL_REPEAT );
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-		glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, texture.Width, texture.Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
-		glBindTexture( GL_TEXTURE_2D, 0 );
-		m_extensions.glActiveTexture( GL_TEXTURE0 );
-	}
-	m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, fbo );
-	m_extensions.glFramebufferTexture2DEXT( GL_READ_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, glTexture, 0 );
-
-	glEnable( GL_TEXTURE_2D );
-	glBindTexture( GL_TEXTURE_2D, texture.Handle );
-	glBegin( GL_QUADS );
-
-	//lower left
-	glTexCoord2f( roi.left, roi.bottom);
-	glVertex2f( -1.0, -1.0 );
-	//upper left
-	glTexCoord2f( roi.left, roi.top);
-	glVertex2f( -1.0, 1.0 );
-	// upper right
-	glTexCoord2f( roi.right, roi.top);
-	glVertex2f( 1.0, 1.0 );
-	//lower right
-	glTexCoord2f( roi.right, roi.bottom);
-	glVertex2f( 1.0, -1.0 );
-	glEnd();
-	glDisable( GL_TEXTURE_2D );
-
-	glBindTexture( GL_TEXTURE_2D , 0);
-
-	if (hostFbo > 0)
-		m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, hostFbo );
-	else
-		m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, 0 );
+	m_fixtureColors.Allocate( GL_TEXTURE_2D, GL_RGBA8, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &m_glResources );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+
+	GLint viewport[4];
+	glGetIntegerv( GL_VIEWPORT, viewport );
+
+	m_fixtureFbo.Create( m_extensions, &m_glResources );
+	m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, m_fixtureFbo.GetHandle() );
+	m_extensions.glFramebufferTexture2DEXT( GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, m_fixtureColors.GetHandle(), 0 );
+	glViewport( 0, 0, width, height );
+
+	FFGLTexCoords maxCoords = GetMaxGLTexCoords( input );
+
+	m_fixtureShader.BindShader();
+	m_fixtureShader.SetUniform1i( m_fixtureInputUniform, 0 );
+	m_fixtureShader.SetUniform1i( m_fixturePositionsUniform, 1 );
+	m_fixtureShader.SetUniform2f( m_fixtureMaxCoordsUniform, (GLfloat)maxCoords.s, (GLfloat)maxCoords.t );
+
+	m_extensions.glActiveTexture( GL_TEXTURE1 );
+	glBindTexture( GL_TEXTURE_2D, m_fixturePositions.GetHandle() );
+	m_extensions.glActiveTexture( GL_TEXTURE0 );
+	glBindTexture( GL_TEXTURE_2D, input.Handle );
+
+	FFGLDrawQuad( -1.0f, -1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f );
+
+	m_extensions.glActiveTexture( GL_TEXTURE1 );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+	m_extensions.glActiveTexture( GL_TEXTURE0 );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+
+	m_fixtureShader.UnbindShader();
+
+	m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, hostFbo );
+	glViewport( viewport[0], viewport[1], viewport[2], viewport[3] );
+
+	// queues the copy, the colors reach the sender a few frames later
+	FFGLTextureStruct colors;
+	colors.Width = colors.HardwareWidth = width;
+	colors.Height = colors.HardwareHeight = height;
+	colors.Handle = m_fixtureColors.GetHandle();
+	m_readback.Capture( colors );
 }
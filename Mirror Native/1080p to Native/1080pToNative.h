@@ -4,8 +4,14 @@
 #include <vector>
 #include "FFGL.h"
 #include "FFGLLib.h"
+#include "FFGLNativeScreens.h"
 #include "FFGLShader.h"
+#include "FFGLResources.h"
+#include "FFGLReadback.h"
+#include "FFGLPixelMap.h"
+#include "FFGLDMXSender.h"
 #include "FFGLPluginSDK.h"
+#include "FFGLEffect.h"
 
 #if (!(defined(WIN32) || defined(_WIN32) || defined(__WIN32__)))
 // posix
@@ -27,16 +33,21 @@ typedef int64_t LARGE_INTEGER;
 #define GL_READ_FRAMEBUFFER_EXT		0x8CA8
 #define GL_TEXTURE_WRAP_R			0x8072
 
-struct ROI
+// The parameters, see s_schema in 1080pToNative.cpp
+struct C1080pToNativeParams
 {
-	float top;
-	float left;
 	float bottom;
+	float left;
+	float top;
 	float right;
+	float precision;
+	float dmxOutput;
+	std::string pixelMap; // path of the pixel map file
 };
 
-class C1080pToNative : public CFreeFrameGLPlugin
+class C1080pToNative : public FFGLEffect<C1080pToNative>
 {
+	friend class FFGLEffect<C1080pToNative>;
 
 public:
 
@@ -56,9 +67,9 @@ public:
 	///////////////////////////////////////////////////
 	FFResult SetFloatParameter( unsigned int index, float value );
 	float GetFloatParameter( unsigned int index );
-	FFResult ProcessOpenGL( ProcessOpenGLStruct* pGL );
-	FFResult InitGL( const FFGLViewportStruct *vp );
-	FFResult DeInitGL();
+	FFResult SetTextParameter( unsigned int index, const char *value );
+	char * GetTextParameter( unsigned int index );
+	FFResult SetParameters( const SetParameterStruct *params, unsigned int numParams );
 	FFResult GetInputStatus( DWORD dwIndex );
 	char * GetParameterDisplay( DWORD dwIndex );
 
@@ -75,33 +86,33 @@ public:
 
 protected:
 
-	bool bInitialized;
-
-	ROI m_Roi;
+	C1080pToNativeParams m_params;
 
 	std::vector<ROI> screens;
 
-	// Local fbo and texture
-	GLuint m_glTexture0;
-	GLuint m_glTexture1;
-	GLuint m_fbo;
-
-	// Viewport
-	float m_vpWidth;
-	float m_vpHeight;
-
-	int m_initResources;
-	FFGLExtensions m_extensions;
-	FFGLShader m_shader;
-
-	GLint m_inputTextureLocation;
-
-
+	// DMX output: every pixel of the pixel map is sampled from the input
+	// into m_fixtureColors in one pass, read back asynchronously and sent
+	// from the readback's consumer thread
+	FFGLPixelMap m_pixelMap;
+	bool m_pixelMapChanged;
+	FFGLShader m_fixtureShader;
+	bool m_fixtureShaderLoaded;
+	int m_fixtureInputUniform;
+	int m_fixturePositionsUniform;
+	int m_fixtureMaxCoordsUniform;
+	FFGLTexture m_fixturePositions;
+	FFGLTexture m_fixtureColors;
+	FFGLFramebuffer m_fixtureFbo;
+	FFGLReadback m_readback;
+	FFGLDMXSender m_dmxSender;
 
 	void SetDefaults();
-	void StartCounter();
-	double GetCounter();
-	bool LoadShader( std::string shaderString );
-	void CreateRectangleTexture( FFGLTextureStruct texture, FFGLTexCoords maxCoords, GLuint &glTexture, GLenum texunit, GLuint &fbo, GLuint hostFbo );
-	void CreateRectangleTexture( FFGLTextureStruct texture, FFGLTexCoords maxCoords, ROI roi, GLuint &glTexture, GLenum texunit, GLuint &fbo, GLuint hostFbo );
+	void LoadPixelMap();
+	void ApplyPixelMap();
+	void SampleFixtures( FFGLTextureStruct input, GLuint hostFbo );
+
+	// FFGLEffect hooks
+	bool InitEffect();
+	void DeInitEffect();
+	FFResult Render( ProcessOpenGLStruct *pGL );
 };
@@ -11,9 +11,23 @@ int( *cross_secure_sprintf )(char *, size_t, const char *, ...) = snprintf;
 #define FFPARAM_LEFT	(1)
 #define FFPARAM_TOP		(2)
 #define FFPARAM_RIGHT	(3)
+#define FFPARAM_PRECISION	(4)
 
 #define STRINGIFY(A) #A
 
+// In the order of the FFPARAM_ indexes
+static constexpr FFGLParam<MirrorNativeParams> s_params[] =
+{
+	{ "Bottom Bound",	FF_TYPE_STANDARD, 0.0f, 0.0f, 1.0f, &MirrorNativeParams::bottom, NULL, NULL },
+	{ "Left Bound",		FF_TYPE_STANDARD, 0.0f, 0.0f, 1.0f, &MirrorNativeParams::left, NULL, NULL },
+	{ "Top Bound",		FF_TYPE_STANDARD, 1.0f, 0.0f, 1.0f, &MirrorNativeParams::top, NULL, NULL },
+	{ "Right Bound",	FF_TYPE_STANDARD, 1.0f, 0.0f, 1.0f, &MirrorNativeParams::right, NULL, NULL },
+	{ "Precision",		FF_TYPE_STANDARD, FFGLTargetFormat::PrecisionToParam( FFGL_PRECISION_AUTO ), 0.0f, 1.0f, &MirrorNativeParams::precision, NULL, NULL },
+};
+static_assert( FFGLParamsValid( s_params ), "bad parameter schema" );
+
+static const FFGLParamSchema<MirrorNativeParams> s_schema( s_params );
+
 ///Plugin Info
 static CFFGLPluginInfo PluginInfo(
 	MirrorNative::CreateInstance,		// Create method
@@ -80,6 +94,7 @@ char *fragmentShaderCode = STRINGIFY(
 );
 
 MirrorNative::MirrorNative()
+	: FFGLEffect<MirrorNative>( vertexShaderCode, fragmentShaderCode )
 {
 #ifdef DEBUG
 	// Debug console window so printf works
@@ -94,16 +109,10 @@ MirrorNative::MirrorNative()
 	SetMaxInputs( 2 );
 
 	//Setup Parameters
-	SetParamInfo( FFPARAM_BOTTOM,	"Bottom Bound"	, FF_TYPE_STANDARD, 0.0f );
-	SetParamInfo( FFPARAM_LEFT,		"Left Bound"	, FF_TYPE_STANDARD, 0.0f );
-	SetParamInfo( FFPARAM_TOP,		"Top Bound"		, FF_TYPE_STANDARD, 1.0f );
-	SetParamInfo( FFPARAM_RIGHT,	"Right Bound"	, FF_TYPE_STANDARD, 1.0f );
-
-	m_Roi = { 0.0f, 0.0f, 1.0f, 1.0f };
+	SetParamSchema( &s_schema );
+	s_schema.SetDefaults( m_params );
 
 	SetDefaults();
-
-	bInitialized = false;
 }
 
 MirrorNative::~MirrorNative()
@@ -111,451 +120,126 @@ MirrorNative::~MirrorNative()
 	//stub
 }
 
-FFResult MirrorNative::InitGL( const FFGLViewportStruct * vp )
+FFResult MirrorNative::Render( ProcessOpenGLStruct * pGL )
 {
-	m_extensions.Initialize();
-	if (m_extensions.multitexture == 0 || m_extensions.ARB_shader_objects == 0)
-		return FF_FAIL;
-
-	m_vpWidth = (float)vp->width;
-	m_vpHeight = (float)vp->height;
+	if (pGL->numInputTextures < 1 || pGL->inputTextures[0] == NULL)
+		return FF_SUCCESS;
 
+	BindMirrorShader();
+	DrawScreens( *(pGL->inputTextures[0]), pGL->HostFBO );
+	m_shader.UnbindShader();
 
-	StartCounter();
-
-	std::string shaderString = fragmentShaderCode;
-	bInitialized = LoadShader( shaderString );
 	return FF_SUCCESS;
 }
 
-FFResult MirrorNative::DeInitGL()
+FFResult MirrorNative::ProcessOpenGLBatch( ProcessOpenGLBatchStruct *pBatch )
 {
-	if (m_fbo)	m_extensions.glDeleteFramebuffersEXT( 1, &m_fbo );
-	if (m_glTexture0)	glDeleteTextures( 1, &m_glTexture0 );
-	if (m_glTexture1)	glDeleteTextures( 1, &m_glTexture1 );
-	if (m_glTexture2)	glDeleteTextures( 1, &m_glTexture2 );
-	if (m_glTexture3)	glDeleteTextures( 1, &m_glTexture3 );
-
-	m_glTexture0 = 0;
-	m_glTexture1 = 0;
-	m_glTexture2 = 0;
-	m_glTexture3 = 0;
-	m_fbo = 0;
-	bInitialized = false;
-
-	return FF_SUCCESS;
-}
+	// until the shader has loaded every frame goes through ProcessOpenGL,
+	// which passes it through
+	if (!bShaderLoaded)
+		return FFGLEffect<MirrorNative>::ProcessOpenGLBatch( pBatch );
 
-FFResult MirrorNative::ProcessOpenGL( ProcessOpenGLStruct * pGL )
-{
-	FFGLTextureStruct Texture0;
+	if (BeginBatch( pBatch ) != FF_SUCCESS)
+		return FF_FAIL;
 
-	FFGLTexCoords maxCoords;
+	// the shader and its sampler are set once for the whole batch, and
+	// every frame is drawn straight into its layer
+	BindMirrorShader();
 
-	if (bInitialized) 
+	for (FFUInt32 i = 0; i < pBatch->numFrames; i++)
 	{
-		float vpdim[4];
-		glGetFloatv( GL_VIEWPORT, vpdim );
-		m_vpWidth = vpdim[2];
-		m_vpHeight = vpdim[3];
-
-		for (ROI screen : this->screens)
-		{
-			if (m_inputTextureLocation >= 0 || m_inputTextureLocation1 >= 0)
-			{
-				if (m_inputTextureLocation >= 0 && pGL->numInputTextures > 0 && pGL->inputTextures[0] != NULL)
-				{
-					Texture0 = *(pGL->inputTextures[0]);
-					maxCoords = GetMaxGLTexCoords( Texture0 );
-
-					if ((int)m_channelResolution[0][0] != Texture0.Width
-						|| (int)m_channelResolution[0][1] != Texture0.Height)
-					{
-						if (m_glTexture0 > 0)
-						{
-							glDeleteTextures( 1, &m_glTexture0 );
-							m_glTexture0 = 0;
-						}
-					}
-
-					m_channelResolution[0][0] = (float)Texture0.Width;
-					m_channelResolution[0][1] = (float)Texture0.Height;
-
-					//CreateRectangleTexture( Texture0, maxCoords, m_glTexture0, GL_TEXTURE0, m_fbo, pGL->HostFBO );
-
-					CreateRectangleTexture( Texture0, maxCoords, screen, m_glTexture0, GL_TEXTURE0, m_fbo, pGL->HostFBO );
-				}
-			}
-
-			lastTime = elapsedTime;
-			elapsedTime = GetCounter() / 1000.0;
-			//m_time = m_time + (float)(elapsedTime - lastTime);
-
-			m_shader.BindShader();
-
-
-			//Bind all the variables!
-			if (m_inputTextureLocation >= 0 && Texture0.Handle > 0)
-			{
-				m_extensions.glUniform1iARB( m_inputTextureLocation, 0 );
-			}
-
-			if (m_inputTextureLocation >= 0 && Texture0.Handle > 0)
-			{
-				m_extensions.glActiveTexture( GL_TEXTURE0 );
-
-				if (m_glTexture0 > 0)
-					glBindTexture( GL_TEXTURE_2D, m_glTexture0 );
-				else
-					glBindTexture( GL_TEXTURE_2D, Texture0.Handle );
-			}
-
-			ROI normalizedRoi = screen;
-			normalizedRoi.bottom = normalizedRoi.bottom * 2 - 1;
-			normalizedRoi.left = normalizedRoi.left * 2 - 1;
-			normalizedRoi.top = normalizedRoi.top * 2 - 1;
-			normalizedRoi.right = normalizedRoi.right * 2 - 1;
-
-			glEnable( GL_TEXTURE_2D );
-			glBegin( GL_QUADS );
-			glTexCoord2f( 0.0, 0.0 );
-			glVertex2f( normalizedRoi.left, normalizedRoi.bottom );
-			glTexCoord2f( 0.0, 1.0 );
-			glVertex2f( normalizedRoi.left, normalizedRoi.top );
-			glTexCoord2f( 1.0, 1.0 );
-			glVertex2f( (normalizedRoi.right - normalizedRoi.left) / 2 + normalizedRoi.left, normalizedRoi.top );
-			glTexCoord2f( 1.0, 0.0 );
-			glVertex2f( (normalizedRoi.right - normalizedRoi.left) / 2 + normalizedRoi.left, normalizedRoi.bottom );
-
-			//mirror
-			glTexCoord2f( 1.0, 0.0 );
-			glVertex2f( (normalizedRoi.right - normalizedRoi.left) / 2 + normalizedRoi.left, normalizedRoi.bottom );
-			glTexCoord2f( 1.0, 1.0 );
-			glVertex2f( (normalizedRoi.right - normalizedRoi.left) / 2 + normalizedRoi.left, normalizedRoi.top );
-			glTexCoord2f( 0.0, 1.0 );
-			glVertex2f( normalizedRoi.right, normalizedRoi.top );
-			glTexCoord2f( 0.0, 0.0 );
-			glVertex2f( normalizedRoi.right, normalizedRoi.bottom );
-			glEnd();
-			glDisable( GL_TEXTURE_2D );
-
-			// unbind input texture 0
-			if (m_inputTextureLocation >= 0 && Texture0.Handle > 0) {
-				m_extensions.glActiveTexture( GL_TEXTURE0 );
-				glBindTexture( GL_TEXTURE_2D, 0 );
-			}
-
-			m_shader.UnbindShader();
-
-		}
+		ProcessOpenGLStruct pGL;
+		BeginBatchFrame( pBatch, i, &pGL );
 
+		if (pGL.numInputTextures >= 1 && pGL.inputTextures[0] != NULL)
+			DrawScreens( *(pGL.inputTextures[0]), pGL.HostFBO );
 	}
 
+	m_shader.UnbindShader();
+	EndBatch( pBatch );
+
 	return FF_SUCCESS;
 }
 
-FFResult MirrorNative::SetFloatParameter( unsigned int index, float value )
+void MirrorNative::BindMirrorShader()
 {
-	switch (index)
-	{
-	case FFPARAM_BOTTOM:
-		m_Roi.bottom = value;
-		break;
-
-	case FFPARAM_LEFT:
-		m_Roi.left = value;
-		break;
-
-	case FFPARAM_TOP:
-		m_Roi.top = value;
-		break;
+	m_shader.BindShader();
 
-	case FFPARAM_RIGHT:
-		m_Roi.right = value;
-		break;
+	//Bind all the variables!
+	if (m_inputTextureUniform >= 0)
+		m_shader.SetUniform1i( m_inputTextureUniform, 0 );
 
-	default:
-		return FF_FAIL;
-	}
-	return FF_SUCCESS;
+	m_extensions.glActiveTexture( GL_TEXTURE0 );
 }
 
-float MirrorNative::GetFloatParameter( unsigned int index )
+void MirrorNative::DrawScreens( const FFGLTextureStruct &Texture0, GLuint hostFbo )
 {
-	switch (index)
+	for (const ROI &screen : this->screens)
 	{
-	case FFPARAM_BOTTOM:
-		return m_Roi.bottom;
-		break;
+		// the shader samples tex0 as it is, like the fixed function draw
+		// of CopyInput, so it can stay bound for the copy
+		FFGLTextureStruct copy = CopyInput( Texture0, hostFbo, screen.left, screen.bottom, screen.right, screen.top );
 
-	case FFPARAM_LEFT:
-		return m_Roi.left;
-		break;
+		glBindTexture( GL_TEXTURE_2D, copy.Handle );
 
-	case FFPARAM_TOP:
-		return m_Roi.top;
-		break;
+		ROI normalizedRoi = screen;
+		normalizedRoi.bottom = normalizedRoi.bottom * 2 - 1;
+		normalizedRoi.left = normalizedRoi.left * 2 - 1;
+		normalizedRoi.top = normalizedRoi.top * 2 - 1;
+		normalizedRoi.right = normalizedRoi.right * 2 - 1;
 
-	case FFPARAM_RIGHT:
-		return m_Roi.right;
-		break;
+		float middle = (normalizedRoi.right - normalizedRoi.left) / 2 + normalizedRoi.left;
 
-	default:
-		return FF_FAIL;
-	}
-}
-
-FFResult MirrorNative::GetInputStatus( DWORD dwIndex )
-{
-	return FF_SUCCESS;
-}
+		glEnable( GL_TEXTURE_2D );
+		FFGLDrawQuad( normalizedRoi.left, normalizedRoi.bottom, middle, normalizedRoi.top, 0.0f, 0.0f, 1.0f, 1.0f );
+		//mirror
+		FFGLDrawQuad( middle, normalizedRoi.bottom, normalizedRoi.right, normalizedRoi.top, 1.0f, 0.0f, 0.0f, 1.0f );
+		glDisable( GL_TEXTURE_2D );
 
-char * MirrorNative::GetParameterDisplay( DWORD dwIndex )
-{
-	return "1";
+		// unbind input texture 0
+		glBindTexture( GL_TEXTURE_2D, 0 );
+	}
 }
 
-void MirrorNative::SetDefaults()
+FFResult MirrorNative::SetFloatParameter( unsigned int index, float value )
 {
-	elapsedTime = 0.0;
-	lastTime = 0.0;
-#if (defined(WIN32) || defined(_WIN32) || defined(__WIN32__))
-	PCFreq = 0.0;
-	CounterStart = 0;
-#else
-	start = std::chrono::steady_clock::now();
-#endif
-
-	m_glTexture0 = 0;
-	m_glTexture1 = 0;
-	m_fbo = 0;
+	if (s_schema.SetFloat( m_params, index, value ) != FF_SUCCESS)
+		return FF_FAIL;
 
-	//set screen ROI's
+	if (index == FFPARAM_PRECISION)
+		m_targetFormat.SetPrecision( FFGLTargetFormat::PrecisionFromParam( m_params.precision ) );
 
-	ROI screen;
-	
-	//back wall
-	screen.bottom = 1.0f - (512.0f / 1080.0f);
-	screen.top = 1.0f;
-	screen.left = 0.0f;
-	screen.right = .5f;
-	this->screens.push_back( screen );
-
-	//dj booth
-	screen.bottom = 1.0f - ((512.0f + 375.0f) / 1080.0f);
-	screen.top = 1.0f - (512.0f / 1080.0f);
-	screen.left = 649.0 / 4096.0;
-	screen.right = screen.left + (750.0f / 4096.0f);
-	this->screens.push_back( screen );
-
-	//screen near bar
-	screen.bottom = 1.0f - (384.0f / 1080.0f);
-	screen.top = 1.0f;
-	screen.left = (2432.0f / 4096.0f);
-	screen.right = (3712.0f / 4096.0f);
-	this->screens.push_back( screen );
-
-	//outer wall L
-	screen.bottom = 0.0f;
-	screen.top = 384.0f / 1080.0f;
-	screen.left = 1792.0f / 4096.0f;
-	screen.right = screen.left + (640.0f / 4096.0f);
-	this->screens.push_back( screen );
-
-	//south wall l
-	screen.left = screen.right;
-	screen.right += 512.0f / 4096.0f;
-	this->screens.push_back( screen );
-
-	//south wall r
-	screen.left = screen.right;
-	screen.right += 512.0f / 4096.0f;
-	this->screens.push_back( screen );
-
-	//outer wall r
-	screen.left = screen.right;
-	screen.right += 640.0f / 4096.0f;
-	this->screens.push_back( screen );
+	return FF_SUCCESS;
 }
 
-void MirrorNative::StartCounter()
+FFResult MirrorNative::SetParameters( const SetParameterStruct *params, unsigned int numParams )
 {
-#if (defined(WIN32) || defined(_WIN32) || defined(__WIN32__))
-	LARGE_INTEGER li;
-	// Find frequency
-	QueryPerformanceFrequency( &li );
-	PCFreq = double( li.QuadPart ) / 1000.0;
-	// Second call needed
-	QueryPerformanceCounter( &li );
-	CounterStart = li.QuadPart;
-#else
-	// posix c++11
-	start = std::chrono::steady_clock::now();
-#endif
+	// the bounds are only stored, the precision is applied once for all of them
+	FFResult result = s_schema.SetParameters( m_params, params, numParams );
+	m_targetFormat.SetPrecision( FFGLTargetFormat::PrecisionFromParam( m_params.precision ) );
+	return result;
 }
-	FFGLTextureStruct Texture1;
 
-double MirrorNative::GetCounter()
+float MirrorNative::GetFloatParameter( unsigned int index )
 {
-#if (defined(WIN32) || defined(_WIN32) || defined(__WIN32__))
-	LARGE_INTEGER li;
-	QueryPerformanceCounter( &li );
-	return double( li.QuadPart - CounterStart ) / PCFreq;
-#else
-	// posix c++11
-	end = std::chrono::steady_clock::now();
-	return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.;
-#endif
-	return 0;
-
+	return s_schema.GetFloat( m_params, index );
 }
 
-bool MirrorNative::LoadShader( std::string shaderString )
+FFResult MirrorNative::GetInputStatus( DWORD dwIndex )
 {
-	m_shader.SetExtensions( &m_extensions );
-	if (!m_shader.Compile( vertexShaderCode, shaderString.c_str() ))
-	{
-		printf( "Shader failed to compile." );
-		return false;
-	}
-	else
-	{
-		bool success = false;
-		if (m_shader.IsReady())
-		{
-			if (m_shader.BindShader())
-				success = true;
-		}
-		if (!success)
-			return false;
-		else
-		{
-			//get uniform locations here using m_shader.FindUniform("string")
-			m_inputTextureLocation = -1;
-
-			if (m_inputTextureLocation < 0)
-				m_inputTextureLocation = m_shader.FindUniform( "tex0" );
-
-			m_shader.UnbindShader();
-			if (m_glTexture0 > 0) glDeleteTextures( 1, &m_glTexture0 );
-			if (m_glTexture1 > 0) glDeleteTextures( 1, &m_glTexture1 );
-			m_glTexture0 = 0;
-			m_glTexture1 = 0;
-
-			StartCounter();
-
-			return true;
-		}
-	}
-	return false;
+	return FF_SUCCESS;
 }
 
-void MirrorNative::CreateRectangleTexture( FFGLTextureStruct texture, FFGLTexCoords maxCoords, GLuint & glTexture, GLenum texunit, GLuint & fbo, GLuint hostFbo )
+char * MirrorNative::GetParameterDisplay( DWORD dwIndex )
 {
-	if (fbo == 0)
-	{
-		m_extensions.glGenFramebuffersEXT( 1, &fbo );
-	}
+	if (dwIndex == FFPARAM_PRECISION)
+		return CopyParameterDisplay( FFGLTargetFormat::GetPrecisionName( m_targetFormat.GetPrecision() ) );
 
-	if (glTexture == 0)
-	{
-		glGenTextures( 1, &glTexture );
-		m_extensions.glActiveTexture( texunit );
-		glBindTexture( GL_TEXTURE_2D, glTexture );
-		glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-		glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-		glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_R, GL_REPEAT );
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-		glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, texture.Width, texture.Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
-		glBindTexture( GL_TEXTURE_2D, 0 );
-		m_extensions.glActiveTexture( GL_TEXTURE0 );
-	}
-	m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, fbo );
-	m_extensions.glFramebufferTexture2DEXT( GL_READ_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, glTexture, 0 );
-
-	glEnable( GL_TEXTURE_2D );
-	glBindTexture( GL_TEXTURE_2D, texture.Handle );
-	glBegin( GL_QUADS );
-
-	//lower left
-	glTexCoord2f( 0.0, 0.0 );
-	glVertex2f( -1.0, -1.0 );
-	//upper left
-	glTexCoord2f( 0.0, (float)maxCoords.t );
-	glVertex2f( -1.0, 1.0 );
-	// upper right
-	glTexCoord2f( (float)maxCoords.s, (float)maxCoords.t );
-	glVertex2f( 1.0, 1.0 );
-	//lower right
-	glTexCoord2f( (float)maxCoords.s, 0.0 );
-	glVertex2f( 1.0, -1.0 );
-	glEnd();
-	glDisable( GL_TEXTURE_2D );
-
-	glBindTexture( GL_TEXTURE_2D , 0);
-
-	if (hostFbo > 0)
-		m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, hostFbo );
-	else
-		m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, 0 );
+	return CFreeFrameGLPlugin::GetParameterDisplay( dwIndex );
 }
 
-void MirrorNative::CreateRectangleTexture( FFGLTextureStruct texture, FFGLTexCoords maxCoords, ROI roi, GLuint & glTexture, GLenum texunit, GLuint & fbo, GLuint hostFbo )
+void MirrorNative::SetDefaults()
 {
-	if (fbo == 0)
-	{
-		m_extensions.glGenFramebuffersEXT( 1, &fbo );
-	}
-
-	float texWidth = (float)maxCoords.s;
-	float texHeight = (float)maxCoords.t;
-
-	roi.left *= texWidth;
-	roi.right *= texWidth;
-	roi.bottom *= texHeight;
-	roi.top *= texHeight;
-
-	if (glTexture == 0)
-	{
-		glGenTextures( 1, &glTexture );
-		m_extensions.glActiveTexture( texunit );
-		glBindTexture( GL_TEXTURE_2D, glTexture );
-		glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-		glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-		glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_R, GL_REPEAT );
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-		glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, texture.Width, texture.Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
-		glBindTexture( GL_TEXTURE_2D, 0 );
-		m_extensions.glActiveTexture( GL_TEXTURE0 );
-	}
-	m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, fbo );
-	m_extensions.glFramebufferTexture2DEXT( GL_READ_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, glTexture, 0 );
-
-	glEnable( GL_TEXTURE_2D );
-	glBindTexture( GL_TEXTURE_2D, texture.Handle );
-	glBegin( GL_QUADS );
-
-	//lower left
-	glTexCoord2f( roi.left, roi.bottom);
-	glVertex2f( -1.0, -1.0 );
-	//upper left
-	glTexCoord2f( roi.left, roi.top);
-	glVertex2f( -1.0, 1.0 );
-	// upper right
-	glTexCoord2f( roi.right, roi.top);
-	glVertex2f( 1.0, 1.0 );
-	//lower right
-	glTexCoord2f( roi.right, roi.bottom);
-	glVertex2f( 1.0, -1.0 );
-	glEnd();
-	glDisable( GL_TEXTURE_2D );
-
-	glBindTexture( GL_TEXTURE_2D , 0);
-
-	if (hostFbo > 0)
-		m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, hostFbo );
-	else
-		m_extensions.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, 0 );
-}
+	//set screen ROI's
+	FFGLGetNativeScreens( this->screens );
+}
\ No newline at end of file
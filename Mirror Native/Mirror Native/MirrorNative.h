@@ -6,8 +6,11 @@
 #include <vector>
 #include "FFGL.h"
 #include "FFGLLib.h"
+#include "FFGLNativeScreens.h"
 #include "FFGLShader.h"
+#include "FFGLResources.h"
 #include "FFGLPluginSDK.h"
+#include "FFGLEffect.h"
 
 #if (!(defined(WIN32) || defined(_WIN32) || defined(__WIN32__)))
 // posix
@@ -29,16 +32,19 @@ typedef int64_t LARGE_INTEGER;
 #define GL_READ_FRAMEBUFFER_EXT		0x8CA8
 #define GL_TEXTURE_WRAP_R			0x8072
 
-struct ROI
+// The parameters, see s_schema in MirrorNative.cpp
+struct MirrorNativeParams
 {
-	float top;
-	float left;
 	float bottom;
+	float left;
+	float top;
 	float right;
+	float precision;
 };
 
-class MirrorNative : public CFreeFrameGLPlugin
+class MirrorNative : public FFGLEffect<MirrorNative>
 {
+	friend class FFGLEffect<MirrorNative>;
 
 public:
 
@@ -58,9 +64,7 @@ public:
 	///////////////////////////////////////////////////
 	FFResult SetFloatParameter( unsigned int index, float value );
 	float GetFloatParameter( unsigned int index );
-	FFResult ProcessOpenGL( ProcessOpenGLStruct* pGL );
-	FFResult InitGL( const FFGLViewportStruct *vp );
-	FFResult DeInitGL();
+	FFResult SetParameters( const SetParameterStruct *params, unsigned int numParams );
 	FFResult GetInputStatus( DWORD dwIndex );
 	char * GetParameterDisplay( DWORD dwIndex );
 
@@ -77,54 +81,18 @@ public:
 
 protected:
 
-	bool bInitialized;
-
-	ROI m_Roi;
+	MirrorNativeParams m_params;
 
 	std::vector<ROI> screens;
 
-	// Local fbo and texture
-	GLuint m_glTexture0;
-	GLuint m_glTexture1;
-	GLuint m_glTexture2;
-	GLuint m_glTexture3;
-	GLuint m_fbo;
-
-	// Viewport
-	float m_vpWidth;
-	float m_vpHeight;
-
-	int m_initResources;
-	FFGLExtensions m_extensions;
-	FFGLShader m_shader;
-
-	GLint m_inputTextureLocation;
-	GLint m_inputTextureLocation1;
-
-	// Channel playback time (in seconds)
-	// iChannelTime components are always equal to iGlobalTime
-	float m_channelTime[4];
-
-	// Channel resolution in pixels - 4 channels with width, height, depth each
-	float m_channelResolution[4][3];
-
-
-	// Time
-	double elapsedTime, lastTime;
-#if (defined(WIN32) || defined(_WIN32) || defined(__WIN32__))
-	// windows
-	double PCFreq;
-	__int64 CounterStart;
-#else
-	// posix c++11
-	std::chrono::steady_clock::time_point start;
-	std::chrono::steady_clock::time_point end;
-#endif
-
 	void SetDefaults();
-	void StartCounter();
-	double GetCounter();
-	bool LoadShader( std::string shaderString );
-	void CreateRectangleTexture( FFGLTextureStruct texture, FFGLTexCoords maxCoords, GLuint &glTexture, GLenum texunit, GLuint &fbo, GLuint hostFbo );
-	void CreateRectangleTexture( FFGLTextureStruct texture, FFGLTexCoords maxCoords, ROI roi, GLuint &glTexture, GLenum texunit, GLuint &fbo, GLuint hostFbo );
+
+	// FFGLEffect hooks
+	FFResult Render( ProcessOpenGLStruct *pGL );
+
+	// FF_PROCESSOPENGLBATCH, with the shader bound once per batch
+	FFResult ProcessOpenGLBatch( ProcessOpenGLBatchStruct *pBatch );
+
+	void BindMirrorShader();
+	void DrawScreens( const FFGLTextureStruct &Texture0, GLuint hostFbo );
 };
\ No newline at end of file
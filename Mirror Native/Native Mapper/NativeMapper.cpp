@@ -0,0 +1,313 @@
+#include "NativeMapper.h"
+
+#if (defined(WIN32) || defined(_WIN32) || defined(__WIN32__))
+int( *cross_secure_sprintf )(char *, size_t, const char *, ...) = sprintf_s;
+#else
+// posix
+int( *cross_secure_sprintf )(char *, size_t, const char *, ...) = snprintf;
+#endif
+
+#define FFPARAM_THRESHOLD_BEGIN (0)
+#define FFPARAM_THRESHOLD_END (1)
+#define FFPARAM_PREMULTIPLY (2)
+#define FFPARAM_INPUT_FORMAT (3)
+#define FFPARAM_BT709 (4)
+#define FFPARAM_FULL_RANGE (5)
+
+#define STRINGIFY(A) #A
+
+// In the order of the FFPARAM_ indexes. The thresholds are uploaded to the
+// shader by UpdateParamUniforms
+static constexpr FFGLParam<NativeMapperParams> s_params[] =
+{
+	{ "Threshold Begin", FF_TYPE_STANDARD, 0.0f, 0.0f, 1.0f, &NativeMapperParams::thresholdBegin, "thresholdBegin", NULL },
+	{ "Threshold End", FF_TYPE_STANDARD, 0.0f, 0.0f, 1.0f, &NativeMapperParams::thresholdEnd, "thresholdEnd", NULL },
+	{ "Premultiply", FF_TYPE_BOOLEAN, 0.0f, 0.0f, 1.0f, &NativeMapperParams::premultiply, NULL, NULL },
+	{ "Input Format", FF_TYPE_STANDARD, FFGLYUVInput::FormatToParam( FFGL_INPUT_RGBA ), 0.0f, 1.0f, &NativeMapperParams::inputFormat, NULL, NULL },
+	{ "YUV BT.709", FF_TYPE_BOOLEAN, 1.0f, 0.0f, 1.0f, &NativeMapperParams::bt709, NULL, NULL },
+	{ "YUV Full Range", FF_TYPE_BOOLEAN, 0.0f, 0.0f, 1.0f, &NativeMapperParams::fullRange, NULL, NULL },
+};
+static_assert( FFGLParamsValid( s_params ), "bad parameter schema" );
+
+static const FFGLParamSchema<NativeMapperParams> s_schema( s_params );
+
+///Plugin Info
+static CFFGLPluginInfo PluginInfo(
+	NativeMapper::CreateInstance,		// Create method
+	"NTMP",								// *** Plugin unique ID (4 chars) - this must be unique for each plugin
+	"Native Mapper",					// *** Plugin name - make it different for each plugin
+	1,						   			// API major version number
+	006,								// API minor version number
+	1,									// *** Plugin major version number
+	000,								// *** Plugin minor version number
+	FF_EFFECT,							// Plugin type can always be an effect
+	"Luma Key and Mirror Native in a single pass "		// *** Plugin description - you can expand on this
+	"for EDGE Nightclub Native Content",
+	"by Daniel Goodnow (danielgoodnow@gmail.com)"		// *** About - use your own name and details
+	);
+
+// The sampling and the key come from FFGLShaderSnippets.h, LoadShaders puts
+// them in front of this main. The mirroring is done by the texture
+// coordinates of the quads, so the fetch (and the YUV conversion, for
+// planar inputs) is all that's left to do per pixel
+char *fragmentShaderCode = STRINGIFY(
+void main( void ) {
+	float luma;
+	vec4 color = ffglSampleInputLuma( gl_TexCoord[0].st, luma );
+	gl_FragColor = ffglLumaKey( color, luma );
+}
+);
+
+NativeMapper::NativeMapper()
+{
+#ifdef DEBUG
+	// Debug console window so printf works
+	FILE* pCout; // should really be freed on exit
+	AllocConsole();
+	freopen_s( &pCout, "CONOUT$", "w", stdout );
+	printf( "Shader Maker Vers 1.004\n" );
+	printf( "GLSL version [%s]\n", glGetString( GL_SHADING_LANGUAGE_VERSION ) );
+#endif
+
+	SetMinInputs( 0 );
+	SetMaxInputs( 3 );
+
+	//Setup Parameters
+	SetParamSchema( &s_schema );
+	s_schema.SetDefaults( m_params );
+	ApplyFormats();
+
+	FFGLGetNativeScreens( this->screens );
+
+	m_shader = NULL;
+	m_shaderFormat = FFGL_INPUT_RGBA;
+	m_queuedFormats = 0;
+
+	bInitialized = false;
+}
+
+NativeMapper::~NativeMapper()
+{
+	//stub
+}
+
+FFResult NativeMapper::InitGL( const FFGLViewportStruct *vp )
+{
+	m_extensions.Initialize();
+	if (m_extensions.multitexture == 0 || m_extensions.ARB_shader_objects == 0)
+		return FF_FAIL;
+
+	bInitialized = LoadShaders();
+	return FF_SUCCESS;
+}
+
+FFResult NativeMapper::DeInitGL()
+{
+	m_shaders.FreeGLResources();
+	m_shader = NULL;
+	m_queuedFormats = 0;
+
+	bInitialized = false;
+
+	return FF_SUCCESS;
+}
+
+FFResult NativeMapper::GetInputStatus( DWORD dwIndex )
+{
+	return FF_SUCCESS;
+}
+
+FFResult NativeMapper::ProcessOpenGL( ProcessOpenGLStruct * pGL )
+{
+	if (!bInitialized)
+		return FF_SUCCESS;
+
+	if (pGL->numInputTextures < 1 || pGL->inputTextures[0] == NULL)
+		return FF_SUCCESS;
+
+	// the variants of other input formats are only compiled once the
+	// format is first selected
+	QueueVariants( m_yuv.GetFormat() );
+
+	// pick the variant for the current parameters. while it is still
+	// compiling keep the previous one, or pass the input through
+	FFGLShader *shader = m_shaders.Get( SelectVariant() );
+	if (shader != NULL && shader != m_shader)
+		UseVariant( shader, m_yuv.GetFormat() );
+
+	// a variant of another format can't read this input
+	if (m_shader == NULL || m_shaderFormat != m_yuv.GetFormat())
+	{
+		FFGLDrawPassThrough( *(pGL->inputTextures[0]) );
+		return FF_SUCCESS;
+	}
+
+	DrawScreens( pGL );
+
+	return FF_SUCCESS;
+}
+
+void NativeMapper::DrawScreens( ProcessOpenGLStruct *pGL )
+{
+	// the screens are given in the used part of the input, which is
+	// maxCoords of the (possibly padded) texture
+	FFGLTexCoords maxCoords = GetMaxGLTexCoords( *(pGL->inputTextures[0]) );
+	float maxS = (float)maxCoords.s;
+	float maxT = (float)maxCoords.t;
+
+	m_shader->BindShader();
+
+	// binds input 0, or all the planes of a YUV input
+	if (!m_yuv.Bind( m_extensions, pGL ))
+	{
+		m_shader->UnbindShader();
+		return;
+	}
+
+	UpdateParamUniforms( m_shader );
+
+	glEnable( GL_TEXTURE_2D );
+	glBegin( GL_QUADS );
+
+	for (ROI screen : this->screens)
+	{
+		// where the screen is sampled from
+		float s0 = screen.left * maxS;
+		float s1 = screen.right * maxS;
+		float t0 = screen.bottom * maxT;
+		float t1 = screen.top * maxT;
+
+		// where it is drawn, the left half as is and the right half mirrored
+		float left = screen.left * 2 - 1;
+		float right = screen.right * 2 - 1;
+		float bottom = screen.bottom * 2 - 1;
+		float top = screen.top * 2 - 1;
+		float middle = (right - left) / 2 + left;
+
+		glTexCoord2f( s0, t0 );
+		glVertex2f( left, bottom );
+		glTexCoord2f( s0, t1 );
+		glVertex2f( left, top );
+		glTexCoord2f( s1, t1 );
+		glVertex2f( middle, top );
+		glTexCoord2f( s1, t0 );
+		glVertex2f( middle, bottom );
+
+		//mirror
+		glTexCoord2f( s1, t0 );
+		glVertex2f( middle, bottom );
+		glTexCoord2f( s1, t1 );
+		glVertex2f( middle, top );
+		glTexCoord2f( s0, t1 );
+		glVertex2f( right, top );
+		glTexCoord2f( s0, t0 );
+		glVertex2f( right, bottom );
+	}
+
+	glEnd();
+	glDisable( GL_TEXTURE_2D );
+
+	m_yuv.Unbind( m_extensions );
+
+	m_shader->UnbindShader();
+}
+
+FFResult NativeMapper::SetFloatParameter( unsigned int index, float value )
+{
+	float thresholdBegin = m_params.thresholdBegin;
+	if (s_schema.SetFloat( m_params, index, value ) != FF_SUCCESS)
+		return FF_FAIL;
+
+	switch (index)
+	{
+	case FFPARAM_THRESHOLD_BEGIN:
+		m_params.thresholdBegin = FFGLLumaKeyBegin( m_params.thresholdBegin, m_params.thresholdEnd, thresholdBegin );
+		break;
+
+	case FFPARAM_INPUT_FORMAT:
+	case FFPARAM_BT709:
+	case FFPARAM_FULL_RANGE:
+		ApplyFormats();
+		break;
+	}
+
+	return FF_SUCCESS;
+}
+
+FFResult NativeMapper::SetParameters( const SetParameterStruct *params, unsigned int numParams )
+{
+	// all the values are stored first, the formats follow them once
+	float thresholdBegin = m_params.thresholdBegin;
+	FFResult result = s_schema.SetParameters( m_params, params, numParams );
+
+	m_params.thresholdBegin = FFGLLumaKeyBegin( m_params.thresholdBegin, m_params.thresholdEnd, thresholdBegin );
+
+	ApplyFormats();
+	return result;
+}
+
+void NativeMapper::ApplyFormats()
+{
+	m_yuv.SetFormat( FFGLYUVInput::FormatFromParam( m_params.inputFormat ) );
+	m_yuv.SetBT709( m_params.bt709 > 0.5f ? 1 : 0 );
+	m_yuv.SetFullRange( m_params.fullRange > 0.5f ? 1 : 0 );
+}
+
+float NativeMapper::GetFloatParameter( unsigned int index )
+{
+	return s_schema.GetFloat( m_params, index );
+}
+
+char * NativeMapper::GetParameterDisplay( DWORD dwIndex )
+{
+	if (dwIndex == FFPARAM_INPUT_FORMAT)
+		return CopyParameterDisplay( FFGLYUVInput::GetFormatName( m_yuv.GetFormat() ) );
+
+	return CFreeFrameGLPlugin::GetParameterDisplay( dwIndex );
+}
+
+bool NativeMapper::LoadShaders()
+{
+	m_shaders.SetExtensions( &m_extensions );
+	m_shaders.SetResourceTracker( &m_glResources );
+
+	m_fragmentSource = FFGLSnippetSampleInput;
+	m_fragmentSource += FFGLSnippetLumaKey;
+	m_fragmentSource += fragmentShaderCode;
+	m_shaders.SetSource( FFGLSnippetVertexPassThrough, m_fragmentSource.c_str() );
+
+	m_queuedFormats = 0;
+	QueueVariants( m_yuv.GetFormat() );
+	return true;
+}
+
+void NativeMapper::QueueVariants( int format )
+{
+	if (m_queuedFormats & (1 << format))
+		return;
+
+	m_queuedFormats |= 1 << format;
+
+	// the key variants of Luma Key, without its luma and feather ones
+	for (int mode = LK_MODE_PASSTHROUGH; mode <= LK_MODE_SOFT; mode++)
+	{
+		for (int premultiply = 0; premultiply <= 1; premultiply++)
+			FFGLAddLumaKeyVariant( m_shaders, mode, premultiply, LK_FEATHER_OFF, format );
+	}
+}
+
+unsigned int NativeMapper::SelectVariant()
+{
+	int mode = FFGLLumaKeyMode( m_params.thresholdBegin, m_params.thresholdEnd );
+	return LK_VARIANT( mode, m_params.premultiply > 0.5f ? 1 : 0, LK_FEATHER_OFF, m_yuv.GetFormat() );
+}
+
+void NativeMapper::UseVariant( FFGLShader *shader, int format )
+{
+	m_shader = shader;
+	m_shaderFormat = format;
+
+	//the thresholds are bound with SetParamUniform, the samplers and the
+	//YUV conversion by m_yuv
+	m_yuv.UseShader( shader );
+}
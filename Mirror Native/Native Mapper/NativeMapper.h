@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdio.h>
+#include <string>
+#include <time.h>
+#include <vector>
+#include "FFGL.h"
+#include "FFGLLib.h"
+#include "FFGLLumaKeyVariants.h"
+#include "FFGLNativeScreens.h"
+#include "FFGLShader.h"
+#include "FFGLShaderCache.h"
+#include "FFGLShaderSnippets.h"
+#include "FFGLYUV.h"
+#include "FFGLResources.h"
+#include "FFGLPluginSDK.h"
+
+#if (!(defined(WIN32) || defined(_WIN32) || defined(__WIN32__)))
+// posix
+typedef uint8_t  CHAR;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef int8_t  BYTE;
+typedef int16_t SHORT;
+typedef int32_t LONG;
+typedef LONG INT;
+typedef INT BOOL;
+typedef int64_t __int64;
+typedef int64_t LARGE_INTEGER;
+#endif
+
+#define GL_SHADING_LANGUAGE_VERSION	0x8B8C
+
+// The parameters, see s_schema in NativeMapper.cpp
+struct NativeMapperParams
+{
+	float thresholdBegin;
+	float thresholdEnd;
+	float premultiply;
+	float inputFormat;
+	float bt709;
+	float fullRange;
+};
+
+// Luma Key followed by Mirror Native, fused into a single pass. Every native
+// screen is drawn straight from the input: its region is mirrored by the
+// texture coordinates of the quads and keyed while it is fetched, so no
+// intermediate frame is written or read. The input may be RGBA or planar
+// YUV (see FFGLYUV.h)
+class NativeMapper : public CFreeFrameGLPlugin
+{
+
+public:
+
+	///
+	///	Constructor.
+	///
+
+	NativeMapper();
+
+	///
+	///	Destructor.
+	///
+	~NativeMapper();
+
+	///////////////////////////////////////////////////
+	// FreeFrameGL plugin methods
+	///////////////////////////////////////////////////
+	FFResult SetFloatParameter( unsigned int index, float value );
+	float GetFloatParameter( unsigned int index );
+	FFResult SetParameters( const SetParameterStruct *params, unsigned int numParams );
+	FFResult ProcessOpenGL( ProcessOpenGLStruct* pGL );
+	FFResult InitGL( const FFGLViewportStruct *vp );
+	FFResult DeInitGL();
+	FFResult GetInputStatus( DWORD dwIndex );
+	char * GetParameterDisplay( DWORD dwIndex );
+
+	///////////////////////////////////////////////////
+	// Factory method
+	///////////////////////////////////////////////////
+	static FFResult __stdcall CreateInstance( CFreeFrameGLPlugin **ppOutInstance )
+	{
+		*ppOutInstance = new NativeMapper();
+		if (*ppOutInstance != NULL)
+			return FF_SUCCESS;
+		return FF_FAIL;
+	}
+
+protected:
+
+	bool bInitialized;
+
+	std::vector<ROI> screens;
+
+	NativeMapperParams m_params;
+
+	FFGLExtensions m_extensions;
+	FFGLShaderCache m_shaders;
+	FFGLShader *m_shader;
+	int m_shaderFormat;
+	int m_queuedFormats;
+	std::string m_fragmentSource;
+
+	FFGLYUVInput m_yuv;
+
+	void ApplyFormats();
+	bool LoadShaders();
+	unsigned int SelectVariant();
+	void QueueVariants( int format );
+	void UseVariant( FFGLShader *shader, int format );
+	void DrawScreens( ProcessOpenGLStruct *pGL );
+};
@@ -0,0 +1,54 @@
+// Converts a text pixel map (see FFGLPixelMap.h) to the binary form,
+// which 1080p to Native loads without parsing:
+//
+//	PixelMapConverter layout.txt layout.ffpm
+//
+// The binary file can be given to the Pixel Map parameter in place of
+// the text one.
+
+#include "FFGLPixelMap.h"
+#include <chrono>
+#include <stdio.h>
+
+int main( int argc, char *argv[] )
+{
+	if (argc != 3)
+	{
+		fprintf( stderr, "usage: %s <text pixel map> <binary pixel map>\n", argv[0] );
+		return 1;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	FFGLPixelMap map;
+	if (!map.Load( argv[1] ))
+	{
+		fprintf( stderr, "%s: %s\n", argv[1], map.GetError().c_str() );
+		return 1;
+	}
+
+	std::chrono::steady_clock::time_point parsed = std::chrono::steady_clock::now();
+
+	if (!map.Save( argv[2] ))
+	{
+		fprintf( stderr, "%s\n", map.GetError().c_str() );
+		return 1;
+	}
+
+	// load the result back, both to check it and to show what it saves
+	FFGLPixelMap check;
+	std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
+	if (!check.Load( argv[2] ) || check.GetNumPixels() != map.GetNumPixels())
+	{
+		fprintf( stderr, "%s: written file doesn't load back: %s\n", argv[2], check.GetError().c_str() );
+		return 1;
+	}
+	std::chrono::steady_clock::time_point loaded = std::chrono::steady_clock::now();
+
+	printf( "%u pixels, %dx%d texture\n", (unsigned int)map.GetNumPixels(), map.GetTextureWidth(), map.GetTextureHeight() );
+	printf( "text load %.2f ms, binary load %.2f ms\n",
+		std::chrono::duration<double, std::milli>( parsed - start ).count(),
+		std::chrono::duration<double, std::milli>( loaded - loadStart ).count() );
+
+	return 0;
+}
@@ -0,0 +1,67 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+static const void *volatile s_sink;
+
+void KeepResult( const void *result )
+{
+	s_sink = result;
+}
+
+BenchmarkSuite::BenchmarkSuite()
+{
+}
+
+void BenchmarkSuite::Add( const std::string &name, Body body, unsigned int callsPerIteration )
+{
+	Benchmark benchmark;
+	benchmark.name = name;
+	benchmark.body = body;
+	benchmark.callsPerIteration = callsPerIteration > 0 ? callsPerIteration : 1;
+	m_benchmarks.push_back( benchmark );
+}
+
+double BenchmarkSuite::Time( Benchmark &benchmark, unsigned int iterations )
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	benchmark.body( iterations );
+	return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+}
+
+void BenchmarkSuite::Run( const char *filter, double minSeconds, int repetitions )
+{
+	printf( "%-36s %12s %12s %12s\n", "benchmark", "iterations", "ns/call", "median" );
+
+	for (size_t i = 0; i < m_benchmarks.size(); i++)
+	{
+		Benchmark &benchmark = m_benchmarks[i];
+		if (filter != NULL && benchmark.name.find( filter ) == std::string::npos)
+			continue;
+
+		// warms the caches, and finds the number of iterations that takes
+		// minSeconds
+		unsigned int iterations = 1;
+		double seconds = Time( benchmark, iterations );
+		while (seconds < minSeconds && iterations < 0x40000000)
+		{
+			double scale = seconds > 0.0 ? minSeconds * 1.4 / seconds : 10.0;
+			scale = std::min( std::max( scale, 2.0 ), 10.0 );
+			iterations = (unsigned int)std::min( iterations * scale, (double)0x40000000 );
+			seconds = Time( benchmark, iterations );
+		}
+
+		std::vector<double> results;
+		results.push_back( seconds );
+		for (int r = 1; r < repetitions; r++)
+			results.push_back( Time( benchmark, iterations ) );
+		std::sort( results.begin(), results.end() );
+
+		double calls = (double)iterations * benchmark.callsPerIteration;
+		printf( "%-36s %12u %12.1f %12.1f\n", benchmark.name.c_str(), iterations,
+			results.front() * 1e9 / calls, results[results.size() / 2] * 1e9 / calls );
+		fflush( stdout );
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// A small harness in the manner of Google Benchmark: every benchmark is a
+// body that makes its calls iterations times, and the harness grows
+// iterations until a run lasts long enough for the clock to be trusted.
+// Runs are repeated and the fastest and the median reported, so a busy
+// machine shows up as a spread instead of a slower result.
+class BenchmarkSuite
+{
+public:
+	typedef std::function<void( unsigned int iterations )> Body;
+
+	BenchmarkSuite();
+
+	// callsPerIteration is the number of plugMain calls one iteration
+	// makes, so the time is reported per call
+	void Add( const std::string &name, Body body, unsigned int callsPerIteration = 1 );
+
+	// Runs every benchmark whose name contains filter (all of them for
+	// NULL) and prints a line for each
+	void Run( const char *filter, double minSeconds, int repetitions );
+
+private:
+	struct Benchmark
+	{
+		std::string name;
+		Body body;
+		unsigned int callsPerIteration;
+	};
+
+	std::vector<Benchmark> m_benchmarks;
+
+	double Time( Benchmark &benchmark, unsigned int iterations );
+};
+
+// Keeps the compiler from dropping calls whose result isn't used
+void KeepResult( const void *result );
+
+#endif
@@ -0,0 +1,416 @@
+// DispatchBench measures what a plugin costs the host's CPU outside of
+// rendering: plugMain's dispatch, the parameter calls a host makes every
+// frame and the creation of instances. A host with a dozen layers and an
+// open parameter panel makes these calls thousands of times a second, so
+// a change to FFGL.cpp or CFFGLPluginManager shows up here long before it
+// shows up in a frame time:
+//
+//	DispatchBench LumaKey.dll --filter Parameter --repetitions 9
+//
+// Every call goes through plugMain, exactly like a host's.
+
+#include "Benchmark.h"
+#include "OfflineContext.h"
+#include <FFGL.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+// instantiateGL reports failure as a pointer with the value of FF_FAIL
+static const FFInstanceID FAILED_INSTANCE = (FFInstanceID)(uintptr_t)FF_FAIL;
+
+static FF_Main_FuncPtr s_main = NULL;
+
+static FFMixed Call( FFUInt32 functionCode, FFUInt32 input, FFInstanceID instance )
+{
+	FFMixed mixed;
+	mixed.PointerValue = NULL;
+	mixed.UIntValue = input;
+	return s_main( functionCode, mixed, instance );
+}
+
+static FFMixed Call( FFUInt32 functionCode, void *input, FFInstanceID instance )
+{
+	FFMixed mixed;
+	mixed.PointerValue = input;
+	return s_main( functionCode, mixed, instance );
+}
+
+static FF_Main_FuncPtr LoadPlugin( const char *path )
+{
+#ifdef _WIN32
+	HMODULE module = LoadLibraryA( path );
+	if (module == NULL)
+		return NULL;
+	return (FF_Main_FuncPtr)GetProcAddress( module, "plugMain" );
+#else
+	void *module = dlopen( path, RTLD_NOW | RTLD_LOCAL );
+	if (module == NULL)
+	{
+		fprintf( stderr, "%s\n", dlerror() );
+		return NULL;
+	}
+	return (FF_Main_FuncPtr)dlsym( module, "plugMain" );
+#endif
+}
+
+static FFInstanceID Instantiate( FFGLViewportStruct &viewport )
+{
+	FFInstanceID instance = Call( FF_INSTANTIATEGL, &viewport, NULL ).PointerValue;
+	return instance == FAILED_INSTANCE ? NULL : instance;
+}
+
+// A value for parameter index on iteration, different every time so the
+// plugin can't skip the work of a change
+static void SetParameter( FFInstanceID instance, FFUInt32 index, FFUInt32 type, unsigned int iteration )
+{
+	static const char *TEXTS[2] = { "left", "right" };
+
+	SetParameterStruct set;
+	set.ParameterNumber = index;
+	if (type == FF_TYPE_TEXT)
+	{
+		set.NewParameterValue.PointerValue = (void *)TEXTS[iteration & 1];
+	}
+	else
+	{
+		float value = type == FF_TYPE_BOOLEAN ? (float)(iteration & 1) : (float)(iteration % 101) / 100.0f;
+		set.NewParameterValue.PointerValue = NULL;
+		memcpy( &set.NewParameterValue.UIntValue, &value, sizeof( value ) );
+	}
+
+	Call( FF_SETPARAMETER, &set, instance );
+}
+
+// The same values as SetParameter, for every parameter at once
+static void FillParameters( std::vector<SetParameterStruct> &params, const std::vector<FFUInt32> &types, unsigned int iteration )
+{
+	static const char *TEXTS[2] = { "left", "right" };
+
+	params.resize( types.size() );
+	for (FFUInt32 p = 0; p < types.size(); p++)
+	{
+		SetParameterStruct &set = params[p];
+		set.ParameterNumber = p;
+		if (types[p] == FF_TYPE_TEXT)
+		{
+			set.NewParameterValue.PointerValue = (void *)TEXTS[iteration & 1];
+		}
+		else
+		{
+			float value = types[p] == FF_TYPE_BOOLEAN ? (float)(iteration & 1) : (float)(iteration % 101) / 100.0f;
+			set.NewParameterValue.PointerValue = NULL;
+			memcpy( &set.NewParameterValue.UIntValue, &value, sizeof( value ) );
+		}
+	}
+}
+
+static void AddBenchmarks( BenchmarkSuite &suite, FFGLViewportStruct &viewport, FFInstanceID instance )
+{
+	FFUInt32 numParameters = Call( FF_GETNUMPARAMETERS, 0u, NULL ).UIntValue;
+	if (numParameters == FF_FAIL)
+		numParameters = 0;
+
+	std::vector<FFUInt32> types;
+	for (FFUInt32 i = 0; i < numParameters; i++)
+		types.push_back( Call( FF_GETPARAMETERTYPE, i, NULL ).UIntValue );
+
+	// the bare cost of getting into plugMain and out again
+	suite.Add( "plugMain/GetInfo", []( unsigned int iterations )
+	{
+		for (unsigned int i = 0; i < iterations; i++)
+			KeepResult( Call( FF_GETINFO, 0u, NULL ).PointerValue );
+	} );
+
+	suite.Add( "plugMain/GetPluginCaps", []( unsigned int iterations )
+	{
+		for (unsigned int i = 0; i < iterations; i++)
+			KeepResult( Call( FF_GETPLUGINCAPS, i % 6, NULL ).PointerValue );
+	} );
+
+	if (numParameters > 0)
+	{
+		// what a host asks once per plugin, and some hosts every frame
+		suite.Add( "Manager/GetParameterName", [numParameters]( unsigned int iterations )
+		{
+			for (unsigned int i = 0; i < iterations; i++)
+			{
+				for (FFUInt32 p = 0; p < numParameters; p++)
+					KeepResult( Call( FF_GETPARAMETERNAME, p, NULL ).PointerValue );
+			}
+		}, numParameters );
+
+		suite.Add( "Manager/GetParameterType", [numParameters]( unsigned int iterations )
+		{
+			for (unsigned int i = 0; i < iterations; i++)
+			{
+				for (FFUInt32 p = 0; p < numParameters; p++)
+					KeepResult( Call( FF_GETPARAMETERTYPE, p, NULL ).PointerValue );
+			}
+		}, numParameters );
+
+		suite.Add( "Manager/GetParameterDefault", [numParameters]( unsigned int iterations )
+		{
+			for (unsigned int i = 0; i < iterations; i++)
+			{
+				for (FFUInt32 p = 0; p < numParameters; p++)
+					KeepResult( Call( FF_GETPARAMETERDEFAULT, p, NULL ).PointerValue );
+			}
+		}, numParameters );
+
+		// a storm: every parameter changes every call, as with a MIDI
+		// controller or an LFO mapped to all of them
+		suite.Add( "Instance/SetParameter", [instance, types]( unsigned int iterations )
+		{
+			for (unsigned int i = 0; i < iterations; i++)
+			{
+				for (FFUInt32 p = 0; p < types.size(); p++)
+					SetParameter( instance, p, types[p], i );
+			}
+		}, numParameters );
+
+		// the same storm in one call per iteration
+		if (Call( FF_GETPLUGINCAPS, FF_CAP_SETPARAMETERS, NULL ).UIntValue == FF_TRUE)
+		{
+			suite.Add( "Instance/SetParameters", [instance, types]( unsigned int iterations )
+			{
+				std::vector<SetParameterStruct> params;
+				for (unsigned int i = 0; i < iterations; i++)
+				{
+					FillParameters( params, types, i );
+
+					SetParametersStruct set;
+					set.numParameters = (FFUInt32)params.size();
+					set.parameters = &params[0];
+					Call( FF_SETPARAMETERS, &set, instance );
+				}
+			}, numParameters );
+		}
+
+		suite.Add( "Instance/GetParameter", [instance, numParameters]( unsigned int iterations )
+		{
+			for (unsigned int i = 0; i < iterations; i++)
+			{
+				for (FFUInt32 p = 0; p < numParameters; p++)
+					KeepResult( Call( FF_GETPARAMETER, p, instance ).PointerValue );
+			}
+		}, numParameters );
+
+		// the value changes first, or a plugin caching the text would be
+		// measured instead of the formatting
+		suite.Add( "Instance/GetParameterDisplay", [instance, types]( unsigned int iterations )
+		{
+			for (unsigned int i = 0; i < iterations; i++)
+			{
+				for (FFUInt32 p = 0; p < types.size(); p++)
+				{
+					SetParameter( instance, p, types[p], i );
+					KeepResult( Call( FF_GETPARAMETERDISPLAY, p, instance ).PointerValue );
+				}
+			}
+		}, numParameters * 2 );
+	}
+
+	if (Call( FF_GETPLUGINCAPS, FF_CAP_SETTIME, NULL ).UIntValue == FF_TRUE)
+	{
+		suite.Add( "Instance/SetTime", [instance]( unsigned int iterations )
+		{
+			for (unsigned int i = 0; i < iterations; i++)
+			{
+				double time = i / 60.0;
+				Call( FF_SETTIME, &time, instance );
+			}
+		} );
+	}
+
+	// automation sent as keyframes: every float parameter gets one for
+	// half a second ahead, and the time moves on at 60 frames a second
+	if (Call( FF_GETPLUGINCAPS, FF_CAP_PARAMETERRAMPS, NULL ).UIntValue == FF_TRUE)
+	{
+		std::vector<FFUInt32> ramped;
+		for (FFUInt32 p = 0; p < types.size(); p++)
+		{
+			if (types[p] != FF_TYPE_TEXT)
+				ramped.push_back( p );
+		}
+
+		if (!ramped.empty())
+		{
+			suite.Add( "Instance/ParameterRamps", [instance, ramped]( unsigned int iterations )
+			{
+				std::vector<ParameterKeyframeStruct> keyframes( ramped.size() );
+				for (unsigned int i = 0; i < iterations; i++)
+				{
+					if (i % 30 == 0)
+					{
+						for (size_t k = 0; k < ramped.size(); k++)
+						{
+							keyframes[k].ParameterNumber = ramped[k];
+							keyframes[k].Value = (float)((i / 30 + k) % 2);
+							keyframes[k].Time = (i + 30) / 60.0;
+						}
+
+						SetParameterRampsStruct set;
+						set.numKeyframes = (FFUInt32)keyframes.size();
+						set.keyframes = &keyframes[0];
+						Call( FF_SETPARAMETERRAMPS, &set, instance );
+					}
+
+					double time = i / 60.0;
+					Call( FF_SETTIME, &time, instance );
+				}
+			}, (unsigned int)ramped.size() );
+		}
+	}
+
+	// what a host does for every frame of a layer with its parameter
+	// panel open: the time, all the parameters, and their display text
+	suite.Add( "Host/Frame", [instance, types]( unsigned int iterations )
+	{
+		for (unsigned int i = 0; i < iterations; i++)
+		{
+			double time = i / 60.0;
+			Call( FF_SETTIME, &time, instance );
+
+			for (FFUInt32 p = 0; p < types.size(); p++)
+			{
+				SetParameter( instance, p, types[p], i );
+				KeepResult( Call( FF_GETPARAMETERDISPLAY, p, instance ).PointerValue );
+			}
+		}
+	}, 1 + (unsigned int)types.size() * 2 );
+
+	// a host loading a composition: instances come and go in bursts. This
+	// includes the plugin's GL setup (shaders, textures), which is usually
+	// most of it
+	suite.Add( "Host/InstantiateDeinstantiate", [&viewport]( unsigned int iterations )
+	{
+		for (unsigned int i = 0; i < iterations; i++)
+		{
+			FFInstanceID created = Instantiate( viewport );
+			if (created != NULL)
+				Call( FF_DEINSTANTIATEGL, 0u, created );
+		}
+	}, 2 );
+}
+
+static void PrintUsage()
+{
+	printf(
+		"usage: DispatchBench <plugin> [options]\n"
+		"\n"
+		"  --filter text     runs only the benchmarks whose name contains text\n"
+		"  --min-time S      seconds a run lasts at least, default 0.2\n"
+		"  --repetitions N   runs of every benchmark, default 5\n"
+		"  --size WxH        viewport of the instances, default 1920x1080\n" );
+}
+
+int main( int argc, char *argv[] )
+{
+	const char *path = NULL;
+	const char *filter = NULL;
+	double minSeconds = 0.2;
+	int repetitions = 5;
+
+	FFGLViewportStruct viewport;
+	viewport.x = 0;
+	viewport.y = 0;
+	viewport.width = 1920;
+	viewport.height = 1080;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+		if (arg[0] != '-')
+		{
+			path = argv[i];
+			continue;
+		}
+
+		if (value == NULL)
+		{
+			PrintUsage();
+			return 1;
+		}
+		i++;
+
+		if (arg == "--filter")
+			filter = value;
+		else if (arg == "--min-time")
+			minSeconds = atof( value );
+		else if (arg == "--repetitions")
+			repetitions = atoi( value ) > 0 ? atoi( value ) : 1;
+		else if (arg == "--size")
+		{
+			unsigned int width, height;
+			char *end;
+			width = (unsigned int)strtoul( value, &end, 10 );
+			height = *end == 'x' ? (unsigned int)strtoul( end + 1, &end, 10 ) : 0;
+			if (width == 0 || height == 0)
+			{
+				fprintf( stderr, "bad size %s\n", value );
+				return 1;
+			}
+			viewport.width = width;
+			viewport.height = height;
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if (path == NULL)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	s_main = LoadPlugin( path );
+	if (s_main == NULL)
+	{
+		fprintf( stderr, "%s: not a FreeFrame plugin\n", path );
+		return 1;
+	}
+
+	if (Call( FF_INITIALISE, 0u, NULL ).UIntValue == FF_FAIL)
+	{
+		fprintf( stderr, "%s: initialise failed\n", path );
+		return 1;
+	}
+
+	// instances set up their shaders and textures in instantiateGL
+	OfflineContext context;
+	if (!context.Create())
+	{
+		fprintf( stderr, "%s\n", context.GetError().c_str() );
+		return 1;
+	}
+
+	FFInstanceID instance = Instantiate( viewport );
+	if (instance == NULL)
+	{
+		fprintf( stderr, "%s: can't instantiate\n", path );
+		return 1;
+	}
+
+	BenchmarkSuite suite;
+	AddBenchmarks( suite, viewport, instance );
+	suite.Run( filter, minSeconds, repetitions );
+
+	Call( FF_DEINSTANTIATEGL, 0u, instance );
+	context.Destroy();
+	Call( FF_DEINITIALISE, 0u, NULL );
+
+	return 0;
+}
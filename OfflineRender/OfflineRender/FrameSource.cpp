@@ -0,0 +1,239 @@
+#include "FrameSource.h"
+#include <FFGLShaderSnippets.h>
+#include <string.h>
+#include <string>
+
+// Samples the planes with the rows flipped, files start at the top
+static const char convertFragment[] = FFGL_GLSL(
+void main()
+{
+	gl_FragColor = ffglSampleInput( vec2( gl_TexCoord[0].s, 1.0 - gl_TexCoord[0].t ) );
+}
+);
+
+FrameSource::FrameSource()
+	: m_extensions( NULL ),
+	m_tracker( NULL ),
+	m_format( VIDEO_RGBA ),
+	m_width( 0 ),
+	m_height( 0 ),
+	m_chromaWidth( 0 ),
+	m_chromaHeight( 0 ),
+	m_frameSize( 0 ),
+	m_nextBuffer( 0 )
+{
+}
+
+FrameSource::~FrameSource()
+{
+	DeInit();
+}
+
+int FrameSource::AllocatePlane( int index, GLint internalFormat, GLenum format, int width, int height )
+{
+	if (!m_planes[index].Allocate( GL_TEXTURE_2D, internalFormat, width, height, format, GL_UNSIGNED_BYTE, m_tracker ))
+		return 0;
+
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+
+	return 1;
+}
+
+int FrameSource::Init( FFGLExtensions &e, const VideoReader &video, int bt709, int fullRange, FFGLResourceTracker *tracker )
+{
+	DeInit();
+
+	m_extensions = &e;
+	m_tracker = tracker;
+	m_format = video.GetFormat();
+	m_width = video.GetWidth();
+	m_height = video.GetHeight();
+	m_chromaWidth = video.GetChromaWidth();
+	m_chromaHeight = video.GetChromaHeight();
+	m_frameSize = video.GetFrameSize();
+
+	int inputFormat;
+	if (m_format == VIDEO_Y4M)
+	{
+		// the chroma planes are sampled with the luma coordinates, so the
+		// same path serves 4:2:0, 4:2:2 and 4:4:4
+		inputFormat = FFGL_INPUT_I420;
+		if (!AllocatePlane( 0, GL_LUMINANCE8, GL_LUMINANCE, m_width, m_height ) ||
+			!AllocatePlane( 1, GL_LUMINANCE8, GL_LUMINANCE, m_chromaWidth, m_chromaHeight ) ||
+			!AllocatePlane( 2, GL_LUMINANCE8, GL_LUMINANCE, m_chromaWidth, m_chromaHeight ))
+			return 0;
+	}
+	else
+	{
+		inputFormat = FFGL_INPUT_RGBA;
+		if (!AllocatePlane( 0, GL_RGBA8, GL_RGBA, m_width, m_height ))
+			return 0;
+	}
+
+	// clamped like the chain's own targets, so the first plugin of the
+	// chain samples past its edges the same way as the others
+	if (!m_output.Allocate( GL_TEXTURE_2D, GL_RGBA8, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, m_tracker ))
+		return 0;
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+
+	if (!m_fbo.Create( e, m_tracker ))
+		return 0;
+
+	std::string fragment = FFGLSnippetSampleInput;
+	fragment += convertFragment;
+
+	m_shader.SetExtensions( &e );
+	m_shader.SetResourceTracker( m_tracker );
+	if (!m_shader.Compile( FFGLSnippetVertexPassThrough, fragment.c_str(), FFGLYUVInput::GetDefines( inputFormat ) ))
+		return 0;
+
+	m_yuv.SetFormat( inputFormat );
+	m_yuv.SetBT709( bt709 );
+	m_yuv.SetFullRange( fullRange );
+	m_yuv.UseShader( &m_shader );
+
+	return 1;
+}
+
+void FrameSource::DeInit()
+{
+	for (int i = 0; i < NUM_BUFFERS; i++)
+		m_buffers[i].Release();
+
+	for (int i = 0; i < 3; i++)
+		m_planes[i].Release();
+
+	m_output.Release();
+	m_fbo.Release();
+	m_shader.FreeGLResources();
+}
+
+void FrameSource::Upload( const unsigned char *frame )
+{
+	FFGLExtensions &e = *m_extensions;
+	const unsigned char *source = frame;
+
+	if (e.ARB_pixel_buffer_object)
+	{
+		// respecifying the storage orphans the old one, so the driver never
+		// waits for a transfer still reading from it
+		FFGLBuffer &buffer = m_buffers[m_nextBuffer];
+		m_nextBuffer = (m_nextBuffer + 1) % NUM_BUFFERS;
+
+		if (buffer.Allocate( e, GL_PIXEL_UNPACK_BUFFER_ARB, m_frameSize, NULL, GL_STREAM_DRAW_ARB, m_tracker ))
+		{
+			void *mapped = e.glMapBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB );
+			if (mapped != NULL)
+			{
+				memcpy( mapped, frame, m_frameSize );
+				e.glUnmapBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB );
+
+				// with the buffer bound the pointers below are offsets into it
+				source = NULL;
+			}
+			else
+			{
+				e.glBindBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, 0 );
+			}
+		}
+	}
+
+	// chroma rows of odd sized frames aren't 4 byte aligned
+	GLint alignment;
+	glGetIntegerv( GL_UNPACK_ALIGNMENT, &alignment );
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+
+	if (m_format == VIDEO_Y4M)
+	{
+		size_t lumaSize = (size_t)m_width * (size_t)m_height;
+		size_t chromaSize = (size_t)m_chromaWidth * (size_t)m_chromaHeight;
+
+		glBindTexture( GL_TEXTURE_2D, m_planes[0].GetHandle() );
+		glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_LUMINANCE, GL_UNSIGNED_BYTE, source );
+		glBindTexture( GL_TEXTURE_2D, m_planes[1].GetHandle() );
+		glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, m_chromaWidth, m_chromaHeight, GL_LUMINANCE, GL_UNSIGNED_BYTE, source + lumaSize );
+		glBindTexture( GL_TEXTURE_2D, m_planes[2].GetHandle() );
+		glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, m_chromaWidth, m_chromaHeight, GL_LUMINANCE, GL_UNSIGNED_BYTE, source + lumaSize + chromaSize );
+	}
+	else
+	{
+		glBindTexture( GL_TEXTURE_2D, m_planes[0].GetHandle() );
+		glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, source );
+	}
+
+	glBindTexture( GL_TEXTURE_2D, 0 );
+	glPixelStorei( GL_UNPACK_ALIGNMENT, alignment );
+
+	if (source == NULL)
+		e.glBindBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, 0 );
+}
+
+int FrameSource::Load( const unsigned char *frame )
+{
+	if (m_extensions == NULL || frame == NULL)
+		return 0;
+
+	FFGLExtensions &e = *m_extensions;
+
+	Upload( frame );
+
+	FFGLTextureStruct planes[3];
+	FFGLTextureStruct *inputs[3];
+	for (int i = 0; i < 3; i++)
+	{
+		planes[i].Width = planes[i].HardwareWidth = m_planes[i].GetWidth();
+		planes[i].Height = planes[i].HardwareHeight = m_planes[i].GetHeight();
+		planes[i].Handle = m_planes[i].GetHandle();
+		inputs[i] = &planes[i];
+	}
+
+	ProcessOpenGLStruct pGL;
+	pGL.numInputTextures = FFGLYUVInput::GetNumPlanes( m_yuv.GetFormat() );
+	pGL.inputTextures = inputs;
+	pGL.HostFBO = 0;
+
+	e.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, m_fbo.GetHandle() );
+	e.glFramebufferTexture2DEXT( GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, m_output.GetHandle(), 0 );
+	glViewport( 0, 0, m_width, m_height );
+
+	m_shader.BindShader();
+	int result = m_yuv.Bind( e, &pGL );
+
+	if (result)
+	{
+		glBegin( GL_QUADS );
+		glTexCoord2f( 0.0f, 0.0f );
+		glVertex2f( -1.0f, -1.0f );
+		glTexCoord2f( 0.0f, 1.0f );
+		glVertex2f( -1.0f, 1.0f );
+		glTexCoord2f( 1.0f, 1.0f );
+		glVertex2f( 1.0f, 1.0f );
+		glTexCoord2f( 1.0f, 0.0f );
+		glVertex2f( 1.0f, -1.0f );
+		glEnd();
+	}
+
+	m_yuv.Unbind( e );
+	m_shader.UnbindShader();
+
+	e.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, 0 );
+
+	return result;
+}
+
+FFGLTextureStruct FrameSource::GetTexture() const
+{
+	FFGLTextureStruct t;
+	t.Width = t.HardwareWidth = m_output.GetWidth();
+	t.Height = t.HardwareHeight = m_output.GetHeight();
+	t.Handle = m_output.GetHandle();
+	return t;
+}
@@ -0,0 +1,64 @@
+#ifndef FRAMESOURCE_H
+#define FRAMESOURCE_H
+
+#include <FFGL.h>
+#include <FFGLExtensions.h>
+#include <FFGLResources.h>
+#include <FFGLShader.h>
+#include <FFGLYUV.h>
+#include "VideoFile.h"
+
+// FrameSource turns frames of a VideoReader into the RGBA texture the
+// first plugin of the chain reads.
+//
+// Frames are copied straight from the mapped file into a ring of pixel
+// unpack buffers, so glTexSubImage2D returns at once and the transfer
+// overlaps with the rendering of the previous frame. The planes are then
+// converted (Y'CbCr to RGB, see FFGLYUVInput) and turned the right way
+// up: files start with the top row, GL textures with the bottom one.
+class FrameSource
+{
+public:
+	FrameSource();
+	~FrameSource();
+
+	// Context current. bt709 and fullRange only matter for Y4M
+	int Init( FFGLExtensions &e, const VideoReader &video, int bt709, int fullRange, FFGLResourceTracker *tracker );
+	void DeInit();
+
+	// Uploads and converts frame; the result is left in GetTexture
+	int Load( const unsigned char *frame );
+
+	FFGLTextureStruct GetTexture() const;
+
+private:
+	enum { NUM_BUFFERS = 3 };
+
+	FFGLExtensions *m_extensions;
+	FFGLResourceTracker *m_tracker;
+
+	int m_format;
+	int m_width;
+	int m_height;
+	int m_chromaWidth;
+	int m_chromaHeight;
+	size_t m_frameSize;
+
+	FFGLBuffer m_buffers[NUM_BUFFERS];
+	int m_nextBuffer;
+
+	FFGLTexture m_planes[3];
+	FFGLTexture m_output;
+	FFGLFramebuffer m_fbo;
+
+	FFGLShader m_shader;
+	FFGLYUVInput m_yuv;
+
+	void Upload( const unsigned char *frame );
+	int AllocatePlane( int index, GLint internalFormat, GLenum format, int width, int height );
+
+	FrameSource( const FrameSource & );
+	FrameSource &operator=( const FrameSource & );
+};
+
+#endif
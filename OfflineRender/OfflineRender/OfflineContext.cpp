@@ -0,0 +1,223 @@
+#include "OfflineContext.h"
+
+#ifndef _WIN32
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <string.h>
+#endif
+
+OfflineContext::OfflineContext()
+#ifdef _WIN32
+	: m_window( NULL ),
+	m_dc( NULL ),
+	m_context( NULL )
+#else
+	: m_display( EGL_NO_DISPLAY ),
+	m_surface( EGL_NO_SURFACE ),
+	m_context( EGL_NO_CONTEXT )
+#endif
+{
+}
+
+OfflineContext::~OfflineContext()
+{
+	Destroy();
+}
+
+int OfflineContext::Fail( const char *message )
+{
+	m_error = message;
+	Destroy();
+	return 0;
+}
+
+#ifdef _WIN32
+
+static const char WINDOW_CLASS[] = "FFGLOfflineRender";
+
+int OfflineContext::Create()
+{
+	Destroy();
+
+	HINSTANCE instance = GetModuleHandle( NULL );
+
+	WNDCLASSA windowClass;
+	ZeroMemory( &windowClass, sizeof( windowClass ) );
+	windowClass.style = CS_OWNDC;
+	windowClass.lpfnWndProc = DefWindowProcA;
+	windowClass.hInstance = instance;
+	windowClass.lpszClassName = WINDOW_CLASS;
+	RegisterClassA( &windowClass );
+
+	// never shown, it only gives the context a pixel format
+	m_window = CreateWindowA( WINDOW_CLASS, "", WS_OVERLAPPEDWINDOW, 0, 0, 16, 16, NULL, NULL, instance, NULL );
+	if (m_window == NULL)
+		return Fail( "can't create a window" );
+
+	m_dc = GetDC( m_window );
+
+	PIXELFORMATDESCRIPTOR pfd;
+	ZeroMemory( &pfd, sizeof( pfd ) );
+	pfd.nSize = sizeof( pfd );
+	pfd.nVersion = 1;
+	pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL;
+	pfd.iPixelType = PFD_TYPE_RGBA;
+	pfd.cColorBits = 32;
+	pfd.iLayerType = PFD_MAIN_PLANE;
+
+	int pixelFormat = ChoosePixelFormat( m_dc, &pfd );
+	if (pixelFormat == 0 || !SetPixelFormat( m_dc, pixelFormat, &pfd ))
+		return Fail( "no OpenGL pixel format" );
+
+	m_context = wglCreateContext( m_dc );
+	if (m_context == NULL)
+		return Fail( "can't create an OpenGL context" );
+
+	if (!wglMakeCurrent( m_dc, m_context ))
+		return Fail( "can't make the OpenGL context current" );
+
+	return 1;
+}
+
+void OfflineContext::Destroy()
+{
+	if (m_context != NULL)
+	{
+		wglMakeCurrent( NULL, NULL );
+		wglDeleteContext( m_context );
+		m_context = NULL;
+	}
+
+	if (m_dc != NULL)
+	{
+		ReleaseDC( m_window, m_dc );
+		m_dc = NULL;
+	}
+
+	if (m_window != NULL)
+	{
+		DestroyWindow( m_window );
+		m_window = NULL;
+	}
+}
+
+#else
+
+// Whether the space separated list of extensions holds name
+static int HasExtension( const char *extensions, const char *name )
+{
+	size_t length = strlen( name );
+	for (const char *found = extensions; found != NULL && (found = strstr( found, name )) != NULL; found += length)
+	{
+		if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == 0))
+			return 1;
+	}
+
+	return 0;
+}
+
+// The display every context of the process is created on. EGL hands out
+// the same one to every thread, so it is initialised once and never
+// terminated, which would take the contexts of the other threads with it
+static EGLDisplay GetDisplay()
+{
+	static const EGLDisplay display = []() -> EGLDisplay
+	{
+		EGLDisplay found = EGL_NO_DISPLAY;
+
+		// Mesa renders without any window system with its surfaceless
+		// platform, on the GPU or with llvmpipe
+		const char *clientExtensions = eglQueryString( EGL_NO_DISPLAY, EGL_EXTENSIONS );
+		if (HasExtension( clientExtensions, "EGL_MESA_platform_surfaceless" ))
+		{
+			PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+				(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress( "eglGetPlatformDisplayEXT" );
+			if (getPlatformDisplay != NULL)
+				found = getPlatformDisplay( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL );
+		}
+
+		if (found == EGL_NO_DISPLAY)
+			found = eglGetDisplay( EGL_DEFAULT_DISPLAY );
+
+		if (found != EGL_NO_DISPLAY && !eglInitialize( found, NULL, NULL ))
+			found = EGL_NO_DISPLAY;
+
+		return found;
+	}();
+
+	return display;
+}
+
+int OfflineContext::Create()
+{
+	Destroy();
+
+	EGLDisplay display = GetDisplay();
+	if (display == EGL_NO_DISPLAY)
+		return Fail( "can't initialise an EGL display" );
+	m_display = display;
+
+	// the plugins draw with the fixed function pipeline, so this is a
+	// desktop OpenGL context with the compatibility profile
+	if (!eglBindAPI( EGL_OPENGL_API ))
+		return Fail( "EGL has no desktop OpenGL" );
+
+	static const EGLint attributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint numConfigs = 0;
+	if (!eglChooseConfig( display, attributes, &config, 1, &numConfigs ) || numConfigs == 0)
+		return Fail( "no EGL config for OpenGL" );
+
+	m_context = eglCreateContext( display, config, EGL_NO_CONTEXT, NULL );
+	if (m_context == EGL_NO_CONTEXT)
+		return Fail( "can't create an OpenGL context" );
+
+	// without surfaceless contexts a pbuffer is only there to make the
+	// context current
+	if (!HasExtension( eglQueryString( display, EGL_EXTENSIONS ), "EGL_KHR_surfaceless_context" ))
+	{
+		static const EGLint pbufferAttributes[] = { EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE };
+		m_surface = eglCreatePbufferSurface( display, config, pbufferAttributes );
+		if (m_surface == EGL_NO_SURFACE)
+			return Fail( "can't create a pbuffer" );
+	}
+
+	if (!eglMakeCurrent( display, m_surface, m_surface, m_context ))
+		return Fail( "can't make the OpenGL context current" );
+
+	return 1;
+}
+
+void OfflineContext::Destroy()
+{
+	if (m_display == EGL_NO_DISPLAY)
+		return;
+
+	if (m_context != EGL_NO_CONTEXT)
+	{
+		eglMakeCurrent( m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+		eglDestroyContext( m_display, m_context );
+		m_context = EGL_NO_CONTEXT;
+	}
+
+	if (m_surface != EGL_NO_SURFACE)
+	{
+		eglDestroySurface( m_display, m_surface );
+		m_surface = EGL_NO_SURFACE;
+	}
+
+	// the display stays, see GetDisplay
+	eglReleaseThread();
+	m_display = EGL_NO_DISPLAY;
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef OFFLINECONTEXT_H
+#define OFFLINECONTEXT_H
+
+#include <FFGL.h>
+#include <string>
+
+// An OpenGL context without anything to show on: a hidden window on
+// Windows, an EGL context elsewhere, which needs no X server (Mesa's
+// surfaceless platform, or a pbuffer of the default display where that
+// is missing). Everything is rendered into framebuffer objects, so the
+// window system never composites or throttles a frame.
+class OfflineContext
+{
+public:
+	OfflineContext();
+	~OfflineContext();
+
+	// Creates the context and makes it current on the calling thread.
+	// Every render thread creates its own. Returns 0 on failure, see
+	// GetError
+	int Create();
+	void Destroy();
+
+	const std::string &GetError() const { return m_error; }
+
+private:
+#ifdef _WIN32
+	HWND m_window;
+	HDC m_dc;
+	HGLRC m_context;
+#else
+	void *m_display; // EGLDisplay
+	void *m_surface; // EGLSurface, EGL_NO_SURFACE when surfaceless
+	void *m_context; // EGLContext
+#endif
+
+	std::string m_error;
+
+	int Fail( const char *message );
+
+	OfflineContext( const OfflineContext & );
+	OfflineContext &operator=( const OfflineContext & );
+};
+
+#endif
@@ -0,0 +1,720 @@
+// OfflineRender pushes a video file through a chain of FFGL plugins as
+// fast as the GPU allows and writes the result to another file, e.g. to
+// pre-render a show at the native resolution of the LED processors:
+//
+//	OfflineRender -i show.y4m -o native.y4m --out-size 1152x480
+//		-p "Mirror Native.dll" -s "Precision=0"
+//		-p LumaKey.dll -s "Threshold End=0.2"
+//
+// Frames are read from a memory-mapped file, uploaded through a ring of
+// pixel unpack buffers, run through the plugins' plugMain like a live
+// host would and read back with FFGLReadback. Upload, rendering, readback
+// and writing all overlap, so the throughput is that of the slowest of
+// them rather than of their sum.
+//
+// Where one context can't keep the machine busy (llvmpipe on a many-core
+// render node, several GPUs) --threads splits the clip into chunks of
+// frames rendered by independent contexts, each with its own instances of
+// the plugins, and OrderedWriter puts the frames back in order.
+//
+// --batch N hands the last plugin N frames at a time through
+// FF_PROCESSOPENGLBATCH, the way a host pre-rendering a clip would, so the
+// batch path of the SDK renders the same frames as the frame by frame one.
+//
+// --compare and --baseline turn a render into a regression check, see
+// Regression.h. With a generated input (-i pattern:ramp) it needs no
+// footage.
+
+#include "FrameSource.h"
+#include "OfflineContext.h"
+#include "OrderedWriter.h"
+#include "PluginChain.h"
+#include "Regression.h"
+#include "VideoFile.h"
+#include <FFGLReadback.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Options
+{
+	const char *input;
+	const char *output;
+	int width, height; // raw input size
+	int outputWidth, outputHeight; // 0 follows the input
+	int rateNum, rateDen; // for raw input
+	int bt709;
+	int fullRange;
+	int latency;
+	int threads;
+	unsigned int batch; // frames per FF_PROCESSOPENGLBATCH, 0 for none
+	unsigned int patternFrames; // length of a generated input
+
+	const char *compare; // golden file
+	int tolerance;
+	const char *baseline;
+	const char *writeBaseline;
+	double slack; // < 0 doesn't check the time per frame
+};
+
+static const char PATTERN_PREFIX[] = "pattern:";
+
+static void PrintUsage()
+{
+	printf(
+		"usage: OfflineRender -i <input> -o <output> -p <plugin> [-s name=value ...] [-p ...]\n"
+		"\n"
+		"  -i file          .y4m (8 bit 4:2:0, 4:2:2 or 4:4:4) or raw RGBA, or\n"
+		"                   pattern:<name> to generate one of %s\n"
+		"  -o file          .y4m (written as 4:4:4) or raw RGBA\n"
+		"  -p plugin        adds a plugin to the end of the chain\n"
+		"  -s name=value    sets a parameter of the last plugin added: a number\n"
+		"                   (0..1, 0/1 for switches) or the text of a text parameter\n"
+		"  --size WxH       size of a raw input, or of a pattern (default 640x360)\n"
+		"  --fps N[:D]      frame rate of a raw input, default 30\n"
+		"  --out-size WxH   output size, default the input size\n"
+		"  --bt601          BT.601 instead of BT.709 Y'CbCr\n"
+		"  --full-range     full range instead of limited range Y'CbCr\n"
+		"  --latency N      frames in flight on the readback, 2..8, default 3\n"
+		"  --threads N      render contexts working side by side, default 1. Plugins\n"
+		"                   that keep state between frames see only some of them\n"
+		"  --frames N       length of a pattern input, default 30\n"
+		"  --batch N        renders N frames at a time with the last plugin's\n"
+		"                   FF_PROCESSOPENGLBATCH (2..64), default frame by frame\n"
+		"\n"
+		"regression checks, failing with exit code 1:\n"
+		"  --compare file   compares the output with a golden render of the same chain\n"
+		"  --tolerance N    bytes may differ by N (0..255) from the golden render, default 2\n"
+		"  --baseline file  compares GL memory with a baseline, prints the time per frame\n"
+		"  --slack F        fails too when the time per frame exceeds the baseline by\n"
+		"                   more than F (0.1 is 10%%), on a machine as quiet as its own\n"
+		"  --write-baseline file  records time per frame and GL memory as a baseline\n",
+		PATTERN_NAMES );
+}
+
+static int ParseSize( const char *text, int *width, int *height )
+{
+	char *end;
+	long w = strtol( text, &end, 10 );
+	if (*end != 'x' && *end != 'X')
+		return 0;
+
+	long h = strtol( end + 1, &end, 10 );
+	if (*end != 0 || w <= 0 || h <= 0)
+		return 0;
+
+	*width = (int)w;
+	*height = (int)h;
+	return 1;
+}
+
+static int ParseRate( const char *text, int *num, int *den )
+{
+	char *end;
+	long n = strtol( text, &end, 10 );
+	long d = 1;
+
+	if (*end == ':')
+		d = strtol( end + 1, &end, 10 );
+
+	if (*end != 0 || n <= 0 || d <= 0)
+		return 0;
+
+	*num = (int)n;
+	*den = (int)d;
+	return 1;
+}
+
+// Fills options and adds the plugins to chain. Returns 0 after printing
+// what is wrong
+static int ParseArguments( int argc, char *argv[], Options &options, PluginChain &chain )
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+		if (arg == "-h" || arg == "--help")
+		{
+			PrintUsage();
+			return 0;
+		}
+
+		if (arg == "--bt601")
+		{
+			options.bt709 = 0;
+			continue;
+		}
+
+		if (arg == "--full-range")
+		{
+			options.fullRange = 1;
+			continue;
+		}
+
+		if (value == NULL)
+		{
+			fprintf( stderr, "%s needs a value\n", arg.c_str() );
+			return 0;
+		}
+		i++;
+
+		if (arg == "-i")
+			options.input = value;
+		else if (arg == "-o")
+			options.output = value;
+		else if (arg == "-p")
+		{
+			if (chain.Add( value ) == NULL)
+			{
+				fprintf( stderr, "%s\n", chain.GetError().c_str() );
+				return 0;
+			}
+		}
+		else if (arg == "-s")
+		{
+			const char *equals = strchr( value, '=' );
+			if (chain.GetLast() == NULL || equals == NULL)
+			{
+				fprintf( stderr, "-s %s: needs name=value, after a -p\n", value );
+				return 0;
+			}
+
+			chain.GetLast()->AddParameter( std::string( value, equals - value ), equals + 1 );
+		}
+		else if (arg == "--size")
+		{
+			if (!ParseSize( value, &options.width, &options.height ))
+			{
+				fprintf( stderr, "bad size %s\n", value );
+				return 0;
+			}
+		}
+		else if (arg == "--out-size")
+		{
+			if (!ParseSize( value, &options.outputWidth, &options.outputHeight ))
+			{
+				fprintf( stderr, "bad size %s\n", value );
+				return 0;
+			}
+		}
+		else if (arg == "--fps")
+		{
+			if (!ParseRate( value, &options.rateNum, &options.rateDen ))
+			{
+				fprintf( stderr, "bad frame rate %s\n", value );
+				return 0;
+			}
+		}
+		else if (arg == "--latency")
+		{
+			options.latency = atoi( value );
+		}
+		else if (arg == "--frames")
+		{
+			options.patternFrames = (unsigned int)atoi( value );
+			if (options.patternFrames == 0)
+			{
+				fprintf( stderr, "bad number of frames %s\n", value );
+				return 0;
+			}
+		}
+		else if (arg == "--compare")
+			options.compare = value;
+		else if (arg == "--tolerance")
+		{
+			options.tolerance = atoi( value );
+			if (options.tolerance < 0 || options.tolerance > 255)
+			{
+				fprintf( stderr, "bad tolerance %s\n", value );
+				return 0;
+			}
+		}
+		else if (arg == "--baseline")
+			options.baseline = value;
+		else if (arg == "--write-baseline")
+			options.writeBaseline = value;
+		else if (arg == "--slack")
+		{
+			options.slack = atof( value );
+			if (options.slack < 0.0)
+			{
+				fprintf( stderr, "bad slack %s\n", value );
+				return 0;
+			}
+		}
+		else if (arg == "--batch")
+		{
+			int batch = atoi( value );
+			if (batch < 2 || batch > 64)
+			{
+				fprintf( stderr, "bad batch size %s\n", value );
+				return 0;
+			}
+			options.batch = (unsigned int)batch;
+		}
+		else if (arg == "--threads")
+		{
+			options.threads = atoi( value );
+			if (options.threads < 1 || options.threads > 256)
+			{
+				fprintf( stderr, "bad number of threads %s\n", value );
+				return 0;
+			}
+		}
+		else
+		{
+			fprintf( stderr, "unknown option %s\n", arg.c_str() );
+			PrintUsage();
+			return 0;
+		}
+	}
+
+	if (options.input == NULL || options.output == NULL || chain.GetNumPlugins() == 0)
+	{
+		PrintUsage();
+		return 0;
+	}
+
+	return 1;
+}
+
+// Frames a thread takes at a time. Small enough that the threads stay
+// close together in the clip, which keeps the reordering cheap
+static const unsigned int CHUNK_SIZE = 4;
+
+// State shared by the render threads
+struct RenderJob
+{
+	const Options *options;
+	const VideoReader *reader;
+	PluginChain *chain;
+	OrderedWriter *writer;
+	int outputWidth;
+	int outputHeight;
+	double frameDuration;
+	unsigned int chunkSize; // CHUNK_SIZE, or a whole batch
+
+	std::atomic<unsigned int> nextChunk;
+	std::atomic<int> numRunning;
+	std::atomic<int> failed;
+
+	std::mutex errorMutex;
+	std::string error;
+
+	// GL memory of the busiest context, for the baseline
+	std::mutex memoryMutex;
+	FFGLMemoryUsageStruct peakMemory;
+
+	// With a baseline every context renders a frame before the clock
+	// starts, which keeps context creation, instantiation and shader
+	// compiles out of the time per frame
+	int warmUp;
+	std::mutex warmUpMutex;
+	std::condition_variable warmUpDone;
+	int numWarm;
+	std::chrono::steady_clock::time_point steadyStart;
+
+	void AddMemoryUsage( const FFGLMemoryUsageStruct &usage )
+	{
+		std::lock_guard<std::mutex> lock( memoryMutex );
+		if (usage.NumKiloBytes > peakMemory.NumKiloBytes)
+			peakMemory = usage;
+	}
+
+	// Waits for the other threads to warm up. Failed threads come here too
+	// so nobody waits for them
+	void WarmedUp()
+	{
+		std::unique_lock<std::mutex> lock( warmUpMutex );
+		if (++numWarm == options->threads)
+		{
+			steadyStart = std::chrono::steady_clock::now();
+			warmUpDone.notify_all();
+		}
+		else
+		{
+			warmUpDone.wait( lock, [this] { return numWarm >= options->threads; } );
+		}
+	}
+
+	// Stops every thread; only the first error is kept
+	void Fail( const std::string &message )
+	{
+		{
+			std::lock_guard<std::mutex> lock( errorMutex );
+			if (!failed)
+				error = message;
+			failed = 1;
+		}
+
+		writer->Abort();
+	}
+};
+
+// A render thread: its own context, input conversion, plugin instances
+// and readback, working through chunks of frames until the clip is done
+static void RenderFrames( RenderJob &job )
+{
+	OfflineContext context;
+	FFGLExtensions extensions;
+	FFGLResourceTracker resources;
+	FrameSource source;
+	ChainInstance chain;
+	FFGLReadback readback;
+
+	// first frame of every chunk taken, so the consumer can tell which
+	// frame a capture was. Only the last chunk of the clip is short
+	std::vector<unsigned int> chunks;
+	std::mutex chunksMutex;
+
+	if (!context.Create())
+	{
+		job.Fail( context.GetError() );
+	}
+	else
+	{
+		extensions.Initialize();
+		if (!extensions.EXT_framebuffer_object || !extensions.ARB_shader_objects)
+			job.Fail( "the OpenGL driver lacks framebuffer objects or shaders" );
+		else if (!source.Init( extensions, *job.reader, job.options->bt709, job.options->fullRange, &resources ))
+			job.Fail( "can't set up the input conversion" );
+		else if (!chain.Init( *job.chain, extensions, job.outputWidth, job.outputHeight, &resources ))
+			job.Fail( chain.GetError() );
+		else if (job.options->batch > 0 && !chain.InitBatch( job.options->batch, &resources ))
+			job.Fail( chain.GetError() );
+	}
+
+	if (job.warmUp)
+	{
+		// frame 0 of the clip, thrown away. A plugin carrying state from
+		// frame to frame sees it one more time than without a baseline
+		if (!job.failed)
+		{
+			if (!source.Load( job.reader->GetFrame( 0 ) ))
+				job.Fail( "can't convert frame 0" );
+			else
+				chain.Process( source.GetTexture(), 0.0 );
+			glFinish();
+		}
+
+		job.WarmedUp();
+	}
+
+	if (!job.failed)
+	{
+		// every frame has to make it into the file, so the readback waits
+		// instead of dropping when the writer falls behind
+		readback.SetExtensions( &extensions );
+		readback.SetResourceTracker( &resources );
+		readback.SetDropFrames( 0 );
+		if (job.options->latency > 0)
+			readback.SetLatency( job.options->latency );
+
+		readback.Start( [&job, &chunks, &chunksMutex]( const FFGLReadbackFrame &frame )
+		{
+			// captures are numbered from 1
+			unsigned int capture = frame.frameNumber - 1;
+			unsigned int index;
+			{
+				std::lock_guard<std::mutex> lock( chunksMutex );
+				index = chunks[capture / job.chunkSize] + capture % job.chunkSize;
+			}
+
+			if (!job.writer->Write( index, &frame.pixels[0] ) && !job.failed)
+				job.Fail( "can't write the output" );
+		} );
+
+		unsigned int numFrames = job.reader->GetNumFrames();
+
+		while (!job.failed)
+		{
+			unsigned int start = job.nextChunk++ * job.chunkSize;
+			if (start >= numFrames)
+				break;
+
+			{
+				std::lock_guard<std::mutex> lock( chunksMutex );
+				chunks.push_back( start );
+			}
+
+			unsigned int end = start + job.chunkSize < numFrames ? start + job.chunkSize : numFrames;
+			for (unsigned int i = start; i < end && !job.failed; i++)
+			{
+				if (!source.Load( job.reader->GetFrame( i ) ))
+				{
+					job.Fail( "can't convert frame " + std::to_string( i ) );
+					break;
+				}
+
+				if (job.options->batch > 0)
+				{
+					if (!chain.AddToBatch( source.GetTexture(), i * job.frameDuration ))
+					{
+						job.Fail( "can't batch frame " + std::to_string( i ) );
+						break;
+					}
+
+					// a chunk is a whole batch, only the last one of the
+					// clip is short
+					if (i + 1 < end)
+						continue;
+
+					unsigned int numBatched = chain.GetNumBatched();
+					if (!chain.ProcessBatch())
+					{
+						job.Fail( "the batch ending at frame " + std::to_string( i ) + " failed" );
+						break;
+					}
+
+					for (unsigned int j = 0; j < numBatched; j++)
+					{
+						if (!readback.CaptureLayer( chain.GetBatchOutput(), j, job.outputWidth, job.outputHeight ))
+						{
+							job.Fail( "can't read frame " + std::to_string( i + 1 - numBatched + j ) + " back" );
+							break;
+						}
+					}
+					continue;
+				}
+
+				FFGLTextureStruct output = chain.Process( source.GetTexture(), i * job.frameDuration );
+
+				// without pixel buffer objects there is no way to read back
+				if (!readback.Capture( output ))
+				{
+					job.Fail( "can't read frame " + std::to_string( i ) + " back" );
+					break;
+				}
+			}
+		}
+
+		readback.Flush();
+		readback.Stop();
+
+		// what the plugins hold after a whole clip, caches included
+		job.AddMemoryUsage( chain.GetMemoryUsage() );
+	}
+
+	readback.FreeGLResources();
+	chain.DeInit();
+	source.DeInit();
+	context.Destroy();
+
+	job.numRunning--;
+}
+
+// Compares the output with the golden render
+static int CheckOutput( const Options &options, int outputWidth, int outputHeight )
+{
+	VideoComparison comparison;
+	std::string error;
+	if (!CompareVideos( options.output, options.compare, outputWidth, outputHeight, options.tolerance, &comparison, &error ))
+	{
+		fprintf( stderr, "can't compare with %s: %s\n", options.compare, error.c_str() );
+		return 0;
+	}
+
+	if (comparison.numDifferent > 0)
+	{
+		printf( "output differs from %s: %zu bytes off by more than %d, up to %d, first in frame %u\n",
+			options.compare, comparison.numDifferent, options.tolerance, comparison.maxDifference, comparison.firstDifferentFrame );
+		return 0;
+	}
+
+	printf( "output matches %s, %u frames, largest difference %d\n", options.compare, comparison.numFrames, comparison.maxDifference );
+	return 1;
+}
+
+static int CheckPerformance( const Options &options, const PerfBaseline &measured )
+{
+	int ok = 1;
+
+	if (options.baseline != NULL)
+	{
+		PerfBaseline baseline;
+		if (!ReadBaseline( options.baseline, &baseline ))
+		{
+			fprintf( stderr, "%s: not a baseline\n", options.baseline );
+			return 0;
+		}
+
+		ok = CheckBaseline( measured, baseline, options.slack );
+	}
+
+	if (options.writeBaseline != NULL && !WriteBaseline( options.writeBaseline, measured ))
+	{
+		fprintf( stderr, "%s: can't write the baseline\n", options.writeBaseline );
+		ok = 0;
+	}
+
+	return ok;
+}
+
+static int Render( Options &options, PluginChain &chain )
+{
+	VideoReader reader;
+	int opened;
+	if (strncmp( options.input, PATTERN_PREFIX, strlen( PATTERN_PREFIX ) ) == 0)
+	{
+		int width = options.width > 0 ? options.width : 640;
+		int height = options.height > 0 ? options.height : 360;
+		opened = reader.OpenPattern( options.input + strlen( PATTERN_PREFIX ), width, height, options.patternFrames );
+	}
+	else
+	{
+		opened = reader.Open( options.input, options.width, options.height );
+	}
+
+	if (!opened)
+	{
+		fprintf( stderr, "%s: %s\n", options.input, reader.GetError().c_str() );
+		return 0;
+	}
+
+	// the threads pick frames anywhere in the file
+	reader.IndexFrames();
+
+	if (reader.GetFrameRateNum() > 0)
+	{
+		options.rateNum = reader.GetFrameRateNum();
+		options.rateDen = reader.GetFrameRateDen();
+	}
+
+	int outputWidth = options.outputWidth > 0 ? options.outputWidth : reader.GetWidth();
+	int outputHeight = options.outputHeight > 0 ? options.outputHeight : reader.GetHeight();
+
+	VideoWriter writer;
+	if (!writer.Open( options.output, outputWidth, outputHeight, options.rateNum, options.rateDen, options.bt709, options.fullRange ))
+	{
+		fprintf( stderr, "%s: %s\n", options.output, writer.GetError().c_str() );
+		return 0;
+	}
+
+	unsigned int chunkSize = options.batch > 0 ? options.batch : CHUNK_SIZE;
+
+	// room for a chunk per thread plus the one the file waits for
+	OrderedWriter orderedWriter;
+	orderedWriter.Init( &writer, (options.threads + 1) * chunkSize );
+
+	RenderJob job;
+	job.options = &options;
+	job.reader = &reader;
+	job.chain = &chain;
+	job.writer = &orderedWriter;
+	job.outputWidth = outputWidth;
+	job.outputHeight = outputHeight;
+	job.frameDuration = (double)options.rateDen / (double)options.rateNum;
+	job.chunkSize = chunkSize;
+	job.nextChunk = 0;
+	job.numRunning = options.threads;
+	job.failed = 0;
+	memset( &job.peakMemory, 0, sizeof( job.peakMemory ) );
+	job.warmUp = options.baseline != NULL || options.writeBaseline != NULL;
+	job.numWarm = 0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point lastReport = start;
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < options.threads; i++)
+		threads.push_back( std::thread( RenderFrames, std::ref( job ) ) );
+
+	while (job.numRunning > 0)
+	{
+		std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (now - lastReport >= std::chrono::seconds( 1 ))
+		{
+			unsigned int numWritten = orderedWriter.GetNumWritten();
+			double seconds = std::chrono::duration<double>( now - start ).count();
+			printf( "\rframe %u/%u, %.1f fps   ", numWritten, reader.GetNumFrames(), numWritten / seconds );
+			fflush( stdout );
+			lastReport = now;
+		}
+	}
+
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>( end - start ).count();
+	double fps = seconds > 0.0 ? writer.GetNumFrames() / seconds : 0.0;
+
+	int ok = !job.failed;
+	if (ok)
+	{
+		printf( "\r%u frames in %.2f s, %.1f fps (%.1fx real time)",
+			writer.GetNumFrames(), seconds, fps, fps * job.frameDuration );
+		if (options.threads > 1)
+			printf( " on %d contexts, %u frames reordered", options.threads, orderedWriter.GetNumReordered() );
+		printf( "\n" );
+	}
+	else
+	{
+		fprintf( stderr, "\n%s\n", job.error.c_str() );
+	}
+
+	if (!writer.Close())
+	{
+		fprintf( stderr, "%s: %s\n", options.output, writer.GetError().c_str() );
+		ok = 0;
+	}
+
+	if (ok && options.compare != NULL)
+		ok = CheckOutput( options, outputWidth, outputHeight );
+
+	if (ok && (options.baseline != NULL || options.writeBaseline != NULL))
+	{
+		PerfBaseline measured;
+		// steady state, from the end of the warm-up to the last frame
+		double steadySeconds = std::chrono::duration<double>( end - job.steadyStart ).count();
+		measured.msPerFrame = writer.GetNumFrames() > 0 ? steadySeconds * 1000.0 / writer.GetNumFrames() : 0.0;
+		measured.glObjects = job.peakMemory.NumObjects;
+		measured.glKiloBytes = job.peakMemory.NumKiloBytes;
+
+		if (!CheckPerformance( options, measured ))
+			ok = 0;
+	}
+
+	return ok;
+}
+
+int main( int argc, char *argv[] )
+{
+	Options options;
+	options.input = NULL;
+	options.output = NULL;
+	options.width = options.height = 0;
+	options.outputWidth = options.outputHeight = 0;
+	options.rateNum = 30;
+	options.rateDen = 1;
+	options.bt709 = 1;
+	options.fullRange = 0;
+	options.latency = 0;
+	options.threads = 1;
+	options.batch = 0;
+	options.patternFrames = 30;
+	options.compare = NULL;
+	options.tolerance = 2;
+	options.baseline = NULL;
+	options.writeBaseline = NULL;
+	options.slack = -1.0;
+
+	// the plugins are unloaded after the contexts are gone, see Render
+	PluginChain chain;
+
+	if (!ParseArguments( argc, argv, options, chain ))
+		return 1;
+
+	return Render( options, chain ) ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+#include "OrderedWriter.h"
+#include <string.h>
+
+OrderedWriter::OrderedWriter()
+	: m_writer( NULL ),
+	m_window( 1 ),
+	m_frameSize( 0 ),
+	m_next( 0 ),
+	m_failed( 0 ),
+	m_numReordered( 0 )
+{
+}
+
+OrderedWriter::~OrderedWriter()
+{
+	std::map<unsigned int, std::vector<unsigned char> *>::iterator i;
+	for (i = m_waiting.begin(); i != m_waiting.end(); ++i)
+		delete i->second;
+
+	for (size_t j = 0; j < m_spare.size(); j++)
+		delete m_spare[j];
+}
+
+void OrderedWriter::Init( VideoWriter *writer, unsigned int window )
+{
+	m_writer = writer;
+	m_window = window > 0 ? window : 1;
+	m_frameSize = writer->GetFrameSize();
+	m_next = 0;
+	m_failed = 0;
+	m_numReordered = 0;
+}
+
+// m_mutex locked
+int OrderedWriter::WriteNext( const unsigned char *rgba )
+{
+	if (!m_writer->Write( rgba ))
+	{
+		m_failed = 1;
+		return 0;
+	}
+
+	m_next++;
+	return 1;
+}
+
+int OrderedWriter::Write( unsigned int index, const unsigned char *rgba )
+{
+	std::unique_lock<std::mutex> lock( m_mutex );
+
+	while (!m_failed && index - m_next >= m_window)
+		m_written.wait( lock );
+
+	if (m_failed)
+		return 0;
+
+	if (index != m_next)
+	{
+		std::vector<unsigned char> *copy;
+		if (m_spare.empty())
+		{
+			copy = new std::vector<unsigned char>( m_frameSize );
+		}
+		else
+		{
+			copy = m_spare.back();
+			m_spare.pop_back();
+		}
+
+		memcpy( &(*copy)[0], rgba, m_frameSize );
+		m_waiting[index] = copy;
+		m_numReordered++;
+		return 1;
+	}
+
+	WriteNext( rgba );
+
+	// the frames that were waiting for this one
+	std::map<unsigned int, std::vector<unsigned char> *>::iterator i;
+	while (!m_failed && (i = m_waiting.find( m_next )) != m_waiting.end())
+	{
+		WriteNext( &(*i->second)[0] );
+		m_spare.push_back( i->second );
+		m_waiting.erase( i );
+	}
+
+	m_written.notify_all();
+	return !m_failed;
+}
+
+void OrderedWriter::Abort()
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	m_failed = 1;
+	m_written.notify_all();
+}
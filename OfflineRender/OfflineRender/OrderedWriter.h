@@ -0,0 +1,62 @@
+#ifndef ORDEREDWRITER_H
+#define ORDEREDWRITER_H
+
+#include "VideoFile.h"
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// OrderedWriter puts the frames of several render threads back in order
+// before they go to a VideoWriter.
+//
+// A frame that is next in the file is written at once, any other one is
+// copied aside until the frames before it have arrived. Frames more than
+// a window ahead of the file make their thread wait, which bounds the
+// memory and keeps the threads working on neighbouring frames.
+class OrderedWriter
+{
+public:
+	OrderedWriter();
+	~OrderedWriter();
+
+	// window is the number of frames that may wait to be written. It has
+	// to cover the frames every thread has in flight, or the threads take
+	// turns instead of running side by side
+	void Init( VideoWriter *writer, unsigned int window );
+
+	// Any thread. rgba is as for VideoWriter::Write. Returns 0 once
+	// writing has failed or Abort was called
+	int Write( unsigned int index, const unsigned char *rgba );
+
+	// Makes every waiting and later Write return 0, for a thread that
+	// gives up: the frames it would have rendered never arrive
+	void Abort();
+
+	unsigned int GetNumWritten() const { return m_next; }
+
+	// Frames that had to be copied aside, i.e. arrived out of order
+	unsigned int GetNumReordered() const { return m_numReordered; }
+
+private:
+	VideoWriter *m_writer;
+	unsigned int m_window;
+	size_t m_frameSize;
+
+	std::mutex m_mutex;
+	std::condition_variable m_written;
+	std::atomic<unsigned int> m_next;
+	int m_failed;
+
+	std::map<unsigned int, std::vector<unsigned char> *> m_waiting;
+	std::vector<std::vector<unsigned char> *> m_spare;
+	unsigned int m_numReordered;
+
+	int WriteNext( const unsigned char *rgba );
+
+	OrderedWriter( const OrderedWriter & );
+	OrderedWriter &operator=( const OrderedWriter & );
+};
+
+#endif
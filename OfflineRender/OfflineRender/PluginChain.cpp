@@ -0,0 +1,570 @@
+#include "PluginChain.h"
+#include <FFGLLib.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+// instantiateGL reports failure as a pointer with the value of FF_FAIL
+static const FFInstanceID FAILED_INSTANCE = (FFInstanceID)(uintptr_t)FF_FAIL;
+
+// Parameter names are 16 characters, not null terminated
+static std::string ToName( const char *name16 )
+{
+	size_t length = 0;
+	while (length < 16 && name16[length] != 0)
+		length++;
+	while (length > 0 && name16[length - 1] == ' ')
+		length--;
+
+	return std::string( name16, length );
+}
+
+static int SameName( const std::string &a, const std::string &b )
+{
+	if (a.size() != b.size())
+		return 0;
+
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		if (tolower( (unsigned char)a[i] ) != tolower( (unsigned char)b[i] ))
+			return 0;
+	}
+
+	return 1;
+}
+
+ChainPlugin::ChainPlugin()
+	: m_module( NULL ),
+	m_main( NULL ),
+	m_initialised( 0 ),
+	m_supportsTime( 0 ),
+	m_supportsBatch( 0 )
+{
+}
+
+ChainPlugin::~ChainPlugin()
+{
+	if (m_initialised)
+		Call( FF_DEINITIALISE, 0, NULL );
+
+	if (m_module != NULL)
+	{
+#ifdef _WIN32
+		FreeLibrary( (HMODULE)m_module );
+#else
+		dlclose( m_module );
+#endif
+	}
+}
+
+int ChainPlugin::Fail( const std::string &message )
+{
+	m_error = m_path + ": " + message;
+	return 0;
+}
+
+FFMixed ChainPlugin::Call( FFUInt32 functionCode, FFMixed input, FFInstanceID instance )
+{
+	return m_main( functionCode, input, instance );
+}
+
+FFMixed ChainPlugin::Call( FFUInt32 functionCode, FFUInt32 input, FFInstanceID instance )
+{
+	FFMixed mixed;
+	mixed.PointerValue = NULL;
+	mixed.UIntValue = input;
+	return m_main( functionCode, mixed, instance );
+}
+
+int ChainPlugin::Load( const char *path )
+{
+	m_path = path;
+
+#ifdef _WIN32
+	m_module = LoadLibraryA( path );
+	if (m_module == NULL)
+		return Fail( "can't load the plugin" );
+
+	m_main = (FF_Main_FuncPtr)GetProcAddress( (HMODULE)m_module, "plugMain" );
+#else
+	m_module = dlopen( path, RTLD_NOW | RTLD_LOCAL );
+	if (m_module == NULL)
+		return Fail( dlerror() );
+
+	m_main = (FF_Main_FuncPtr)dlsym( m_module, "plugMain" );
+#endif
+
+	if (m_main == NULL)
+		return Fail( "not a FreeFrame plugin, no plugMain" );
+
+	const PluginInfoStruct *info = (const PluginInfoStruct *)Call( FF_GETINFO, 0, NULL ).PointerValue;
+	if (info == NULL)
+		return Fail( "no plugin info" );
+	m_name = ToName( info->PluginName );
+
+	if (Call( FF_GETPLUGINCAPS, FF_CAP_PROCESSOPENGL, NULL ).UIntValue != FF_TRUE)
+		return Fail( "not a FreeFrameGL plugin" );
+
+	if (Call( FF_INITIALISE, 0, NULL ).UIntValue == FF_FAIL)
+		return Fail( "initialise failed" );
+	m_initialised = 1;
+
+	m_supportsTime = Call( FF_GETPLUGINCAPS, FF_CAP_SETTIME, NULL ).UIntValue == FF_TRUE;
+	m_supportsBatch = Call( FF_GETPLUGINCAPS, FF_CAP_PROCESSOPENGLBATCH, NULL ).UIntValue == FF_TRUE;
+
+	return 1;
+}
+
+void ChainPlugin::AddParameter( const std::string &name, const std::string &value )
+{
+	Parameter parameter;
+	parameter.name = name;
+	parameter.value = value;
+	m_parameters.push_back( parameter );
+}
+
+int ChainPlugin::FindParameter( const std::string &name, FFUInt32 *index, FFUInt32 *type )
+{
+	FFUInt32 numParameters = Call( FF_GETNUMPARAMETERS, 0, NULL ).UIntValue;
+	if (numParameters == FF_FAIL)
+		return 0;
+
+	for (FFUInt32 i = 0; i < numParameters; i++)
+	{
+		const char *name16 = (const char *)Call( FF_GETPARAMETERNAME, i, NULL ).PointerValue;
+		if (name16 != NULL && SameName( ToName( name16 ), name ))
+		{
+			*index = i;
+			*type = Call( FF_GETPARAMETERTYPE, i, NULL ).UIntValue;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int ChainPlugin::ApplyParameter( FFInstanceID instance, const Parameter &parameter )
+{
+	FFUInt32 index, type;
+	if (!FindParameter( parameter.name, &index, &type ))
+		return Fail( "no parameter \"" + parameter.name + "\"" );
+
+	SetParameterStruct set;
+	set.ParameterNumber = index;
+
+	if (type == FF_TYPE_TEXT)
+	{
+		set.NewParameterValue.PointerValue = (void *)parameter.value.c_str();
+	}
+	else
+	{
+		char *end;
+		float value = (float)strtod( parameter.value.c_str(), &end );
+		if (*end != 0 || parameter.value.empty())
+			return Fail( "\"" + parameter.name + "\" needs a number" );
+
+		set.NewParameterValue.PointerValue = NULL;
+		memcpy( &set.NewParameterValue.UIntValue, &value, sizeof( value ) );
+	}
+
+	FFMixed input;
+	input.PointerValue = &set;
+	if (Call( FF_SETPARAMETER, input, instance ).UIntValue == FF_FAIL)
+		return Fail( "can't set \"" + parameter.name + "\"" );
+
+	return 1;
+}
+
+FFInstanceID ChainPlugin::Instantiate( GLuint width, GLuint height )
+{
+	FFGLViewportStruct viewport;
+	viewport.x = 0;
+	viewport.y = 0;
+	viewport.width = width;
+	viewport.height = height;
+
+	FFMixed input;
+	input.PointerValue = &viewport;
+	FFInstanceID instance = Call( FF_INSTANTIATEGL, input, NULL ).PointerValue;
+
+	if (instance == NULL || instance == FAILED_INSTANCE)
+	{
+		Fail( "can't instantiate" );
+		return NULL;
+	}
+
+	for (size_t i = 0; i < m_parameters.size(); i++)
+	{
+		if (!ApplyParameter( instance, m_parameters[i] ))
+		{
+			Call( FF_DEINSTANTIATEGL, 0, instance );
+			return NULL;
+		}
+	}
+
+	return instance;
+}
+
+void ChainPlugin::Deinstantiate( FFInstanceID instance )
+{
+	if (instance != NULL)
+		Call( FF_DEINSTANTIATEGL, 0, instance );
+}
+
+void ChainPlugin::SetTime( FFInstanceID instance, double time )
+{
+	if (instance == NULL || !m_supportsTime)
+		return;
+
+	FFMixed input;
+	input.PointerValue = &time;
+	Call( FF_SETTIME, input, instance );
+}
+
+int ChainPlugin::Process( FFInstanceID instance, const FFGLTextureStruct &input, GLuint hostFbo )
+{
+	if (instance == NULL)
+		return 0;
+
+	FFGLTextureStruct texture = input;
+	FFGLTextureStruct *inputs[1] = { &texture };
+
+	ProcessOpenGLStruct pGL;
+	pGL.numInputTextures = 1;
+	pGL.inputTextures = inputs;
+	pGL.HostFBO = hostFbo;
+
+	FFMixed mixed;
+	mixed.PointerValue = &pGL;
+	return Call( FF_PROCESSOPENGL, mixed, instance ).UIntValue == FF_SUCCESS;
+}
+
+int ChainPlugin::ProcessBatch( FFInstanceID instance, FFGLTextureStruct **inputs, const double *times, unsigned int numFrames, GLuint outputArray, GLuint hostFbo )
+{
+	if (instance == NULL || !m_supportsBatch)
+		return 0;
+
+	ProcessOpenGLBatchStruct batch;
+	batch.numFrames = numFrames;
+	batch.numInputTextures = 1;
+	batch.inputTextures = inputs;
+	batch.numParameters = 0;
+	batch.parameters = NULL;
+	batch.times = times;
+	batch.outputTexture = outputArray;
+	batch.firstLayer = 0;
+	batch.HostFBO = hostFbo;
+
+	FFMixed mixed;
+	mixed.PointerValue = &batch;
+	return Call( FF_PROCESSOPENGLBATCH, mixed, instance ).UIntValue == FF_SUCCESS;
+}
+
+int ChainPlugin::GetMemoryUsage( FFInstanceID instance, FFGLMemoryUsageStruct *usage )
+{
+	if (instance == NULL)
+		return 0;
+
+	FFMixed input;
+	input.PointerValue = usage;
+	return Call( FF_GETGLMEMORYUSAGE, input, instance ).UIntValue == FF_SUCCESS;
+}
+
+PluginChain::PluginChain()
+{
+}
+
+PluginChain::~PluginChain()
+{
+	// the instances are gone by now, see ChainInstance
+	for (size_t i = 0; i < m_plugins.size(); i++)
+		delete m_plugins[i];
+}
+
+ChainPlugin *PluginChain::Add( const char *path )
+{
+	ChainPlugin *plugin = new ChainPlugin();
+	if (!plugin->Load( path ))
+	{
+		m_error = plugin->GetError();
+		delete plugin;
+		return NULL;
+	}
+
+	m_plugins.push_back( plugin );
+	return plugin;
+}
+
+ChainInstance::ChainInstance()
+	: m_chain( NULL ),
+	m_extensions( NULL ),
+	m_width( 0 ),
+	m_height( 0 ),
+	m_batchSize( 0 ),
+	m_tracker( NULL )
+{
+}
+
+ChainInstance::~ChainInstance()
+{
+	// the plugins free their GL objects when they are deinstantiated, so
+	// DeInit should have been called while the context was current
+	DeInit();
+}
+
+int ChainInstance::Init( PluginChain &chain, FFGLExtensions &e, GLuint outputWidth, GLuint outputHeight, FFGLResourceTracker *tracker )
+{
+	DeInit();
+
+	m_chain = &chain;
+	m_extensions = &e;
+	m_width = outputWidth;
+	m_height = outputHeight;
+	m_tracker = tracker;
+
+	for (int i = 0; i < 2; i++)
+	{
+		if (!m_targets[i].Allocate( GL_TEXTURE_2D, GL_RGBA8, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, tracker ))
+		{
+			m_error = "can't allocate the chain's targets";
+			return 0;
+		}
+
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+		glBindTexture( GL_TEXTURE_2D, 0 );
+	}
+
+	if (!m_fbo.Create( e, tracker ))
+	{
+		m_error = "can't create a framebuffer";
+		return 0;
+	}
+
+	for (size_t i = 0; i < chain.GetNumPlugins(); i++)
+	{
+		FFInstanceID instance = chain.GetPlugin( i )->Instantiate( m_width, m_height );
+		if (instance == NULL)
+		{
+			m_error = chain.GetPlugin( i )->GetError();
+			return 0;
+		}
+
+		m_instances.push_back( instance );
+	}
+
+	return 1;
+}
+
+void ChainInstance::DeInit()
+{
+	for (size_t i = 0; i < m_instances.size(); i++)
+		m_chain->GetPlugin( i )->Deinstantiate( m_instances[i] );
+	m_instances.clear();
+
+	m_targets[0].Release();
+	m_targets[1].Release();
+	m_fbo.Release();
+
+	for (size_t i = 0; i < m_batchInputs.size(); i++)
+		delete m_batchInputs[i];
+	m_batchInputs.clear();
+	m_batchInputStructs.clear();
+	m_batchTimes.clear();
+	m_batchOutput.Release();
+	m_batchSize = 0;
+}
+
+FFGLTextureStruct ChainInstance::Process( const FFGLTextureStruct &input, double time )
+{
+	FFGLTextureStruct output = ProcessPlugins( input, time, m_instances.size() );
+	m_extensions->glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, 0 );
+	return output;
+}
+
+FFGLTextureStruct ChainInstance::ProcessPlugins( const FFGLTextureStruct &input, double time, size_t numPlugins, GLuint lastTarget )
+{
+	FFGLExtensions &e = *m_extensions;
+	FFGLTextureStruct current = input;
+
+	for (size_t i = 0; i < numPlugins; i++)
+	{
+		ChainPlugin *plugin = m_chain->GetPlugin( i );
+		GLuint target = i + 1 == numPlugins && lastTarget != 0 ? lastTarget : m_targets[i % 2].GetHandle();
+
+		e.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, m_fbo.GetHandle() );
+		e.glFramebufferTexture2DEXT( GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, target, 0 );
+
+		glViewport( 0, 0, m_width, m_height );
+		SetPluginState();
+		glClear( GL_COLOR_BUFFER_BIT );
+
+		plugin->SetTime( m_instances[i], time );
+		plugin->Process( m_instances[i], current, m_fbo.GetHandle() );
+
+		current.Width = current.HardwareWidth = m_width;
+		current.Height = current.HardwareHeight = m_height;
+		current.Handle = target;
+	}
+
+	return current;
+}
+
+void ChainInstance::SetPluginState()
+{
+	// the state a plugin finds is the same every time, whatever the one
+	// before it left behind
+	glMatrixMode( GL_PROJECTION );
+	glLoadIdentity();
+	glMatrixMode( GL_MODELVIEW );
+	glLoadIdentity();
+	glDisable( GL_BLEND );
+	glColor4f( 1.0f, 1.0f, 1.0f, 1.0f );
+	glClearColor( 0.0f, 0.0f, 0.0f, 0.0f );
+}
+
+int ChainInstance::InitBatch( unsigned int batchSize, FFGLResourceTracker *tracker )
+{
+	ChainPlugin *last = m_chain->GetLast();
+	if (!last->SupportsBatch())
+	{
+		m_error = last->GetName() + " doesn't render batches";
+		return 0;
+	}
+
+	if (!m_extensions->EXT_texture_array ||
+		!m_batchOutput.AllocateArray( *m_extensions, GL_RGBA8, m_width, m_height, batchSize, GL_RGBA, GL_UNSIGNED_BYTE, tracker ))
+	{
+		m_error = "can't allocate the batch's texture array";
+		return 0;
+	}
+	glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+	glTexParameteri( GL_TEXTURE_2D_ARRAY_EXT, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+	glBindTexture( GL_TEXTURE_2D_ARRAY_EXT, 0 );
+
+	// the inputs get their size from the first frame put in them
+	for (unsigned int i = 0; i < batchSize; i++)
+		m_batchInputs.push_back( new FFGLTexture() );
+	m_batchInputStructs.resize( batchSize );
+	m_batchSize = batchSize;
+	return 1;
+}
+
+int ChainInstance::AddToBatch( const FFGLTextureStruct &input, double time )
+{
+	unsigned int index = GetNumBatched();
+	if (index >= m_batchSize)
+		return 0;
+
+	FFGLExtensions &e = *m_extensions;
+	size_t numBefore = m_instances.size() - 1;
+
+	// the plugins before the last write into the same two targets every
+	// frame, and the input is overwritten by the next one, so what the last
+	// plugin reads needs a texture of its own
+	GLuint width = numBefore > 0 ? m_width : input.Width;
+	GLuint height = numBefore > 0 ? m_height : input.Height;
+	FFGLTexture &batchInput = *m_batchInputs[index];
+	if (!batchInput.Allocate( GL_TEXTURE_2D, GL_RGBA8, width, height, GL_RGBA, GL_UNSIGNED_BYTE, m_tracker ))
+		return 0;
+
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+
+	if (numBefore > 0)
+	{
+		ProcessPlugins( input, time, numBefore, batchInput.GetHandle() );
+	}
+	else
+	{
+		e.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, m_fbo.GetHandle() );
+		e.glFramebufferTexture2DEXT( GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, batchInput.GetHandle(), 0 );
+		glViewport( 0, 0, width, height );
+		SetPluginState();
+		FFGLDrawPassThrough( input );
+	}
+	e.glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, 0 );
+
+	FFGLTextureStruct &inputStruct = m_batchInputStructs[index];
+	inputStruct.Width = inputStruct.HardwareWidth = width;
+	inputStruct.Height = inputStruct.HardwareHeight = height;
+	inputStruct.Handle = batchInput.GetHandle();
+
+	m_batchTimes.push_back( time );
+	return 1;
+}
+
+int ChainInstance::ProcessBatch()
+{
+	unsigned int numFrames = GetNumBatched();
+	if (numFrames == 0)
+		return 1;
+
+	std::vector<FFGLTextureStruct *> inputs( numFrames );
+	for (unsigned int i = 0; i < numFrames; i++)
+		inputs[i] = &m_batchInputStructs[i];
+
+	// the plugin sets the viewport and clears every layer itself
+	SetPluginState();
+
+	size_t last = m_instances.size() - 1;
+	int ok = m_chain->GetPlugin( last )->ProcessBatch( m_instances[last], &inputs[0], &m_batchTimes[0], numFrames,
+		m_batchOutput.GetHandle(), 0 );
+
+	m_batchTimes.clear();
+	return ok;
+}
+
+FFGLMemoryUsageStruct ChainInstance::GetMemoryUsage()
+{
+	FFGLMemoryUsageStruct total;
+	memset( &total, 0, sizeof( total ) );
+
+	for (size_t i = 0; i < m_instances.size(); i++)
+	{
+		FFGLMemoryUsageStruct usage;
+		memset( &usage, 0, sizeof( usage ) );
+		if (!m_chain->GetPlugin( i )->GetMemoryUsage( m_instances[i], &usage ))
+			continue;
+
+		total.NumObjects += usage.NumObjects;
+		total.NumKiloBytes += usage.NumKiloBytes;
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		if (m_targets[i].GetHandle() != 0)
+		{
+			total.NumObjects++;
+			total.NumKiloBytes += (FFUInt32)(((size_t)m_width * m_height * 4 + 1023) / 1024);
+		}
+	}
+	if (m_fbo.GetHandle() != 0)
+		total.NumObjects++;
+
+	for (size_t i = 0; i < m_batchInputs.size(); i++)
+	{
+		if (m_batchInputs[i]->GetHandle() != 0)
+		{
+			total.NumObjects++;
+			total.NumKiloBytes += (FFUInt32)((m_batchInputs[i]->GetNumBytes() + 1023) / 1024);
+		}
+	}
+	if (m_batchOutput.GetHandle() != 0)
+	{
+		total.NumObjects++;
+		total.NumKiloBytes += (FFUInt32)((m_batchOutput.GetNumBytes() + 1023) / 1024);
+	}
+
+	return total;
+}
@@ -0,0 +1,182 @@
+#ifndef PLUGINCHAIN_H
+#define PLUGINCHAIN_H
+
+#include <FFGL.h>
+#include <FFGLExtensions.h>
+#include <FFGLResources.h>
+#include <string>
+#include <vector>
+
+// One FFGL plugin of the chain: the loaded module and the parameters to
+// give its instances, driven through plugMain like any host would. Every
+// render context creates its own instances, see ChainInstance.
+class ChainPlugin
+{
+public:
+	ChainPlugin();
+	~ChainPlugin();
+
+	// Loads the module and initialises it. Returns 0 on failure, see
+	// GetError
+	int Load( const char *path );
+
+	// Applied to every instance. value is a number (0..1) or 0/1 for
+	// boolean parameters, taken as is for text parameters
+	void AddParameter( const std::string &name, const std::string &value );
+
+	// Context current. Creates an instance for a viewport of the given
+	// size and applies the parameters. Returns NULL on failure. The render
+	// threads instantiate and deinstantiate at the same time, without a
+	// lock, as a host with a context per output would
+	FFInstanceID Instantiate( GLuint width, GLuint height );
+	void Deinstantiate( FFInstanceID instance );
+
+	int SupportsTime() const { return m_supportsTime; }
+	void SetTime( FFInstanceID instance, double time );
+
+	// Renders input into whatever framebuffer hostFbo is
+	int Process( FFInstanceID instance, const FFGLTextureStruct &input, GLuint hostFbo );
+
+	// Renders numFrames frames, one input each, into the layers of
+	// outputArray (a GL_TEXTURE_2D_ARRAY_EXT) with one
+	// FF_PROCESSOPENGLBATCH. times holds the time of every frame
+	int SupportsBatch() const { return m_supportsBatch; }
+	int ProcessBatch( FFInstanceID instance, FFGLTextureStruct **inputs, const double *times, unsigned int numFrames, GLuint outputArray, GLuint hostFbo );
+
+	// The GL objects and bytes the instance holds, from
+	// FF_GETGLMEMORYUSAGE. Returns 0 for plugins that don't report them
+	int GetMemoryUsage( FFInstanceID instance, FFGLMemoryUsageStruct *usage );
+
+	const std::string &GetName() const { return m_name; }
+	const std::string &GetError() const { return m_error; }
+
+private:
+	struct Parameter
+	{
+		std::string name;
+		std::string value;
+	};
+
+	void *m_module; // HMODULE on windows, a dlopen handle elsewhere
+	FF_Main_FuncPtr m_main;
+	int m_initialised;
+	int m_supportsTime;
+	int m_supportsBatch;
+
+	std::string m_path;
+	std::string m_name;
+	std::string m_error;
+	std::vector<Parameter> m_parameters;
+
+	FFMixed Call( FFUInt32 functionCode, FFMixed input, FFInstanceID instance );
+	FFMixed Call( FFUInt32 functionCode, FFUInt32 input, FFInstanceID instance );
+	int FindParameter( const std::string &name, FFUInt32 *index, FFUInt32 *type );
+	int ApplyParameter( FFInstanceID instance, const Parameter &parameter );
+	int Fail( const std::string &message );
+
+	ChainPlugin( const ChainPlugin & );
+	ChainPlugin &operator=( const ChainPlugin & );
+};
+
+// PluginChain is the list of plugins frames go through, each one reading
+// the output of the one before.
+class PluginChain
+{
+public:
+	PluginChain();
+	~PluginChain();
+
+	// Returns the new plugin, or NULL if it couldn't be loaded (the error
+	// is in GetError)
+	ChainPlugin *Add( const char *path );
+	ChainPlugin *GetLast() { return m_plugins.empty() ? NULL : m_plugins.back(); }
+	ChainPlugin *GetPlugin( size_t index ) { return m_plugins[index]; }
+	size_t GetNumPlugins() const { return m_plugins.size(); }
+
+	const std::string &GetError() const { return m_error; }
+
+private:
+	std::vector<ChainPlugin *> m_plugins;
+	std::string m_error;
+
+	PluginChain( const PluginChain & );
+	PluginChain &operator=( const PluginChain & );
+};
+
+// ChainInstance runs a PluginChain in one GL context: an instance of
+// every plugin, and two textures of the output size the outputs
+// ping-pong between. Instances of the same chain in different contexts
+// render independently, each on its own thread.
+class ChainInstance
+{
+public:
+	ChainInstance();
+	~ChainInstance();
+
+	// Context current. Instantiates every plugin of chain for the output
+	// size
+	int Init( PluginChain &chain, FFGLExtensions &e, GLuint outputWidth, GLuint outputHeight, FFGLResourceTracker *tracker );
+	void DeInit();
+
+	// Runs input through the chain. time (in seconds) goes to plugins
+	// that support SetTime. Returns the texture holding the result, which
+	// stays valid until the next call
+	FFGLTextureStruct Process( const FFGLTextureStruct &input, double time );
+
+	// --batch: the plugins before the last run frame by frame, and the
+	// last renders batchSize of their outputs at a time with
+	// FF_PROCESSOPENGLBATCH. Context current, after Init
+	int InitBatch( unsigned int batchSize, FFGLResourceTracker *tracker );
+	unsigned int GetBatchSize() const { return m_batchSize; }
+	unsigned int GetNumBatched() const { return (unsigned int)m_batchTimes.size(); }
+
+	// Runs input through the plugins before the last, the one before it
+	// rendering straight into an input of the next batch. With only one
+	// plugin input itself is copied there. Returns 0 if the batch is
+	// already full
+	int AddToBatch( const FFGLTextureStruct &input, double time );
+
+	// Renders the frames added since the last batch. Returns 0 if the
+	// plugin failed
+	int ProcessBatch();
+
+	// The GL_TEXTURE_2D_ARRAY_EXT of the output size the last batch was
+	// rendered into, frame i in layer i. See FFGLReadback::CaptureLayer
+	GLuint GetBatchOutput() const { return m_batchOutput.GetHandle(); }
+
+	// The GL memory of every plugin instance reporting it, plus the
+	// chain's own targets
+	FFGLMemoryUsageStruct GetMemoryUsage();
+
+	const std::string &GetError() const { return m_error; }
+
+private:
+	PluginChain *m_chain;
+	FFGLExtensions *m_extensions;
+	std::vector<FFInstanceID> m_instances;
+	std::string m_error;
+
+	GLuint m_width;
+	GLuint m_height;
+	FFGLTexture m_targets[2];
+	FFGLFramebuffer m_fbo;
+
+	// The inputs of the last plugin for the batch, and the layers it
+	// renders them into
+	unsigned int m_batchSize;
+	std::vector<FFGLTexture *> m_batchInputs;
+	std::vector<FFGLTextureStruct> m_batchInputStructs;
+	std::vector<double> m_batchTimes;
+	FFGLTexture m_batchOutput;
+	FFGLResourceTracker *m_tracker;
+
+	// Runs input through the first numPlugins plugins, the last of them
+	// rendering into lastTarget unless it is 0
+	FFGLTextureStruct ProcessPlugins( const FFGLTextureStruct &input, double time, size_t numPlugins, GLuint lastTarget = 0 );
+	void SetPluginState();
+
+	ChainInstance( const ChainInstance & );
+	ChainInstance &operator=( const ChainInstance & );
+};
+
+#endif
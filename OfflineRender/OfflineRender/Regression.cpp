@@ -0,0 +1,157 @@
+#include "Regression.h"
+#include "VideoFile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int CompareVideos( const char *path, const char *referencePath, int width, int height, int tolerance, VideoComparison *result, std::string *error )
+{
+	memset( result, 0, sizeof( *result ) );
+
+	VideoReader video, reference;
+	if (!video.Open( path, width, height ))
+	{
+		*error = std::string( path ) + ": " + video.GetError();
+		return 0;
+	}
+
+	if (!reference.Open( referencePath, width, height ))
+	{
+		*error = std::string( referencePath ) + ": " + reference.GetError();
+		return 0;
+	}
+
+	if (video.GetFormat() != reference.GetFormat() || video.GetFrameSize() != reference.GetFrameSize() ||
+		video.GetWidth() != reference.GetWidth() || video.GetHeight() != reference.GetHeight())
+	{
+		*error = "the reference has a different layout or size";
+		return 0;
+	}
+
+	if (video.IndexFrames() != reference.IndexFrames())
+	{
+		*error = "the reference has " + std::to_string( reference.GetNumFrames() ) + " frames, not " +
+			std::to_string( video.GetNumFrames() );
+		return 0;
+	}
+
+	size_t frameSize = video.GetFrameSize();
+	result->numFrames = video.GetNumFrames();
+
+	for (unsigned int i = 0; i < result->numFrames; i++)
+	{
+		const unsigned char *a = video.GetFrame( i );
+		const unsigned char *b = reference.GetFrame( i );
+
+		// most frames of a good render are identical
+		if (memcmp( a, b, frameSize ) == 0)
+			continue;
+
+		for (size_t j = 0; j < frameSize; j++)
+		{
+			int difference = abs( (int)a[j] - (int)b[j] );
+			if (difference > result->maxDifference)
+				result->maxDifference = difference;
+
+			if (difference > tolerance)
+			{
+				if (result->numDifferent == 0)
+					result->firstDifferentFrame = i;
+				result->numDifferent++;
+			}
+		}
+	}
+
+	return 1;
+}
+
+int ReadBaseline( const char *path, PerfBaseline *baseline )
+{
+	memset( baseline, 0, sizeof( *baseline ) );
+
+	FILE *file;
+#ifdef _WIN32
+	if (fopen_s( &file, path, "r" ) != 0)
+		file = NULL;
+#else
+	file = fopen( path, "r" );
+#endif
+	if (file == NULL)
+		return 0;
+
+	int numFound = 0;
+	char line[256];
+	while (fgets( line, sizeof( line ), file ) != NULL)
+	{
+		char *space = strchr( line, ' ' );
+		if (space == NULL)
+			continue;
+
+		std::string name( line, space - line );
+		char *end;
+		double value = strtod( space + 1, &end );
+		if (end == space + 1)
+			continue;
+
+		if (name == "ms_per_frame")
+			baseline->msPerFrame = value;
+		else if (name == "gl_objects")
+			baseline->glObjects = (unsigned int)value;
+		else if (name == "gl_kilobytes")
+			baseline->glKiloBytes = (unsigned int)value;
+		else
+			continue;
+
+		numFound++;
+	}
+
+	fclose( file );
+
+	// a baseline without a time is no baseline
+	return numFound > 0 && baseline->msPerFrame > 0.0;
+}
+
+int WriteBaseline( const char *path, const PerfBaseline &baseline )
+{
+	FILE *file;
+#ifdef _WIN32
+	if (fopen_s( &file, path, "w" ) != 0)
+		file = NULL;
+#else
+	file = fopen( path, "w" );
+#endif
+	if (file == NULL)
+		return 0;
+
+	fprintf( file, "ms_per_frame %.4f\n", baseline.msPerFrame );
+	fprintf( file, "gl_objects %u\n", baseline.glObjects );
+	fprintf( file, "gl_kilobytes %u\n", baseline.glKiloBytes );
+
+	return fclose( file ) == 0;
+}
+
+int CheckBaseline( const PerfBaseline &measured, const PerfBaseline &baseline, double slack )
+{
+	int ok = 1;
+
+	if (slack >= 0.0)
+	{
+		double limit = baseline.msPerFrame * (1.0 + slack);
+		printf( "time:      %.3f ms/frame, baseline %.3f (limit %.3f)%s\n",
+			measured.msPerFrame, baseline.msPerFrame, limit, measured.msPerFrame > limit ? "  SLOWER" : "" );
+		if (measured.msPerFrame > limit)
+			ok = 0;
+	}
+	else
+	{
+		printf( "time:      %.3f ms/frame, baseline %.3f (not checked)\n", measured.msPerFrame, baseline.msPerFrame );
+	}
+
+	printf( "GL memory: %u objects, %u KB, baseline %u objects, %u KB%s\n",
+		measured.glObjects, measured.glKiloBytes, baseline.glObjects, baseline.glKiloBytes,
+		measured.glObjects > baseline.glObjects || measured.glKiloBytes > baseline.glKiloBytes ? "  MORE" : "" );
+	if (measured.glObjects > baseline.glObjects || measured.glKiloBytes > baseline.glKiloBytes)
+		ok = 0;
+
+	return ok;
+}
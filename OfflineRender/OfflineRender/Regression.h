@@ -0,0 +1,52 @@
+#ifndef REGRESSION_H
+#define REGRESSION_H
+
+#include <string>
+
+// Checks of a render against earlier ones, for catching a plugin change
+// that alters the picture or slows it down before it goes into a show:
+//
+//	OfflineRender -i pattern:ramp -o ramp.y4m -p LumaKey.dll
+//		--compare golden/ramp.y4m --baseline golden/ramp.perf
+//
+// The golden files are renders of a build known to be good; --write-baseline
+// records the timings and GL memory of one.
+//
+// Regression/run.sh runs the suite of the plugins in this repository
+// against the goldens and baselines committed next to it.
+
+// Result of CompareVideos
+struct VideoComparison
+{
+	unsigned int numFrames;
+	int maxDifference; // largest difference of a byte, 0..255
+	size_t numDifferent; // bytes differing by more than the tolerance
+	unsigned int firstDifferentFrame; // valid when numDifferent > 0
+};
+
+// Compares the frames of two files byte by byte. They must have the same
+// layout, size and number of frames. width and height are for raw RGBA.
+// Returns 0 if the files can't be compared, with the reason in error
+int CompareVideos( const char *path, const char *referencePath, int width, int height, int tolerance, VideoComparison *result, std::string *error );
+
+// Performance of a render, kept in a text file of "name value" lines so
+// it can be read and edited by hand
+struct PerfBaseline
+{
+	double msPerFrame; // steady state, after a warm-up frame per context
+	unsigned int glObjects; // GL objects of one render context
+	unsigned int glKiloBytes; // and their memory
+};
+
+int ReadBaseline( const char *path, PerfBaseline *baseline );
+int WriteBaseline( const char *path, const PerfBaseline &baseline );
+
+// Prints how measured compares to baseline. GL memory has no slack, a
+// plugin holding more than it used to is leaking or caching more than it
+// should. The time per frame depends on whatever else the machine does,
+// so it is only checked with a slack >= 0: the render is too slow when it
+// takes more than slack (0.1 is 10%) longer per frame. Returns 0 on a
+// regression
+int CheckBaseline( const PerfBaseline &measured, const PerfBaseline &baseline, double slack );
+
+#endif
@@ -0,0 +1,451 @@
+#include "VideoFile.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Longest Y4M header and frame header we look for the end of
+static const size_t MAX_HEADER = 1024;
+
+int GetVideoFormat( const char *path )
+{
+	size_t length = strlen( path );
+	if (length >= 4)
+	{
+		const char *extension = path + length - 4;
+		if (extension[0] == '.' &&
+			(extension[1] | 0x20) == 'y' && extension[2] == '4' && (extension[3] | 0x20) == 'm')
+			return VIDEO_Y4M;
+	}
+
+	return VIDEO_RGBA;
+}
+
+static int ToInt( const std::string &word, int *value )
+{
+	char *end;
+	long l = strtol( word.c_str(), &end, 10 );
+	*value = (int)l;
+	return *end == 0 && !word.empty() && l > 0;
+}
+
+VideoReader::VideoReader()
+{
+	Close();
+}
+
+int VideoReader::Fail( const char *message )
+{
+	m_error = message;
+	Close();
+	return 0;
+}
+
+void VideoReader::Close()
+{
+	m_file.Close();
+
+	m_format = VIDEO_RGBA;
+	m_width = 0;
+	m_height = 0;
+	m_chromaWidth = 0;
+	m_chromaHeight = 0;
+	m_rateNum = 0;
+	m_rateDen = 1;
+	m_frameSize = 0;
+	m_position = 0;
+	m_numFrames = 0;
+	m_frames.clear();
+	m_pattern.clear();
+}
+
+int VideoReader::Open( const char *path, int width, int height )
+{
+	Close();
+	m_error.clear();
+
+	m_format = GetVideoFormat( path );
+
+	if (!m_file.Open( path ))
+		return Fail( "can't open the input" );
+
+	if (m_format == VIDEO_Y4M)
+	{
+		if (!ParseY4MHeader())
+			return 0;
+	}
+	else
+	{
+		if (width <= 0 || height <= 0)
+			return Fail( "raw RGBA input needs a size" );
+
+		m_width = width;
+		m_height = height;
+		m_frameSize = (size_t)width * (size_t)height * 4;
+		m_numFrames = (unsigned int)(GetSize() / m_frameSize);
+	}
+
+	return 1;
+}
+
+const char PATTERN_NAMES[] = "gradient|ramp|checker";
+
+int VideoReader::OpenPattern( const char *name, int width, int height, unsigned int numFrames )
+{
+	Close();
+	m_error.clear();
+
+	std::string pattern = name;
+	if (pattern != "gradient" && pattern != "ramp" && pattern != "checker")
+		return Fail( "unknown pattern" );
+
+	if (width <= 0 || height <= 0 || numFrames == 0)
+		return Fail( "a pattern needs a size and a number of frames" );
+
+	m_format = VIDEO_RGBA;
+	m_width = width;
+	m_height = height;
+	m_frameSize = (size_t)width * (size_t)height * 4;
+	m_numFrames = numFrames;
+	m_pattern.resize( m_frameSize * numFrames );
+
+	unsigned char *pixel = &m_pattern[0];
+	for (unsigned int frame = 0; frame < numFrames; frame++)
+	{
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				int xs = x + (int)frame * 2;
+				unsigned char r, g, b;
+
+				if (pattern == "gradient")
+				{
+					r = (unsigned char)(x * 255 / (width > 1 ? width - 1 : 1));
+					g = (unsigned char)(y * 255 / (height > 1 ? height - 1 : 1));
+					b = (unsigned char)(frame * 8);
+				}
+				else if (pattern == "ramp")
+				{
+					r = g = b = (unsigned char)((xs * 255 / (width > 1 ? width - 1 : 1)) & 0xff);
+				}
+				else
+				{
+					r = g = b = ((xs / 32 + y / 32) & 1) ? 255 : 0;
+				}
+
+				pixel[0] = r;
+				pixel[1] = g;
+				pixel[2] = b;
+				pixel[3] = 255;
+				pixel += 4;
+			}
+		}
+	}
+
+	return 1;
+}
+
+int VideoReader::ParseY4MHeader()
+{
+	const char *data = (const char *)GetData();
+	size_t size = GetSize();
+
+	size_t end = 0;
+	while (end < size && end < MAX_HEADER && data[end] != '\n')
+		end++;
+
+	if (end >= size || end == MAX_HEADER || size < 10 || memcmp( data, "YUV4MPEG2 ", 10 ) != 0)
+		return Fail( "not a YUV4MPEG2 file" );
+
+	std::string colorspace = "420";
+	size_t i = 10;
+
+	while (i < end)
+	{
+		size_t start = i;
+		while (i < end && data[i] != ' ')
+			i++;
+
+		std::string word( data + start, i - start );
+		i++;
+
+		if (word.empty())
+			continue;
+
+		std::string value = word.substr( 1 );
+
+		switch (word[0])
+		{
+		case 'W':
+			if (!ToInt( value, &m_width ))
+				return Fail( "bad width" );
+			break;
+
+		case 'H':
+			if (!ToInt( value, &m_height ))
+				return Fail( "bad height" );
+			break;
+
+		case 'F':
+		{
+			size_t colon = value.find( ':' );
+			if (colon == std::string::npos ||
+				!ToInt( value.substr( 0, colon ), &m_rateNum ) ||
+				!ToInt( value.substr( colon + 1 ), &m_rateDen ))
+				return Fail( "bad frame rate" );
+			break;
+		}
+
+		case 'C':
+			colorspace = value;
+			break;
+
+		default:
+			// interlacing, aspect ratio and extensions don't matter here
+			break;
+		}
+	}
+
+	if (m_width == 0 || m_height == 0)
+		return Fail( "Y4M header without a size" );
+
+	// 8 bit 4:2:0 (any chroma siting), 4:2:2 and 4:4:4
+	if (colorspace == "420" || colorspace == "420jpeg" || colorspace == "420paldv" || colorspace == "420mpeg2")
+	{
+		m_chromaWidth = (m_width + 1) / 2;
+		m_chromaHeight = (m_height + 1) / 2;
+	}
+	else if (colorspace == "422")
+	{
+		m_chromaWidth = (m_width + 1) / 2;
+		m_chromaHeight = m_height;
+	}
+	else if (colorspace == "444")
+	{
+		m_chromaWidth = m_width;
+		m_chromaHeight = m_height;
+	}
+	else
+	{
+		return Fail( "unsupported Y4M colorspace, use 8 bit 420, 422 or 444" );
+	}
+
+	m_frameSize = (size_t)m_width * (size_t)m_height + 2 * (size_t)m_chromaWidth * (size_t)m_chromaHeight;
+	m_position = end + 1;
+
+	// "FRAME\n" in front of every frame
+	m_numFrames = (unsigned int)((size - m_position) / (m_frameSize + 6));
+
+	return 1;
+}
+
+const unsigned char *VideoReader::NextFrame()
+{
+	const unsigned char *data = GetData();
+	size_t size = GetSize();
+
+	if (data == NULL || m_frameSize == 0)
+		return NULL;
+
+	if (m_format == VIDEO_Y4M)
+	{
+		if (size - m_position < 6 || memcmp( data + m_position, "FRAME", 5 ) != 0)
+			return NULL;
+
+		// frame headers may carry parameters too
+		size_t end = m_position + 5;
+		while (end < size && end - m_position < MAX_HEADER && data[end] != '\n')
+			end++;
+
+		if (end >= size || data[end] != '\n')
+			return NULL;
+
+		m_position = end + 1;
+	}
+
+	if (size - m_position < m_frameSize)
+		return NULL;
+
+	const unsigned char *frame = data + m_position;
+	m_position += m_frameSize;
+
+	return frame;
+}
+
+unsigned int VideoReader::IndexFrames()
+{
+	if (!m_frames.empty())
+		return m_numFrames;
+
+	// only the headers are touched, a page per frame
+	size_t start = m_position;
+	const unsigned char *frame;
+	while ((frame = NextFrame()) != NULL)
+		m_frames.push_back( frame );
+	m_position = start;
+
+	m_numFrames = (unsigned int)m_frames.size();
+	return m_numFrames;
+}
+
+const unsigned char *VideoReader::GetFrame( unsigned int index ) const
+{
+	return index < m_frames.size() ? m_frames[index] : NULL;
+}
+
+VideoWriter::VideoWriter()
+	: m_file( NULL ),
+	m_format( VIDEO_RGBA ),
+	m_width( 0 ),
+	m_height( 0 ),
+	m_numFrames( 0 )
+{
+}
+
+VideoWriter::~VideoWriter()
+{
+	Close();
+}
+
+int VideoWriter::Fail( const char *message )
+{
+	m_error = message;
+	Close();
+	return 0;
+}
+
+int VideoWriter::Open( const char *path, int width, int height, int rateNum, int rateDen, int bt709, int fullRange )
+{
+	Close();
+	m_error.clear();
+
+	m_format = GetVideoFormat( path );
+	m_width = width;
+	m_height = height;
+	m_numFrames = 0;
+
+#ifdef _WIN32
+	if (fopen_s( &m_file, path, "wb" ) != 0)
+		m_file = NULL;
+#else
+	m_file = fopen( path, "wb" );
+#endif
+
+	if (m_file == NULL)
+		return Fail( "can't create the output" );
+
+	// whole frames go out in a few large writes
+	setvbuf( m_file, NULL, _IOFBF, 4 << 20 );
+
+	if (m_format == VIDEO_Y4M)
+	{
+		if (rateNum <= 0 || rateDen <= 0)
+		{
+			rateNum = 30;
+			rateDen = 1;
+		}
+
+		if (fprintf( m_file, "YUV4MPEG2 W%d H%d F%d:%d Ip A1:1 C444\n", width, height, rateNum, rateDen ) < 0)
+			return Fail( "can't write the output" );
+
+		// R'G'B' to Y'CbCr in 16.16 fixed point, the inverse of what
+		// FFGLYUVInput does on the way in
+		double kr = bt709 ? 0.2126 : 0.299;
+		double kb = bt709 ? 0.0722 : 0.114;
+		double kg = 1.0 - kr - kb;
+
+		double yScale = fullRange ? 1.0 : 219.0 / 255.0;
+		double cScale = fullRange ? 1.0 : 224.0 / 255.0;
+		double yOffset = fullRange ? 0.0 : 16.0;
+
+		double rows[3][3] = {
+			{ kr * yScale, kg * yScale, kb * yScale },
+			{ -kr / (2.0 * (1.0 - kb)) * cScale, -kg / (2.0 * (1.0 - kb)) * cScale, 0.5 * cScale },
+			{ 0.5 * cScale, -kg / (2.0 * (1.0 - kr)) * cScale, -kb / (2.0 * (1.0 - kr)) * cScale }
+		};
+		double offsets[3] = { yOffset, 128.0, 128.0 };
+
+		for (int r = 0; r < 3; r++)
+		{
+			for (int c = 0; c < 3; c++)
+				m_matrix[r][c] = (int)(rows[r][c] * 65536.0 + (rows[r][c] < 0.0 ? -0.5 : 0.5));
+
+			m_matrix[r][3] = (int)(offsets[r] * 65536.0) + 32768;
+		}
+
+		m_planes.resize( (size_t)width * (size_t)height * 3 );
+	}
+
+	return 1;
+}
+
+int VideoWriter::Close()
+{
+	int result = 1;
+
+	if (m_file != NULL)
+	{
+		if (fclose( m_file ) != 0)
+		{
+			m_error = "can't write the output";
+			result = 0;
+		}
+
+		m_file = NULL;
+	}
+
+	m_planes.clear();
+	return result;
+}
+
+static unsigned char Clamp8( int value )
+{
+	value >>= 16;
+	if (value < 0) return 0;
+	if (value > 255) return 255;
+	return (unsigned char)value;
+}
+
+int VideoWriter::Write( const unsigned char *rgba )
+{
+	if (m_file == NULL)
+		return 0;
+
+	size_t rowSize = (size_t)m_width * 4;
+
+	if (m_format == VIDEO_RGBA)
+	{
+		// files start with the top row
+		for (int y = m_height - 1; y >= 0; y--)
+		{
+			if (fwrite( rgba + rowSize * y, 1, rowSize, m_file ) != rowSize)
+				return Fail( "can't write the output" );
+		}
+	}
+	else
+	{
+		size_t planeSize = (size_t)m_width * (size_t)m_height;
+		unsigned char *planeY = &m_planes[0];
+		unsigned char *planeCb = planeY + planeSize;
+		unsigned char *planeCr = planeCb + planeSize;
+
+		for (int y = 0; y < m_height; y++)
+		{
+			const unsigned char *src = rgba + rowSize * (m_height - 1 - y);
+			size_t row = (size_t)y * (size_t)m_width;
+
+			for (int x = 0; x < m_width; x++, src += 4)
+			{
+				int r = src[0], g = src[1], b = src[2];
+				planeY[row + x] = Clamp8( m_matrix[0][0] * r + m_matrix[0][1] * g + m_matrix[0][2] * b + m_matrix[0][3] );
+				planeCb[row + x] = Clamp8( m_matrix[1][0] * r + m_matrix[1][1] * g + m_matrix[1][2] * b + m_matrix[1][3] );
+				planeCr[row + x] = Clamp8( m_matrix[2][0] * r + m_matrix[2][1] * g + m_matrix[2][2] * b + m_matrix[2][3] );
+			}
+		}
+
+		if (fwrite( "FRAME\n", 1, 6, m_file ) != 6 || fwrite( &m_planes[0], 1, m_planes.size(), m_file ) != m_planes.size())
+			return Fail( "can't write the output" );
+	}
+
+	m_numFrames++;
+	return 1;
+}
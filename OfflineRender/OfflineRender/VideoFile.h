@@ -0,0 +1,145 @@
+#ifndef VIDEOFILE_H
+#define VIDEOFILE_H
+
+#include <FFGLMappedFile.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Layouts of the frames in a video file
+enum
+{
+	VIDEO_RGBA, // raw, 4 bytes per pixel, top row first, no header
+	VIDEO_Y4M // YUV4MPEG2, 8 bit planar Y'CbCr
+};
+
+// Picks the layout from the file name: .y4m is VIDEO_Y4M, anything else
+// raw RGBA
+int GetVideoFormat( const char *path );
+
+// Test patterns of VideoReader::OpenPattern, separated by '|':
+// gradient (red across, green up), ramp (a grey ramp, the luma keys'
+// worst case) and checker (32 pixel squares, edges everywhere)
+extern const char PATTERN_NAMES[];
+
+// VideoReader memory-maps a video file and walks its frames in place.
+// Nothing is copied or parsed beyond the frame headers, so a frame costs
+// the page faults that bring it in.
+class VideoReader
+{
+public:
+	VideoReader();
+
+	// width and height are only used for raw RGBA, which has no header.
+	// Returns 0 on failure, see GetError
+	int Open( const char *path, int width, int height );
+
+	// Generates numFrames RGBA frames of a test pattern instead of reading
+	// a file, see PATTERN_NAMES. The pattern moves a little every frame so
+	// plugins that keep state between frames are exercised too
+	int OpenPattern( const char *name, int width, int height, unsigned int numFrames );
+
+	void Close();
+
+	const std::string &GetError() const { return m_error; }
+
+	int GetFormat() const { return m_format; }
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+
+	// Size of the chroma planes of a Y4M file, 0 for raw RGBA
+	int GetChromaWidth() const { return m_chromaWidth; }
+	int GetChromaHeight() const { return m_chromaHeight; }
+
+	// 0/1 when the file doesn't say
+	int GetFrameRateNum() const { return m_rateNum; }
+	int GetFrameRateDen() const { return m_rateDen; }
+
+	size_t GetFrameSize() const { return m_frameSize; }
+
+	// Estimated from the file size, exact unless Y4M frame headers carry
+	// parameters
+	unsigned int GetNumFrames() const { return m_numFrames; }
+
+	// The next frame, planes one after the other, or NULL at the end of
+	// the file. Points into the mapping, valid until Close
+	const unsigned char *NextFrame();
+
+	// Walks the frame headers once so GetFrame can jump to any frame, and
+	// makes GetNumFrames exact. Returns the number of frames
+	unsigned int IndexFrames();
+
+	// Frame index of an indexed file, NULL past the end. Safe to call
+	// from several threads at once
+	const unsigned char *GetFrame( unsigned int index ) const;
+
+private:
+	FFGLMappedFile m_file;
+	std::string m_error;
+
+	int m_format;
+	int m_width;
+	int m_height;
+	int m_chromaWidth;
+	int m_chromaHeight;
+	int m_rateNum;
+	int m_rateDen;
+
+	size_t m_frameSize;
+	size_t m_position;
+	unsigned int m_numFrames;
+	std::vector<const unsigned char *> m_frames;
+
+	int ParseY4MHeader();
+	// the frames of OpenPattern, used instead of the mapping
+	std::vector<unsigned char> m_pattern;
+
+	const unsigned char *GetData() const { return m_pattern.empty() ? m_file.GetData() : &m_pattern[0]; }
+	size_t GetSize() const { return m_pattern.empty() ? m_file.GetSize() : m_pattern.size(); }
+
+	int Fail( const char *message );
+};
+
+// VideoWriter writes frames read back from the GPU (RGBA, bottom row
+// first) as raw RGBA or as 4:4:4 Y4M. It is meant to run on the
+// consumer thread of a FFGLReadback.
+class VideoWriter
+{
+public:
+	VideoWriter();
+	~VideoWriter();
+
+	// frameRate is only written to Y4M headers. bt709 and fullRange
+	// select the Y'CbCr conversion, as for FFGLYUVInput
+	int Open( const char *path, int width, int height, int rateNum, int rateDen, int bt709, int fullRange );
+	int Close();
+
+	const std::string &GetError() const { return m_error; }
+
+	// rgba is width*height*4 bytes, bottom row first
+	int Write( const unsigned char *rgba );
+	size_t GetFrameSize() const { return (size_t)m_width * (size_t)m_height * 4; }
+
+	unsigned int GetNumFrames() const { return m_numFrames; }
+
+private:
+	FILE *m_file;
+	std::string m_error;
+
+	int m_format;
+	int m_width;
+	int m_height;
+	unsigned int m_numFrames;
+
+	// Y4M: fixed point R'G'B' to Y'CbCr, rows of [r, g, b, offset]
+	int m_matrix[3][4];
+	std::vector<unsigned char> m_planes;
+
+	int Fail( const char *message );
+
+	VideoWriter( const VideoWriter & );
+	VideoWriter &operator=( const VideoWriter & );
+};
+
+#endif
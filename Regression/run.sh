@@ -0,0 +1,144 @@
+#!/bin/bash
+# Regression suite of the plugins: renders generated inputs (gradient,
+# luma ramp, checkerboard) through every plugin with OfflineRender at a few
+# sizes and compares the output with the golden renders in golden/, then
+# checks the GL objects and GL memory of a render context of every plugin
+# against the baselines in baseline/.
+#
+#	Regression/run.sh <OfflineRender> <plugin dir> [plugin extension]
+#
+# The plugin dir holds the plugins as the solutions build them (LumaKey.dll,
+# "Mirror Native.dll", ...), the extension defaults to dll. Runs from Git
+# Bash on Windows as well as on linux, where OfflineRender renders through
+# EGL without an X server, on a headless host with Mesa's llvmpipe.
+#
+# The baselines hold the time per frame as well, which is printed but
+# only checked with TIMING=1: a shared machine or another GPU makes it
+# vary far more than a plugin change does. On a quiet machine with its own
+# baselines, TIMING=1 fails a render more than SLACK (default 0.25) slower.
+#
+# The goldens and baselines were recorded with llvmpipe. Another GPU may
+# round a little differently (TOLERANCE, default 2) and is certainly
+# faster or slower, so record its own baselines first:
+#
+#	Regression/run.sh --update <OfflineRender> <plugin dir>
+#
+# re-renders every golden and baseline. Only commit them after checking
+# that the change of picture is intended.
+#
+# Exits with the number of failed cases.
+
+cd "$(dirname "$0")" || exit 1
+
+UPDATE=0
+if [ "$1" = "--update" ]; then
+	UPDATE=1
+	shift
+fi
+
+if [ $# -lt 2 ]; then
+	sed -n '2,/^$/p' "$0" | sed 's/^# \{0,1\}//'
+	exit 1
+fi
+
+RENDER=$1
+PLUGINS=$2
+EXT=${3:-dll}
+TOLERANCE=${TOLERANCE:-2}
+TIMING=${TIMING:-0}
+SLACK=${SLACK:-0.25}
+OUT=out
+
+mkdir -p "$OUT" golden baseline
+FAILED=0
+
+# check <case> <plugin> <pattern> <size> [OfflineRender arguments]
+# renders 2 frames of a pattern through one plugin and compares them with
+# golden/<case>.rgba, or golden/$GOLDEN.rgba when set
+check()
+{
+	local name=$1 plugin=$2 pattern=$3 size=$4
+	local golden=golden/${GOLDEN:-$name}.rgba
+	shift 4
+
+	local args=( -i "pattern:$pattern" --size "$size" --frames 2 -p "$PLUGINS/$plugin.$EXT" "$@" )
+	if [ $UPDATE = 1 ]; then
+		"$RENDER" "${args[@]}" -o "$golden" > "$OUT/$name.log" 2>&1
+	else
+		"$RENDER" "${args[@]}" -o "$OUT/$name.rgba" --compare "$golden" --tolerance $TOLERANCE > "$OUT/$name.log" 2>&1
+	fi
+	report $? "$name"
+}
+
+# perf <case> <plugin> [OfflineRender arguments]
+# renders 30 frames of 640x360 and compares the GL memory, and with
+# TIMING=1 the time per frame, with baseline/<case>.perf
+perf()
+{
+	local name=$1 plugin=$2
+	shift 2
+
+	local args=( -i pattern:gradient --size 640x360 --frames 30 -p "$PLUGINS/$plugin.$EXT" "$@" -o "$OUT/$name.rgba" )
+	if [ $UPDATE = 1 ]; then
+		"$RENDER" "${args[@]}" --write-baseline "baseline/$name.perf" > "$OUT/$name.log" 2>&1
+	else
+		[ "$TIMING" = 1 ] && args+=( --slack "$SLACK" )
+		"$RENDER" "${args[@]}" --baseline "baseline/$name.perf" > "$OUT/$name.log" 2>&1
+	fi
+	report $? "$name"
+}
+
+report()
+{
+	if [ $1 = 0 ]; then
+		echo "ok      $2"
+	else
+		echo "FAILED  $2"
+		sed 's/^/        /' "$OUT/$2.log"
+		FAILED=$((FAILED + 1))
+	fi
+}
+
+for pattern in gradient ramp checker; do
+	for size in 64x36 96x54; do
+		check "lumakey_soft_${pattern}_$size" LumaKey $pattern $size -s "Threshold Begin=0.2" -s "Threshold End=0.6"
+		check "lumakey_hard_${pattern}_$size" LumaKey $pattern $size -s "Threshold Begin=0.4" -s "Threshold End=0.4"
+		check "mirror_${pattern}_$size" "Mirror Native" $pattern $size
+		check "1080p_${pattern}_$size" "1080p to Native" $pattern $size
+		check "mapper_${pattern}_$size" "Native Mapper" $pattern $size
+		check "edgetracer_${pattern}_$size" EdgeTracer $pattern $size
+	done
+done
+
+# the other switches of LumaKey, on the ramp that crosses both thresholds
+check lumakey_premultiply_ramp_96x54 LumaKey ramp 96x54 -s "Threshold Begin=0.2" -s "Threshold End=0.6" -s "Premultiply=1"
+check lumakey_feather_ramp_96x54 LumaKey ramp 96x54 -s "Threshold Begin=0.2" -s "Threshold End=0.6" -s "Feather=0.5"
+
+# the screens of the native layout against a checkerboard, whose squares
+# show where every screen samples: 1080p content onto a 1/16 scale native
+# frame, and a native frame mirrored onto itself
+check 1080p_screens_checker "1080p to Native" checker 128x72 --out-size 256x68
+check mirror_screens_checker "Mirror Native" checker 256x68
+check mirror_screens_checker_512x135 "Mirror Native" checker 512x135
+
+# FF_PROCESSOPENGLBATCH has to render what frame by frame rendering does,
+# so the batch cases share the goldens of the cases above
+if [ $UPDATE = 0 ]; then
+	GOLDEN=lumakey_soft_ramp_96x54 check lumakey_batch_ramp_96x54 LumaKey ramp 96x54 -s "Threshold Begin=0.2" -s "Threshold End=0.6" --batch 2
+	GOLDEN=mirror_screens_checker check mirror_batch_screens_checker "Mirror Native" checker 256x68 --batch 2
+fi
+
+perf perf_lumakey LumaKey -s "Threshold Begin=0.2" -s "Threshold End=0.6"
+perf perf_lumakey_feather LumaKey -s "Threshold Begin=0.2" -s "Threshold End=0.6" -s "Feather=0.5"
+perf perf_lumakey_auto LumaKey -s "Threshold End=0.6" -s "Threshold Begin=0.2" -s "Auto Key=1"
+perf perf_mirror "Mirror Native"
+perf perf_1080p "1080p to Native"
+perf perf_mapper "Native Mapper"
+perf perf_edgetracer EdgeTracer
+
+if [ $FAILED = 0 ]; then
+	echo "all passed"
+else
+	echo "$FAILED failed"
+fi
+exit $FAILED